@@ -0,0 +1,23 @@
+#!/bin/sh
+# Emit a C source file holding the kernel symbol table for ksym_lookup().
+# Usage: gen_ksyms.sh [kernel-image]   (no image -> empty table)
+#
+# Only text symbols are kept, sorted by address so lookups can bisect.
+
+echo '// Generated by scripts/gen_ksyms.sh - do not edit'
+echo '#include "kernel/ksyms.h"'
+echo ''
+echo 'const ksym_t ksyms_table[] = {'
+
+if [ -n "$1" ]; then
+    nm -n "$1" | awk '
+        $2 == "T" || $2 == "t" || $2 == "W" || $2 == "w" {
+            printf "    { 0x%s, \"%s\" },\n", $1, $3
+        }'
+fi
+
+# Terminator (also keeps the array non-empty on the first pass)
+echo '    { 0xFFFFFFFFFFFFFFFFULL, "" },'
+echo '};'
+echo ''
+echo 'const uint32_t ksyms_count = sizeof(ksyms_table) / sizeof(ksyms_table[0]) - 1;'
@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+"""Turn the kernel's BENCH lines into JSON and compare against a baseline.
+
+  perf_report.py parse <serial-log> <report.json>
+  perf_report.py compare <report.json> <baseline.json> [--tolerance 0.10] [--min-delta 10]
+                         [--strict-pixels]
+
+A benchmark regresses when its median exceeds the baseline median by more
+than the tolerance (a fraction) and by at least min-delta cycles, so
+few-cycle operations don't flap on a single cycle of noise. A benchmark in
+the baseline but missing from the run (a crashed or renamed workload) also
+fails. compare exits 1 on any regression or missing benchmark and 0
+otherwise, including when there is no baseline yet.
+
+Headless runs also log CHECKSUM and FRAMETIME lines per workload. Checksum
+mismatches against the baseline are reported; they only fail the compare
+with --strict-pixels, since anything time-dependent on screen (the clock)
+changes the pixels between runs.
+
+LATENCY lines (input-to-photon percentiles per input class, in
+microseconds) are kept in the report under "input_latency" for reference;
+compare does not judge them.
+"""
+import argparse
+import json
+import os
+import sys
+
+FIELDS = ("samples", "batch", "min", "median", "p90", "p99", "max")
+FRAME_FIELDS = ("frames", "median", "p99", "max")
+LATENCY_FIELDS = ("events", "p50", "p95", "p99", "max")
+
+
+def parse_pairs(line):
+    return dict(item.split("=", 1) for item in line.split()[1:] if "=" in item)
+
+
+def parse_log(path):
+    results = {}
+    checksums = {}
+    frames = {}
+    latency = {}
+    with open(path, errors="replace") as log:
+        for line in log:
+            line = line.strip()
+            kind = line.split(" ", 1)[0]
+            if kind not in ("BENCH", "CHECKSUM", "FRAMETIME", "LATENCY"):
+                continue
+            pairs = parse_pairs(line)
+            if "name" not in pairs:
+                continue
+            name = pairs["name"]
+            if kind == "BENCH":
+                results[name] = {key: int(pairs[key]) for key in FIELDS if key in pairs}
+            elif kind == "CHECKSUM" and "value" in pairs:
+                checksums[name] = pairs["value"]
+            elif kind == "FRAMETIME":
+                frames[name] = {key: int(pairs[key]) for key in FRAME_FIELDS if key in pairs}
+            elif kind == "LATENCY":
+                latency[name] = {key: int(pairs[key]) for key in LATENCY_FIELDS if key in pairs}
+    return results, checksums, frames, latency
+
+
+def cmd_parse(args):
+    results, checksums, frames, latency = parse_log(args.log)
+    if not results:
+        print("perf-report: no BENCH lines in %s" % args.log, file=sys.stderr)
+        return 1
+    report = {"unit": "cycles", "benchmarks": results}
+    if checksums:
+        report["checksums"] = checksums
+    if frames:
+        report["frame_times"] = frames
+    if latency:
+        report["input_latency"] = {"unit": "us", "classes": latency}
+    with open(args.report, "w") as out:
+        json.dump(report, out, indent=2, sort_keys=True)
+        out.write("\n")
+    print("perf-report: %d benchmarks, %d checksums -> %s" % (len(results), len(checksums), args.report))
+    return 0
+
+
+def compare_checksums(current, baseline):
+    mismatches = 0
+    for name in sorted(baseline):
+        if name in current and current[name] != baseline[name]:
+            print("  PIXELS   %-32s %s -> %s" % (name, baseline[name], current[name]))
+            mismatches += 1
+    return mismatches
+
+
+def cmd_compare(args):
+    with open(args.report) as f:
+        current_report = json.load(f)
+    if not os.path.exists(args.baseline):
+        print("perf-report: no baseline at %s (make perf-baseline records one)" % args.baseline)
+        return 0
+    with open(args.baseline) as f:
+        baseline_report = json.load(f)
+    current = current_report["benchmarks"]
+    baseline = baseline_report["benchmarks"]
+
+    regressions = 0
+    missing = 0
+    for name in sorted(baseline):
+        if name not in current:
+            print("  MISSING  %s" % name)
+            missing += 1
+            continue
+        old = baseline[name]["median"]
+        new = current[name]["median"]
+        change = (new - old) / old if old else 0.0
+        if change > args.tolerance and new - old >= args.min_delta:
+            verdict = "SLOWER"
+            regressions += 1
+        elif change < -args.tolerance and old - new >= args.min_delta:
+            verdict = "faster"
+        else:
+            verdict = "ok"
+        print("  %-7s %-32s %10d -> %10d  %+6.1f%%" % (verdict, name, old, new, change * 100))
+
+    for name in sorted(set(current) - set(baseline)):
+        print("  NEW      %s" % name)
+
+    mismatches = compare_checksums(current_report.get("checksums", {}),
+                                   baseline_report.get("checksums", {}))
+    if mismatches:
+        print("perf-report: %d frame checksum mismatch(es)" % mismatches)
+
+    if missing:
+        print("perf-report: %d baseline benchmark(s) missing from this run" % missing)
+    if regressions:
+        print("perf-report: %d regression(s) beyond %.0f%%" % (regressions, args.tolerance * 100))
+    if regressions or missing:
+        return 1
+    if mismatches and args.strict_pixels:
+        return 1
+    print("perf-report: no regressions beyond %.0f%%" % (args.tolerance * 100))
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("parse")
+    p.add_argument("log")
+    p.add_argument("report")
+    p.set_defaults(func=cmd_parse)
+
+    c = sub.add_parser("compare")
+    c.add_argument("report")
+    c.add_argument("baseline")
+    c.add_argument("--tolerance", type=float, default=0.10)
+    c.add_argument("--min-delta", type=int, default=10)
+    c.add_argument("--strict-pixels", action="store_true")
+    c.set_defaults(func=cmd_compare)
+
+    args = parser.parse_args()
+    return args.func(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,29 @@
+#!/usr/bin/env bash
+# Boot the perf-test ISO headless in QEMU and capture its serial output.
+# Usage: perf_test.sh <iso> <log>
+#
+# The kernel runs its workloads, prints BENCH lines on COM1 and leaves
+# through isa-debug-exit: QEMU status 33 means success, 35 a kernel-side
+# failure. Anything else (including the timeout's 124) is a crash or hang.
+
+ISO="$1"
+LOG="$2"
+QEMU="${QEMU:-qemu-system-x86_64}"
+TIMEOUT="${PERF_TIMEOUT:-600}"
+
+timeout "$TIMEOUT" "$QEMU" -cdrom "$ISO" -m 512M \
+    -display none -monitor none -serial stdio -no-reboot \
+    -device isa-debug-exit,iobase=0xf4,iosize=0x04 | tee "$LOG"
+status=${PIPESTATUS[0]}
+
+case "$status" in
+    33) ;;
+    35) echo "perf-test: kernel reported failure" >&2; exit 1 ;;
+    124) echo "perf-test: timed out after ${TIMEOUT}s" >&2; exit 1 ;;
+    *) echo "perf-test: QEMU exited with status $status" >&2; exit 1 ;;
+esac
+
+if ! grep -q '^PERFTEST END' "$LOG"; then
+    echo "perf-test: no PERFTEST END marker in $LOG" >&2
+    exit 1
+fi
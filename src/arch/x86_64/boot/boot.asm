@@ -21,6 +21,8 @@ align 4
 
 section .bss
 align 16
+global stack_bottom
+global stack_top
 stack_bottom:
 resb 32768
 stack_top:
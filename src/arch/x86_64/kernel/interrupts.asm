@@ -78,6 +78,17 @@ IRQ 13, 45
 IRQ 14, 46
 IRQ 15, 47
 
+; Vectors 48-255 (IOAPIC pins, MSIs, LAPIC-local) share the IRQ path;
+; idt.c installs them from vector_stub_table
+%assign vec 48
+%rep 208
+vector%+vec:
+    push qword 0
+    push qword vec
+    jmp irq_common_stub
+%assign vec vec+1
+%endrep
+
 isr_common_stub:
     push rax
     push rbx
@@ -203,3 +214,13 @@ irq_common_stub:
     
     add rsp, 16
     iretq
+
+section .rodata
+
+global vector_stub_table
+vector_stub_table:
+%assign vec 48
+%rep 208
+    dq vector%+vec
+%assign vec vec+1
+%endrep
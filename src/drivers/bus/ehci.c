@@ -0,0 +1,97 @@
+#include "ehci.h"
+#include "drivers/bus/pci.h"
+#include "kernel/printk.h"
+#include "kernel/tsc.h"
+#include "mm/vmm.h"
+#include <stddef.h>
+
+// This kernel has no high-speed transfer code. Keyboards and mice are
+// full or low speed, and with CONFIGFLAG clear the EHCI routes each port
+// to a companion UHCI controller, where the UHCI driver finds them.
+
+static inline uint32_t ehci_read(volatile uint8_t* base, uint32_t reg) {
+    return *(volatile uint32_t*)(base + reg);
+}
+
+static inline void ehci_write(volatile uint8_t* base, uint32_t reg, uint32_t value) {
+    *(volatile uint32_t*)(base + reg) = value;
+}
+
+// Ask the BIOS to give up the controller (it may be emulating a PS/2
+// keyboard with SMIs) and turn those SMIs off
+static void ehci_bios_handoff(struct pci_device* pci, uint8_t eecp) {
+    // Bounded walk of the extended capability list
+    for (int i = 0; i < 16 && eecp >= 0x40; i++) {
+        uint32_t cap = pci_read_config(pci->bus, pci->slot, pci->func, eecp);
+        if ((cap & 0xFF) == EHCI_CAP_LEGSUP) {
+            pci_write_config(pci->bus, pci->slot, pci->func, eecp, cap | EHCI_LEGSUP_OS);
+            for (int ms = 0; ms < 1000; ms++) {
+                cap = pci_read_config(pci->bus, pci->slot, pci->func, eecp);
+                if (!(cap & EHCI_LEGSUP_BIOS)) break;
+                udelay(1000);
+            }
+            pci_write_config(pci->bus, pci->slot, pci->func, eecp + 4, 0);
+            return;
+        }
+        eecp = (cap >> 8) & 0xFC;
+    }
+}
+
+static int ehci_release(struct pci_device* pci) {
+    uint32_t bar = pci_read_config(pci->bus, pci->slot, pci->func, PCI_BAR0);
+    if (bar & 1) return -1;     // Registers are always memory mapped
+    
+    uint64_t phys = bar & 0xFFFFFFF0;
+    if (((bar >> 1) & 3) == 2) {
+        phys |= (uint64_t)pci_read_config(pci->bus, pci->slot, pci->func, PCI_BAR1) << 32;
+    }
+    if (!phys) return -1;
+    
+    uint32_t command = pci_read_config(pci->bus, pci->slot, pci->func, PCI_COMMAND) & 0xFFFF;
+    pci_write_config(pci->bus, pci->slot, pci->func, PCI_COMMAND, command | 0x02);
+    
+    volatile uint8_t* caps = (volatile uint8_t*)vmm_map_mmio(phys, 0x1000);
+    if (!caps) return -1;
+    volatile uint8_t* ops = caps + caps[EHCI_CAPLENGTH];
+    uint32_t hcsparams = ehci_read(caps, EHCI_HCSPARAMS);
+    
+    ehci_bios_handoff(pci, EHCI_HCC_EECP(ehci_read(caps, EHCI_HCCPARAMS)));
+    
+    // Stop, then reset (resetting a running controller is undefined)
+    ehci_write(ops, EHCI_USBINTR, 0);
+    ehci_write(ops, EHCI_USBCMD, ehci_read(ops, EHCI_USBCMD) & ~EHCI_CMD_RS);
+    for (int i = 0; i < 100 && !(ehci_read(ops, EHCI_USBSTS) & EHCI_STS_HALTED); i++) {
+        udelay(100);
+    }
+    ehci_write(ops, EHCI_USBCMD, EHCI_CMD_HCRESET);
+    for (int i = 0; i < 1000 && (ehci_read(ops, EHCI_USBCMD) & EHCI_CMD_HCRESET); i++) {
+        udelay(100);
+    }
+    if (ehci_read(ops, EHCI_USBCMD) & EHCI_CMD_HCRESET) return -1;
+    
+    // Unconfigured: every port belongs to the companions
+    ehci_write(ops, EHCI_CONFIGFLAG, 0);
+    for (uint32_t port = 0; port < EHCI_HCS_N_PORTS(hcsparams); port++) {
+        uint32_t status = ehci_read(ops, EHCI_PORTSC(port)) & ~EHCI_PORT_W1C;
+        if (hcsparams & EHCI_HCS_PPC) status |= EHCI_PORT_POWER;
+        ehci_write(ops, EHCI_PORTSC(port), status | EHCI_PORT_OWNER);
+    }
+    
+    // Let the companions see the connections
+    udelay(20000);
+    return 0;
+}
+
+int ehci_init(void) {
+    struct pci_device* pci = NULL;
+    int count = 0;
+    
+    while ((pci = pci_find_class(PCI_CLASS_SERIAL_BUS, PCI_SUBCLASS_USB, EHCI_PROG_IF, pci))) {
+        if (ehci_release(pci) == 0) {
+            count++;
+        } else {
+            pr_warn("usb", "ehci %02x:%02x.%x: handover failed", pci->bus, pci->slot, pci->func);
+        }
+    }
+    return count;
+}
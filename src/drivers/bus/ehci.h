@@ -0,0 +1,43 @@
+#ifndef EHCI_H
+#define EHCI_H
+
+#include <stdint.h>
+
+#define EHCI_PROG_IF        0x20
+
+// Capability registers (MMIO, BAR0)
+#define EHCI_CAPLENGTH      0x00    // Byte: offset of the operational registers
+#define EHCI_HCSPARAMS      0x04
+#define EHCI_HCCPARAMS      0x08
+
+#define EHCI_HCS_N_PORTS(p) ((p) & 0xF)
+#define EHCI_HCS_PPC        (1 << 4)    // Software controls port power
+#define EHCI_HCC_EECP(p)    (((p) >> 8) & 0xFF)
+
+// Operational registers
+#define EHCI_USBCMD         0x00
+#define EHCI_USBSTS         0x04
+#define EHCI_USBINTR        0x08
+#define EHCI_CONFIGFLAG     0x40
+#define EHCI_PORTSC(n)      (0x44 + 4 * (n))
+
+#define EHCI_CMD_RS         (1 << 0)
+#define EHCI_CMD_HCRESET    (1 << 1)
+#define EHCI_STS_HALTED     (1 << 12)
+
+#define EHCI_PORT_CCS       (1 << 0)
+#define EHCI_PORT_POWER     (1 << 12)
+#define EHCI_PORT_OWNER     (1 << 13)   // Set: a companion controller owns the port
+#define EHCI_PORT_W1C       ((1 << 1) | (1 << 3) | (1 << 5))
+
+// USB legacy support extended capability (PCI config space at EECP)
+#define EHCI_CAP_LEGSUP     0x01
+#define EHCI_LEGSUP_BIOS    (1 << 16)   // BIOS owned semaphore
+#define EHCI_LEGSUP_OS      (1 << 24)   // OS owned semaphore
+
+// Take each EHCI controller from the BIOS, reset it and leave it
+// unconfigured, so every root port is routed to its UHCI companions.
+// Returns the number of controllers handed over.
+int ehci_init(void);
+
+#endif
@@ -1,47 +1,399 @@
 #include "pci.h"
 #include "lib/io.h"
+#include <stddef.h>
+#include "kernel/irq.h"
+#include "kernel/lapic.h"
+#include "mm/vmm.h"
+#include "kernel/acpi.h"
+#include "kernel/tsc.h"
+
+#define PCI_HASH_BUCKETS 32     // Power of two
+
+static struct pci_device pci_devices[PCI_MAX_DEVICES];
+static int pci_count = 0;
+
+// Hash chains through the table: heads per bucket, next index per device
+static int8_t class_heads[PCI_HASH_BUCKETS];
+static int8_t vendor_heads[PCI_HASH_BUCKETS];
+static int8_t class_next[PCI_MAX_DEVICES];
+static int8_t vendor_next[PCI_MAX_DEVICES];
+
+// ECAM window for segment 0 (NULL: use the I/O ports)
+static volatile uint8_t* ecam_base = NULL;
+static uint8_t ecam_start_bus = 0;
+static uint8_t ecam_end_bus = 0;
+
+static uint64_t scan_cycles = 0;
+
+static inline volatile uint32_t* pci_ecam_address(uint8_t bus, uint8_t slot, uint8_t func,
+                                                  uint8_t offset) {
+    if (!ecam_base || bus < ecam_start_bus || bus > ecam_end_bus) return NULL;
+    
+    uint64_t off = ((uint64_t)(bus - ecam_start_bus) << 20) | ((uint64_t)slot << 15) |
+                   ((uint64_t)func << 12) | (offset & 0xFC);
+    return (volatile uint32_t*)(ecam_base + off);
+}
+
+static inline uint32_t pci_port_address(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset) {
+    return (uint32_t)((bus << 16) | (slot << 11) | (func << 8) | (offset & 0xFC) | 0x80000000);
+}
 
 uint32_t pci_read_config(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset) {
-    uint32_t address = (uint32_t)((bus << 16) | (slot << 11) | 
-                       (func << 8) | (offset & 0xFC) | 0x80000000);
-    outl(PCI_CONFIG_ADDRESS, address);
+    volatile uint32_t* reg = pci_ecam_address(bus, slot, func, offset);
+    if (reg) return *reg;
+    
+    outl(PCI_CONFIG_ADDRESS, pci_port_address(bus, slot, func, offset));
     return inl(PCI_CONFIG_DATA);
 }
 
 void pci_write_config(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset, uint32_t value) {
-    uint32_t address = (uint32_t)((bus << 16) | (slot << 11) | 
-                       (func << 8) | (offset & 0xFC) | 0x80000000);
-    outl(PCI_CONFIG_ADDRESS, address);
+    volatile uint32_t* reg = pci_ecam_address(bus, slot, func, offset);
+    if (reg) {
+        *reg = value;
+        return;
+    }
+    
+    outl(PCI_CONFIG_ADDRESS, pci_port_address(bus, slot, func, offset));
     outl(PCI_CONFIG_DATA, value);
 }
 
+// Map the MCFG window covering segment 0, if the firmware has one
+static void pci_ecam_init(void) {
+    acpi_mcfg_t* mcfg = (acpi_mcfg_t*)acpi_find_table("MCFG");
+    if (!mcfg) return;
+    
+    uint32_t entries = (mcfg->header.length - sizeof(acpi_mcfg_t)) / sizeof(acpi_mcfg_entry_t);
+    acpi_mcfg_entry_t* entry = (acpi_mcfg_entry_t*)(mcfg + 1);
+    
+    for (uint32_t i = 0; i < entries; i++, entry++) {
+        if (entry->segment != 0 || entry->end_bus < entry->start_bus) continue;
+        
+        uint64_t size = (uint64_t)(entry->end_bus - entry->start_bus + 1) << 20;
+        ecam_base = (volatile uint8_t*)vmm_map_mmio(entry->base_address, size);
+        if (!ecam_base) return;     // Stay on port I/O
+        ecam_start_bus = entry->start_bus;
+        ecam_end_bus = entry->end_bus;
+        return;
+    }
+}
+
+static inline uint32_t pci_class_hash(uint8_t class_code, uint8_t subclass, uint8_t prog_if) {
+    uint32_t key = ((uint32_t)class_code << 16) | ((uint32_t)subclass << 8) | prog_if;
+    return (key * 0x9E3779B1u) >> 27;
+}
+
+static inline uint32_t pci_vendor_hash(uint16_t vendor_id) {
+    return ((uint32_t)vendor_id * 0x9E3779B1u) >> 27;
+}
+
+// Link devices into their chains back to front so each chain keeps
+// bus order
+static void pci_build_index(void) {
+    for (int i = 0; i < PCI_HASH_BUCKETS; i++) {
+        class_heads[i] = -1;
+        vendor_heads[i] = -1;
+    }
+    
+    for (int i = pci_count - 1; i >= 0; i--) {
+        struct pci_device* dev = &pci_devices[i];
+        uint32_t c = pci_class_hash(dev->class_code, dev->subclass, dev->prog_if);
+        uint32_t v = pci_vendor_hash(dev->vendor_id);
+        class_next[i] = class_heads[c];
+        class_heads[c] = (int8_t)i;
+        vendor_next[i] = vendor_heads[v];
+        vendor_heads[v] = (int8_t)i;
+    }
+}
+
+static void pci_scan_bus(uint8_t bus, uint32_t* seen);
+
+static void pci_add_function(uint8_t bus, uint8_t slot, uint8_t func, uint32_t id,
+                             uint32_t* seen) {
+    uint32_t class_info = pci_read_config(bus, slot, func, PCI_CLASS_REVISION);
+    uint8_t header_type = (pci_read_config(bus, slot, func, PCI_HEADER_INFO) >> 16) & 0xFF;
+    
+    if (pci_count < PCI_MAX_DEVICES) {
+        struct pci_device* dev = &pci_devices[pci_count++];
+        dev->bus = bus;
+        dev->slot = slot;
+        dev->func = func;
+        dev->vendor_id = id & 0xFFFF;
+        dev->device_id = (id >> 16) & 0xFFFF;
+        dev->class_code = (class_info >> 24) & 0xFF;
+        dev->subclass = (class_info >> 16) & 0xFF;
+        dev->prog_if = (class_info >> 8) & 0xFF;
+        dev->header_type = header_type;
+        dev->bar0 = 0;
+        dev->bar1 = 0;
+        // Bridges use these dwords for windows, not BARs
+        if ((header_type & PCI_HEADER_TYPE_MASK) == 0) {
+            dev->bar0 = pci_read_config(bus, slot, func, PCI_BAR0) & 0xFFFFFFF0;
+            dev->bar1 = pci_read_config(bus, slot, func, PCI_BAR1) & 0xFFFFFFF0;
+        }
+        dev->interrupt_line = pci_read_config(bus, slot, func, PCI_INTERRUPT_LINE) & 0xFF;
+    }
+    
+    // Devices behind a bridge sit on its secondary bus
+    if ((header_type & PCI_HEADER_TYPE_MASK) == PCI_HEADER_BRIDGE) {
+        uint8_t secondary = (pci_read_config(bus, slot, func, PCI_BRIDGE_BUSES) >> 8) & 0xFF;
+        if (secondary != 0) pci_scan_bus(secondary, seen);
+    }
+}
+
+static void pci_scan_bus(uint8_t bus, uint32_t* seen) {
+    // A misprogrammed bridge could send us round in circles
+    if (seen[bus / 32] & (1u << (bus % 32))) return;
+    seen[bus / 32] |= 1u << (bus % 32);
+    
+    for (uint8_t slot = 0; slot < 32; slot++) {
+        uint32_t id = pci_read_config(bus, slot, 0, PCI_VENDOR_ID);
+        if ((id & 0xFFFF) == 0xFFFF) continue;
+        
+        uint8_t header_type = (pci_read_config(bus, slot, 0, PCI_HEADER_INFO) >> 16) & 0xFF;
+        pci_add_function(bus, slot, 0, id, seen);
+        if (!(header_type & PCI_HEADER_MULTIFUNC)) continue;
+        
+        for (uint8_t func = 1; func < 8; func++) {
+            id = pci_read_config(bus, slot, func, PCI_VENDOR_ID);
+            if ((id & 0xFFFF) != 0xFFFF) pci_add_function(bus, slot, func, id, seen);
+        }
+    }
+}
+
+int pci_init(void) {
+    uint32_t seen[256 / 32] = { 0 };
+    
+    pci_ecam_init();
+    
+    uint64_t start = rdtsc();
+    pci_count = 0;
+    
+    // A multi-function host bridge means one root bus per function
+    uint8_t header_type = (pci_read_config(0, 0, 0, PCI_HEADER_INFO) >> 16) & 0xFF;
+    if (header_type & PCI_HEADER_MULTIFUNC) {
+        for (uint8_t func = 0; func < 8; func++) {
+            uint32_t id = pci_read_config(0, 0, func, PCI_VENDOR_ID);
+            if ((id & 0xFFFF) != 0xFFFF) pci_scan_bus(func, seen);
+        }
+    } else {
+        pci_scan_bus(0, seen);
+    }
+    
+    pci_build_index();
+    scan_cycles = rdtsc() - start;
+    return pci_count;
+}
+
+int pci_device_count(void) {
+    return pci_count;
+}
+
+struct pci_device* pci_get_device(int index) {
+    if (index < 0 || index >= pci_count) return NULL;
+    return &pci_devices[index];
+}
+
+struct pci_device* pci_find_class(uint8_t class_code, uint8_t subclass, uint8_t prog_if,
+                                  struct pci_device* from) {
+    int i = from ? class_next[from - pci_devices]
+                 : class_heads[pci_class_hash(class_code, subclass, prog_if)];
+    
+    for (; i >= 0; i = class_next[i]) {
+        struct pci_device* dev = &pci_devices[i];
+        if (dev->class_code == class_code && dev->subclass == subclass && dev->prog_if == prog_if) {
+            return dev;
+        }
+    }
+    return NULL;
+}
+
+struct pci_device* pci_find_vendor(uint16_t vendor_id, uint16_t device_id,
+                                   struct pci_device* from) {
+    int i = from ? vendor_next[from - pci_devices] : vendor_heads[pci_vendor_hash(vendor_id)];
+    
+    for (; i >= 0; i = vendor_next[i]) {
+        struct pci_device* dev = &pci_devices[i];
+        if (dev->vendor_id == vendor_id && (device_id == PCI_ANY_ID || dev->device_id == device_id)) {
+            return dev;
+        }
+    }
+    return NULL;
+}
+
 int pci_find_device(uint8_t class_code, uint8_t subclass, uint8_t prog_if, struct pci_device* out) {
+    struct pci_device* dev = pci_find_class(class_code, subclass, prog_if, NULL);
+    if (!dev) return 0;
+    
+    *out = *dev;
+    return 1;
+}
+
+const char* pci_config_method(void) {
+    return ecam_base ? "ecam" : "port I/O";
+}
+
+uint64_t pci_scan_cycles(void) {
+    return scan_cycles;
+}
+
+uint64_t pci_legacy_scan_cycles(void) {
+    uint64_t start = rdtsc();
+    
     for (uint16_t bus = 0; bus < 256; bus++) {
         for (uint8_t slot = 0; slot < 32; slot++) {
-            uint32_t vendor = pci_read_config(bus, slot, 0, 0);
-            if ((vendor & 0xFFFF) == 0xFFFF) continue;
+            outl(PCI_CONFIG_ADDRESS, pci_port_address(bus, slot, 0, PCI_VENDOR_ID));
+            uint32_t id = inl(PCI_CONFIG_DATA);
+            if ((id & 0xFFFF) == 0xFFFF) continue;
             
-            uint32_t class_info = pci_read_config(bus, slot, 0, 0x08);
-            uint8_t dev_class = (class_info >> 24) & 0xFF;
-            uint8_t dev_subclass = (class_info >> 16) & 0xFF;
-            uint8_t dev_prog_if = (class_info >> 8) & 0xFF;
-            
-            if (dev_class == class_code && dev_subclass == subclass && dev_prog_if == prog_if) {
-                out->bus = bus;
-                out->slot = slot;
-                out->func = 0;
-                out->vendor_id = vendor & 0xFFFF;
-                out->device_id = (vendor >> 16) & 0xFFFF;
-                out->class_code = dev_class;
-                out->subclass = dev_subclass;
-                out->prog_if = dev_prog_if;
-                out->bar0 = pci_read_config(bus, slot, 0, 0x10) & 0xFFFFFFF0;
-                out->bar1 = pci_read_config(bus, slot, 0, 0x14) & 0xFFFFFFF0;
-                uint32_t irq_info = pci_read_config(bus, slot, 0, 0x3C);
-                out->interrupt_line = irq_info & 0xFF;
-                return 1;
-            }
+            outl(PCI_CONFIG_ADDRESS, pci_port_address(bus, slot, 0, PCI_CLASS_REVISION));
+            inl(PCI_CONFIG_DATA);
         }
     }
+    return rdtsc() - start;
+}
+
+const char* pci_class_name(uint8_t class_code, uint8_t subclass) {
+    switch (class_code) {
+    case 0x00: return "Legacy Device";
+    case 0x01: return "Mass Storage";
+    case 0x02: return "Network Controller";
+    case 0x03: return "Display Controller";
+    case 0x04: return "Multimedia";
+    case 0x05: return "Memory Controller";
+    case PCI_CLASS_BRIDGE:
+        if (subclass == PCI_SUBCLASS_HOST) return "Host Bridge";
+        if (subclass == PCI_SUBCLASS_PCI) return "PCI Bridge";
+        return "Bridge Device";
+    case PCI_CLASS_SERIAL_BUS:
+        return subclass == PCI_SUBCLASS_USB ? "USB Controller" : "Serial Bus";
+    default:   return "Unknown";
+    }
+}
+
+uint8_t pci_find_capability(struct pci_device* dev, uint8_t cap_id) {
+    uint32_t cmd_status = pci_read_config(dev->bus, dev->slot, dev->func, PCI_COMMAND);
+    if (!(cmd_status & PCI_STATUS_CAP_LIST)) return 0;
+    
+    uint8_t offset = pci_read_config(dev->bus, dev->slot, dev->func, PCI_CAPABILITY_PTR) & 0xFC;
+    
+    // Bound the walk in case of a looping list
+    for (int i = 0; i < 48 && offset; i++) {
+        uint32_t header = pci_read_config(dev->bus, dev->slot, dev->func, offset);
+        if ((header & 0xFF) == cap_id) return offset;
+        offset = (header >> 8) & 0xFC;
+    }
     return 0;
 }
+
+static void pci_set_intx(struct pci_device* dev, int enabled) {
+    uint32_t command = pci_read_config(dev->bus, dev->slot, dev->func, PCI_COMMAND) & 0xFFFF;
+    if (enabled) {
+        command &= ~PCI_COMMAND_INTX_DISABLE;
+    } else {
+        command |= PCI_COMMAND_INTX_DISABLE;
+    }
+    // Status bits are write-1-to-clear; write zeros to leave them alone
+    pci_write_config(dev->bus, dev->slot, dev->func, PCI_COMMAND, command);
+}
+
+int pci_enable_msi(struct pci_device* dev, uint8_t vector, uint8_t dest_apic) {
+    uint8_t cap = pci_find_capability(dev, PCI_CAP_ID_MSI);
+    if (!cap) return -1;
+    
+    uint32_t header = pci_read_config(dev->bus, dev->slot, dev->func, cap);
+    uint16_t control = header >> 16;
+    
+    pci_write_config(dev->bus, dev->slot, dev->func, cap + 4,
+                     LAPIC_MSI_ADDRESS | ((uint32_t)dest_apic << 12));
+    if (control & PCI_MSI_64BIT) {
+        pci_write_config(dev->bus, dev->slot, dev->func, cap + 8, 0);
+        pci_write_config(dev->bus, dev->slot, dev->func, cap + 12, vector);
+    } else {
+        pci_write_config(dev->bus, dev->slot, dev->func, cap + 8, vector);
+    }
+    
+    // One message, edge-triggered fixed delivery
+    control &= ~PCI_MSI_MME_MASK;
+    control |= PCI_MSI_ENABLE;
+    pci_write_config(dev->bus, dev->slot, dev->func, cap,
+                     (header & 0xFFFF) | ((uint32_t)control << 16));
+    
+    pci_set_intx(dev, 0);
+    irq_set_chip(vector, &lapic_chip);
+    return 0;
+}
+
+void pci_disable_msi(struct pci_device* dev) {
+    uint8_t cap = pci_find_capability(dev, PCI_CAP_ID_MSI);
+    if (!cap) return;
+    
+    uint32_t header = pci_read_config(dev->bus, dev->slot, dev->func, cap);
+    pci_write_config(dev->bus, dev->slot, dev->func, cap,
+                     header & ~((uint32_t)PCI_MSI_ENABLE << 16));
+    pci_set_intx(dev, 1);
+}
+
+int pci_msix_count(struct pci_device* dev) {
+    uint8_t cap = pci_find_capability(dev, PCI_CAP_ID_MSIX);
+    if (!cap) return 0;
+    
+    uint32_t header = pci_read_config(dev->bus, dev->slot, dev->func, cap);
+    return ((header >> 16) & PCI_MSIX_SIZE_MASK) + 1;
+}
+
+// Map the BAR holding the MSI-X table and return the table's address
+static volatile uint32_t* pci_msix_table(struct pci_device* dev, uint8_t cap) {
+    uint32_t table_info = pci_read_config(dev->bus, dev->slot, dev->func, cap + 4);
+    uint8_t bir = table_info & 0x7;
+    if (bir > 5) return NULL;
+    
+    uint8_t bar_offset = 0x10 + bir * 4;
+    uint32_t bar = pci_read_config(dev->bus, dev->slot, dev->func, bar_offset);
+    if (bar & 1) return NULL;   // The table is always in memory space
+    
+    uint64_t base = bar & 0xFFFFFFF0;
+    if (((bar >> 1) & 3) == 2 && bir < 5) {
+        base |= (uint64_t)pci_read_config(dev->bus, dev->slot, dev->func, bar_offset + 4) << 32;
+    }
+    
+    uint64_t table = base + (table_info & ~7u);
+    uint64_t size = (uint64_t)pci_msix_count(dev) * PCI_MSIX_ENTRY_SIZE;
+    return (volatile uint32_t*)vmm_map_mmio(table, size);
+}
+
+int pci_enable_msix(struct pci_device* dev, int entry, uint8_t vector, uint8_t dest_apic) {
+    uint8_t cap = pci_find_capability(dev, PCI_CAP_ID_MSIX);
+    if (!cap || entry < 0 || entry >= pci_msix_count(dev)) return -1;
+    
+    volatile uint32_t* table = pci_msix_table(dev, cap);
+    if (!table) return -1;
+    
+    // Function-mask while the entry is rewritten, then enable MSI-X
+    uint32_t header = pci_read_config(dev->bus, dev->slot, dev->func, cap);
+    pci_write_config(dev->bus, dev->slot, dev->func, cap,
+                     header | ((uint32_t)(PCI_MSIX_ENABLE | PCI_MSIX_FUNC_MASK) << 16));
+    
+    volatile uint32_t* slot = table + entry * (PCI_MSIX_ENTRY_SIZE / 4);
+    slot[0] = LAPIC_MSI_ADDRESS | ((uint32_t)dest_apic << 12);
+    slot[1] = 0;
+    slot[2] = vector;
+    slot[3] = 0;    // Unmask this entry
+    
+    header = pci_read_config(dev->bus, dev->slot, dev->func, cap);
+    pci_write_config(dev->bus, dev->slot, dev->func, cap,
+                     header & ~((uint32_t)PCI_MSIX_FUNC_MASK << 16));
+    
+    pci_set_intx(dev, 0);
+    irq_set_chip(vector, &lapic_chip);
+    return 0;
+}
+
+void pci_msix_mask(struct pci_device* dev, int entry, int masked) {
+    uint8_t cap = pci_find_capability(dev, PCI_CAP_ID_MSIX);
+    if (!cap || entry < 0 || entry >= pci_msix_count(dev)) return;
+    
+    volatile uint32_t* table = pci_msix_table(dev, cap);
+    if (!table) return;
+    
+    table[entry * (PCI_MSIX_ENTRY_SIZE / 4) + 3] = masked ? PCI_MSIX_ENTRY_CTRL_MASKED : 0;
+}
@@ -6,9 +6,49 @@
 #define PCI_CONFIG_ADDRESS 0xCF8
 #define PCI_CONFIG_DATA    0xCFC
 
+// Config space registers
+#define PCI_VENDOR_ID        0x00
+#define PCI_COMMAND          0x04
+#define PCI_CLASS_REVISION   0x08
+#define PCI_HEADER_INFO      0x0C   // Header type in bits 16-23
+#define PCI_BAR0             0x10
+#define PCI_BAR1             0x14
+#define PCI_BRIDGE_BUSES     0x18   // Primary/secondary/subordinate bus
+#define PCI_INTERRUPT_LINE   0x3C
+
+#define PCI_HEADER_TYPE_MASK 0x7F
+#define PCI_HEADER_BRIDGE    0x01   // PCI-to-PCI bridge
+#define PCI_HEADER_MULTIFUNC 0x80
+
+#define PCI_STATUS_CAP_LIST  (1 << 20)   // In the command/status dword
+#define PCI_CAPABILITY_PTR   0x34
+#define PCI_COMMAND_INTX_DISABLE (1 << 10)
+
+// Capability IDs
+#define PCI_CAP_ID_MSI       0x05
+#define PCI_CAP_ID_MSIX      0x11
+
+// MSI message control (upper half of the capability's first dword)
+#define PCI_MSI_ENABLE       (1 << 0)
+#define PCI_MSI_MME_MASK     (7 << 4)
+#define PCI_MSI_64BIT        (1 << 7)
+
+// MSI-X message control and table layout
+#define PCI_MSIX_ENABLE      (1 << 15)
+#define PCI_MSIX_FUNC_MASK   (1 << 14)
+#define PCI_MSIX_SIZE_MASK   0x7FF
+#define PCI_MSIX_ENTRY_SIZE  16
+#define PCI_MSIX_ENTRY_CTRL_MASKED 1
+
+#define PCI_CLASS_BRIDGE     0x06
+#define PCI_SUBCLASS_HOST    0x00
+#define PCI_SUBCLASS_PCI     0x04
 #define PCI_CLASS_SERIAL_BUS 0x0C
 #define PCI_SUBCLASS_USB     0x03
 
+#define PCI_ANY_ID           0xFFFF
+#define PCI_MAX_DEVICES      64     // Functions kept in the device table
+
 // PCI Device
 struct pci_device {
     uint8_t bus;
@@ -22,10 +62,59 @@ struct pci_device {
     uint32_t bar0;
     uint32_t bar1;
     uint8_t interrupt_line;
+    uint8_t header_type;
 };
 
+// Config space goes through ECAM (memory mapped, from the ACPI MCFG) when
+// the firmware provides it, else through ports 0xCF8/0xCFC
 uint32_t pci_read_config(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset);
 void pci_write_config(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset, uint32_t value);
+
+// Enumerate every function once, following PCI-to-PCI bridges, into the
+// device table. Run after acpi_init (for ECAM) and tsc_init (for timing).
+// Returns the number of functions found.
+int pci_init(void);
+
+int pci_device_count(void);
+struct pci_device* pci_get_device(int index);
+
+// Table lookups, hashed by class triple or by vendor. Pass the previous
+// match as `from` to get the next one, NULL for the first.
+struct pci_device* pci_find_class(uint8_t class_code, uint8_t subclass, uint8_t prog_if,
+                                  struct pci_device* from);
+struct pci_device* pci_find_vendor(uint16_t vendor_id, uint16_t device_id,   // or PCI_ANY_ID
+                                   struct pci_device* from);
+
+// Copy the first function of a class into out. Returns 1 if found.
 int pci_find_device(uint8_t class_code, uint8_t subclass, uint8_t prog_if, struct pci_device* out);
 
+// "ecam" or "port I/O"
+const char* pci_config_method(void);
+
+// Cycles pci_init spent enumerating
+uint64_t pci_scan_cycles(void);
+
+// Time the brute-force scan pci_find_device used to do on every call
+// (function 0 of 256 buses x 32 slots through the I/O ports)
+uint64_t pci_legacy_scan_cycles(void);
+
+// Printable name of a class code
+const char* pci_class_name(uint8_t class_code, uint8_t subclass);
+
+// Config-space offset of a capability, or 0 if the device lacks it
+uint8_t pci_find_capability(struct pci_device* dev, uint8_t cap_id);
+
+// Deliver the device's interrupt as an MSI with the given vector to one
+// LAPIC, and turn off its INTx line. Returns 0 on success, -1 without MSI.
+int pci_enable_msi(struct pci_device* dev, uint8_t vector, uint8_t dest_apic);
+void pci_disable_msi(struct pci_device* dev);
+
+// Number of MSI-X table entries (0 without MSI-X)
+int pci_msix_count(struct pci_device* dev);
+
+// Program MSI-X table entry `entry` (e.g. one per queue) and enable MSI-X.
+// Each entry can target a different vector and CPU. Returns 0 on success.
+int pci_enable_msix(struct pci_device* dev, int entry, uint8_t vector, uint8_t dest_apic);
+void pci_msix_mask(struct pci_device* dev, int entry, int masked);
+
 #endif
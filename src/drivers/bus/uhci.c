@@ -0,0 +1,350 @@
+#include "uhci.h"
+#include "drivers/bus/pci.h"
+#include "drivers/bus/usb.h"
+#include "kernel/irq.h"
+#include "kernel/printk.h"
+#include "kernel/softirq.h"
+#include "kernel/tsc.h"
+#include "lib/io.h"
+#include "lib/string.h"
+#include <stddef.h>
+
+#define UHCI_CONTROL_TDS    40      // SETUP + 256 bytes in 8-byte packets + status
+#define UHCI_CONTROL_BUF    USB_CONFIG_MAX
+#define UHCI_PIPE_BUF       64      // Largest full-speed interrupt packet
+#define UHCI_CONTROL_TIMEOUT_US 500000
+
+// Everything the controller reads or writes. The kernel is identity mapped
+// below 4GB, so addresses in here are also the bus addresses.
+typedef struct {
+    uint32_t frame_list[UHCI_FRAMES];
+    uhci_qh_t skel[UHCI_SKEL_LEVELS];
+    uhci_qh_t control_qh;
+    uhci_qh_t pipe_qh[UHCI_MAX_PIPES];
+    uhci_td_t control_td[UHCI_CONTROL_TDS];
+    uhci_td_t pipe_td[UHCI_MAX_PIPES];
+    uint8_t setup[8];
+    uint8_t control_buf[UHCI_CONTROL_BUF];
+    uint8_t pipe_buf[UHCI_MAX_PIPES][UHCI_PIPE_BUF];
+} __attribute__((aligned(4096))) uhci_dma_t;
+
+// One interrupt IN endpoint: a QH holding a single TD, re-armed after
+// every completion
+typedef struct {
+    usb_device_t* dev;
+    usb_complete_t complete;
+    uint8_t endpoint;
+    uint8_t toggle;
+    uint16_t max_packet;
+    uint32_t completed;
+    uint32_t errors;
+} uhci_pipe_t;
+
+typedef struct {
+    struct pci_device* pci;
+    uint16_t io;
+    uint8_t vector;
+    uhci_dma_t* dma;
+    uhci_pipe_t pipes[UHCI_MAX_PIPES];
+    volatile int pipe_count;
+    tasklet_t tasklet;
+    uint64_t irqs;
+} uhci_t;
+
+static uhci_dma_t uhci_dma[UHCI_MAX_CONTROLLERS];
+static uhci_t uhci_controllers[UHCI_MAX_CONTROLLERS];
+static int uhci_count = 0;
+
+static inline uint32_t uhci_phys(volatile void* ptr) {
+    return (uint32_t)(uintptr_t)ptr;
+}
+
+static void uhci_build_schedule(uhci_t* hc) {
+    uhci_dma_t* dma = hc->dma;
+    
+    // Interrupt QHs for each polling interval chain into shorter
+    // intervals, and all of them end in the control QH
+    dma->control_qh.head = UHCI_LINK_TERMINATE;
+    dma->control_qh.element = UHCI_LINK_TERMINATE;
+    for (int level = 0; level < UHCI_SKEL_LEVELS; level++) {
+        uhci_qh_t* qh = &dma->skel[level];
+        qh->element = UHCI_LINK_TERMINATE;
+        qh->head = uhci_phys(level ? &dma->skel[level - 1] : &dma->control_qh) | UHCI_LINK_QH;
+    }
+    
+    // Frame n starts at the longest interval that divides n
+    for (int frame = 0; frame < UHCI_FRAMES; frame++) {
+        int level = __builtin_ctz(frame | (1 << (UHCI_SKEL_LEVELS - 1)));
+        dma->frame_list[frame] = uhci_phys(&dma->skel[level]) | UHCI_LINK_QH;
+    }
+}
+
+static int uhci_reset(uhci_t* hc) {
+    struct pci_device* pci = hc->pci;
+    
+    // Take the controller from the BIOS's keyboard emulation
+    uint32_t legsup = pci_read_config(pci->bus, pci->slot, pci->func, UHCI_PCI_LEGSUP);
+    pci_write_config(pci->bus, pci->slot, pci->func, UHCI_PCI_LEGSUP,
+                     (legsup & 0xFFFF0000) | UHCI_LEGSUP_RWC);
+    
+    outw(hc->io + UHCI_USBINTR, 0);
+    outw(hc->io + UHCI_USBCMD, UHCI_CMD_GRESET);
+    udelay(50000);
+    outw(hc->io + UHCI_USBCMD, 0);
+    udelay(10000);
+    
+    outw(hc->io + UHCI_USBCMD, UHCI_CMD_HCRESET);
+    for (int i = 0; i < 100 && (inw(hc->io + UHCI_USBCMD) & UHCI_CMD_HCRESET); i++) {
+        udelay(100);
+    }
+    if (inw(hc->io + UHCI_USBCMD) & UHCI_CMD_HCRESET) return -1;
+    
+    // I/O decoding and bus mastering; status bits are W1C, so write zeros
+    uint32_t command = pci_read_config(pci->bus, pci->slot, pci->func, PCI_COMMAND) & 0xFFFF;
+    pci_write_config(pci->bus, pci->slot, pci->func, PCI_COMMAND, command | 0x05);
+    
+    uhci_build_schedule(hc);
+    outl(hc->io + UHCI_FRBASEADD, uhci_phys(hc->dma->frame_list));
+    outw(hc->io + UHCI_FRNUM, 0);
+    outb(hc->io + UHCI_SOFMOD, 64);     // 1 ms frames
+    outw(hc->io + UHCI_USBSTS, UHCI_STS_ALL);
+    
+    pci_write_config(pci->bus, pci->slot, pci->func, UHCI_PCI_LEGSUP,
+                     (legsup & 0xFFFF0000) | UHCI_LEGSUP_PIRQ);
+    
+    outw(hc->io + UHCI_USBINTR, UHCI_INTR_IOC | UHCI_INTR_TIMEOUT | UHCI_INTR_SHORT);
+    outw(hc->io + UHCI_USBCMD, UHCI_CMD_RS | UHCI_CMD_CF | UHCI_CMD_MAXP);
+    
+    for (int i = 0; i < 100 && (inw(hc->io + UHCI_USBSTS) & UHCI_STS_HALTED); i++) {
+        udelay(100);
+    }
+    return (inw(hc->io + UHCI_USBSTS) & UHCI_STS_HALTED) ? -1 : 0;
+}
+
+static int uhci_control(usb_device_t* dev, const struct usb_device_request* req, void* data) {
+    uhci_t* hc = (uhci_t*)dev->hc;
+    uhci_dma_t* dma = hc->dma;
+    uint16_t length = req->length;
+    int in = (req->request_type & USB_DIR_IN) != 0;
+    uint16_t mps = dev->max_packet0;
+    int packets = (length + mps - 1) / mps;
+    
+    if (length > UHCI_CONTROL_BUF || packets + 2 > UHCI_CONTROL_TDS) return -1;
+    
+    uint32_t status = UHCI_TD_ACTIVE | UHCI_TD_CERR(3) |
+                      (dev->speed == USB_SPEED_LOW ? UHCI_TD_LS : 0);
+    memcpy(dma->setup, req, sizeof(dma->setup));
+    if (!in && length) memcpy(dma->control_buf, data, length);
+    
+    // SETUP, DATA0/1/0... in max-packet chunks, then a zero-length status
+    // stage in the other direction. We always ask for exact lengths, so a
+    // short packet would be an error anyway.
+    uhci_td_t* td = dma->control_td;
+    int n = 0;
+    td[n].token = UHCI_TOKEN(UHCI_PID_SETUP, dev->address, 0, 0, 8);
+    td[n].buffer = uhci_phys(dma->setup);
+    n++;
+    for (int i = 0; i < packets; i++, n++) {
+        uint16_t chunk = length - i * mps < mps ? length - i * mps : mps;
+        td[n].token = UHCI_TOKEN(in ? UHCI_PID_IN : UHCI_PID_OUT, dev->address, 0, (i + 1) & 1, chunk);
+        td[n].buffer = uhci_phys(dma->control_buf + i * mps);
+    }
+    td[n].token = UHCI_TOKEN(in && length ? UHCI_PID_OUT : UHCI_PID_IN, dev->address, 0, 1, 0);
+    td[n].buffer = 0;
+    n++;
+    
+    for (int i = 0; i < n; i++) {
+        td[i].link = i + 1 < n ? uhci_phys(&td[i + 1]) | UHCI_LINK_DEPTH : UHCI_LINK_TERMINATE;
+        td[i].status = status;
+    }
+    asm volatile("" : : : "memory");
+    dma->control_qh.element = uhci_phys(td);
+    
+    int failed = 1;
+    for (int waited = 0; waited < UHCI_CONTROL_TIMEOUT_US; waited += 10) {
+        if (!(td[n - 1].status & UHCI_TD_ACTIVE)) {
+            failed = (td[n - 1].status & UHCI_TD_ERRORS) != 0;
+            break;
+        }
+        int error = 0;
+        for (int i = 0; i < n; i++) {
+            uint32_t s = td[i].status;
+            if (!(s & UHCI_TD_ACTIVE) && (s & UHCI_TD_ERRORS)) error = 1;
+        }
+        if (error) break;
+        udelay(10);
+    }
+    dma->control_qh.element = UHCI_LINK_TERMINATE;
+    if (failed) return -1;
+    
+    int actual = 0;
+    for (int i = 1; i <= packets; i++) {
+        actual += (td[i].status + 1) & UHCI_TD_ACTLEN_MASK;
+    }
+    if (in) memcpy(data, dma->control_buf, actual);
+    return actual;
+}
+
+static int uhci_set_address(usb_device_t* dev, uint8_t address) {
+    return usb_control(dev, 0, USB_REQ_SET_ADDRESS, address, 0, 0, NULL) < 0 ? -1 : 0;
+}
+
+static void uhci_pipe_arm(uhci_t* hc, int index) {
+    uhci_pipe_t* pipe = &hc->pipes[index];
+    uhci_td_t* td = &hc->dma->pipe_td[index];
+    
+    td->link = UHCI_LINK_TERMINATE;
+    td->buffer = uhci_phys(hc->dma->pipe_buf[index]);
+    td->token = UHCI_TOKEN(UHCI_PID_IN, pipe->dev->address, pipe->endpoint & 0xF, pipe->toggle,
+                           pipe->max_packet);
+    td->status = UHCI_TD_ACTIVE | UHCI_TD_IOC | UHCI_TD_CERR(3) |
+                 (pipe->dev->speed == USB_SPEED_LOW ? UHCI_TD_LS : 0);
+    asm volatile("" : : : "memory");
+    hc->dma->pipe_qh[index].element = uhci_phys(td);
+}
+
+static int uhci_interrupt_in(usb_device_t* dev, uint8_t endpoint, uint16_t max_packet,
+                             uint8_t interval, usb_complete_t complete) {
+    uhci_t* hc = (uhci_t*)dev->hc;
+    int index = hc->pipe_count;
+    if (index >= UHCI_MAX_PIPES || max_packet == 0 || max_packet > UHCI_PIPE_BUF) return -1;
+    
+    uhci_pipe_t* pipe = &hc->pipes[index];
+    pipe->dev = dev;
+    pipe->complete = complete;
+    pipe->endpoint = endpoint;
+    pipe->toggle = 0;
+    pipe->max_packet = max_packet;
+    pipe->completed = 0;
+    pipe->errors = 0;
+    uhci_pipe_arm(hc, index);
+    
+    // Poll at the largest power of two not above the requested interval
+    int level = 0;
+    while (level + 1 < UHCI_SKEL_LEVELS && (2 << level) <= interval) level++;
+    
+    uhci_qh_t* qh = &hc->dma->pipe_qh[index];
+    uhci_qh_t* skel = &hc->dma->skel[level];
+    qh->head = skel->head;
+    asm volatile("" : : : "memory");
+    skel->head = uhci_phys(qh) | UHCI_LINK_QH;
+    
+    hc->pipe_count = index + 1;
+    return 0;
+}
+
+static const usb_hcd_ops_t uhci_ops = {
+    .name = "uhci",
+    .set_address = uhci_set_address,
+    .control = uhci_control,
+    .interrupt_in = uhci_interrupt_in,
+};
+
+// Bottom half: hand finished reports to their drivers and re-arm the TDs
+static void uhci_tasklet(uint64_t data) {
+    uhci_t* hc = (uhci_t*)data;
+    
+    for (int i = 0; i < hc->pipe_count; i++) {
+        uhci_pipe_t* pipe = &hc->pipes[i];
+        uint32_t status = hc->dma->pipe_td[i].status;
+        if (status & UHCI_TD_ACTIVE) continue;
+        
+        if (status & UHCI_TD_ERRORS) {
+            pipe->errors++;
+            // A stalled endpoint stays stalled; stop polling it
+            if (status & UHCI_TD_STALLED) continue;
+        } else {
+            int length = (status + 1) & UHCI_TD_ACTLEN_MASK;
+            pipe->toggle ^= 1;
+            pipe->completed++;
+            pipe->complete(pipe->dev, hc->dma->pipe_buf[i], length);
+        }
+        uhci_pipe_arm(hc, i);
+    }
+}
+
+static int uhci_irq_handler(void* ctx) {
+    uhci_t* hc = (uhci_t*)ctx;
+    uint16_t status = inw(hc->io + UHCI_USBSTS);
+    
+    // The PCI line may be shared
+    if (!(status & (UHCI_STS_USBINT | UHCI_STS_ERROR | UHCI_STS_HSE | UHCI_STS_HCPE))) {
+        return IRQ_NONE;
+    }
+    
+    outw(hc->io + UHCI_USBSTS, status & UHCI_STS_ALL);
+    hc->irqs++;
+    tasklet_schedule(&hc->tasklet);
+    return IRQ_HANDLED;
+}
+
+// Reset a port and enable it. Returns 1 if a device is ready behind it.
+static int uhci_port_reset(uhci_t* hc, int port) {
+    uint16_t reg = hc->io + UHCI_PORTSC(port);
+    
+    outw(reg, UHCI_PORT_PR);
+    udelay(50000);
+    outw(reg, 0);
+    udelay(10);
+    
+    for (int i = 0; i < 10; i++) {
+        uint16_t status = inw(reg);
+        if (!(status & UHCI_PORT_CCS)) return 0;
+        if (status & UHCI_PORT_PED) {
+            outw(reg, UHCI_PORT_PED | (status & UHCI_PORT_W1C));
+            return 1;
+        }
+        outw(reg, UHCI_PORT_PED | UHCI_PORT_W1C);
+        udelay(10000);
+    }
+    return 0;
+}
+
+static void uhci_scan_ports(uhci_t* hc) {
+    for (int port = 0; port < UHCI_PORTS; port++) {
+        if (!(inw(hc->io + UHCI_PORTSC(port)) & UHCI_PORT_CCS)) continue;
+        if (!uhci_port_reset(hc, port)) continue;
+        
+        usb_speed_t speed = (inw(hc->io + UHCI_PORTSC(port)) & UHCI_PORT_LSDA) ?
+                            USB_SPEED_LOW : USB_SPEED_FULL;
+        if (!usb_enumerate(&uhci_ops, hc, port, speed)) {
+            pr_warn("usb", "uhci port %d: enumeration failed", port + 1);
+        }
+    }
+}
+
+int uhci_init(void) {
+    struct pci_device* pci = NULL;
+    
+    while (uhci_count < UHCI_MAX_CONTROLLERS &&
+           (pci = pci_find_class(PCI_CLASS_SERIAL_BUS, PCI_SUBCLASS_USB, UHCI_PROG_IF, pci))) {
+        uint32_t bar = pci_read_config(pci->bus, pci->slot, pci->func, UHCI_PCI_BAR4);
+        if (!(bar & 1) || !(bar & 0xFFFC)) continue;
+        
+        uhci_t* hc = &uhci_controllers[uhci_count];
+        hc->pci = pci;
+        hc->io = bar & 0xFFFC;
+        hc->dma = &uhci_dma[uhci_count];
+        hc->pipe_count = 0;
+        tasklet_init(&hc->tasklet, uhci_tasklet, (uint64_t)(uintptr_t)hc);
+        
+        if (uhci_reset(hc) != 0) {
+            pr_warn("usb", "uhci %02x:%02x.%x: reset failed", pci->bus, pci->slot, pci->func);
+            continue;
+        }
+        uhci_count++;
+        
+        // The BIOS routed INTx to an ISA IRQ, which is already set up on
+        // the PIC or the IOAPIC (with the MADT's level/polarity)
+        if (pci->interrupt_line > 0 && pci->interrupt_line < 16 && pci->interrupt_line != 2) {
+            hc->vector = IRQ_TO_VECTOR(pci->interrupt_line);
+            irq_set_name(hc->vector, "uhci");
+            request_irq(hc->vector, uhci_irq_handler, hc);
+        } else {
+            pr_warn("usb", "uhci %02x:%02x.%x: no usable interrupt line", pci->bus, pci->slot, pci->func);
+        }
+        
+        uhci_scan_ports(hc);
+    }
+    return uhci_count;
+}
@@ -0,0 +1,103 @@
+#ifndef UHCI_H
+#define UHCI_H
+
+#include <stdint.h>
+
+#define UHCI_PROG_IF        0x00
+#define UHCI_MAX_CONTROLLERS 4
+#define UHCI_PORTS          2       // Root hub ports per controller
+#define UHCI_MAX_PIPES      4       // Interrupt endpoints per controller
+
+// PCI config
+#define UHCI_PCI_BAR4       0x20    // I/O register block
+#define UHCI_PCI_LEGSUP     0xC0    // Legacy support (keyboard emulation, PIRQ)
+#define UHCI_LEGSUP_RWC     0x8F00  // Write-1-to-clear status, SMIs off
+#define UHCI_LEGSUP_PIRQ    0x2000  // Route USB interrupts to PIRQD
+
+// I/O registers
+#define UHCI_USBCMD         0x00
+#define UHCI_USBSTS         0x02
+#define UHCI_USBINTR        0x04
+#define UHCI_FRNUM          0x06
+#define UHCI_FRBASEADD      0x08
+#define UHCI_SOFMOD         0x0C
+#define UHCI_PORTSC(n)      (0x10 + 2 * (n))
+
+#define UHCI_CMD_RS         (1 << 0)    // Run/stop
+#define UHCI_CMD_HCRESET    (1 << 1)
+#define UHCI_CMD_GRESET     (1 << 2)
+#define UHCI_CMD_CF         (1 << 6)    // Configured (software flag)
+#define UHCI_CMD_MAXP       (1 << 7)    // 64-byte full-speed bandwidth reclamation
+
+#define UHCI_STS_USBINT     (1 << 0)    // A TD with IOC completed
+#define UHCI_STS_ERROR      (1 << 1)
+#define UHCI_STS_HSE        (1 << 3)    // Host system error
+#define UHCI_STS_HCPE       (1 << 4)    // Schedule process error
+#define UHCI_STS_HALTED     (1 << 5)
+#define UHCI_STS_ALL        0x3F
+
+#define UHCI_INTR_TIMEOUT   (1 << 0)    // Timeout/CRC
+#define UHCI_INTR_IOC       (1 << 2)
+#define UHCI_INTR_SHORT     (1 << 3)
+
+#define UHCI_PORT_CCS       (1 << 0)    // Device connected
+#define UHCI_PORT_CSC       (1 << 1)    // Connect change (W1C)
+#define UHCI_PORT_PED       (1 << 2)    // Enabled
+#define UHCI_PORT_PEDC      (1 << 3)    // Enable change (W1C)
+#define UHCI_PORT_LSDA      (1 << 8)    // Low-speed device attached
+#define UHCI_PORT_PR        (1 << 9)    // Reset
+#define UHCI_PORT_W1C       (UHCI_PORT_CSC | UHCI_PORT_PEDC)
+
+// Link pointers (frame list, QH and TD links)
+#define UHCI_LINK_TERMINATE (1 << 0)
+#define UHCI_LINK_QH        (1 << 1)
+#define UHCI_LINK_DEPTH     (1 << 2)    // TD: follow this link before the next QH
+
+// TD control/status
+#define UHCI_TD_ACTLEN_MASK 0x7FF       // Bytes transferred minus one
+#define UHCI_TD_BITSTUFF    (1 << 17)
+#define UHCI_TD_CRC_TIMEOUT (1 << 18)
+#define UHCI_TD_NAK         (1 << 19)
+#define UHCI_TD_BABBLE      (1 << 20)
+#define UHCI_TD_BUFFER_ERR  (1 << 21)
+#define UHCI_TD_STALLED     (1 << 22)
+#define UHCI_TD_ACTIVE      (1 << 23)
+#define UHCI_TD_IOC         (1 << 24)
+#define UHCI_TD_LS          (1 << 26)   // Low-speed device
+#define UHCI_TD_CERR(n)     ((n) << 27) // Retries before an error stops the TD
+#define UHCI_TD_ERRORS      (UHCI_TD_BITSTUFF | UHCI_TD_CRC_TIMEOUT | UHCI_TD_BABBLE | \
+                             UHCI_TD_BUFFER_ERR | UHCI_TD_STALLED)
+
+// TD token
+#define UHCI_PID_SETUP      0x2D
+#define UHCI_PID_IN         0x69
+#define UHCI_PID_OUT        0xE1
+#define UHCI_TOKEN(pid, addr, ep, toggle, len)                                  \
+    ((uint32_t)(pid) | ((uint32_t)(addr) << 8) | ((uint32_t)(ep) << 15) |       \
+     ((uint32_t)(toggle) << 19) | ((uint32_t)(((len) - 1) & 0x7FF) << 21))
+
+#define UHCI_FRAMES         1024
+#define UHCI_SKEL_LEVELS    8           // Interrupt intervals 1, 2, 4 ... 128 ms
+
+// Transfer descriptor: 16 bytes the controller reads, padded to 32
+typedef struct {
+    volatile uint32_t link;
+    volatile uint32_t status;
+    volatile uint32_t token;
+    volatile uint32_t buffer;
+    uint32_t reserved[4];
+} __attribute__((aligned(32))) uhci_td_t;
+
+// Queue head: a horizontal link to the next QH and a vertical one to the
+// TDs still to run
+typedef struct {
+    volatile uint32_t head;
+    volatile uint32_t element;
+    uint32_t reserved[2];
+} __attribute__((aligned(16))) uhci_qh_t;
+
+// Find the UHCI controllers, reset them and enumerate the devices on their
+// root ports. Returns the number of controllers started.
+int uhci_init(void);
+
+#endif
@@ -1,86 +1,127 @@
-#include "drivers/bus/pci.h"
-#include "lib/io.h"
 #include "usb.h"
-#include "drivers/video/vga.h"
+#include "drivers/bus/ehci.h"
+#include "drivers/bus/uhci.h"
+#include "drivers/bus/xhci.h"
+#include "drivers/input/usb_hid.h"
+#include "kernel/printk.h"
+#include "kernel/tsc.h"
+#include "lib/string.h"
+#include <stddef.h>
 
-// Simplified USB implementation - focuses on getting keyboard/mouse working
-// This is a minimal implementation that polls USB devices
+static usb_device_t usb_devices[USB_MAX_DEVICES];
+static int usb_count = 0;
+static uint8_t next_address = 1;
 
-#define UHCI_PROG_IF 0x00  // UHCI controller
+// Configuration descriptors are parsed once, during enumeration
+static uint8_t config_buf[USB_CONFIG_MAX];
 
-static struct pci_device uhci_controller;
-static uint16_t uhci_base = 0;
-static int usb_initialized = 0;
-
-// USB keyboard scancodes to ASCII (simplified)
-static char usb_to_ascii[256] = {
-    0, 0, 0, 0, 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm',
-    'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z',
-    '1', '2', '3', '4', '5', '6', '7', '8', '9', '0',
-    '\n', 0, '\b', '\t', ' '
-};
+int usb_control(usb_device_t* dev, uint8_t request_type, uint8_t request, uint16_t value,
+                uint16_t index, uint16_t length, void* data) {
+    struct usb_device_request req;
+    req.request_type = request_type;
+    req.request = request;
+    req.value = value;
+    req.index = index;
+    req.length = length;
+    return dev->hcd->control(dev, &req, data);
+}
 
-// External keyboard/mouse state
-extern char terminal_buffer[];
-extern int term_idx;
-extern int mouse_x, mouse_y;
+int usb_get_descriptor(usb_device_t* dev, uint8_t type, uint8_t index, void* buf, uint16_t length) {
+    return usb_control(dev, USB_DIR_IN, USB_REQ_GET_DESCRIPTOR, ((uint16_t)type << 8) | index,
+                       0, length, buf);
+}
 
-void usb_init() {
-    vga_print("Scanning for USB controller...\n");
+// Offer each interface of the active configuration to the class drivers
+static void usb_bind_interfaces(usb_device_t* dev, uint16_t total) {
+    uint16_t pos = 0;
     
-    // Find UHCI controller
-    if (!pci_find_device(PCI_CLASS_SERIAL_BUS, PCI_SUBCLASS_USB, UHCI_PROG_IF, &uhci_controller)) {
-        vga_print("No UHCI controller found\n");
-        return;
+    while (pos + 2 <= total) {
+        uint8_t len = config_buf[pos];
+        if (len < 2 || pos + len > total) break;
+        
+        if (config_buf[pos + 1] == USB_DESC_INTERFACE && len >= sizeof(struct usb_interface_descriptor)) {
+            struct usb_interface_descriptor* iface = (struct usb_interface_descriptor*)&config_buf[pos];
+            if (iface->interface_class == USB_CLASS_HID && iface->alternate_setting == 0) {
+                usb_hid_probe(dev, iface, config_buf + pos + len, total - pos - len);
+            }
+        }
+        pos += len;
     }
+}
+
+usb_device_t* usb_enumerate(const usb_hcd_ops_t* hcd, void* hc, uint8_t port, usb_speed_t speed) {
+    if (usb_count >= USB_MAX_DEVICES) return NULL;
+    
+    usb_device_t* dev = &usb_devices[usb_count];
+    memset(dev, 0, sizeof(*dev));
+    dev->hcd = hcd;
+    dev->hc = hc;
+    dev->port = port;
+    dev->speed = speed;
+    
+    // The first 8 bytes hold bMaxPacketSize0, and fit any endpoint 0
+    dev->max_packet0 = 8;
+    if (usb_get_descriptor(dev, USB_DESC_DEVICE, 0, &dev->desc, 8) != 8) return NULL;
+    dev->max_packet0 = dev->desc.max_packet_size ? dev->desc.max_packet_size : 8;
     
-    vga_print("Found UHCI controller!\n");
-    uhci_base = uhci_controller.bar0;
+    // Addresses are never reused, even if a device fails further on
+    uint8_t address = next_address++;
+    if (address > 127 || hcd->set_address(dev, address) != 0) return NULL;
+    dev->address = address;
+    udelay(2000);   // SET_ADDRESS recovery interval
     
-    if (uhci_base == 0) {
-        vga_print("Invalid UHCI base address\n");
-        return;
+    if (usb_get_descriptor(dev, USB_DESC_DEVICE, 0, &dev->desc, sizeof(dev->desc)) !=
+        (int)sizeof(dev->desc)) {
+        return NULL;
     }
     
-    // Enable bus mastering
-    uint32_t command = pci_read_config(uhci_controller.bus, uhci_controller.slot, 0, 0x04);
-    command |= 0x05; // Bus master + I/O space
-    pci_write_config(uhci_controller.bus, uhci_controller.slot, 0, 0x04, command);
+    struct usb_config_descriptor config;
+    if (usb_get_descriptor(dev, USB_DESC_CONFIGURATION, 0, &config, sizeof(config)) !=
+        (int)sizeof(config)) {
+        return NULL;
+    }
+    uint16_t total = config.total_length < USB_CONFIG_MAX ? config.total_length : USB_CONFIG_MAX;
+    if (usb_get_descriptor(dev, USB_DESC_CONFIGURATION, 0, config_buf, total) != total) return NULL;
     
-    // Reset the controller
-    outw(uhci_base + 0, 0x0002); // GRESET
-    for (volatile int i = 0; i < 10000; i++); // Wait
-    outw(uhci_base + 0, 0x0000); // Clear reset
+    if (usb_control(dev, 0, USB_REQ_SET_CONFIGURATION, config.configuration_value, 0, 0, NULL) < 0) {
+        return NULL;
+    }
     
-    // Start the controller
-    outw(uhci_base + 0, 0x0001); // Run
+    usb_count++;
+    usb_bind_interfaces(dev, total);
     
-    usb_initialized = 1;
-    vga_print("USB initialized!\n");
+    pr_info("usb", "%s port %u: %04x:%04x, %s speed, address %u%s%s", hcd->name, port + 1,
+            dev->desc.vendor_id, dev->desc.product_id, usb_speed_name(speed), address,
+            dev->driver ? ", " : "", dev->driver ? dev->driver : "");
+    return dev;
 }
 
-// Simplified polling - reads from USB HID devices
-void usb_poll() {
-    if (!usb_initialized) return;
+void usb_init(void) {
+    // xHCI drives every speed on its own ports. EHCI goes before UHCI, so
+    // full/low-speed devices are on the companion ports by the time those
+    // are scanned.
+    int xhci = xhci_init();
+    int ehci = ehci_init();
+    int uhci = uhci_init();
     
-    // This is a VERY simplified implementation
-    // In reality, USB requires complex packet/transfer management
-    // For this demo, we'll use a polling approach that checks for data
-    
-    // Read status register
-    uint16_t status = inw(uhci_base + 2);
-    
-    // Check if there's any USB activity
-    if (status & 0x01) {
-        // Acknowledge interrupt
-        outw(uhci_base + 2, status);
-        
-        // Try to read data (this is highly simplified)
-        // In a real implementation, you'd traverse the frame list,
-        // check transfer descriptors, etc.
-        
-        // For now, we'll just simulate detecting keypresses
-        // This won't actually work without proper USB enumeration
-        // but it shows the structure
+    pr_info("usb", "%d xHCI, %d EHCI, %d UHCI controllers, %d devices", xhci, ehci, uhci, usb_count);
+}
+
+int usb_device_count(void) {
+    return usb_count;
+}
+
+usb_device_t* usb_get_device(int index) {
+    if (index < 0 || index >= usb_count) return NULL;
+    return &usb_devices[index];
+}
+
+const char* usb_speed_name(usb_speed_t speed) {
+    switch (speed) {
+    case USB_SPEED_LOW:   return "low";
+    case USB_SPEED_FULL:  return "full";
+    case USB_SPEED_HIGH:  return "high";
+    case USB_SPEED_SUPER: return "super";
+    default:              return "unknown";
     }
 }
@@ -4,16 +4,40 @@
 #include <stdint.h>
 
 // USB Request Types
+#define USB_REQ_CLEAR_FEATURE  0x01
 #define USB_REQ_GET_DESCRIPTOR 0x06
 #define USB_REQ_SET_ADDRESS    0x05
 #define USB_REQ_SET_CONFIGURATION 0x09
 
+// bmRequestType
+#define USB_DIR_IN             0x80
+#define USB_TYPE_CLASS         0x20
+#define USB_RECIP_INTERFACE    0x01
+#define USB_RECIP_ENDPOINT     0x02
+
+#define USB_FEATURE_ENDPOINT_HALT 0x00
+
 // Descriptor Types
 #define USB_DESC_DEVICE        0x01
 #define USB_DESC_CONFIGURATION 0x02
 #define USB_DESC_INTERFACE     0x04
 #define USB_DESC_ENDPOINT      0x05
 
+#define USB_ENDPOINT_IN        0x80
+#define USB_ENDPOINT_INTERRUPT 0x03    // bmAttributes transfer type
+
+#define USB_CLASS_HID          0x03
+
+#define USB_MAX_DEVICES        8
+#define USB_CONFIG_MAX         256     // Configuration descriptor bytes we read
+
+typedef enum {
+    USB_SPEED_LOW,
+    USB_SPEED_FULL,
+    USB_SPEED_HIGH,
+    USB_SPEED_SUPER,
+} usb_speed_t;
+
 // USB Device Request
 struct usb_device_request {
     uint8_t request_type;
@@ -53,8 +77,83 @@ struct usb_config_descriptor {
     uint8_t max_power;
 } __attribute__((packed));
 
-// USB declarations
-void usb_init();
-void usb_poll();
+struct usb_interface_descriptor {
+    uint8_t length;
+    uint8_t descriptor_type;
+    uint8_t interface_number;
+    uint8_t alternate_setting;
+    uint8_t num_endpoints;
+    uint8_t interface_class;
+    uint8_t interface_subclass;
+    uint8_t interface_protocol;
+    uint8_t interface_string;
+} __attribute__((packed));
+
+struct usb_endpoint_descriptor {
+    uint8_t length;
+    uint8_t descriptor_type;
+    uint8_t endpoint_address;
+    uint8_t attributes;
+    uint16_t max_packet_size;
+    uint8_t interval;
+} __attribute__((packed));
+
+struct usb_device;
+
+// Called from the controller's tasklet with each completed interrupt IN
+// transfer
+typedef void (*usb_complete_t)(struct usb_device* dev, const uint8_t* data, int length);
+
+// What a host controller driver provides to the core
+typedef struct usb_hcd_ops {
+    const char* name;
+
+    // Move the default-address device to `address` (SET_ADDRESS on
+    // UHCI, Address Device on xHCI). Returns 0 on success.
+    int (*set_address)(struct usb_device* dev, uint8_t address);
+
+    // Synchronous control transfer; data is read or written depending on
+    // the request direction. Returns the bytes transferred or -1.
+    int (*control)(struct usb_device* dev, const struct usb_device_request* req, void* data);
+
+    // Start polling an interrupt IN endpoint every `interval` ms.
+    // Returns 0 on success.
+    int (*interrupt_in)(struct usb_device* dev, uint8_t endpoint, uint16_t max_packet,
+                        uint8_t interval, usb_complete_t complete);
+} usb_hcd_ops_t;
+
+typedef struct usb_device {
+    const usb_hcd_ops_t* hcd;
+    void* hc;                   // Controller private state
+    uint8_t port;               // Root hub port (0-based)
+    uint8_t address;
+    usb_speed_t speed;
+    uint16_t max_packet0;       // Endpoint 0 packet size
+    struct usb_device_descriptor desc;
+
+    // Set by the class driver that claimed the device
+    const char* driver;
+    void* driver_data;
+} usb_device_t;
+
+// Reset and configure the host controllers (xHCI; EHCI hands every port
+// to its UHCI companions), enumerate the devices on their root ports and start
+// the HID drivers. Run with interrupts enabled, after pci_init.
+void usb_init(void);
+
+// Enumerate a freshly reset device at address 0 on a controller's root
+// port: read its descriptors, assign an address, configure it and bind a
+// class driver. Returns the device or NULL.
+usb_device_t* usb_enumerate(const usb_hcd_ops_t* hcd, void* hc, uint8_t port, usb_speed_t speed);
+
+// Convenience wrappers around hcd->control
+int usb_control(usb_device_t* dev, uint8_t request_type, uint8_t request, uint16_t value,
+                uint16_t index, uint16_t length, void* data);
+int usb_get_descriptor(usb_device_t* dev, uint8_t type, uint8_t index, void* buf, uint16_t length);
+
+int usb_device_count(void);
+usb_device_t* usb_get_device(int index);
+
+const char* usb_speed_name(usb_speed_t speed);
 
 #endif
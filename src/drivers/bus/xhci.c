@@ -0,0 +1,850 @@
+#include "xhci.h"
+#include "drivers/bus/pci.h"
+#include "drivers/bus/usb.h"
+#include "kernel/cmdline.h"
+#include "kernel/irq.h"
+#include "kernel/lapic.h"
+#include "kernel/printk.h"
+#include "kernel/softirq.h"
+#include "kernel/spinlock.h"
+#include "kernel/tsc.h"
+#include "kernel/workqueue.h"
+#include "lib/string.h"
+#include "mm/heap.h"
+#include "mm/vmm.h"
+#include <stddef.h>
+
+#define XHCI_RING_TRBS      32      // Per command/transfer ring; the last is the link
+#define XHCI_EVENT_TRBS     64
+#define XHCI_PIPE_INFLIGHT  4       // Transfers kept queued on each interrupt endpoint
+#define XHCI_PIPE_BUF       64      // Largest full-speed interrupt packet
+#define XHCI_MAX_DEVICES    USB_MAX_DEVICES
+#define XHCI_CTX_MAX        64      // Largest context size
+#define XHCI_IMOD_MAX_US    16383   // 16-bit interval in 250 ns units
+#define XHCI_TIMEOUT_US     500000  // Commands and control transfers
+#define XHCI_PAGE_SIZE      4096
+#define XHCI_PIPE_MAX_RESETS 3      // Halts in a row before a pipe is given up
+
+// Controller-wide structures the xHC reads or writes. The kernel is
+// identity mapped below 4GB, so addresses in here are also the bus
+// addresses. Nothing crosses a 64KB boundary.
+typedef struct {
+    xhci_trb_t event_ring[XHCI_EVENT_TRBS];
+    xhci_trb_t cmd_ring[XHCI_RING_TRBS];
+    xhci_erst_t erst[1];
+    uint64_t dcbaa[XHCI_MAX_SLOTS + 1] __attribute__((aligned(64)));
+} __attribute__((aligned(4096))) xhci_dma_t;
+
+// One device's contexts, rings and buffers
+typedef struct {
+    xhci_trb_t ep0_ring[XHCI_RING_TRBS];
+    xhci_trb_t pipe_ring[XHCI_DEV_PIPES][XHCI_RING_TRBS];
+    uint8_t out_ctx[32 * XHCI_CTX_MAX] __attribute__((aligned(64)));
+    uint8_t in_ctx[33 * XHCI_CTX_MAX] __attribute__((aligned(64)));
+    uint8_t control_buf[USB_CONFIG_MAX] __attribute__((aligned(64)));
+    uint8_t pipe_buf[XHCI_DEV_PIPES][XHCI_PIPE_INFLIGHT][XHCI_PIPE_BUF];
+} __attribute__((aligned(4096))) xhci_dev_dma_t;
+
+// Producer side of a command or transfer ring
+typedef struct {
+    xhci_trb_t* trbs;
+    uint32_t enqueue;
+    uint32_t cycle;             // Cycle bit that hands a TRB to the xHC
+} xhci_ring_t;
+
+// One interrupt IN endpoint with XHCI_PIPE_INFLIGHT transfers queued, so
+// a report arriving while the last one is delivered still has a buffer
+typedef struct {
+    usb_device_t* dev;
+    usb_complete_t complete;
+    uint8_t dci;                // Device context index
+    uint16_t max_packet;
+    xhci_ring_t ring;
+    uint32_t completed;
+    uint32_t errors;
+    uint32_t resets;            // Halts since the last good transfer
+    int stopped;
+    volatile int halted;        // Waiting for xhci_recover_work
+} xhci_pipe_t;
+
+struct xhci;
+
+typedef struct {
+    struct xhci* hc;
+    uint8_t id;
+    uint8_t port;
+    uint8_t speed;              // PORTSC speed ID
+    uint8_t context_entries;
+    xhci_dev_dma_t* dma;
+    xhci_ring_t ep0;
+    xhci_pipe_t pipes[XHCI_DEV_PIPES];
+    int pipe_count;
+    
+    // Control transfer in flight, completed by the event handler
+    volatile int control_done;
+    uint32_t control_code;
+    uint32_t data_residual;
+    uint64_t data_trb;
+    uint64_t status_trb;
+} xhci_slot_t;
+
+typedef struct xhci {
+    struct pci_device* pci;
+    volatile uint8_t* caps;
+    volatile uint8_t* ops;
+    volatile uint8_t* ir;       // Interrupter 0
+    volatile uint32_t* db;
+    uint32_t ctx_size;
+    uint8_t max_slots;
+    uint8_t ports;
+    const char* irq_mode;
+    uint8_t vector;
+    xhci_dma_t* dma;
+    xhci_ring_t cmd;
+    uint32_t event_dequeue;
+    uint32_t event_cycle;
+    spinlock_t lock;            // Event ring consumer
+    tasklet_t tasklet;
+    
+    // Command in flight (one at a time)
+    volatile int cmd_done;
+    uint32_t cmd_code;
+    uint8_t cmd_slot;
+    
+    xhci_slot_t* slots[XHCI_MAX_SLOTS + 1];     // By slot ID
+    xhci_slot_t* port_slot[XHCI_MAX_PORTS];     // By root port
+    int slot_count;
+    uint64_t irqs;
+    uint64_t events;
+} xhci_t;
+
+static xhci_dma_t xhci_dma[XHCI_MAX_CONTROLLERS];
+static xhci_t xhci_controllers[XHCI_MAX_CONTROLLERS];
+static int controller_count = 0;
+
+static xhci_dev_dma_t xhci_dev_dma[XHCI_MAX_DEVICES];
+static xhci_slot_t xhci_slots[XHCI_MAX_DEVICES];
+static int slots_used = 0;
+
+static uint32_t imod_us = XHCI_IMOD_DEFAULT_US;
+
+// Clearing a halted pipe takes commands, which can't be waited for from
+// the tasklet
+static work_t xhci_recover_work;
+
+static inline uint32_t xhci_read(volatile uint8_t* base, uint32_t reg) {
+    return *(volatile uint32_t*)(base + reg);
+}
+
+static inline void xhci_write(volatile uint8_t* base, uint32_t reg, uint32_t value) {
+    *(volatile uint32_t*)(base + reg) = value;
+}
+
+// 64-bit registers as two dword writes, low half first
+static inline void xhci_write64(volatile uint8_t* base, uint32_t reg, uint64_t value) {
+    xhci_write(base, reg, (uint32_t)value);
+    xhci_write(base, reg + 4, (uint32_t)(value >> 32));
+}
+
+static inline uint64_t xhci_phys(volatile void* ptr) {
+    return (uint64_t)(uintptr_t)ptr;
+}
+
+static void xhci_ring_init(xhci_ring_t* ring, xhci_trb_t* trbs) {
+    memset(trbs, 0, XHCI_RING_TRBS * sizeof(xhci_trb_t));
+    trbs[XHCI_RING_TRBS - 1].param = xhci_phys(trbs);
+    ring->trbs = trbs;
+    ring->enqueue = 0;
+    ring->cycle = 1;
+}
+
+// Queue one TRB. The control word (with the cycle bit) goes in last, so
+// the xHC never sees a half-written entry.
+static xhci_trb_t* xhci_ring_push(xhci_ring_t* ring, uint64_t param, uint32_t status,
+                                  uint32_t control) {
+    xhci_trb_t* trb = &ring->trbs[ring->enqueue];
+    trb->param = param;
+    trb->status = status;
+    barrier();
+    trb->control = control | ring->cycle;
+    
+    if (++ring->enqueue == XHCI_RING_TRBS - 1) {
+        // Hand over the link too, chained if the TD continues past it
+        xhci_trb_t* link = &ring->trbs[XHCI_RING_TRBS - 1];
+        link->control = XHCI_TRB_TYPE(XHCI_TRB_LINK) | XHCI_TRB_TC | (control & XHCI_TRB_CH) |
+                        ring->cycle;
+        ring->enqueue = 0;
+        ring->cycle ^= 1;
+    }
+    return trb;
+}
+
+static inline volatile uint32_t* xhci_ctx(xhci_t* hc, uint8_t* base, int index) {
+    return (volatile uint32_t*)(base + index * hc->ctx_size);
+}
+
+static usb_speed_t xhci_usb_speed(uint8_t speed) {
+    switch (speed) {
+    case XHCI_SPEED_LOW:  return USB_SPEED_LOW;
+    case XHCI_SPEED_FULL: return USB_SPEED_FULL;
+    case XHCI_SPEED_HIGH: return USB_SPEED_HIGH;
+    default:              return USB_SPEED_SUPER;
+    }
+}
+
+// Completion codes that leave the endpoint Halted
+static int xhci_halts(uint32_t code) {
+    return code == XHCI_CC_STALL || code == XHCI_CC_BABBLE || code == XHCI_CC_TRANSACTION;
+}
+
+// Deliver a finished interrupt transfer and queue its buffer again
+static void xhci_pipe_complete(xhci_slot_t* slot, xhci_pipe_t* pipe, xhci_trb_t* event) {
+    uint32_t code = XHCI_EVENT_CODE(event->status);
+    xhci_trb_t* trb = (xhci_trb_t*)(uintptr_t)event->param;
+    uint64_t buffer = trb->param;
+    
+    if (code != XHCI_CC_SUCCESS && code != XHCI_CC_SHORT_PACKET) {
+        // Stop polling; a halted endpoint gets reset from process context
+        pipe->errors++;
+        pipe->stopped = 1;
+        if (xhci_halts(code) && pipe->resets < XHCI_PIPE_MAX_RESETS) {
+            pipe->halted = 1;
+            schedule_work(&xhci_recover_work);
+        }
+        return;
+    }
+    
+    int length = pipe->max_packet - (int)XHCI_EVENT_LENGTH(event->status);
+    pipe->completed++;
+    pipe->resets = 0;
+    pipe->complete(pipe->dev, (const uint8_t*)(uintptr_t)buffer, length < 0 ? 0 : length);
+    
+    xhci_ring_push(&pipe->ring, buffer, pipe->max_packet,
+                   XHCI_TRB_TYPE(XHCI_TRB_NORMAL) | XHCI_TRB_ISP | XHCI_TRB_IOC);
+    slot->hc->db[slot->id] = pipe->dci;
+}
+
+static void xhci_transfer_event(xhci_t* hc, xhci_trb_t* event) {
+    uint32_t control = event->control;
+    uint8_t id = XHCI_TRB_GET_SLOT(control);
+    uint8_t dci = XHCI_TRB_GET_EP(control);
+    if (id == 0 || id > hc->max_slots || !hc->slots[id]) return;
+    
+    xhci_slot_t* slot = hc->slots[id];
+    if (dci == 1) {
+        // Data stage events carry the residual; the status stage (or any
+        // failure) ends the transfer
+        uint32_t code = XHCI_EVENT_CODE(event->status);
+        if (event->param == slot->data_trb) slot->data_residual = XHCI_EVENT_LENGTH(event->status);
+        if (event->param == slot->status_trb ||
+            (code != XHCI_CC_SUCCESS && code != XHCI_CC_SHORT_PACKET)) {
+            slot->control_code = code;
+            slot->control_done = 1;
+        }
+        return;
+    }
+    
+    for (int i = 0; i < slot->pipe_count; i++) {
+        if (slot->pipes[i].dci == dci && !slot->pipes[i].stopped) {
+            xhci_pipe_complete(slot, &slot->pipes[i], event);
+        }
+    }
+}
+
+// Consume the event ring up to the first TRB the xHC still owns. Called
+// with hc->lock held, from the tasklet and from synchronous waits.
+static void xhci_process_events(xhci_t* hc) {
+    xhci_trb_t* ring = hc->dma->event_ring;
+    
+    for (;;) {
+        xhci_trb_t* event = &ring[hc->event_dequeue];
+        uint32_t control = event->control;
+        if ((control & XHCI_TRB_CYCLE) != hc->event_cycle) break;
+        
+        switch (XHCI_TRB_GET_TYPE(control)) {
+        case XHCI_TRB_TRANSFER_EVENT:
+            xhci_transfer_event(hc, event);
+            break;
+        case XHCI_TRB_COMMAND_EVENT:
+            hc->cmd_code = XHCI_EVENT_CODE(event->status);
+            hc->cmd_slot = XHCI_TRB_GET_SLOT(control);
+            hc->cmd_done = 1;
+            break;
+        default:
+            // Port status changes: no hotplug, ports are scanned once
+            break;
+        }
+        
+        hc->events++;
+        if (++hc->event_dequeue == XHCI_EVENT_TRBS) {
+            hc->event_dequeue = 0;
+            hc->event_cycle ^= 1;
+        }
+    }
+    xhci_write64(hc->ir, XHCI_ERDP, xhci_phys(&ring[hc->event_dequeue]) | XHCI_ERDP_EHB);
+}
+
+// Poll the event ring until *done is set, handling whatever else comes
+// in on the way. Works with interrupts off as well as on.
+static int xhci_wait(xhci_t* hc, volatile int* done) {
+    for (int waited = 0; waited < XHCI_TIMEOUT_US; waited += 10) {
+        uint64_t flags = spin_lock_irqsave(&hc->lock);
+        xhci_process_events(hc);
+        spin_unlock_irqrestore(&hc->lock, flags);
+        if (*done) return 0;
+        udelay(10);
+    }
+    return -1;
+}
+
+static int xhci_command(xhci_t* hc, uint64_t param, uint32_t control) {
+    hc->cmd_done = 0;
+    xhci_ring_push(&hc->cmd, param, 0, control);
+    barrier();
+    hc->db[0] = 0;
+    
+    if (xhci_wait(hc, &hc->cmd_done) != 0) return -1;
+    return hc->cmd_code == XHCI_CC_SUCCESS ? 0 : -1;
+}
+
+// Take a halted endpoint back to Running: Reset Endpoint leaves it
+// Stopped, then its dequeue pointer moves to the enqueue position so the
+// TRBs the xHC abandoned are skipped. The next doorbell restarts it.
+static int xhci_reset_endpoint(xhci_slot_t* slot, uint8_t dci, xhci_ring_t* ring) {
+    xhci_t* hc = slot->hc;
+    uint32_t target = XHCI_TRB_SLOT(slot->id) | XHCI_TRB_EP(dci);
+    
+    if (xhci_command(hc, 0, XHCI_TRB_TYPE(XHCI_TRB_RESET_ENDPOINT) | target) != 0) return -1;
+    
+    uint64_t dequeue = xhci_phys(&ring->trbs[ring->enqueue]) | ring->cycle;
+    return xhci_command(hc, dequeue, XHCI_TRB_TYPE(XHCI_TRB_SET_TR_DEQUEUE) | target);
+}
+
+// Input context with the slot context filled in and nothing else added
+static uint8_t* xhci_input_ctx(xhci_slot_t* slot, uint32_t add) {
+    xhci_t* hc = slot->hc;
+    uint8_t* in = slot->dma->in_ctx;
+    memset(in, 0, sizeof(slot->dma->in_ctx));
+    
+    xhci_ctx(hc, in, 0)[1] = add;
+    volatile uint32_t* sc = xhci_ctx(hc, in, 1);
+    sc[0] = XHCI_SLOT_SPEED(slot->speed) | XHCI_SLOT_ENTRIES(slot->context_entries);
+    sc[1] = XHCI_SLOT_PORT(slot->port + 1);
+    return in;
+}
+
+// Address Device. With `block` the xHC only sets up the slot and endpoint
+// 0 (Default state, device still at address 0); without, it also sends
+// SET_ADDRESS.
+static int xhci_address_device(xhci_slot_t* slot, uint16_t max_packet0, int block) {
+    xhci_t* hc = slot->hc;
+    uint8_t* in = xhci_input_ctx(slot, 0x3);    // Slot and endpoint 0
+    
+    // Endpoint 0 picks up where the ring is now
+    uint64_t dequeue = xhci_phys(&slot->ep0.trbs[slot->ep0.enqueue]) | slot->ep0.cycle;
+    volatile uint32_t* ep = xhci_ctx(hc, in, 2);
+    ep[1] = XHCI_EP_CERR(3) | XHCI_EP_TYPE(XHCI_EP_CONTROL) | XHCI_EP_MPS(max_packet0);
+    ep[2] = (uint32_t)dequeue;
+    ep[3] = (uint32_t)(dequeue >> 32);
+    ep[4] = 8;      // Average TRB length
+    
+    return xhci_command(hc, xhci_phys(in), XHCI_TRB_TYPE(XHCI_TRB_ADDRESS_DEVICE) |
+                        XHCI_TRB_SLOT(slot->id) | (block ? XHCI_TRB_BSR : 0));
+}
+
+static int xhci_control(usb_device_t* dev, const struct usb_device_request* req, void* data) {
+    xhci_t* hc = (xhci_t*)dev->hc;
+    xhci_slot_t* slot = hc->port_slot[dev->port];
+    uint16_t length = req->length;
+    int in = (req->request_type & USB_DIR_IN) != 0;
+    
+    if (!slot || length > USB_CONFIG_MAX) return -1;
+    
+    uint64_t setup;
+    memcpy(&setup, req, sizeof(setup));
+    if (!in && length) memcpy(slot->dma->control_buf, data, length);
+    
+    // SETUP with the request inline, one DATA TRB for the whole buffer,
+    // then STATUS in the other direction. The xHC splits the data into
+    // packets itself.
+    uint32_t trt = !length ? XHCI_TRT_NONE : in ? XHCI_TRT_IN : XHCI_TRT_OUT;
+    slot->control_done = 0;
+    slot->data_residual = 0;
+    slot->data_trb = 0;
+    xhci_ring_push(&slot->ep0, setup, 8, XHCI_TRB_TYPE(XHCI_TRB_SETUP) | XHCI_TRB_IDT | trt);
+    if (length) {
+        xhci_trb_t* trb = xhci_ring_push(&slot->ep0, xhci_phys(slot->dma->control_buf), length,
+                                         XHCI_TRB_TYPE(XHCI_TRB_DATA) | XHCI_TRB_ISP | XHCI_TRB_IOC |
+                                         (in ? XHCI_TRB_DIR_IN : 0));
+        slot->data_trb = xhci_phys(trb);
+    }
+    xhci_trb_t* status = xhci_ring_push(&slot->ep0, 0, 0, XHCI_TRB_TYPE(XHCI_TRB_STATUS) |
+                                        XHCI_TRB_IOC | (in && length ? 0 : XHCI_TRB_DIR_IN));
+    slot->status_trb = xhci_phys(status);
+    barrier();
+    hc->db[slot->id] = 1;
+    
+    if (xhci_wait(hc, &slot->control_done) != 0) return -1;
+    if (slot->control_code != XHCI_CC_SUCCESS) {
+        // A STALL is the device refusing the request; endpoint 0 still has
+        // to come out of Halted for the next one
+        if (xhci_halts(slot->control_code) && xhci_reset_endpoint(slot, 1, &slot->ep0) != 0) {
+            pr_warn("usb", "xhci slot %u: endpoint 0 reset failed", slot->id);
+        }
+        return -1;
+    }
+    
+    int actual = length - (int)slot->data_residual;
+    if (actual < 0) actual = 0;
+    if (in) memcpy(data, slot->dma->control_buf, actual);
+    return actual;
+}
+
+static int xhci_set_address(usb_device_t* dev, uint8_t address) {
+    xhci_t* hc = (xhci_t*)dev->hc;
+    xhci_slot_t* slot = hc->port_slot[dev->port];
+    if (!slot) return -1;
+    
+    // The xHC chooses the bus address itself; `address` only names the
+    // device in the core. SuperSpeed bMaxPacketSize0 is an exponent.
+    (void)address;
+    uint16_t max_packet0 = dev->max_packet0;
+    if (dev->speed == USB_SPEED_SUPER) {
+        max_packet0 = dev->max_packet0 <= 9 ? 1 << dev->max_packet0 : 512;
+    }
+    return xhci_address_device(slot, max_packet0, 0);
+}
+
+// Queue every buffer of a pipe and ring its doorbell
+static void xhci_pipe_queue(xhci_slot_t* slot, int index) {
+    xhci_pipe_t* pipe = &slot->pipes[index];
+    for (int i = 0; i < XHCI_PIPE_INFLIGHT; i++) {
+        xhci_ring_push(&pipe->ring, xhci_phys(slot->dma->pipe_buf[index][i]), pipe->max_packet,
+                       XHCI_TRB_TYPE(XHCI_TRB_NORMAL) | XHCI_TRB_ISP | XHCI_TRB_IOC);
+    }
+    barrier();
+    slot->hc->db[slot->id] = pipe->dci;
+}
+
+static int xhci_interrupt_in(usb_device_t* dev, uint8_t endpoint, uint16_t max_packet,
+                             uint8_t interval, usb_complete_t complete) {
+    xhci_t* hc = (xhci_t*)dev->hc;
+    xhci_slot_t* slot = hc->port_slot[dev->port];
+    if (!slot || slot->pipe_count >= XHCI_DEV_PIPES || max_packet == 0 ||
+        max_packet > XHCI_PIPE_BUF) {
+        return -1;
+    }
+    
+    int index = slot->pipe_count;
+    xhci_pipe_t* pipe = &slot->pipes[index];
+    pipe->dev = dev;
+    pipe->complete = complete;
+    pipe->dci = (endpoint & 0xF) * 2 + 1;
+    pipe->max_packet = max_packet;
+    pipe->completed = 0;
+    pipe->errors = 0;
+    pipe->resets = 0;
+    pipe->stopped = 0;
+    pipe->halted = 0;
+    xhci_ring_init(&pipe->ring, slot->dma->pipe_ring[index]);
+    
+    // The period is 2^n x 125 us. Below high speed bInterval is in frames
+    // (use the largest period not above it); from high speed up it is
+    // already n + 1.
+    uint32_t exponent;
+    if (dev->speed == USB_SPEED_HIGH || dev->speed == USB_SPEED_SUPER) {
+        exponent = interval ? interval - 1 : 0;
+        if (exponent > 15) exponent = 15;
+    } else {
+        exponent = 31 - __builtin_clz((interval ? interval : 1) * 8u);
+        if (exponent > 10) exponent = 10;
+    }
+    
+    if (pipe->dci > slot->context_entries) slot->context_entries = pipe->dci;
+    uint8_t* in = xhci_input_ctx(slot, 1 | (1u << pipe->dci));
+    uint64_t dequeue = xhci_phys(pipe->ring.trbs) | pipe->ring.cycle;
+    volatile uint32_t* ep = xhci_ctx(hc, in, 1 + pipe->dci);
+    ep[0] = XHCI_EP_INTERVAL(exponent);
+    ep[1] = XHCI_EP_CERR(3) | XHCI_EP_TYPE(XHCI_EP_INTERRUPT_IN) | XHCI_EP_MPS(max_packet);
+    ep[2] = (uint32_t)dequeue;
+    ep[3] = (uint32_t)(dequeue >> 32);
+    ep[4] = XHCI_EP_ESIT(max_packet) | max_packet;
+    
+    if (xhci_command(hc, xhci_phys(in), XHCI_TRB_TYPE(XHCI_TRB_CONFIGURE_EP) |
+                     XHCI_TRB_SLOT(slot->id)) != 0) {
+        return -1;
+    }
+    
+    // Nothing completes before the doorbell, so no lock is needed yet
+    slot->pipe_count = index + 1;
+    xhci_pipe_queue(slot, index);
+    return 0;
+}
+
+static const usb_hcd_ops_t xhci_ops = {
+    .name = "xhci",
+    .set_address = xhci_set_address,
+    .control = xhci_control,
+    .interrupt_in = xhci_interrupt_in,
+};
+
+// Bring halted interrupt pipes back. Once the xHC endpoint is reset the
+// device gets CLEAR_FEATURE(ENDPOINT_HALT), which clears a STALL and its
+// data toggle. The failed transfer's buffer was never requeued and the
+// dequeue move drops the rest, so every buffer is queued again.
+static void xhci_recover(work_t* work) {
+    (void)work;
+    
+    for (int c = 0; c < controller_count; c++) {
+        xhci_t* hc = &xhci_controllers[c];
+        for (int id = 1; id <= hc->max_slots; id++) {
+            xhci_slot_t* slot = hc->slots[id];
+            if (!slot) continue;
+            
+            for (int i = 0; i < slot->pipe_count; i++) {
+                xhci_pipe_t* pipe = &slot->pipes[i];
+                if (!pipe->halted) continue;
+                
+                pipe->halted = 0;
+                pipe->resets++;
+                
+                struct usb_device_request req = {
+                    USB_RECIP_ENDPOINT, USB_REQ_CLEAR_FEATURE, USB_FEATURE_ENDPOINT_HALT,
+                    (uint16_t)(USB_ENDPOINT_IN | (pipe->dci / 2)), 0
+                };
+                if (xhci_reset_endpoint(slot, pipe->dci, &pipe->ring) != 0 ||
+                    xhci_control(pipe->dev, &req, NULL) < 0) {
+                    pr_warn("usb", "xhci slot %u: endpoint %u reset failed", slot->id, pipe->dci / 2);
+                    continue;
+                }
+                
+                uint64_t flags = spin_lock_irqsave(&hc->lock);
+                pipe->stopped = 0;
+                xhci_pipe_queue(slot, i);
+                spin_unlock_irqrestore(&hc->lock, flags);
+            }
+        }
+    }
+}
+
+// Bottom half: drain the event ring, which completes the HID reports
+static void xhci_tasklet(uint64_t data) {
+    xhci_t* hc = (xhci_t*)data;
+    
+    uint64_t flags = spin_lock_irqsave(&hc->lock);
+    xhci_process_events(hc);
+    spin_unlock_irqrestore(&hc->lock, flags);
+}
+
+static int xhci_irq_handler(void* ctx) {
+    xhci_t* hc = (xhci_t*)ctx;
+    uint32_t status = xhci_read(hc->ops, XHCI_USBSTS);
+    
+    // INTx may be shared
+    if (!(status & (XHCI_STS_EINT | XHCI_STS_HSE))) return IRQ_NONE;
+    
+    xhci_write(hc->ops, XHCI_USBSTS, status & (XHCI_STS_EINT | XHCI_STS_HSE | XHCI_STS_PCD));
+    xhci_write(hc->ir, XHCI_IMAN, XHCI_IMAN_IE | XHCI_IMAN_IP);
+    hc->irqs++;
+    tasklet_schedule(&hc->tasklet);
+    return IRQ_HANDLED;
+}
+
+// Ask the BIOS to give up the controller and turn its SMIs off
+static void xhci_bios_handoff(xhci_t* hc) {
+    uint32_t offset = XHCI_HCC1_XECP(xhci_read(hc->caps, XHCI_HCCPARAMS1)) * 4;
+    
+    // Bounded walk of the extended capability list
+    for (int i = 0; i < 32 && offset; i++) {
+        volatile uint8_t* cap = hc->caps + offset;
+        uint32_t header = xhci_read(cap, 0);
+        if ((header & 0xFF) == XHCI_EXT_LEGSUP) {
+            xhci_write(cap, 0, header | XHCI_LEGSUP_OS);
+            for (int ms = 0; ms < 1000 && (xhci_read(cap, 0) & XHCI_LEGSUP_BIOS); ms++) {
+                udelay(1000);
+            }
+            xhci_write(cap, 4, XHCI_LEGCTL_SMI_W1C);
+            return;
+        }
+        uint32_t next = (header >> 8) & 0xFF;
+        if (!next) return;
+        offset += next * 4;
+    }
+}
+
+// Scratchpad pages the xHC keeps its own state in (QEMU asks for none)
+static int xhci_scratchpads(xhci_t* hc) {
+    uint32_t count = XHCI_HCS2_SCRATCHPADS(xhci_read(hc->caps, XHCI_HCSPARAMS2));
+    if (!count) return 0;
+    
+    // Page array first, then the pages; the heap is identity mapped
+    uint8_t* mem = (uint8_t*)malloc((count + 1) * XHCI_PAGE_SIZE + XHCI_PAGE_SIZE - 1);
+    if (!mem) return -1;
+    mem = (uint8_t*)(((uintptr_t)mem + XHCI_PAGE_SIZE - 1) & ~(uintptr_t)(XHCI_PAGE_SIZE - 1));
+    memset(mem, 0, (count + 1) * XHCI_PAGE_SIZE);
+    
+    uint64_t* array = (uint64_t*)mem;
+    for (uint32_t i = 0; i < count; i++) {
+        array[i] = xhci_phys(mem + (i + 1) * XHCI_PAGE_SIZE);
+    }
+    hc->dma->dcbaa[0] = xhci_phys(array);
+    return 0;
+}
+
+// Reset, then hand the xHC its slot table, command ring and event ring
+// and start it (interrupts are enabled later, once a vector is set up)
+static int xhci_reset(xhci_t* hc) {
+    xhci_write(hc->ops, XHCI_USBCMD, xhci_read(hc->ops, XHCI_USBCMD) & ~XHCI_CMD_RS);
+    for (int i = 0; i < 200 && !(xhci_read(hc->ops, XHCI_USBSTS) & XHCI_STS_HCH); i++) {
+        udelay(100);
+    }
+    
+    xhci_write(hc->ops, XHCI_USBCMD, XHCI_CMD_HCRST);
+    for (int ms = 0; ms < 1000; ms++) {
+        if (!(xhci_read(hc->ops, XHCI_USBCMD) & XHCI_CMD_HCRST) &&
+            !(xhci_read(hc->ops, XHCI_USBSTS) & XHCI_STS_CNR)) {
+            break;
+        }
+        udelay(1000);
+    }
+    if ((xhci_read(hc->ops, XHCI_USBCMD) & XHCI_CMD_HCRST) ||
+        (xhci_read(hc->ops, XHCI_USBSTS) & XHCI_STS_CNR)) {
+        return -1;
+    }
+    if (!(xhci_read(hc->ops, XHCI_PAGESIZE) & 1)) return -1;   // 4KB pages only
+    
+    xhci_dma_t* dma = hc->dma;
+    memset(dma, 0, sizeof(*dma));
+    if (xhci_scratchpads(hc) != 0) return -1;
+    
+    xhci_write(hc->ops, XHCI_CONFIG, hc->max_slots);
+    xhci_write64(hc->ops, XHCI_DCBAAP, xhci_phys(dma->dcbaa));
+    
+    xhci_ring_init(&hc->cmd, dma->cmd_ring);
+    xhci_write64(hc->ops, XHCI_CRCR, xhci_phys(dma->cmd_ring) | XHCI_CRCR_RCS);
+    
+    // One event ring segment; ERSTBA goes last, it enables the ring
+    dma->erst[0].base = xhci_phys(dma->event_ring);
+    dma->erst[0].size = XHCI_EVENT_TRBS;
+    hc->event_dequeue = 0;
+    hc->event_cycle = 1;
+    xhci_write(hc->ir, XHCI_ERSTSZ, 1);
+    xhci_write64(hc->ir, XHCI_ERDP, xhci_phys(dma->event_ring));
+    xhci_write64(hc->ir, XHCI_ERSTBA, xhci_phys(dma->erst));
+    xhci_write(hc->ir, XHCI_IMOD, imod_us * 4);
+    
+    xhci_write(hc->ops, XHCI_USBSTS, XHCI_STS_EINT | XHCI_STS_HSE | XHCI_STS_PCD);
+    xhci_write(hc->ops, XHCI_USBCMD, XHCI_CMD_RS);
+    for (int i = 0; i < 100 && (xhci_read(hc->ops, XHCI_USBSTS) & XHCI_STS_HCH); i++) {
+        udelay(100);
+    }
+    return (xhci_read(hc->ops, XHCI_USBSTS) & XHCI_STS_HCH) ? -1 : 0;
+}
+
+// MSI-X, then MSI, then the BIOS-routed INTx line. Without any of them
+// only the synchronous waits drain the event ring, so HID is dead.
+static void xhci_setup_irq(xhci_t* hc) {
+    struct pci_device* pci = hc->pci;
+    hc->irq_mode = "polled";
+    
+    if (lapic_available()) {
+        int vector = irq_alloc_vector();
+        if (vector >= 0) {
+            if (pci_enable_msix(pci, 0, vector, lapic_id()) == 0) {
+                hc->irq_mode = "msi-x";
+            } else if (pci_enable_msi(pci, vector, lapic_id()) == 0) {
+                hc->irq_mode = "msi";
+            } else {
+                irq_free_vector(vector);
+                vector = -1;
+            }
+        }
+        if (vector >= 0) hc->vector = vector;
+    }
+    
+    if (!hc->vector && pci->interrupt_line > 0 && pci->interrupt_line < 16 &&
+        pci->interrupt_line != 2) {
+        hc->vector = IRQ_TO_VECTOR(pci->interrupt_line);
+        hc->irq_mode = "intx";
+    }
+    
+    if (!hc->vector) {
+        pr_warn("usb", "xhci %02x:%02x.%x: no usable interrupt", pci->bus, pci->slot, pci->func);
+        return;
+    }
+    irq_set_name(hc->vector, "xhci");
+    request_irq(hc->vector, xhci_irq_handler, hc);
+    
+    xhci_write(hc->ir, XHCI_IMAN, XHCI_IMAN_IE | XHCI_IMAN_IP);
+    xhci_write(hc->ops, XHCI_USBCMD, xhci_read(hc->ops, XHCI_USBCMD) | XHCI_CMD_INTE);
+}
+
+// Reset a root port if it needs it (USB2; USB3 ports train and enable by
+// themselves). Returns 1 if an enabled device is behind it.
+static int xhci_port_reset(xhci_t* hc, int port) {
+    uint32_t reg = XHCI_PORTSC(port);
+    uint32_t status = xhci_read(hc->ops, reg);
+    if (!(status & XHCI_PORT_CCS)) return 0;
+    
+    if (!(status & XHCI_PORT_PED)) {
+        xhci_write(hc->ops, reg, (status & XHCI_PORT_PRESERVE) | XHCI_PORT_PR);
+        for (int ms = 0; ms < 100 && !(xhci_read(hc->ops, reg) & XHCI_PORT_PRC); ms++) {
+            udelay(1000);
+        }
+        udelay(10000);  // Reset recovery
+    }
+    
+    // Acknowledge the change bits
+    status = xhci_read(hc->ops, reg);
+    xhci_write(hc->ops, reg, (status & XHCI_PORT_PRESERVE) | (status & XHCI_PORT_W1C));
+    return (status & (XHCI_PORT_CCS | XHCI_PORT_PED)) == (XHCI_PORT_CCS | XHCI_PORT_PED);
+}
+
+// Enable a slot for a port's device and bring it to the Default state,
+// where endpoint 0 talks to address 0 like on the older controllers
+static xhci_slot_t* xhci_slot_alloc(xhci_t* hc, int port, uint8_t speed) {
+    if (slots_used >= XHCI_MAX_DEVICES) return NULL;
+    if (xhci_command(hc, 0, XHCI_TRB_TYPE(XHCI_TRB_ENABLE_SLOT)) != 0) return NULL;
+    
+    uint8_t id = hc->cmd_slot;
+    if (id == 0 || id > hc->max_slots) return NULL;
+    
+    xhci_slot_t* slot = &xhci_slots[slots_used];
+    memset(slot, 0, sizeof(*slot));
+    slot->hc = hc;
+    slot->id = id;
+    slot->port = port;
+    slot->speed = speed;
+    slot->context_entries = 1;
+    slot->dma = &xhci_dev_dma[slots_used];
+    memset(slot->dma->out_ctx, 0, sizeof(slot->dma->out_ctx));
+    xhci_ring_init(&slot->ep0, slot->dma->ep0_ring);
+    hc->dma->dcbaa[id] = xhci_phys(slot->dma->out_ctx);
+    hc->slots[id] = slot;
+    
+    uint16_t max_packet0 = speed == XHCI_SPEED_HIGH ? 64 : speed >= XHCI_SPEED_SUPER ? 512 : 8;
+    if (xhci_address_device(slot, max_packet0, 1) != 0) {
+        hc->slots[id] = NULL;
+        return NULL;
+    }
+    
+    slots_used++;
+    hc->slot_count++;
+    hc->port_slot[port] = slot;
+    return slot;
+}
+
+static void xhci_scan_ports(xhci_t* hc) {
+    for (int port = 0; port < hc->ports; port++) {
+        if (!xhci_port_reset(hc, port)) continue;
+        
+        uint8_t speed = XHCI_PORT_SPEED(xhci_read(hc->ops, XHCI_PORTSC(port)));
+        if (!xhci_slot_alloc(hc, port, speed)) {
+            pr_warn("usb", "xhci port %d: no device slot", port + 1);
+            continue;
+        }
+        if (!usb_enumerate(&xhci_ops, hc, port, xhci_usb_speed(speed))) {
+            pr_warn("usb", "xhci port %d: enumeration failed", port + 1);
+        }
+    }
+}
+
+int xhci_init(void) {
+    struct pci_device* pci = NULL;
+    char value[8];
+    
+    init_work(&xhci_recover_work, xhci_recover);
+    
+    if (cmdline_value("xhci_imod", value, sizeof(value))) {
+        uint32_t us = 0;
+        for (int i = 0; value[i] >= '0' && value[i] <= '9'; i++) us = us * 10 + (value[i] - '0');
+        imod_us = us < XHCI_IMOD_MAX_US ? us : XHCI_IMOD_MAX_US;
+    }
+    
+    while (controller_count < XHCI_MAX_CONTROLLERS &&
+           (pci = pci_find_class(PCI_CLASS_SERIAL_BUS, PCI_SUBCLASS_USB, XHCI_PROG_IF, pci))) {
+        uint32_t bar = pci_read_config(pci->bus, pci->slot, pci->func, PCI_BAR0);
+        if (bar & 1) continue;
+        
+        uint64_t phys = bar & 0xFFFFFFF0;
+        if (((bar >> 1) & 3) == 2) {
+            phys |= (uint64_t)pci_read_config(pci->bus, pci->slot, pci->func, PCI_BAR1) << 32;
+        }
+        if (!phys) continue;
+        
+        // Memory decoding and bus mastering
+        uint32_t command = pci_read_config(pci->bus, pci->slot, pci->func, PCI_COMMAND) & 0xFFFF;
+        pci_write_config(pci->bus, pci->slot, pci->func, PCI_COMMAND, command | 0x06);
+        
+        xhci_t* hc = &xhci_controllers[controller_count];
+        memset(hc, 0, sizeof(*hc));
+        hc->pci = pci;
+        hc->dma = &xhci_dma[controller_count];
+        spin_lock_init(&hc->lock);
+        tasklet_init(&hc->tasklet, xhci_tasklet, (uint64_t)(uintptr_t)hc);
+        
+        // Map the capability registers, then everything up to the last
+        // doorbell, interrupter and port register
+        hc->caps = (volatile uint8_t*)vmm_map_mmio(phys, 0x1000);
+        if (!hc->caps) continue;
+        uint32_t hcs1 = xhci_read(hc->caps, XHCI_HCSPARAMS1);
+        uint32_t dboff = xhci_read(hc->caps, XHCI_DBOFF) & ~0x3u;
+        uint32_t rtsoff = xhci_read(hc->caps, XHCI_RTSOFF) & ~0x1Fu;
+        uint32_t oplen = hc->caps[XHCI_CAPLENGTH];
+        uint64_t size = oplen + XHCI_PORTSC(XHCI_HCS1_MAX_PORTS(hcs1));
+        if (dboff + 4 * 256 > size) size = dboff + 4 * 256;
+        if (rtsoff + 0x40 > size) size = rtsoff + 0x40;
+        hc->caps = (volatile uint8_t*)vmm_map_mmio(phys, size);
+        if (!hc->caps) continue;
+        
+        hc->ops = hc->caps + oplen;
+        hc->ir = hc->caps + rtsoff + XHCI_IR0;
+        hc->db = (volatile uint32_t*)(hc->caps + dboff);
+        hc->ctx_size = (xhci_read(hc->caps, XHCI_HCCPARAMS1) & XHCI_HCC1_CSZ) ? 64 : 32;
+        hc->max_slots = XHCI_HCS1_MAX_SLOTS(hcs1) < XHCI_MAX_SLOTS ?
+                        XHCI_HCS1_MAX_SLOTS(hcs1) : XHCI_MAX_SLOTS;
+        hc->ports = XHCI_HCS1_MAX_PORTS(hcs1) < XHCI_MAX_PORTS ?
+                    XHCI_HCS1_MAX_PORTS(hcs1) : XHCI_MAX_PORTS;
+        
+        xhci_bios_handoff(hc);
+        if (xhci_reset(hc) != 0) {
+            pr_warn("usb", "xhci %02x:%02x.%x: reset failed", pci->bus, pci->slot, pci->func);
+            continue;
+        }
+        controller_count++;
+        xhci_setup_irq(hc);
+        
+        pr_info("usb", "xhci %02x:%02x.%x: %u ports, %u slots, %s, moderation %u us", pci->bus,
+                pci->slot, pci->func, hc->ports, hc->max_slots, hc->irq_mode, imod_us);
+        xhci_scan_ports(hc);
+    }
+    return controller_count;
+}
+
+void xhci_set_moderation(uint32_t us) {
+    imod_us = us < XHCI_IMOD_MAX_US ? us : XHCI_IMOD_MAX_US;
+    for (int i = 0; i < controller_count; i++) {
+        xhci_write(xhci_controllers[i].ir, XHCI_IMOD, imod_us * 4);
+    }
+}
+
+uint32_t xhci_moderation(void) {
+    return imod_us;
+}
+
+int xhci_count(void) {
+    return controller_count;
+}
+
+int xhci_get_stats(int index, xhci_stats_t* stats) {
+    if (index < 0 || index >= controller_count) return -1;
+    
+    xhci_t* hc = &xhci_controllers[index];
+    stats->irq_mode = hc->irq_mode;
+    stats->vector = hc->vector;
+    stats->ports = hc->ports;
+    stats->slots = hc->slot_count;
+    stats->irqs = hc->irqs;
+    stats->events = hc->events;
+    return 0;
+}
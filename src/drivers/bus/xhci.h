@@ -0,0 +1,178 @@
+#ifndef XHCI_H
+#define XHCI_H
+
+#include <stdint.h>
+
+#define XHCI_PROG_IF        0x30
+#define XHCI_MAX_CONTROLLERS 2
+#define XHCI_MAX_SLOTS      16      // Device slots we enable per controller
+#define XHCI_MAX_PORTS      32      // Root hub ports we scan
+#define XHCI_DEV_PIPES      2       // Interrupt IN endpoints per device
+#define XHCI_IMOD_DEFAULT_US 40     // Interrupt moderation interval
+
+// Capability registers (MMIO, BAR0)
+#define XHCI_CAPLENGTH      0x00    // Byte: offset of the operational registers
+#define XHCI_HCSPARAMS1     0x04
+#define XHCI_HCSPARAMS2     0x08
+#define XHCI_HCCPARAMS1     0x10
+#define XHCI_DBOFF          0x14
+#define XHCI_RTSOFF         0x18
+
+#define XHCI_HCS1_MAX_SLOTS(p)  ((p) & 0xFF)
+#define XHCI_HCS1_MAX_PORTS(p)  (((p) >> 24) & 0xFF)
+#define XHCI_HCS2_SCRATCHPADS(p) ((((p) >> 16) & 0x3E0) | (((p) >> 27) & 0x1F))
+#define XHCI_HCC1_CSZ       (1 << 2)    // 64-byte contexts
+#define XHCI_HCC1_XECP(p)   (((p) >> 16) & 0xFFFF)  // In dwords
+
+// Operational registers
+#define XHCI_USBCMD         0x00
+#define XHCI_USBSTS         0x04
+#define XHCI_PAGESIZE       0x08
+#define XHCI_CRCR           0x18    // 64-bit
+#define XHCI_DCBAAP         0x30    // 64-bit
+#define XHCI_CONFIG         0x38
+#define XHCI_PORTSC(n)      (0x400 + 0x10 * (n))
+
+#define XHCI_CMD_RS         (1 << 0)
+#define XHCI_CMD_HCRST      (1 << 1)
+#define XHCI_CMD_INTE       (1 << 2)
+
+#define XHCI_STS_HCH        (1 << 0)    // Halted
+#define XHCI_STS_HSE        (1 << 2)    // Host system error (W1C)
+#define XHCI_STS_EINT       (1 << 3)    // Event interrupt (W1C)
+#define XHCI_STS_PCD        (1 << 4)    // Port change (W1C)
+#define XHCI_STS_CNR        (1 << 11)   // Controller not ready
+
+#define XHCI_CRCR_RCS       (1 << 0)    // Ring cycle state
+
+#define XHCI_PORT_CCS       (1 << 0)    // Device connected
+#define XHCI_PORT_PED       (1 << 1)    // Enabled (writing 1 disables)
+#define XHCI_PORT_PR        (1 << 4)    // Reset
+#define XHCI_PORT_PP        (1 << 9)    // Power
+#define XHCI_PORT_SPEED(p)  (((p) >> 10) & 0xF)
+#define XHCI_PORT_CSC       (1 << 17)   // Connect change (W1C)
+#define XHCI_PORT_PRC       (1 << 21)   // Reset change (W1C)
+#define XHCI_PORT_W1C       0x00FE0000  // Every change bit
+// Bits written back unchanged: power, indicator and wake enables
+#define XHCI_PORT_PRESERVE  ((1 << 9) | (3 << 14) | (7 << 25))
+
+// PORTSC speed IDs (the defaults every controller uses)
+#define XHCI_SPEED_FULL     1
+#define XHCI_SPEED_LOW      2
+#define XHCI_SPEED_HIGH     3
+#define XHCI_SPEED_SUPER    4
+
+// Runtime registers: interrupter n at 0x20 + 0x20 * n
+#define XHCI_IR0            0x20
+#define XHCI_IMAN           0x00
+#define XHCI_IMOD           0x04    // Interval in 250 ns units
+#define XHCI_ERSTSZ         0x08
+#define XHCI_ERSTBA         0x10    // 64-bit
+#define XHCI_ERDP           0x18    // 64-bit
+
+#define XHCI_IMAN_IP        (1 << 0)    // Interrupt pending (W1C)
+#define XHCI_IMAN_IE        (1 << 1)
+#define XHCI_ERDP_EHB       (1 << 3)    // Event handler busy (W1C)
+
+// Extended capabilities
+#define XHCI_EXT_LEGSUP     1
+#define XHCI_LEGSUP_BIOS    (1 << 16)
+#define XHCI_LEGSUP_OS      (1 << 24)
+#define XHCI_LEGCTL_SMI_W1C 0xE0000000  // SMI status bits in USBLEGCTLSTS
+
+// TRB control field
+#define XHCI_TRB_CYCLE      (1 << 0)
+#define XHCI_TRB_TC         (1 << 1)    // Link: toggle the cycle state
+#define XHCI_TRB_ISP        (1 << 2)    // Interrupt on short packet
+#define XHCI_TRB_CH         (1 << 4)    // Chain
+#define XHCI_TRB_IOC        (1 << 5)
+#define XHCI_TRB_IDT        (1 << 6)    // Immediate data (setup packet)
+#define XHCI_TRB_BSR        (1 << 9)    // Address Device: skip SET_ADDRESS
+#define XHCI_TRB_DIR_IN     (1 << 16)   // Data/status stage direction
+#define XHCI_TRB_TYPE(t)    ((uint32_t)(t) << 10)
+#define XHCI_TRB_GET_TYPE(c) (((c) >> 10) & 0x3F)
+#define XHCI_TRB_SLOT(s)    ((uint32_t)(s) << 24)
+#define XHCI_TRB_GET_SLOT(c) ((c) >> 24)
+#define XHCI_TRB_EP(e)      ((uint32_t)(e) << 16)
+#define XHCI_TRB_GET_EP(c)  (((c) >> 16) & 0x1F)
+
+// Setup stage transfer type
+#define XHCI_TRT_NONE       (0 << 16)
+#define XHCI_TRT_OUT        (2 << 16)
+#define XHCI_TRT_IN         (3 << 16)
+
+// TRB types
+#define XHCI_TRB_NORMAL     1
+#define XHCI_TRB_SETUP      2
+#define XHCI_TRB_DATA       3
+#define XHCI_TRB_STATUS     4
+#define XHCI_TRB_LINK       6
+#define XHCI_TRB_ENABLE_SLOT 9
+#define XHCI_TRB_ADDRESS_DEVICE 11
+#define XHCI_TRB_CONFIGURE_EP 12
+#define XHCI_TRB_RESET_ENDPOINT 14
+#define XHCI_TRB_SET_TR_DEQUEUE 16
+#define XHCI_TRB_TRANSFER_EVENT 32
+#define XHCI_TRB_COMMAND_EVENT 33
+#define XHCI_TRB_PORT_EVENT 34
+
+// Event status field
+#define XHCI_EVENT_CODE(s)  ((s) >> 24)
+#define XHCI_EVENT_LENGTH(s) ((s) & 0xFFFFFF)   // Residual bytes
+#define XHCI_CC_SUCCESS     1
+#define XHCI_CC_BABBLE      3
+#define XHCI_CC_TRANSACTION 4
+#define XHCI_CC_STALL       6
+#define XHCI_CC_SHORT_PACKET 13
+
+// Context fields (32-byte contexts; 64-byte ones pad each to 64)
+#define XHCI_SLOT_SPEED(s)  ((uint32_t)(s) << 20)
+#define XHCI_SLOT_ENTRIES(n) ((uint32_t)(n) << 27)
+#define XHCI_SLOT_PORT(p)   ((uint32_t)(p) << 16)
+#define XHCI_EP_INTERVAL(i) ((uint32_t)(i) << 16)
+#define XHCI_EP_CERR(n)     ((uint32_t)(n) << 1)
+#define XHCI_EP_TYPE(t)     ((uint32_t)(t) << 3)
+#define XHCI_EP_MPS(m)      ((uint32_t)(m) << 16)
+#define XHCI_EP_ESIT(e)     ((uint32_t)(e) << 16)
+#define XHCI_EP_CONTROL     4
+#define XHCI_EP_INTERRUPT_IN 7
+
+// Transfer request block: every ring entry and event is one of these
+typedef struct {
+    volatile uint64_t param;
+    volatile uint32_t status;
+    volatile uint32_t control;
+} __attribute__((aligned(16))) xhci_trb_t;
+
+// Event ring segment table entry
+typedef struct {
+    uint64_t base;
+    uint32_t size;
+    uint32_t reserved;
+} __attribute__((aligned(16))) xhci_erst_t;
+
+// Per-controller figures for the "xhci" command
+typedef struct {
+    const char* irq_mode;       // "msi-x", "msi", "intx" or "polled"
+    uint8_t vector;
+    uint8_t ports;
+    uint8_t slots;              // Device slots in use
+    uint64_t irqs;
+    uint64_t events;
+} xhci_stats_t;
+
+// Find the xHCI controllers, take them from the BIOS, reset and start
+// them, and enumerate the devices on their root ports. "xhci_imod=<us>"
+// on the command line sets the interrupt moderation interval. Returns the
+// number of controllers started.
+int xhci_init(void);
+
+// Interrupt moderation: at most one interrupt per `us` microseconds
+// (0 interrupts on every event). Applies to every controller.
+void xhci_set_moderation(uint32_t us);
+uint32_t xhci_moderation(void);
+
+int xhci_count(void);
+int xhci_get_stats(int index, xhci_stats_t* stats);
+
+#endif
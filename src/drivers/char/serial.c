@@ -0,0 +1,202 @@
+#include "serial.h"
+#include <stddef.h>
+#include "lib/io.h"
+#include "lib/kfifo.h"
+#include "kernel/irq.h"
+#include "kernel/spinlock.h"
+
+static int serial_present = 0;
+static int serial_irq_mode = 0;
+static uint8_t serial_ier = 0;
+
+// TX ring: producers append at head, the THRE interrupt drains from tail
+static char tx_ring[SERIAL_TX_SIZE];
+static uint32_t tx_head = 0;
+static uint32_t tx_tail = 0;
+static uint32_t tx_dropped = 0;
+static spinlock_t tx_lock = SPINLOCK_INIT;
+
+static kfifo_t rx_fifo;
+
+static void serial_set_ier(uint8_t ier) {
+    if (ier != serial_ier) {
+        serial_ier = ier;
+        outb(COM1_PORT + UART_IER, ier);
+    }
+}
+
+// Move up to a FIFO's worth from the ring into the UART (tx_lock held).
+// THRE is only re-armed while there is more to send.
+static void serial_tx_fill(void) {
+    if (!(inb(COM1_PORT + UART_LSR) & UART_LSR_THR_EMPTY)) return;
+    
+    for (int i = 0; i < UART_FIFO_SIZE && tx_tail != tx_head; i++) {
+        outb(COM1_PORT + UART_DATA, (uint8_t)tx_ring[tx_tail & (SERIAL_TX_SIZE - 1)]);
+        tx_tail++;
+    }
+    
+    if (serial_irq_mode) {
+        if (tx_tail != tx_head) {
+            serial_set_ier(serial_ier | UART_IER_THRE);
+        } else {
+            serial_set_ier(serial_ier & ~UART_IER_THRE);
+        }
+    }
+}
+
+static void serial_enqueue(const char* data, uint32_t len, int wait) {
+    if (!serial_present) return;
+    
+    uint64_t flags = spin_lock_irqsave(&tx_lock);
+    
+    for (uint32_t i = 0; i < len; i++) {
+        // Terminals want CRLF
+        int need = (data[i] == '\n') ? 2 : 1;
+        
+        while (SERIAL_TX_SIZE - (tx_head - tx_tail) < (uint32_t)need) {
+            if (!wait) break;
+            
+            // Push bytes out ourselves and let interrupts in while waiting
+            serial_tx_fill();
+            spin_unlock_irqrestore(&tx_lock, flags);
+            cpu_relax();
+            flags = spin_lock_irqsave(&tx_lock);
+        }
+        
+        if (SERIAL_TX_SIZE - (tx_head - tx_tail) < (uint32_t)need) {
+            tx_dropped += need;
+            continue;
+        }
+        
+        if (need == 2) {
+            tx_ring[tx_head++ & (SERIAL_TX_SIZE - 1)] = '\r';
+        }
+        tx_ring[tx_head++ & (SERIAL_TX_SIZE - 1)] = data[i];
+    }
+    
+    serial_tx_fill();
+    
+    // Before the IRQ is hooked up nothing else drains the ring
+    if (!serial_irq_mode) {
+        while (tx_tail != tx_head) {
+            serial_tx_fill();
+        }
+    }
+    
+    spin_unlock_irqrestore(&tx_lock, flags);
+}
+
+static int serial_irq_handler(void* ctx) {
+    (void)ctx;
+    int handled = IRQ_NONE;
+    uint8_t iir;
+    
+    while (!((iir = inb(COM1_PORT + UART_IIR)) & UART_IIR_NO_INT)) {
+        handled = IRQ_HANDLED;
+        
+        switch (iir & UART_IIR_ID_MASK) {
+            case UART_IIR_RX:
+            case UART_IIR_RX_TIMEOUT:
+                while (inb(COM1_PORT + UART_LSR) & UART_LSR_DATA_READY) {
+                    kfifo_put(&rx_fifo, inb(COM1_PORT + UART_DATA));
+                }
+                break;
+            case UART_IIR_THRE:
+                spin_lock(&tx_lock);
+                serial_tx_fill();
+                spin_unlock(&tx_lock);
+                break;
+            case UART_IIR_LINE:
+                inb(COM1_PORT + UART_LSR);
+                break;
+            case UART_IIR_MODEM:
+                inb(COM1_PORT + UART_MSR);
+                break;
+        }
+    }
+    
+    return handled;
+}
+
+int serial_init(void) {
+    outb(COM1_PORT + UART_IER, 0x00);            // No interrupts
+    serial_ier = 0;
+    outb(COM1_PORT + UART_LCR, 0x80);            // DLAB on
+    outb(COM1_PORT + UART_DATA, (115200 / SERIAL_BAUD) & 0xFF);
+    outb(COM1_PORT + UART_IER, (115200 / SERIAL_BAUD) >> 8);
+    outb(COM1_PORT + UART_LCR, 0x03);            // 8N1, DLAB off
+    outb(COM1_PORT + UART_FCR, 0xC7);            // Enable + clear FIFOs, 14-byte threshold
+    
+    // Loopback self-test: a missing UART reads back 0xFF
+    outb(COM1_PORT + UART_MCR, 0x1E);
+    outb(COM1_PORT + UART_DATA, 0xAE);
+    if (inb(COM1_PORT + UART_DATA) != 0xAE) {
+        serial_present = 0;
+        return 0;
+    }
+    
+    outb(COM1_PORT + UART_MCR, 0x0F);            // Normal operation, OUT2 gates the IRQ
+    serial_present = 1;
+    
+    kfifo_init(&rx_fifo);
+    
+    irq_set_name(IRQ_TO_VECTOR(COM1_IRQ), "serial");
+    if (request_irq(IRQ_TO_VECTOR(COM1_IRQ), serial_irq_handler, NULL) == 0) {
+        serial_irq_mode = 1;
+        serial_set_ier(UART_IER_RX | UART_IER_LINE);
+    }
+    
+    return 1;
+}
+
+int serial_available(void) {
+    return serial_present;
+}
+
+void serial_putc(char c) {
+    serial_enqueue(&c, 1, 0);
+}
+
+void serial_write_len(const char* data, uint32_t len) {
+    serial_enqueue(data, len, 0);
+}
+
+void serial_write(const char* str) {
+    uint32_t len = 0;
+    while (str[len]) len++;
+    serial_enqueue(str, len, 0);
+}
+
+void serial_write_blocking(const char* str) {
+    uint32_t len = 0;
+    while (str[len]) len++;
+    serial_enqueue(str, len, 1);
+}
+
+void serial_flush(void) {
+    if (!serial_present) return;
+    
+    while (1) {
+        uint64_t flags = spin_lock_irqsave(&tx_lock);
+        serial_tx_fill();
+        int empty = (tx_tail == tx_head);
+        spin_unlock_irqrestore(&tx_lock, flags);
+        
+        if (empty) break;
+        cpu_relax();
+    }
+}
+
+int serial_getc(void) {
+    uint8_t byte;
+    if (!kfifo_get(&rx_fifo, &byte)) return -1;
+    return byte;
+}
+
+uint32_t serial_tx_dropped(void) {
+    return tx_dropped;
+}
+
+uint32_t serial_rx_dropped(void) {
+    return rx_fifo.dropped;
+}
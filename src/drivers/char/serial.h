@@ -0,0 +1,63 @@
+#ifndef SERIAL_H
+#define SERIAL_H
+
+#include <stdint.h>
+
+#define COM1_PORT 0x3F8
+#define COM1_IRQ  4
+
+// 16550 register offsets
+#define UART_DATA       0   // RX/TX buffer (DLAB=0), divisor low (DLAB=1)
+#define UART_IER        1   // Interrupt enable (DLAB=0), divisor high (DLAB=1)
+#define UART_IIR        2   // Interrupt identification (read)
+#define UART_FCR        2   // FIFO control (write)
+#define UART_LCR        3   // Line control
+#define UART_MCR        4   // Modem control
+#define UART_LSR        5   // Line status
+#define UART_MSR        6   // Modem status
+
+#define UART_IER_RX          0x01
+#define UART_IER_THRE        0x02
+#define UART_IER_LINE        0x04
+
+#define UART_IIR_NO_INT      0x01
+#define UART_IIR_ID_MASK     0x0E
+#define UART_IIR_MODEM       0x00
+#define UART_IIR_THRE        0x02
+#define UART_IIR_RX          0x04
+#define UART_IIR_LINE        0x06
+#define UART_IIR_RX_TIMEOUT  0x0C
+
+#define UART_LSR_DATA_READY  0x01
+#define UART_LSR_THR_EMPTY   0x20   // With FIFOs on: the whole TX FIFO is empty
+
+#define UART_FIFO_SIZE  16
+#define SERIAL_BAUD     115200
+#define SERIAL_TX_SIZE  8192        // Power of two
+
+// Program COM1 for 115200 8N1 with FIFOs and hook its IRQ (RX and TX are
+// then interrupt driven). Returns 1 if a UART answered the loopback test.
+int serial_init(void);
+int serial_available(void);
+
+// Queue output for the TX interrupt to drain. Never waits: when the ring
+// is full the bytes are dropped and counted, so logging can't stall.
+void serial_putc(char c);
+void serial_write(const char* str);
+void serial_write_len(const char* data, uint32_t len);
+
+// Queue output, waiting for ring space instead of dropping (bulk dumps
+// from process context)
+void serial_write_blocking(const char* str);
+
+// Wait until everything queued has been handed to the UART
+void serial_flush(void);
+
+// Next received byte, or -1 if none
+int serial_getc(void);
+
+// Bytes dropped on a full TX ring / RX ring
+uint32_t serial_tx_dropped(void);
+uint32_t serial_rx_dropped(void);
+
+#endif
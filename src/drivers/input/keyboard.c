@@ -1,4 +1,13 @@
 #include "kernel/idt.h"
+#include "kernel/irq.h"
+#include "kernel/softirq.h"
+#include "kernel/irqflags.h"
+#include "kernel/workqueue.h"
+#include "lib/kfifo.h"
+#include "kernel/trace.h"
+#include "kernel/debug.h"
+#include "kernel/input_latency.h"
+#include "kernel/tsc.h"
 #include "lib/io.h"
 #include "gui/terminal.h"
 #include "lib/string.h"
@@ -24,99 +33,185 @@ extern void outb(uint16_t port, uint8_t val);
 extern uint8_t inb(uint16_t port);
 extern void cmd_process(const char* cmd);
 
-void keyboard_handler() {
-    irq_count++;
-    uint8_t scancode = inb(0x60);
+// Scancodes queued by the IRQ handler, decoded by the tasklet. Each slot's
+// arrival TSC sits at the same index in kbd_stamps.
+static kfifo_t kbd_fifo;
+static uint64_t kbd_stamps[KFIFO_SIZE];
+static tasklet_t kbd_tasklet;
 
-    if (scancode >= 128) {
-        outb(0x20, 0x20);
-        return;
+DEFINE_TRACEPOINT(keyboard_input);
+DEFINE_PROFILE_ZONE(zone_kbd_irq, "keyboard_irq");
+DEFINE_PROFILE_ZONE(zone_kbd_decode, "keyboard_decode");
+
+// A submitted command line runs from the workqueue, since commands may
+// block (timers sleeps, long output) and must not hold up interrupts
+static work_t cmd_work;
+static char cmd_pending[256];
+static terminal_instance_t* cmd_terminal = NULL;
+
+static void keyboard_run_command(work_t* work) {
+    (void)work;
+    extern terminal_instance_t* active_terminal;
+    char line[256];
+    
+    // The work is no longer pending while it runs, so the next Enter may
+    // refill cmd_pending; take the line and its terminal first
+    uint64_t flags = local_irq_save();
+    strcpy(line, cmd_pending);
+    active_terminal = cmd_terminal;
+    local_irq_restore(flags);
+    
+    if (active_terminal) {
+        // Echo command
+        char cmd_line[300];
+        cmd_line[0] = '$';
+        cmd_line[1] = ' ';
+        strcpy(cmd_line + 2, line);
+        terminal_instance_print(active_terminal, cmd_line);
     }
+    
+    cmd_process(line);
+    active_terminal = NULL;
+}
+
+static void keyboard_submit_line(void) {
+    terminal_buffer[term_idx] = '\0';
+    
+    // The previous command hasn't started yet; keep the line for editing
+    if (work_pending(&cmd_work)) return;
+    
+    // Route to focused terminal
+    window_manager_t* wm = wm_get_state();
+    window_t* focused_win = wm_get_window(wm->focused_window_id);
+    cmd_terminal = (focused_win && focused_win->user_data) ?
+                   (terminal_instance_t*)focused_win->user_data : NULL;
+    
+    strcpy(cmd_pending, terminal_buffer);
+    terminal_buffer[0] = '\0';
+    term_idx = 0;
+    schedule_work(&cmd_work);
+}
 
+static void keyboard_decode(uint8_t scancode) {
     static int extended = 0;
     
     if (scancode == 0xE0) {
         extended = 1;
-        outb(0x20, 0x20);
         return;
     }
     
-    if (!(scancode & 0x80)) {
-        if (extended) {
-            extended = 0;
-            
-            if (scancode == 0x48) {
-                const char* prev = terminal_get_history_prev();
-                if (prev) {
-                    strcpy(terminal_buffer, prev);
-                    term_idx = strlen(prev);
-                }
-                outb(0x20, 0x20);
-                return;
-            }
-            else if (scancode == 0x50) {
-                const char* next = terminal_get_history_next();
-                if (next) {
-                    strcpy(terminal_buffer, next);
-                    term_idx = strlen(next);
-                }
-                outb(0x20, 0x20);
-                return;
-            }
-            else if (scancode == 0x49) {
-                terminal_scroll_up();
-                outb(0x20, 0x20);
-                return;
-            }
-            else if (scancode == 0x51) {
-                terminal_scroll_down();
-                outb(0x20, 0x20);
-                return;
+    // Key releases are ignored
+    if (scancode & 0x80) {
+        extended = 0;
+        return;
+    }
+    
+    if (extended) {
+        extended = 0;
+        
+        if (scancode == 0x48) {
+            const char* prev = terminal_get_history_prev();
+            if (prev) {
+                strcpy(terminal_buffer, prev);
+                term_idx = strlen(prev);
             }
+            return;
         }
-        
-        char c = kbd_US[scancode];
-        
-        if (c == '\b') {
-            if (term_idx > 0) {
-                term_idx--;
-                terminal_buffer[term_idx] = '\0';
-                backspace_pressed = 1;
+        else if (scancode == 0x50) {
+            const char* next = terminal_get_history_next();
+            if (next) {
+                strcpy(terminal_buffer, next);
+                term_idx = strlen(next);
             }
+            return;
+        }
+        else if (scancode == 0x49) {
+            terminal_scroll_up();
+            return;
+        }
+        else if (scancode == 0x51) {
+            terminal_scroll_down();
+            return;
         }
-        else if (c == '\n') {
+    }
+    
+    char c = kbd_US[scancode];
+    
+    if (c == '\b') {
+        if (term_idx > 0) {
+            term_idx--;
             terminal_buffer[term_idx] = '\0';
-            
-            // Route to focused terminal
-            extern terminal_instance_t* active_terminal;
-            window_manager_t* wm = wm_get_state();
-            window_t* focused_win = wm_get_window(wm->focused_window_id);
-            
-            if (focused_win && focused_win->user_data) {
-                active_terminal = (terminal_instance_t*)focused_win->user_data;
-                
-                // Echo command
-                char cmd_line[300];
-                cmd_line[0] = '$';
-                cmd_line[1] = ' ';
-                for (int i = 0; i < term_idx && i < 297; i++) {
-                    cmd_line[i + 2] = terminal_buffer[i];
-                }
-                cmd_line[term_idx + 2] = '\0';
-                terminal_instance_print(active_terminal, cmd_line);
-            }
-            
-            cmd_process(terminal_buffer);
-            active_terminal = NULL;
+            backspace_pressed = 1;
         }
-        else if (c != 0) {
-            if (term_idx < 255) {
-                terminal_buffer[term_idx] = c;
-                term_idx++;
-                terminal_buffer[term_idx] = 0;
-            }
+    }
+    else if (c == '\n') {
+        keyboard_submit_line();
+    }
+    else if (c != 0) {
+        if (term_idx < 255) {
+            terminal_buffer[term_idx] = c;
+            term_idx++;
+            terminal_buffer[term_idx] = 0;
+        }
+    }
+}
+
+static void keyboard_tasklet(uint64_t data) {
+    (void)data;
+    uint8_t scancode;
+    
+    profile_zone_enter(&zone_kbd_decode);
+    for (;;) {
+        uint64_t stamp = kbd_stamps[kbd_fifo.tail & (KFIFO_SIZE - 1)];
+        if (!kfifo_get(&kbd_fifo, &scancode)) break;
+        
+        keyboard_decode(scancode);
+        
+        // Presses are what the user waits to see
+        if (scancode != 0xE0 && !(scancode & 0x80)) {
+            input_latency_event(INPUT_LATENCY_KEY, stamp);
         }
     }
+    profile_zone_exit(&zone_kbd_decode);
+}
+
+// Stamp the slot the next byte goes into (unless the ring is full, when
+// the byte is dropped anyway)
+static inline void keyboard_queue(uint8_t scancode) {
+    if (kfifo_len(&kbd_fifo) < KFIFO_SIZE) {
+        kbd_stamps[kbd_fifo.head & (KFIFO_SIZE - 1)] = rdtsc();
+    }
+    kfifo_put(&kbd_fifo, scancode);
+}
+
+// Hard IRQ: grab the scancode and defer everything else
+int keyboard_handler(void* ctx) {
+    (void)ctx;
+    profile_zone_enter(&zone_kbd_irq);
+    irq_count++;
+    
+    uint8_t scancode = inb(0x60);
+    trace_instant(keyboard_input, scancode);
+    keyboard_queue(scancode);
+    tasklet_schedule(&kbd_tasklet);
+    profile_zone_exit(&zone_kbd_irq);
+    
+    return IRQ_HANDLED;
+}
+
+// The PS/2 IRQ is the fifo's other producer, so keep it out while we add
+void keyboard_inject_scancode(uint8_t scancode) {
+    uint64_t flags = local_irq_save();
+    keyboard_queue(scancode);
+    local_irq_restore(flags);
+    tasklet_schedule(&kbd_tasklet);
+}
+
+void keyboard_init() {
+    kfifo_init(&kbd_fifo);
+    tasklet_init(&kbd_tasklet, keyboard_tasklet, 0);
+    init_work(&cmd_work, keyboard_run_command);
     
-    outb(0x20, 0x20);
-}
\ No newline at end of file
+    irq_set_name(IRQ_TO_VECTOR(1), "keyboard");
+    request_irq(IRQ_TO_VECTOR(1), keyboard_handler, NULL);
+}
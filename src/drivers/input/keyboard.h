@@ -3,8 +3,14 @@
 
 #include <stdint.h>
 
+// Register the IRQ1 handler
+void keyboard_init(void);
+
 // Keyboard handler (called from IRQ1)
-void keyboard_handler(void);
+int keyboard_handler(void* ctx);
+
+// Queue a set-1 scancode as if it came from the PS/2 port (USB keyboards)
+void keyboard_inject_scancode(uint8_t scancode);
 
 // Keyboard state exported for other modules
 extern char terminal_buffer[];
@@ -1,26 +1,81 @@
 #include <stdint.h>
+#include <stddef.h>
 #include "kernel/idt.h"
+#include "kernel/irq.h"
+#include "kernel/softirq.h"
+#include "drivers/input/mouse.h"
 #include "lib/io.h"
+#include "kernel/tsc.h"
+#include "lib/kfifo.h"
+#include "kernel/irqflags.h"
+#include "kernel/seqlock.h"
+#include "kernel/trace.h"
+#include "kernel/debug.h"
+#include "kernel/cmdline.h"
+#include "kernel/printk.h"
+#include "kernel/input_latency.h"
+#include "lib/string.h"
+
+// How long to wait for the PS/2 controller before giving up
+#define MOUSE_TIMEOUT_US 10000
+
+// Packet byte 0
+#define MOUSE_BUTTONS   0x07
+#define MOUSE_SYNC      0x08    // Always set in byte 0
+#define MOUSE_X_SIGN    0x10
+#define MOUSE_Y_SIGN    0x20
+#define MOUSE_OVERFLOW  0xC0
+
+// Device commands
+#define MOUSE_CMD_GET_ID    0xF2
+#define MOUSE_CMD_SET_RATE  0xF3
+#define MOUSE_CMD_ENABLE    0xF4
+#define MOUSE_CMD_DEFAULTS  0xF6
+#define MOUSE_ID_WHEEL      3       // IntelliMouse: 4-byte packets with a wheel
+#define MOUSE_ACK           0xFA
 
 // --- MOUSE STATE ---
 // SECURITY: All ISR-modified variables marked volatile to prevent compiler caching
 int mouse_x = 400;
 int mouse_y = 300;
 uint8_t mouse_cycle = 0;
-int8_t mouse_byte[3];
+uint8_t mouse_byte[4];
+static uint64_t mouse_byte_stamp[4];    // Arrival TSC of each packet byte
 volatile uint8_t mouse_left_btn = 0;
 static volatile uint8_t prev_mouse_left_btn = 0;
 
+static uint8_t mouse_packet_size = 3;
+static uint8_t mouse_buttons = 0;
+static volatile int mouse_wheel_delta = 0;
+static mouse_stats_t mouse_stats;
+
+// Guards mouse_x/mouse_y so readers never see a half-applied move
+static seqlock_t mouse_pos_lock = SEQLOCK_INIT;
+
+// Bytes queued by the IRQ handler, assembled into packets by the tasklet.
+// Each slot's arrival TSC sits at the same index in mouse_stamps.
+static kfifo_t mouse_fifo;
+static uint64_t mouse_stamps[KFIFO_SIZE];
+static tasklet_t mouse_tasklet;
+static void mouse_process_packets(uint64_t data);
+static void mouse_apply(int dx, int dy, uint8_t buttons, uint64_t stamp);
+
+DEFINE_TRACEPOINT(mouse_input);
+DEFINE_PROFILE_ZONE(zone_mouse_irq, "mouse_irq");
+
 extern void outb(uint16_t port, uint8_t val);
 extern uint8_t inb(uint16_t port);
 
-void mouse_wait(uint8_t type) {
-    uint32_t timeout = 100000;
-    if (type == 0) {
-        while (timeout--) { if ((inb(0x64) & 1) == 1) return; }
-    } else {
-        while (timeout--) { if ((inb(0x64) & 2) == 0) return; }
+// type 0: wait for output buffer full, type 1: wait for input buffer empty.
+// Returns -1 on timeout.
+int mouse_wait(uint8_t type) {
+    for (uint32_t us = 0; us < MOUSE_TIMEOUT_US; us++) {
+        uint8_t status = inb(0x64);
+        if (type == 0 && (status & 1) == 1) return 0;
+        if (type == 1 && (status & 2) == 0) return 0;
+        udelay(1);
     }
+    return -1;
 }
 
 void mouse_write(uint8_t write) {
@@ -35,10 +90,43 @@ uint8_t mouse_read() {
     return inb(0x60);
 }
 
-void init_mouse() {
+// Send a command byte and swallow the ACK; -1 if the device didn't answer
+static int mouse_command(uint8_t command) {
+    mouse_write(command);
+    if (mouse_wait(0) != 0) return -1;
+    return inb(0x60) == MOUSE_ACK ? 0 : -1;
+}
+
+static void mouse_set_rate(uint8_t rate) {
+    mouse_command(MOUSE_CMD_SET_RATE);
+    mouse_command(rate);
+}
+
+// "mouse_rate=<hz>" on the command line, rounded down to a rate the
+// device supports
+static uint8_t mouse_requested_rate(void) {
+    static const uint8_t rates[] = { 200, 100, 80, 60, 40, 20, 10 };
+    char value[8];
+    uint32_t hz = MOUSE_RATE_DEFAULT;
+    
+    if (cmdline_value("mouse_rate", value, sizeof(value))) {
+        hz = 0;
+        for (int i = 0; value[i] >= '0' && value[i] <= '9'; i++) hz = hz * 10 + (value[i] - '0');
+    }
+    for (size_t i = 0; i < sizeof(rates); i++) {
+        if (hz >= rates[i]) return rates[i];
+    }
+    return rates[sizeof(rates) - 1];
+}
+
+int init_mouse(void) {
     uint8_t status;
     
-    mouse_wait(1);
+    // No controller: don't sit through a timeout per command
+    if (mouse_wait(1) != 0) {
+        pr_warn("mouse", "PS/2 controller not responding");
+        return -1;
+    }
     outb(0x64, 0xA8);
     
     mouse_wait(1);
@@ -50,57 +138,178 @@ void init_mouse() {
     mouse_wait(1);
     outb(0x60, status);
     
-    mouse_write(0xF6);
-    mouse_read();
-    
-    mouse_write(0xF4);
-    mouse_read();
-}
-
-void mouse_handler() {
-    uint8_t status = inb(0x64);
-    if ((status & 0x01) == 0) {
-        outb(0xA0, 0x20);
-        outb(0x20, 0x20);
-        return;
-    }
-    if ((status & 0x20) == 0) {
-        outb(0xA0, 0x20);
-        outb(0x20, 0x20);
-        return;
+    // Nothing on the aux port: USB pointers still report through mouse_report
+    if (mouse_command(MOUSE_CMD_DEFAULTS) != 0) {
+        pr_info("mouse", "no PS/2 mouse");
+        return -1;
     }
     
-    uint8_t mouse_in = inb(0x60);
+    // IntelliMouse knock: rates 200, 100, 80 switch a wheel mouse to ID 3
+    mouse_set_rate(200);
+    mouse_set_rate(100);
+    mouse_set_rate(80);
+    mouse_command(MOUSE_CMD_GET_ID);
+    if (mouse_read() == MOUSE_ID_WHEEL) mouse_packet_size = 4;
     
-    // SECURITY FIX: Prevent buffer overflow if packet sync lost
-    if (mouse_cycle >= 3) {
-        mouse_cycle = 0;
-    }
+    uint8_t rate = mouse_requested_rate();
+    mouse_set_rate(rate);
+    mouse_stats.rate = rate;
+    mouse_stats.packet_size = mouse_packet_size;
     
-    mouse_byte[mouse_cycle] = mouse_in;
-    mouse_cycle++;
+    mouse_command(MOUSE_CMD_ENABLE);
     
-    if (mouse_cycle == 3) {
-        mouse_cycle = 0;
+    kfifo_init(&mouse_fifo);
+    tasklet_init(&mouse_tasklet, mouse_process_packets, 0);
+    
+    irq_set_name(IRQ_TO_VECTOR(12), "mouse");
+    request_irq(IRQ_TO_VECTOR(12), mouse_handler, NULL);
+    
+    pr_info("mouse", "PS/2 %s, %u samples/s", mouse_packet_size == 4 ? "wheel mouse" : "mouse", rate);
+    return 0;
+}
+
+// Drop the presumed first byte of a bad packet and slide to the next byte
+// that could start one
+static void mouse_resync(void) {
+    do {
+        mouse_cycle--;
+        memmove(mouse_byte, mouse_byte + 1, mouse_cycle);
+        memmove(mouse_byte_stamp, mouse_byte_stamp + 1, mouse_cycle * sizeof(uint64_t));
+    } while (mouse_cycle > 0 && !(mouse_byte[0] & MOUSE_SYNC));
+    mouse_stats.resyncs++;
+}
+
+// Assemble packets and move the pointer (runs from the tasklet). Motion
+// from every packet queued since the last run goes out as one report;
+// a button change flushes the motion before it, so clicks land where the
+// pointer was. A report's latency counts from its oldest packet.
+static void mouse_process_packets(uint64_t data) {
+    (void)data;
+    uint8_t mouse_in;
+    int dx = 0, dy = 0, dz = 0;
+    int pending = 0;
+    uint64_t stamp = 0;
+    
+    for (;;) {
+        uint64_t byte_stamp = mouse_stamps[mouse_fifo.tail & (KFIFO_SIZE - 1)];
+        if (!kfifo_get(&mouse_fifo, &mouse_in)) break;
         
-        uint8_t flags = mouse_byte[0];
-        int8_t x_rel = (int8_t)mouse_byte[1];
-        int8_t y_rel = (int8_t)mouse_byte[2];
+        // SECURITY FIX: Prevent buffer overflow if packet sync lost
+        if (mouse_cycle >= mouse_packet_size) {
+            mouse_cycle = 0;
+        }
+        
+        // Byte 0 always has bit 3 set; drop bytes until we are back in sync
+        if (mouse_cycle == 0 && !(mouse_in & MOUSE_SYNC)) {
+            mouse_stats.resyncs++;
+            continue;
+        }
         
-        mouse_x += x_rel;
-        mouse_y -= y_rel;
+        mouse_byte_stamp[mouse_cycle] = byte_stamp;
+        mouse_byte[mouse_cycle++] = mouse_in;
+        if (mouse_cycle < mouse_packet_size) continue;
         
-        extern int screen_w, screen_h;
-        if (mouse_x < 0) mouse_x = 0;
-        if (mouse_x >= screen_w) mouse_x = screen_w - 1;
-        if (mouse_y < 0) mouse_y = 0;
-        if (mouse_y >= screen_h) mouse_y = screen_h - 1;
+        // The wheel only moves -8..7 per packet; anything else means we
+        // took a motion byte for byte 0
+        int8_t z = mouse_packet_size == 4 ? (int8_t)mouse_byte[3] : 0;
+        if (z < -8 || z > 7) {
+            mouse_resync();
+            continue;
+        }
+        mouse_cycle = 0;
+        mouse_stats.packets++;
+        
+        uint8_t buttons = mouse_byte[0] & MOUSE_BUTTONS;
+        if (buttons != mouse_buttons && pending) {
+            mouse_apply(dx, dy, mouse_buttons, stamp);
+            dx = 0;
+            dy = 0;
+            pending = 0;
+        }
+        if (!pending) stamp = mouse_byte_stamp[0];
+        mouse_buttons = buttons;
+        pending = 1;
         
-        mouse_left_btn = (flags & 0x01);
+        // 9-bit deltas, sign in byte 0; overflowed motion is meaningless
+        if (!(mouse_byte[0] & MOUSE_OVERFLOW)) {
+            dx += mouse_byte[1] - ((mouse_byte[0] & MOUSE_X_SIGN) ? 256 : 0);
+            dy -= mouse_byte[2] - ((mouse_byte[0] & MOUSE_Y_SIGN) ? 256 : 0);  // PS/2 counts y upwards
+        }
+        dz += z;
+    }
+    
+    if (pending) mouse_apply(dx, dy, mouse_buttons, stamp);
+    if (dz) mouse_wheel(dz);
+}
+
+static void mouse_apply(int dx, int dy, uint8_t buttons, uint64_t stamp) {
+    extern int screen_w, screen_h;
+    int x = mouse_x + dx;
+    int y = mouse_y + dy;
+    if (x < 0) x = 0;
+    if (x >= screen_w) x = screen_w - 1;
+    if (y < 0) y = 0;
+    if (y >= screen_h) y = screen_h - 1;
+    
+    write_seqlock(&mouse_pos_lock);
+    mouse_x = x;
+    mouse_y = y;
+    write_sequnlock(&mouse_pos_lock);
+    
+    mouse_left_btn = (buttons & 0x01);
+    mouse_stats.reports++;
+    input_latency_event(INPUT_LATENCY_POINTER, stamp);
+}
+
+// Other pointing devices report from their own bottom halves; latency
+// counts from here
+void mouse_report(int dx, int dy, uint8_t buttons) {
+    mouse_apply(dx, dy, buttons, rdtsc());
+}
+
+void mouse_wheel(int dz) {
+    __atomic_add_fetch(&mouse_wheel_delta, dz, __ATOMIC_RELAXED);
+}
+
+int mouse_wheel_take(void) {
+    return __atomic_exchange_n(&mouse_wheel_delta, 0, __ATOMIC_RELAXED);
+}
+
+void mouse_get_stats(mouse_stats_t* stats) {
+    *stats = mouse_stats;
+}
+
+// Hard IRQ: grab the byte and defer packet handling
+int mouse_handler(void* ctx) {
+    (void)ctx;
+    uint8_t status = inb(0x64);
+    if ((status & 0x01) == 0) {
+        return IRQ_NONE;
+    }
+    if ((status & 0x20) == 0) {
+        return IRQ_NONE;
     }
     
-    outb(0xA0, 0x20);
-    outb(0x20, 0x20);
+    profile_zone_enter(&zone_mouse_irq);
+    uint8_t data = inb(0x60);
+    trace_instant(mouse_input, data);
+    if (kfifo_len(&mouse_fifo) < KFIFO_SIZE) {
+        mouse_stamps[mouse_fifo.head & (KFIFO_SIZE - 1)] = rdtsc();
+    }
+    kfifo_put(&mouse_fifo, data);
+    tasklet_schedule(&mouse_tasklet);
+    profile_zone_exit(&zone_mouse_irq);
+    
+    return IRQ_HANDLED;
+}
+
+void mouse_get_position(int* x, int* y) {
+    uint32_t seq;
+    do {
+        seq = read_seqbegin(&mouse_pos_lock);
+        *x = mouse_x;
+        *y = mouse_y;
+    } while (read_seqretry(&mouse_pos_lock, seq));
 }
 
 int mouse_button_left() {
@@ -109,7 +318,7 @@ int mouse_button_left() {
 
 // SECURITY FIX + BUG FIX #7: Critical section with debounce
 int mouse_button_pressed() {
-    uint32_t flags;
+    uint64_t flags;
     int pressed;
     
     // BUG FIX #7: Debounce protection (prevent double-clicks)
@@ -117,7 +326,7 @@ int mouse_button_pressed() {
     extern volatile uint32_t timer_ticks;
     
     // Save interrupt flag and disable interrupts
-    asm volatile("pushf; cli; pop %0" : "=r"(flags));
+    flags = local_irq_save();
     
     // Read button state atomically
     pressed = (mouse_left_btn && !prev_mouse_left_btn);
@@ -135,21 +344,21 @@ int mouse_button_pressed() {
     }
     
     // Restore interrupts if they were enabled
-    if (flags & 0x200) asm volatile("sti");
+    local_irq_restore(flags);
     
     return pressed;
 }
 
 int mouse_button_released() {
-    uint32_t flags;
+    uint64_t flags;
     int released;
     
-    asm volatile("pushf; cli; pop %0" : "=r"(flags));
+    flags = local_irq_save();
     
     released = (!mouse_left_btn && prev_mouse_left_btn);
     prev_mouse_left_btn = mouse_left_btn;
     
-    if (flags & 0x200) asm volatile("sti");
+    local_irq_restore(flags);
     
     return released;
 }
\ No newline at end of file
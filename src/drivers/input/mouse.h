@@ -3,11 +3,37 @@
 
 #include <stdint.h>
 
+// Default PS/2 sample rate; "mouse_rate=<hz>" picks another (10-200)
+#define MOUSE_RATE_DEFAULT 200
+
 extern int mouse_x;
 extern int mouse_y;
 
-void init_mouse();
-void mouse_handler();
+typedef struct {
+    uint32_t rate;              // PS/2 samples per second
+    uint32_t packet_size;       // 3, or 4 with a wheel
+    uint64_t packets;           // PS/2 packets decoded
+    uint64_t reports;           // Pointer updates applied (any device)
+    uint64_t resyncs;           // Bytes dropped to regain packet sync
+} mouse_stats_t;
+
+// Probe the PS/2 aux port and hook IRQ12; -1 if there is no mouse
+int init_mouse(void);
+int mouse_handler(void* ctx);
+
+// Apply one relative report from any pointing device (dy grows downwards,
+// bit 0 of buttons is the left button). Runs in tasklet context.
+void mouse_report(int dx, int dy, uint8_t buttons);
+
+// Wheel steps (positive scrolls down), collected until the GUI takes them
+// once per frame
+void mouse_wheel(int dz);
+int mouse_wheel_take(void);
+
+void mouse_get_stats(mouse_stats_t* stats);
+
+// Consistent snapshot of the pointer position
+void mouse_get_position(int* x, int* y);
 int mouse_button_left();
 int mouse_button_pressed();
 int mouse_button_released();
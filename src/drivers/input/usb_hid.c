@@ -0,0 +1,145 @@
+#include "usb_hid.h"
+#include "drivers/input/keyboard.h"
+#include "drivers/input/mouse.h"
+#include "lib/string.h"
+#include <stddef.h>
+
+// Extended (0xE0-prefixed) scancodes are marked in the high byte
+#define HID_EXT 0xE000
+
+// Boot keyboard usage IDs to PC scancode set 1 (0: no key)
+static const uint16_t hid_usage_to_set1[0x53] = {
+    [0x04] = 0x1E, 0x30, 0x2E, 0x20, 0x12, 0x21, 0x22, 0x23,   // a-h
+    [0x0C] = 0x17, 0x24, 0x25, 0x26, 0x32, 0x31, 0x18, 0x19,   // i-p
+    [0x14] = 0x10, 0x13, 0x1F, 0x14, 0x16, 0x2F, 0x11, 0x2D,   // q-x
+    [0x1C] = 0x15, 0x2C,                                       // y z
+    [0x1E] = 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09,   // 1-8
+    [0x26] = 0x0A, 0x0B,                                       // 9 0
+    [0x28] = 0x1C, 0x01, 0x0E, 0x0F, 0x39,                     // Enter Esc Bksp Tab Space
+    [0x2D] = 0x0C, 0x0D, 0x1A, 0x1B, 0x2B, 0x2B,               // - = [ ] \ #
+    [0x33] = 0x27, 0x28, 0x29, 0x33, 0x34, 0x35, 0x3A,         // ; ' ` , . / Caps
+    [0x3A] = 0x3B, 0x3C, 0x3D, 0x3E, 0x3F, 0x40, 0x41, 0x42,   // F1-F8
+    [0x42] = 0x43, 0x44, 0x57, 0x58,                           // F9-F12
+    [0x49] = HID_EXT | 0x52, HID_EXT | 0x47, HID_EXT | 0x49,   // Insert Home PgUp
+    [0x4C] = HID_EXT | 0x53, HID_EXT | 0x4F, HID_EXT | 0x51,   // Delete End PgDn
+    [0x4F] = HID_EXT | 0x4D, HID_EXT | 0x4B,                   // Right Left
+    [0x51] = HID_EXT | 0x50, HID_EXT | 0x48,                   // Down Up
+};
+
+// Modifier byte bits: LCtrl LShift LAlt LGUI RCtrl RShift RAlt RGUI
+static const uint16_t hid_modifier_to_set1[8] = {
+    0x1D, 0x2A, 0x38, HID_EXT | 0x5B, HID_EXT | 0x1D, 0x36, HID_EXT | 0x38, HID_EXT | 0x5C,
+};
+
+typedef struct {
+    uint8_t last[HID_KBD_REPORT];
+} usb_kbd_t;
+
+static usb_kbd_t usb_kbds[USB_MAX_DEVICES];
+static int usb_kbd_count = 0;
+
+static void hid_send_key(uint16_t code, int pressed) {
+    if (!code) return;
+    if (code & HID_EXT) keyboard_inject_scancode(0xE0);
+    keyboard_inject_scancode((code & 0x7F) | (pressed ? 0 : 0x80));
+}
+
+static int hid_report_has(const uint8_t* report, uint8_t usage) {
+    for (int i = 2; i < HID_KBD_REPORT; i++) {
+        if (report[i] == usage) return 1;
+    }
+    return 0;
+}
+
+// A boot report lists the keys held down; turn the difference from the
+// previous report into make and break codes
+static void usb_kbd_report(usb_device_t* dev, const uint8_t* data, int length) {
+    usb_kbd_t* kbd = (usb_kbd_t*)dev->driver_data;
+    if (length < HID_KBD_REPORT) return;
+    
+    // Phantom state (too many keys): keep the previous report
+    if (data[2] == 0x01) return;
+    
+    uint8_t changed = data[0] ^ kbd->last[0];
+    for (int bit = 0; bit < 8; bit++) {
+        if (changed & (1 << bit)) hid_send_key(hid_modifier_to_set1[bit], (data[0] >> bit) & 1);
+    }
+    
+    for (int i = 2; i < HID_KBD_REPORT; i++) {
+        uint8_t usage = kbd->last[i];
+        if (usage >= 0x04 && usage < 0x53 && !hid_report_has(data, usage)) {
+            hid_send_key(hid_usage_to_set1[usage], 0);
+        }
+    }
+    for (int i = 2; i < HID_KBD_REPORT; i++) {
+        uint8_t usage = data[i];
+        if (usage >= 0x04 && usage < 0x53 && !hid_report_has(kbd->last, usage)) {
+            hid_send_key(hid_usage_to_set1[usage], 1);
+        }
+    }
+    
+    memcpy(kbd->last, data, HID_KBD_REPORT);
+}
+
+// Boot mouse report: buttons, then signed x and y steps (y grows
+// downwards). Most mice append the wheel, counting up as away from the
+// user.
+static void usb_mouse_report(usb_device_t* dev, const uint8_t* data, int length) {
+    (void)dev;
+    if (length < 3) return;
+    mouse_report((int8_t)data[1], (int8_t)data[2], data[0]);
+    if (length >= 4 && data[3]) mouse_wheel(-(int8_t)data[3]);
+}
+
+int usb_hid_probe(usb_device_t* dev, const struct usb_interface_descriptor* iface,
+                  const uint8_t* extra, int extra_len) {
+    if (iface->interface_subclass != HID_SUBCLASS_BOOT) return -1;
+    if (iface->interface_protocol != HID_BOOT_KEYBOARD &&
+        iface->interface_protocol != HID_BOOT_MOUSE) {
+        return -1;
+    }
+    
+    // First interrupt IN endpoint before the next interface
+    const struct usb_endpoint_descriptor* ep = NULL;
+    for (int pos = 0; pos + 2 <= extra_len && extra[pos] >= 2; pos += extra[pos]) {
+        if (extra[pos + 1] == USB_DESC_INTERFACE) break;
+        if (extra[pos + 1] != USB_DESC_ENDPOINT || pos + extra[pos] > extra_len) continue;
+        
+        const struct usb_endpoint_descriptor* candidate = (const struct usb_endpoint_descriptor*)&extra[pos];
+        if ((candidate->endpoint_address & USB_ENDPOINT_IN) &&
+            (candidate->attributes & 0x03) == USB_ENDPOINT_INTERRUPT) {
+            ep = candidate;
+            break;
+        }
+    }
+    if (!ep) return -1;
+    
+    uint8_t request_type = USB_TYPE_CLASS | USB_RECIP_INTERFACE;
+    usb_control(dev, request_type, HID_REQ_SET_PROTOCOL, HID_PROTOCOL_BOOT,
+                iface->interface_number, 0, NULL);
+    
+    usb_complete_t complete;
+    if (iface->interface_protocol == HID_BOOT_KEYBOARD) {
+        if (usb_kbd_count >= USB_MAX_DEVICES) return -1;
+        usb_kbd_t* kbd = &usb_kbds[usb_kbd_count++];
+        memset(kbd, 0, sizeof(*kbd));
+        dev->driver_data = kbd;
+        dev->driver = "hid keyboard";
+        complete = usb_kbd_report;
+        
+        // Report only on changes, not at every poll
+        usb_control(dev, request_type, HID_REQ_SET_IDLE, 0, iface->interface_number, 0, NULL);
+    } else {
+        dev->driver = "hid mouse";
+        complete = usb_mouse_report;
+    }
+    
+    // Boot reports are 8 bytes or less, whatever the endpoint allows
+    uint16_t max_packet = ep->max_packet_size & 0x7FF;
+    if (max_packet > HID_KBD_REPORT) max_packet = HID_KBD_REPORT;
+    if (dev->hcd->interrupt_in(dev, ep->endpoint_address, max_packet, ep->interval, complete) != 0) {
+        dev->driver = NULL;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,25 @@
+#ifndef USB_HID_H
+#define USB_HID_H
+
+#include <stdint.h>
+#include "drivers/bus/usb.h"
+
+// HID class requests
+#define HID_REQ_SET_IDLE        0x0A
+#define HID_REQ_SET_PROTOCOL    0x0B
+#define HID_PROTOCOL_BOOT       0
+
+#define HID_SUBCLASS_BOOT       1
+#define HID_BOOT_KEYBOARD       1
+#define HID_BOOT_MOUSE          2
+
+#define HID_KBD_REPORT          8       // Boot keyboard report bytes
+
+// Bind a boot-protocol keyboard or mouse interface. `extra` holds the
+// descriptors that follow the interface in the configuration (its
+// endpoints). Keys are fed to the PS/2 keyboard path as set-1 scancodes,
+// movement to mouse_report. Returns 0 if the interface was claimed.
+int usb_hid_probe(usb_device_t* dev, const struct usb_interface_descriptor* iface,
+                  const uint8_t* extra, int extra_len);
+
+#endif
@@ -1,19 +1,39 @@
 #include "graphics.h"
 #include "include/font.h"
 #include "lib/string.h"
+#include "lib/printf.h"
 #include "mm/heap.h"
+#include "mm/vmm.h"
+#include "mm/pmm.h"
+#include "kernel/tsc.h"
+#include "kernel/input_latency.h"
+#include "drivers/char/serial.h"
 #include <stddef.h>
 
+#define LARGE_PAGE_SIZE 0x200000
+
 uint32_t* video_memory;
 int screen_w, screen_h;
 uint32_t* back_buffer = NULL;
 
+static int headless = 0;
+static uint64_t frame_checksum = 0;
+
+// Frame-to-frame times in TSC cycles
+static uint64_t frame_times[FRAME_HISTORY];
+static uint32_t frame_count = 0;
+static uint32_t frame_samples = 0;
+static uint64_t last_present = 0;
+static uint64_t first_present = 0;     // Never reset: the boot chart's time-to-GUI
+
 void graphics_init(struct multiboot_info* mb) {
     video_memory = (uint32_t*)(uintptr_t)mb->framebuffer_addr;  // 64-bit safe cast
     screen_w = (int)mb->framebuffer_width;
     screen_h = (int)mb->framebuffer_height;
+    headless = 0;
     
     uint32_t buffer_size = screen_w * screen_h * sizeof(uint32_t);
+    vmm_identity_map((uint64_t)(uintptr_t)video_memory, buffer_size, VMM_PRESENT | VMM_WRITE);
     back_buffer = (uint32_t*)malloc(buffer_size);
     
     if (!back_buffer) {
@@ -21,6 +41,34 @@ void graphics_init(struct multiboot_info* mb) {
     }
 }
 
+int graphics_init_headless(int width, int height) {
+    if (width > HEADLESS_MAX_WIDTH) width = HEADLESS_MAX_WIDTH;
+    if (width < HEADLESS_MIN_WIDTH) width = HEADLESS_MIN_WIDTH;
+    if (height > HEADLESS_MAX_HEIGHT) height = HEADLESS_MAX_HEIGHT;
+    if (height < HEADLESS_MIN_HEIGHT) height = HEADLESS_MIN_HEIGHT;
+    
+    // A 4K surface is larger than the whole bump heap
+    uint64_t size = (uint64_t)width * height * sizeof(uint32_t);
+    uint64_t stride = (size + LARGE_PAGE_SIZE - 1) & ~(uint64_t)(LARGE_PAGE_SIZE - 1);
+    // Map first: a failed map then leaves nothing reserved
+    if (vmm_identity_map(HEADLESS_BASE, stride * 2, VMM_PRESENT | VMM_WRITE) != 0) return -1;
+    if (pmm_reserve_range(HEADLESS_BASE, stride * 2) != 0) return -1;
+    
+    screen_w = width;
+    screen_h = height;
+    headless = 1;
+    
+    video_memory = (uint32_t*)(uintptr_t)HEADLESS_BASE;
+    back_buffer = (uint32_t*)(uintptr_t)(HEADLESS_BASE + stride);
+    memset(video_memory, 0, size);
+    memset(back_buffer, 0, size);
+    return 0;
+}
+
+int graphics_is_headless(void) {
+    return headless;
+}
+
 void put_pixel(int x, int y, uint32_t color) {
     if (x >= 0 && x < screen_w && y >= 0 && y < screen_h) {
         back_buffer[y * screen_w + x] = color;
@@ -62,8 +110,127 @@ void draw_string(int x, int y, uint32_t color, const char *str) {
     }
 }
 
+// Four independent multiply-xor lanes so the checksum keeps up with the
+// copy; lanes are folded together at the end
+static uint64_t frame_hash(const uint32_t* pixels, uint32_t count) {
+    const uint64_t prime = 0x100000001B3ULL;
+    uint64_t h0 = 0xCBF29CE484222325ULL;
+    uint64_t h1 = h0 ^ 1, h2 = h0 ^ 2, h3 = h0 ^ 3;
+    uint32_t i = 0;
+    
+    for (; i + 4 <= count; i += 4) {
+        h0 = (h0 ^ pixels[i]) * prime;
+        h1 = (h1 ^ pixels[i + 1]) * prime;
+        h2 = (h2 ^ pixels[i + 2]) * prime;
+        h3 = (h3 ^ pixels[i + 3]) * prime;
+    }
+    for (; i < count; i++) {
+        h0 = (h0 ^ pixels[i]) * prime;
+    }
+    
+    uint64_t h = h0;
+    h = (h ^ h1) * prime;
+    h = (h ^ h2) * prime;
+    h = (h ^ h3) * prime;
+    return h ^ ((uint64_t)(uint32_t)screen_w << 32 | (uint32_t)screen_h);
+}
+
+static void frame_record(void) {
+    uint64_t now = rdtsc();
+    
+    if (last_present) {
+        frame_times[frame_samples % FRAME_HISTORY] = now - last_present;
+        frame_samples++;
+    }
+    last_present = now;
+    if (!first_present) first_present = now;
+    frame_count++;
+}
+
 void swap_buffers() {
-    memcpy(video_memory, back_buffer, screen_w * screen_h * 4);
+    uint32_t pixels = screen_w * screen_h;
+    memcpy(video_memory, back_buffer, pixels * 4);
+    
+    if (headless) {
+        frame_checksum = frame_hash(video_memory, pixels);
+    }
+    frame_record();
+    input_latency_frame_flushed();
+}
+
+uint64_t graphics_checksum(void) {
+    return headless ? frame_checksum : 0;
+}
+
+uint64_t graphics_first_present(void) {
+    return first_present;
+}
+
+void graphics_frame_stats(frame_stats_t* out) {
+    static uint64_t sorted[FRAME_HISTORY];
+    uint32_t n = frame_samples < FRAME_HISTORY ? frame_samples : FRAME_HISTORY;
+    
+    memset(out, 0, sizeof(*out));
+    out->frames = frame_count;
+    out->samples = n;
+    if (n == 0) return;
+    
+    // Insertion sort; the history is small
+    for (uint32_t i = 0; i < n; i++) {
+        uint64_t v = frame_times[i];
+        uint32_t j = i;
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+    
+    out->min = sorted[0];
+    out->median = sorted[n / 2];
+    out->p99 = sorted[n * 99 / 100];
+    out->max = sorted[n - 1];
+}
+
+void graphics_frame_stats_reset(void) {
+    frame_count = 0;
+    frame_samples = 0;
+    last_present = 0;
+}
+
+void graphics_format_checksum(uint64_t sum, char* out) {
+    snprintf(out, 17, "%016llx", (unsigned long long)sum);
+}
+
+// "FRAME <w> <h> <checksum>", then lines of "count*rrggbb" runs, then "END"
+void graphics_dump_serial(void) {
+    char line[128];
+    uint32_t pixels = screen_w * screen_h;
+    
+    snprintf(line, sizeof(line), "FRAME %d %d %016llx\n", screen_w, screen_h,
+             (unsigned long long)frame_hash(video_memory, pixels));
+    serial_write_blocking(line);
+    
+    char* p = line;
+    uint32_t i = 0;
+    while (i < pixels) {
+        uint32_t color = video_memory[i] & 0xFFFFFF;
+        uint32_t run = 1;
+        while (i + run < pixels && (video_memory[i + run] & 0xFFFFFF) == color) run++;
+        i += run;
+        
+        p += snprintf(p, line + sizeof(line) - p, "%u*%06x ", run, color);
+        
+        // Flush before the next run could overflow the line
+        if (p - line > (int)sizeof(line) - 24 || i == pixels) {
+            p[-1] = '\n';
+            *p = 0;
+            serial_write_blocking(line);
+            p = line;
+        }
+    }
+    
+    serial_write_blocking("END\n");
 }
 
 void clear_screen(uint32_t color) {
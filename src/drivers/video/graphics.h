@@ -4,7 +4,52 @@
 #include <stdint.h>
 #include "include/multiboot.h"
 
+// Headless surfaces live in fixed physical memory above the heap so any
+// resolution up to 4K fits (front and back buffer, 2MB aligned); the
+// range is reserved in the PMM before use
+#define HEADLESS_BASE           0x4000000
+#define HEADLESS_MAX_WIDTH      3840
+#define HEADLESS_MAX_HEIGHT     2160
+#define HEADLESS_MIN_WIDTH      640
+#define HEADLESS_MIN_HEIGHT     480
+#define HEADLESS_DEFAULT_WIDTH  1920
+#define HEADLESS_DEFAULT_HEIGHT 1080
+
+// Frame-to-frame times kept for the statistics (power of two)
+#define FRAME_HISTORY 256
+
+typedef struct {
+    uint32_t frames;      // Frames presented since the last reset
+    uint32_t samples;     // Intervals in the history (at most FRAME_HISTORY)
+    uint64_t min;         // Frame-to-frame time in TSC cycles
+    uint64_t median;
+    uint64_t p99;
+    uint64_t max;
+} frame_stats_t;
+
 void graphics_init(struct multiboot_info* mb);
+
+// Render into memory instead of a framebuffer (clamped to the limits
+// above). Returns -1, leaving the display untouched, if the surfaces
+// don't fit in RAM or their range is already in use.
+int graphics_init_headless(int width, int height);
+int graphics_is_headless(void);
+
+// Checksum of the last presented headless frame (0 with a real framebuffer)
+uint64_t graphics_checksum(void);
+
+// Format a checksum as 16 hex digits (out holds at least 17 bytes)
+void graphics_format_checksum(uint64_t sum, char* out);
+
+void graphics_frame_stats(frame_stats_t* out);
+void graphics_frame_stats_reset(void);
+
+// TSC when swap_buffers first put a frame on screen (0 before that)
+uint64_t graphics_first_present(void);
+
+// Write the presented frame to serial as run-length encoded text
+void graphics_dump_serial(void);
+
 void put_pixel(int x, int y, uint32_t color);
 void draw_rect(int x, int y, int w, int h, uint32_t color);
 void draw_char(int x, int y, char c, uint32_t color);
@@ -0,0 +1,100 @@
+#include "compositor.h"
+#include "drivers/video/graphics.h"
+#include "gui/desktop.h"
+#include "gui/terminal.h"
+#include "gui/window_manager.h"
+#include "gui/taskbar.h"
+#include "gui/cursor.h"
+#include "kernel/trace.h"
+#include "kernel/debug.h"
+
+extern char terminal_buffer[];
+extern int term_idx;
+
+// Render-stage timeline (trace on / trace dump)
+DEFINE_TRACEPOINT(desktop_render_background);
+DEFINE_TRACEPOINT(terminal_render);
+DEFINE_TRACEPOINT(wm_render_all);
+DEFINE_TRACEPOINT(swap_buffers);
+
+// Render-stage zones (profile command)
+DEFINE_PROFILE_ZONE(zone_background, "render_background");
+DEFINE_PROFILE_ZONE(zone_terminals, "render_terminals");
+DEFINE_PROFILE_ZONE(zone_wm, "wm_render_all");
+DEFINE_PROFILE_ZONE(zone_taskbar, "render_taskbar_cursor");
+DEFINE_PROFILE_ZONE(zone_swap, "swap_buffers");
+
+void compositor_render_frame(void) {
+    // 1. Desktop background
+    trace_begin(desktop_render_background, 0);
+    profile_zone_enter(&zone_background);
+    desktop_render_background();
+    desktop_render_topbar();
+    profile_zone_exit(&zone_background);
+    trace_end(desktop_render_background, 0);
+    
+    // 2. FEATURE 1: Render ALL terminal windows (not just first one!)
+    trace_begin(terminal_render, 0);
+    profile_zone_enter(&zone_terminals);
+    window_manager_t* wm_state = wm_get_state();
+    rcu_read_lock();
+    for (int i = 0; i < MAX_WINDOWS; i++) {
+        window_t* win = &wm_state->windows[i];
+        
+        // Skip invalid or minimized windows
+        if (win->id == -1) continue;
+        if (!(win->flags & WIN_FLAG_VISIBLE)) continue;
+        if (win->flags & WIN_FLAG_MINIMIZED) continue;
+        
+        // Check if this window has a terminal instance
+        terminal_instance_t* term = (terminal_instance_t*)win->user_data;
+        if (!term) continue;  // Not a terminal window
+        
+        // Render this terminal's content
+        int win_content_x = win->x;
+        int win_content_y = win->y + TITLEBAR_HEIGHT;
+        int win_content_h = win->height;
+        
+        // Terminal output area
+        terminal_instance_render(term, win_content_x + 10, win_content_y + 10);
+        
+        // Input line at bottom of window (only for focused terminal)
+        if (win->id == wm_state->focused_window_id) {
+            int input_y = win_content_y + win_content_h - 25;
+            draw_string(win_content_x + 10, input_y, 0x00FF00, "$ ");
+            draw_string(win_content_x + 30, input_y, 0xFFFFFF, terminal_buffer);
+            
+            // Cursor blink
+            extern volatile int irq_count;
+            if ((irq_count / 25) % 2 == 0) {
+                draw_rect(win_content_x + 30 + (term_idx * 8), input_y, 8, 12, 0xFFFFFF);
+            }
+        }
+    }
+    rcu_read_unlock();
+    
+    // Render window frames (title bars, buttons, borders)
+    profile_zone_exit(&zone_terminals);
+    trace_end(terminal_render, 0);
+    
+    trace_begin(wm_render_all, 0);
+    profile_zone_enter(&zone_wm);
+    wm_render_all();
+    profile_zone_exit(&zone_wm);
+    trace_end(wm_render_all, 0);
+    
+    // 3. Taskbar (always on top)
+    profile_zone_enter(&zone_taskbar);
+    taskbar_render();
+    
+    // 4. Cursor (absolutely last - on top of everything)
+    cursor_render();
+    profile_zone_exit(&zone_taskbar);
+    
+    // Swap buffers to display
+    trace_begin(swap_buffers, 0);
+    profile_zone_enter(&zone_swap);
+    swap_buffers();
+    profile_zone_exit(&zone_swap);
+    trace_end(swap_buffers, 0);
+}
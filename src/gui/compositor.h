@@ -0,0 +1,8 @@
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+
+// Draw one frame into the back buffer (desktop, terminal contents,
+// window frames, taskbar, cursor) and swap it to the screen
+void compositor_render_frame(void);
+
+#endif
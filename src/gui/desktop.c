@@ -1,6 +1,7 @@
 #include "desktop.h"
 #include "drivers/video/graphics.h"
 #include "lib/string.h"
+#include "lib/printf.h"
 #include "kernel/timer.h"
 
 static desktop_t desktop;
@@ -42,16 +43,7 @@ void desktop_render_topbar() {
     // Cap hours at 99
     if (hours > 99) hours = 99;
     
-    // Format: HH:MM:SS
-    timestr[0] = '0' + (hours / 10);
-    timestr[1] = '0' + (hours % 10);
-    timestr[2] = ':';
-    timestr[3] = '0' + (minutes / 10);
-    timestr[4] = '0' + (minutes % 10);
-    timestr[5] = ':';
-    timestr[6] = '0' + (seconds / 10);
-    timestr[7] = '0' + (seconds % 10);
-    timestr[8] = '\0';
+    snprintf(timestr, sizeof(timestr), "%02u:%02u:%02u", hours, minutes, seconds);
     
     // UX FIX: Show RAM next to uptime for better layout
     extern uint32_t pmm_get_free_memory();
@@ -61,21 +53,7 @@ void desktop_render_topbar() {
     uint32_t total_mb = pmm_get_total_memory() / 1024 / 1024;
     
     char ramstr[32];
-    int idx = 0;
-    ramstr[idx++] = 'R';
-    ramstr[idx++] = 'A';
-    ramstr[idx++] = 'M';
-    ramstr[idx++] = ':';
-    ramstr[idx++] = ' ';
-    if (free_mb >= 100) ramstr[idx++] = '0' + (free_mb / 100);
-    if (free_mb >= 10) ramstr[idx++] = '0' + ((free_mb / 10) % 10);
-    ramstr[idx++] = '0' + (free_mb % 10);
-    ramstr[idx++] = '/';
-    if (total_mb >= 100) ramstr[idx++] = '0' + (total_mb / 100);
-    if (total_mb >= 10) ramstr[idx++] = '0' + ((total_mb / 10) % 10);
-    ramstr[idx++] = '0' + (total_mb % 10);
-    ramstr[idx++] = 'M';
-    ramstr[idx++] = '\0';
+    snprintf(ramstr, sizeof(ramstr), "RAM: %u/%uM", free_mb, total_mb);
     
     // Draw both: RAM then uptime
     draw_string(screen_w - 180, 7, 0xECF0F1, ramstr);
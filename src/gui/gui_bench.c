@@ -0,0 +1,89 @@
+#include "drivers/video/graphics.h"
+#include "gui/terminal.h"
+#include "gui/window_manager.h"
+#include "kernel/bench.h"
+
+// Renderer and window-manager hot paths. These draw into the back buffer
+// (and swap_buffers onto the screen); the next frame repaints over them.
+
+static void bench_draw_rect(uint64_t size) {
+    draw_rect(0, 0, (int)size, (int)size, 0x00336699);
+}
+
+static void bench_draw_string(uint64_t arg) {
+    (void)arg;
+    draw_string(8, 8, 0x00FFFFFF, "The quick brown fox jumps over the lazy dog");
+}
+
+static void bench_swap_buffers(uint64_t arg) {
+    (void)arg;
+    swap_buffers();
+}
+
+DEFINE_BENCH(bench_rect_16, "draw_rect/16", bench_draw_rect, 16, 16);
+DEFINE_BENCH(bench_rect_128, "draw_rect/128", bench_draw_rect, 128, 4);
+DEFINE_BENCH(bench_rect_512, "draw_rect/512", bench_draw_rect, 512, 1);
+DEFINE_BENCH(bench_string, "draw_string/43", bench_draw_string, 0, 4);
+DEFINE_BENCH(bench_swap, "swap_buffers", bench_swap_buffers, 0, 1);
+
+// Printing into a full scratch terminal, so every line takes the scroll path
+static terminal_instance_t* bench_term = NULL;
+
+static void bench_term_setup(void) {
+    bench_term = terminal_create_instance();
+    if (!bench_term) return;
+    
+    for (int i = 0; i < MAX_LINES; i++) {
+        terminal_instance_print(bench_term, "");
+    }
+}
+
+static void bench_term_teardown(void) {
+    terminal_destroy_instance(bench_term);
+    bench_term = NULL;
+}
+
+static void bench_term_print(uint64_t arg) {
+    (void)arg;
+    if (bench_term) {
+        terminal_instance_print(bench_term, "bench: the quick brown fox jumps over the lazy dog");
+    }
+}
+
+DEFINE_BENCH_FIXTURE(bench_term_print_full, "terminal_instance_print", bench_term_print, 0, 4,
+                     bench_term_setup, bench_term_teardown);
+
+// Hit-testing with every window slot in use. The query point misses all
+// of them, which is the full-scan worst case a mouse move over the
+// desktop pays.
+static int bench_windows[MAX_WINDOWS];
+static int bench_window_count = 0;
+static int bench_saved_focus = -1;
+
+static void bench_wm_setup(void) {
+    bench_saved_focus = wm_get_state()->focused_window_id;
+    bench_window_count = 0;
+    
+    while (wm_get_state()->window_count < MAX_WINDOWS) {
+        window_t* win = wm_create_window(screen_w - 220, 40, 200, 100, "bench");
+        if (!win) break;
+        bench_windows[bench_window_count++] = win->id;
+    }
+}
+
+static void bench_wm_teardown(void) {
+    for (int i = 0; i < bench_window_count; i++) {
+        wm_destroy_window(bench_windows[i]);
+    }
+    bench_window_count = 0;
+    
+    if (bench_saved_focus != -1) wm_focus_window(bench_saved_focus);
+}
+
+static void bench_wm_hit_test(uint64_t arg) {
+    (void)arg;
+    wm_get_window_at(screen_w - 1, screen_h - 31);
+}
+
+DEFINE_BENCH_FIXTURE(bench_wm, "wm_get_window_at", bench_wm_hit_test, 0, 16,
+                     bench_wm_setup, bench_wm_teardown);
@@ -108,6 +108,7 @@ void taskbar_render() {
     
     // Render window buttons
     window_manager_t* wm = wm_get_state();
+    rcu_read_lock();
     
     for (int i = 0; i < taskbar.button_count; i++) {
         taskbar_button_t* btn = &taskbar.buttons[i];
@@ -144,6 +145,7 @@ void taskbar_render() {
             draw_string(btn->x + 5, taskbar.y_position + 10, 0xECF0F1, display_label);
         }
     }
+    rcu_read_unlock();
     
     // UX: RAM moved to top bar - taskbar now cleaner
     // System tray area reserved for future use (clock, notifications, etc.)
@@ -26,6 +26,8 @@ void terminal_destroy_instance(terminal_instance_t* term) {
 void terminal_instance_init(terminal_instance_t* term) {
     if (!term) return;
     
+    spin_lock_init(&term->lock);
+    
     // Clear all buffers
     for (int i = 0; i < MAX_LINES; i++) {
         term->lines[i][0] = '\0';
@@ -47,10 +49,12 @@ void terminal_instance_init(terminal_instance_t* term) {
 void terminal_instance_print(terminal_instance_t* term, const char* text) {
     if (!term) return;
     
+    uint64_t flags = spin_lock_irqsave(&term->lock);
     if (!text || strlen(text) == 0) {
         // Print empty line
         term->lines[term->line_count % MAX_LINES][0] = '\0';
         term->line_count++;
+        spin_unlock_irqrestore(&term->lock, flags);
         return;
     }
     
@@ -77,24 +81,33 @@ void terminal_instance_print(terminal_instance_t* term, const char* text) {
     
     // Auto-scroll to bottom when new text appears
     term->scroll_offset = 0;
+    spin_unlock_irqrestore(&term->lock, flags);
 }
 
 // FEATURE 1: Clear specific terminal instance
 void terminal_instance_clear(terminal_instance_t* term) {
     if (!term) return;
     
+    uint64_t flags = spin_lock_irqsave(&term->lock);
     term->line_count = 0;
     term->scroll_offset = 0;
     
     for (int i = 0; i < MAX_LINES; i++) {
         term->lines[i][0] = '\0';
     }
+    spin_unlock_irqrestore(&term->lock, flags);
 }
 
 // FEATURE 1: Render specific terminal instance
 void terminal_instance_render(terminal_instance_t* term, int x, int y) {
     if (!term) return;
     
+    // Copy the visible lines under the lock and draw with interrupts on
+    char visible[VISIBLE_LINES][MAX_LINE_LENGTH];
+    int count = 0;
+    
+    uint64_t flags = spin_lock_irqsave(&term->lock);
+    
     // Calculate which lines to show
     int total_lines = term->line_count;
     int start_line = total_lines - VISIBLE_LINES - term->scroll_offset;
@@ -102,14 +115,15 @@ void terminal_instance_render(terminal_instance_t* term, int x, int y) {
     if (start_line < 0) start_line = 0;
     if (start_line > total_lines) start_line = total_lines;
     
-    int line_y = y;
-    int lines_drawn = 0;
+    for (int i = start_line; i < total_lines && count < VISIBLE_LINES; i++) {
+        strcpy(visible[count++], term->lines[i % MAX_LINES]);
+    }
+    spin_unlock_irqrestore(&term->lock, flags);
     
-    for (int i = start_line; i < total_lines && lines_drawn < VISIBLE_LINES; i++) {
-        const char* line = term->lines[i % MAX_LINES];
-        draw_string(x, line_y, 0xCCCCCC, line);
+    int line_y = y;
+    for (int i = 0; i < count; i++) {
+        draw_string(x, line_y, 0xCCCCCC, visible[i]);
         line_y += 12;  // Line height
-        lines_drawn++;
     }
 }
 
@@ -117,81 +131,92 @@ void terminal_instance_render(terminal_instance_t* term, int x, int y) {
 void terminal_instance_scroll_up(terminal_instance_t* term) {
     if (!term) return;
     
+    uint64_t flags = spin_lock_irqsave(&term->lock);
     int max_scroll = term->line_count - VISIBLE_LINES;
     if (max_scroll < 0) max_scroll = 0;
     
     if (term->scroll_offset < max_scroll) {
         term->scroll_offset++;
     }
+    spin_unlock_irqrestore(&term->lock, flags);
 }
 
 // FEATURE 1: Scroll down in specific terminal instance
 void terminal_instance_scroll_down(terminal_instance_t* term) {
     if (!term) return;
     
+    uint64_t flags = spin_lock_irqsave(&term->lock);
     if (term->scroll_offset > 0) {
         term->scroll_offset--;
     }
+    spin_unlock_irqrestore(&term->lock, flags);
 }
 
 // FEATURE 1: Add to history in specific terminal instance
 void terminal_instance_add_to_history(terminal_instance_t* term, const char* cmd) {
     if (!term || !cmd || strlen(cmd) == 0) return;
     
+    uint64_t flags = spin_lock_irqsave(&term->lock);
+    
     // Don't add duplicates of the last command
-    if (term->history_count > 0) {
-        int last_idx = (term->history_count - 1) % HISTORY_SIZE;
-        if (strcmp(term->history[last_idx], cmd) == 0) {
-            term->history_pos = term->history_count;
-            return;
-        }
+    int last_idx = (term->history_count - 1) % HISTORY_SIZE;
+    if (term->history_count == 0 || strcmp(term->history[last_idx], cmd) != 0) {
+        int idx = term->history_count % HISTORY_SIZE;
+        strcpy(term->history[idx], cmd);
+        term->history_count++;
     }
-    
-    // Add to history
-    int idx = term->history_count % HISTORY_SIZE;
-    strcpy(term->history[idx], cmd);
-    term->history_count++;
     term->history_pos = term->history_count;
+    spin_unlock_irqrestore(&term->lock, flags);
 }
 
 // FEATURE 1: Get previous history entry
 const char* terminal_instance_get_history_prev(terminal_instance_t* term) {
-    if (!term || term->history_count == 0) return NULL;
-    
-    if (term->history_pos > 0) {
-        term->history_pos--;
-    }
-    
-    int idx = term->history_pos % HISTORY_SIZE;
+    if (!term) return NULL;
     
-    if (term->history_pos >= term->history_count) {
-        return NULL;
+    uint64_t flags = spin_lock_irqsave(&term->lock);
+    const char* entry = NULL;
+    if (term->history_count > 0) {
+        if (term->history_pos > 0) {
+            term->history_pos--;
+        }
+        
+        if (term->history_pos < term->history_count) {
+            entry = term->history[term->history_pos % HISTORY_SIZE];
+        }
     }
-    
-    return term->history[idx];
+    spin_unlock_irqrestore(&term->lock, flags);
+    return entry;
 }
 
 // FEATURE 1: Get next history entry
 const char* terminal_instance_get_history_next(terminal_instance_t* term) {
-    if (!term || term->history_count == 0) return NULL;
-    
-    if (term->history_pos < term->history_count) {
-        term->history_pos++;
-    }
+    if (!term) return NULL;
     
-    // If we're at the end, return empty
-    if (term->history_pos >= term->history_count) {
-        return "";
+    uint64_t flags = spin_lock_irqsave(&term->lock);
+    const char* entry = NULL;
+    if (term->history_count > 0) {
+        if (term->history_pos < term->history_count) {
+            term->history_pos++;
+        }
+        
+        // If we're at the end, return empty
+        if (term->history_pos >= term->history_count) {
+            entry = "";
+        } else {
+            entry = term->history[term->history_pos % HISTORY_SIZE];
+        }
     }
-    
-    int idx = term->history_pos % HISTORY_SIZE;
-    return term->history[idx];
+    spin_unlock_irqrestore(&term->lock, flags);
+    return entry;
 }
 
 // FEATURE 1: Reset history position
 void terminal_instance_reset_history_pos(terminal_instance_t* term) {
     if (!term) return;
+    
+    uint64_t flags = spin_lock_irqsave(&term->lock);
     term->history_pos = term->history_count;
+    spin_unlock_irqrestore(&term->lock, flags);
 }
 
 // ========== LEGACY GLOBAL FUNCTIONS (for backwards compatibility) ==========
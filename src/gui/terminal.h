@@ -2,6 +2,7 @@
 #define TERMINAL_H
 
 #include <stdint.h>
+#include "kernel/spinlock.h"
 
 #define MAX_LINES 100
 #define MAX_LINE_LENGTH 120
@@ -18,6 +19,7 @@ typedef struct {
     int history_count;
     int history_pos;
     int cursor_pos;
+    spinlock_t lock;            // Held by every terminal_instance_* call
 } terminal_instance_t;
 
 // Legacy global terminal structure (for backwards compatibility)
@@ -1,6 +1,9 @@
 #include "window_manager.h"
+#include "gui/terminal.h"
 #include "drivers/video/graphics.h"
 #include "lib/string.h"
+#include "kernel/spinlock.h"
+#include <stddef.h>
 
 // Forward declaration for error messages
 extern void terminal_print(const char*);
@@ -15,8 +18,57 @@ extern void terminal_print(const char*);
 #define COLOR_MAX_BTN         0x27AE60
 #define COLOR_BTN_HOVER       0xFFFFFF
 
+// Terminal lines per wheel step
+#define WHEEL_LINES 3
+
 static window_manager_t wm;
 
+// Serializes every change to wm (RCU callbacks included, hence irqsave)
+static spinlock_t wm_lock = SPINLOCK_INIT;
+
+static window_t* wm_find(int window_id) {
+    for (int i = 0; i < MAX_WINDOWS; i++) {
+        if (wm.windows[i].id == window_id && !(wm.windows[i].flags & WIN_FLAG_DYING)) {
+            return &wm.windows[i];
+        }
+    }
+    return NULL;
+}
+
+static void wm_focus_window_locked(int window_id) {
+    // Unfocus current
+    if (wm.focused_window_id != -1) {
+        window_t* old_focused = wm_find(wm.focused_window_id);
+        if (old_focused) {
+            old_focused->flags &= ~WIN_FLAG_FOCUSED;
+        }
+    }
+    
+    // Focus new
+    wm.focused_window_id = window_id;
+    window_t* win = wm_find(window_id);
+    if (win) {
+        win->flags |= WIN_FLAG_FOCUSED;
+    }
+}
+
+static int wm_free_slot(void) {
+    for (int i = 0; i < MAX_WINDOWS; i++) {
+        if (wm.windows[i].id == -1) return i;
+    }
+    return -1;
+}
+
+// Grace period is over: no reader can still be looking at the slot
+static void wm_free_window(rcu_head_t* head) {
+    window_t* win = (window_t*)((char*)head - offsetof(window_t, rcu));
+    
+    uint64_t flags = spin_lock_irqsave(&wm_lock);
+    win->id = -1;
+    win->flags = 0;
+    spin_unlock_irqrestore(&wm_lock, flags);
+}
+
 void wm_init() {
     wm.window_count = 0;
     wm.focused_window_id = -1;
@@ -43,21 +95,24 @@ window_t* wm_create_window(int x, int y, int width, int height, const char* titl
         return NULL;
     }
     
+    uint64_t flags = spin_lock_irqsave(&wm_lock);
     if (wm.window_count >= MAX_WINDOWS) {
+        spin_unlock_irqrestore(&wm_lock, flags);
         terminal_print("ERROR: Maximum windows reached (16)");
         return NULL;
     }
     
-    // Find free slot
-    int slot = -1;
-    for (int i = 0; i < MAX_WINDOWS; i++) {
-        if (wm.windows[i].id == -1) {
-            slot = i;
-            break;
-        }
+    // Slots of recently destroyed windows come back after a grace period
+    int slot = wm_free_slot();
+    if (slot == -1) {
+        spin_unlock_irqrestore(&wm_lock, flags);
+        rcu_barrier();
+        flags = spin_lock_irqsave(&wm_lock);
+        slot = wm_free_slot();
     }
     
     if (slot == -1) {
+        spin_unlock_irqrestore(&wm_lock, flags);
         terminal_print("ERROR: No free window slots");
         return NULL;
     }
@@ -95,81 +150,71 @@ window_t* wm_create_window(int x, int y, int width, int height, const char* titl
     win->user_data = NULL;  // FEATURE 1
     
     wm.window_count++;
-    wm_focus_window(win->id);
+    wm_focus_window_locked(win->id);
+    spin_unlock_irqrestore(&wm_lock, flags);
     
     return win;
 }
 
 void wm_destroy_window(int window_id) {
-    for (int i = 0; i < MAX_WINDOWS; i++) {
-        if (wm.windows[i].id == window_id) {
-            // Call close callback if set
-            if (wm.windows[i].on_close) {
-                wm.windows[i].on_close(&wm.windows[i]);
-            }
-            
-            // BUG FIX: Remove taskbar button
-            extern void taskbar_remove_button(int);
-            taskbar_remove_button(window_id);
-            
-            wm.windows[i].id = -1;
-            wm.windows[i].flags = 0;
-            wm.window_count--;
-            
-            // Focus another window
-            if (wm.focused_window_id == window_id) {
-                wm.focused_window_id = -1;
-                // Find another visible window
-                for (int j = 0; j < MAX_WINDOWS; j++) {
-                    if (wm.windows[j].id != -1 && 
-                        (wm.windows[j].flags & WIN_FLAG_VISIBLE) &&
-                        !(wm.windows[j].flags & WIN_FLAG_MINIMIZED)) {
-                        wm_focus_window(wm.windows[j].id);
-                        break;
-                    }
-                }
+    uint64_t flags = spin_lock_irqsave(&wm_lock);
+    window_t* win = wm_find(window_id);
+    if (!win) {
+        spin_unlock_irqrestore(&wm_lock, flags);
+        return;
+    }
+    
+    // Readers skip it from now on; the slot stays put until they are done
+    win->flags = WIN_FLAG_DYING;
+    wm.window_count--;
+    
+    // Focus another window
+    if (wm.focused_window_id == window_id) {
+        wm.focused_window_id = -1;
+        // Find another visible window
+        for (int j = 0; j < MAX_WINDOWS; j++) {
+            if (wm.windows[j].id != -1 && 
+                (wm.windows[j].flags & WIN_FLAG_VISIBLE) &&
+                !(wm.windows[j].flags & WIN_FLAG_MINIMIZED)) {
+                wm_focus_window_locked(wm.windows[j].id);
+                break;
             }
-            return;
         }
     }
+    spin_unlock_irqrestore(&wm_lock, flags);
+    
+    // Call close callback if set
+    if (win->on_close) {
+        win->on_close(win);
+    }
+    
+    // BUG FIX: Remove taskbar button
+    extern void taskbar_remove_button(int);
+    taskbar_remove_button(window_id);
+    
+    call_rcu(&win->rcu, wm_free_window);
 }
 
 window_t* wm_get_window(int window_id) {
-    for (int i = 0; i < MAX_WINDOWS; i++) {
-        if (wm.windows[i].id == window_id) {
-            return &wm.windows[i];
-        }
-    }
-    return NULL;
+    return wm_find(window_id);
 }
 
 void wm_focus_window(int window_id) {
-    // Unfocus current
-    if (wm.focused_window_id != -1) {
-        window_t* old_focused = wm_get_window(wm.focused_window_id);
-        if (old_focused) {
-            old_focused->flags &= ~WIN_FLAG_FOCUSED;
-        }
-    }
-    
-    // Focus new
-    wm.focused_window_id = window_id;
-    window_t* win = wm_get_window(window_id);
-    if (win) {
-        win->flags |= WIN_FLAG_FOCUSED;
-    }
+    uint64_t flags = spin_lock_irqsave(&wm_lock);
+    wm_focus_window_locked(window_id);
+    spin_unlock_irqrestore(&wm_lock, flags);
 }
 
 void wm_minimize_window(int window_id) {
-    window_t* win = wm_get_window(window_id);
-    if (!win) return;
+    uint64_t flags = spin_lock_irqsave(&wm_lock);
+    window_t* win = wm_find(window_id);
+    if (!win) {
+        spin_unlock_irqrestore(&wm_lock, flags);
+        return;
+    }
     
     win->flags |= WIN_FLAG_MINIMIZED;
     
-    if (win->on_minimize) {
-        win->on_minimize(win);
-    }
-    
     // Focus another window
     if (wm.focused_window_id == window_id) {
         wm.focused_window_id = -1;
@@ -178,16 +223,25 @@ void wm_minimize_window(int window_id) {
                 wm.windows[i].id != window_id &&
                 (wm.windows[i].flags & WIN_FLAG_VISIBLE) &&
                 !(wm.windows[i].flags & WIN_FLAG_MINIMIZED)) {
-                wm_focus_window(wm.windows[i].id);
+                wm_focus_window_locked(wm.windows[i].id);
                 break;
             }
         }
     }
+    spin_unlock_irqrestore(&wm_lock, flags);
+    
+    if (win->on_minimize) {
+        win->on_minimize(win);
+    }
 }
 
 void wm_maximize_window(int window_id) {
-    window_t* win = wm_get_window(window_id);
-    if (!win) return;
+    uint64_t flags = spin_lock_irqsave(&wm_lock);
+    window_t* win = wm_find(window_id);
+    if (!win) {
+        spin_unlock_irqrestore(&wm_lock, flags);
+        return;
+    }
     
     extern int screen_w, screen_h;
     
@@ -212,6 +266,7 @@ void wm_maximize_window(int window_id) {
         win->height = screen_h - 25 - 30;  // Above taskbar
         win->flags |= WIN_FLAG_MAXIMIZED;
     }
+    spin_unlock_irqrestore(&wm_lock, flags);
     
     if (win->on_maximize) {
         win->on_maximize(win);
@@ -219,60 +274,70 @@ void wm_maximize_window(int window_id) {
 }
 
 void wm_restore_window(int window_id) {
-    window_t* win = wm_get_window(window_id);
-    if (!win) return;
-    
-    win->flags &= ~WIN_FLAG_MINIMIZED;
-    wm_focus_window(window_id);
+    uint64_t flags = spin_lock_irqsave(&wm_lock);
+    window_t* win = wm_find(window_id);
+    if (win) {
+        win->flags &= ~WIN_FLAG_MINIMIZED;
+        wm_focus_window_locked(window_id);
+    }
+    spin_unlock_irqrestore(&wm_lock, flags);
 }
 
 void wm_move_window(int window_id, int new_x, int new_y) {
-    window_t* win = wm_get_window(window_id);
-    if (!win) return;
-    
-    win->x = new_x;
-    win->y = new_y;
+    uint64_t flags = spin_lock_irqsave(&wm_lock);
+    window_t* win = wm_find(window_id);
+    if (win) {
+        win->x = new_x;
+        win->y = new_y;
+    }
+    spin_unlock_irqrestore(&wm_lock, flags);
 }
 
 void wm_resize_window(int window_id, int new_width, int new_height) {
-    window_t* win = wm_get_window(window_id);
-    if (!win) return;
-    
     if (new_width < 200) new_width = 200;
     if (new_height < 150) new_height = 150;
     
-    win->width = new_width;
-    win->height = new_height;
+    uint64_t flags = spin_lock_irqsave(&wm_lock);
+    window_t* win = wm_find(window_id);
+    if (win) {
+        win->width = new_width;
+        win->height = new_height;
+    }
+    spin_unlock_irqrestore(&wm_lock, flags);
+}
+
+static int wm_hit(const window_t* win, int x, int y) {
+    return x >= win->x && x < win->x + win->width &&
+           y >= win->y && y < win->y + win->height + TITLEBAR_HEIGHT;
 }
 
 int wm_get_window_at(int x, int y) {
+    int found = -1;
+    rcu_read_lock();
+    
     // Check from front to back (focused window first)
-    if (wm.focused_window_id != -1) {
-        window_t* win = wm_get_window(wm.focused_window_id);
+    int focused_id = wm.focused_window_id;
+    if (focused_id != -1) {
+        window_t* win = wm_find(focused_id);
         if (win && (win->flags & WIN_FLAG_VISIBLE) && 
-            !(win->flags & WIN_FLAG_MINIMIZED)) {
-            if (x >= win->x && x < win->x + win->width &&
-                y >= win->y && y < win->y + win->height + TITLEBAR_HEIGHT) {
-                return win->id;
-            }
+            !(win->flags & WIN_FLAG_MINIMIZED) && wm_hit(win, x, y)) {
+            found = win->id;
         }
     }
     
     // Check other windows
-    for (int i = 0; i < MAX_WINDOWS; i++) {
-        if (wm.windows[i].id == -1) continue;
-        if (wm.windows[i].id == wm.focused_window_id) continue;
-        if (!(wm.windows[i].flags & WIN_FLAG_VISIBLE)) continue;
-        if (wm.windows[i].flags & WIN_FLAG_MINIMIZED) continue;
-        
+    for (int i = 0; i < MAX_WINDOWS && found == -1; i++) {
         window_t* win = &wm.windows[i];
-        if (x >= win->x && x < win->x + win->width &&
-            y >= win->y && y < win->y + win->height + TITLEBAR_HEIGHT) {
-            return win->id;
-        }
+        if (win->id == -1) continue;
+        if (win->id == focused_id) continue;
+        if (!(win->flags & WIN_FLAG_VISIBLE)) continue;
+        if (win->flags & WIN_FLAG_MINIMIZED) continue;
+        
+        if (wm_hit(win, x, y)) found = win->id;
     }
     
-    return -1;
+    rcu_read_unlock();
+    return found;
 }
 
 int wm_is_point_in_titlebar(window_t* win, int x, int y) {
@@ -363,44 +428,54 @@ void wm_render_window(window_t* win) {
 }
 
 void wm_render_all() {
+    rcu_read_lock();
+    int focused_id = wm.focused_window_id;
+    
     // Render unfocused windows first
     for (int i = 0; i < MAX_WINDOWS; i++) {
         if (wm.windows[i].id == -1) continue;
-        if (wm.windows[i].id == wm.focused_window_id) continue;
+        if (wm.windows[i].id == focused_id) continue;
         wm_render_window(&wm.windows[i]);
     }
     
     // Render focused window last (on top)
-    if (wm.focused_window_id != -1) {
-        window_t* focused = wm_get_window(wm.focused_window_id);
+    if (focused_id != -1) {
+        window_t* focused = wm_find(focused_id);
         if (focused) {
             wm_render_window(focused);
         }
     }
+    rcu_read_unlock();
 }
 
 void wm_handle_mouse_down(int x, int y) {
     int window_id = wm_get_window_at(x, y);
     if (window_id == -1) return;
     
-    window_t* win = wm_get_window(window_id);
-    if (!win) return;
-    
     // Focus this window
-    wm_focus_window(window_id);
+    uint64_t flags = spin_lock_irqsave(&wm_lock);
+    window_t* win = wm_find(window_id);
+    if (!win) {
+        spin_unlock_irqrestore(&wm_lock, flags);
+        return;
+    }
+    wm_focus_window_locked(window_id);
     
-    // Check button clicks
+    // Button clicks run their callbacks, so they drop the lock first
     if (wm_is_point_in_close_button(win, x, y)) {
+        spin_unlock_irqrestore(&wm_lock, flags);
         wm_destroy_window(window_id);
         return;
     }
     
     if (wm_is_point_in_minimize_button(win, x, y)) {
+        spin_unlock_irqrestore(&wm_lock, flags);
         wm_minimize_window(window_id);
         return;
     }
     
     if (wm_is_point_in_maximize_button(win, x, y)) {
+        spin_unlock_irqrestore(&wm_lock, flags);
         wm_maximize_window(window_id);
         return;
     }
@@ -411,18 +486,24 @@ void wm_handle_mouse_down(int x, int y) {
         win->drag_offset_x = x - win->x;
         win->drag_offset_y = y - win->y;
     }
+    spin_unlock_irqrestore(&wm_lock, flags);
 }
 
 void wm_handle_mouse_up(int x, int y) {
+    uint64_t flags = spin_lock_irqsave(&wm_lock);
+    
     // Stop dragging all windows
     for (int i = 0; i < MAX_WINDOWS; i++) {
         if (wm.windows[i].id != -1) {
             wm.windows[i].flags &= ~WIN_FLAG_DRAGGING;
         }
     }
+    spin_unlock_irqrestore(&wm_lock, flags);
 }
 
 void wm_handle_mouse_move(int x, int y) {
+    uint64_t flags = spin_lock_irqsave(&wm_lock);
+    
     // Handle window dragging
     for (int i = 0; i < MAX_WINDOWS; i++) {
         if (wm.windows[i].id == -1) continue;
@@ -457,6 +538,30 @@ void wm_handle_mouse_move(int x, int y) {
         win->x = new_x;
         win->y = new_y;
     }
+    spin_unlock_irqrestore(&wm_lock, flags);
+}
+
+void wm_handle_mouse_wheel(int x, int y, int steps) {
+    int window_id = wm_get_window_at(x, y);
+    if (window_id == -1) return;
+    
+    rcu_read_lock();
+    window_t* win = wm_find(window_id);
+    if (!win || !win->user_data) {
+        rcu_read_unlock();
+        return;
+    }
+    
+    // Terminal windows carry their instance in user_data
+    terminal_instance_t* term = (terminal_instance_t*)win->user_data;
+    for (int i = 0; i < WHEEL_LINES * (steps < 0 ? -steps : steps); i++) {
+        if (steps < 0) {
+            terminal_instance_scroll_up(term);
+        } else {
+            terminal_instance_scroll_down(term);
+        }
+    }
+    rcu_read_unlock();
 }
 
 window_manager_t* wm_get_state() {
@@ -2,6 +2,7 @@
 #define WINDOW_MANAGER_H
 
 #include <stdint.h>
+#include "kernel/rcu.h"
 
 #define MAX_WINDOWS 16
 #define TITLEBAR_HEIGHT 22
@@ -13,6 +14,7 @@
 #define WIN_FLAG_MINIMIZED  0x04
 #define WIN_FLAG_MAXIMIZED  0x08
 #define WIN_FLAG_DRAGGING   0x10
+#define WIN_FLAG_DYING      0x20    // Destroyed, slot freed after a grace period
 
 // Window structure
 typedef struct window {
@@ -35,9 +37,14 @@ typedef struct window {
     
     // FEATURE 1: User data for custom window state (e.g., terminal instance)
     void* user_data;
+    
+    rcu_head_t rcu;             // Frees the slot once readers are done
 } window_t;
 
-// Window manager state
+// Window manager state. Changes to the list and to window geometry go
+// through the wm_* calls, which serialize on one lock; the compositor and
+// hit-testing walk the list under rcu_read_lock. A destroyed window's slot
+// is only reused after a grace period.
 typedef struct {
     window_t windows[MAX_WINDOWS];
     int window_count;
@@ -51,6 +58,7 @@ void wm_init();
 // Window creation/destruction
 window_t* wm_create_window(int x, int y, int width, int height, const char* title);
 void wm_destroy_window(int window_id);
+// The pointer stays valid while the caller is inside rcu_read_lock
 window_t* wm_get_window(int window_id);
 
 // Window operations
@@ -77,6 +85,9 @@ void wm_handle_mouse_down(int x, int y);
 void wm_handle_mouse_up(int x, int y);
 void wm_handle_mouse_move(int x, int y);
 
+// Scroll the terminal under the pointer (steps > 0 scroll down)
+void wm_handle_mouse_wheel(int x, int y, int steps);
+
 // Get window manager state
 window_manager_t* wm_get_state();
 
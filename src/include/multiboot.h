@@ -3,6 +3,9 @@
 
 #include <stdint.h>
 
+// multiboot_info flags: which fields the loader filled in
+#define MULTIBOOT_INFO_MEMORY   0x001   // mem_lower / mem_upper
+
 struct multiboot_info {
     uint32_t flags;
     uint32_t mem_lower;
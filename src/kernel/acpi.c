@@ -0,0 +1,92 @@
+#include "acpi.h"
+#include "mm/vmm.h"
+#include "lib/string.h"
+
+static acpi_rsdp_t* rsdp = NULL;
+static acpi_sdt_header_t* root_table = NULL;
+static int root_is_xsdt = 0;
+
+static int acpi_checksum_ok(const void* ptr, uint32_t length) {
+    const uint8_t* bytes = (const uint8_t*)ptr;
+    uint8_t sum = 0;
+    for (uint32_t i = 0; i < length; i++) {
+        sum += bytes[i];
+    }
+    return sum == 0;
+}
+
+// Scan a physical range on 16-byte boundaries for "RSD PTR "
+static acpi_rsdp_t* acpi_scan_rsdp(uint64_t start, uint64_t length) {
+    for (uint64_t addr = start; addr < start + length; addr += 16) {
+        acpi_rsdp_t* candidate = (acpi_rsdp_t*)(uintptr_t)addr;
+        if (strncmp(candidate->signature, "RSD PTR ", 8) == 0 &&
+            acpi_checksum_ok(candidate, 20)) {
+            return candidate;
+        }
+    }
+    return NULL;
+}
+
+// Tables usually live near the top of RAM, outside the boot mapping.
+// Map the header first, then the whole table once its length is known.
+static acpi_sdt_header_t* acpi_map_table(uint64_t phys) {
+    if (phys == 0) return NULL;
+    
+    vmm_identity_map(phys, sizeof(acpi_sdt_header_t), VMM_PRESENT);
+    acpi_sdt_header_t* table = (acpi_sdt_header_t*)(uintptr_t)phys;
+    vmm_identity_map(phys, table->length, VMM_PRESENT);
+    
+    if (!acpi_checksum_ok(table, table->length)) return NULL;
+    return table;
+}
+
+int acpi_init(void) {
+    // 1. First KB of the EBDA (segment stored at 0x40E)
+    uint64_t ebda = (uint64_t)(*(volatile uint16_t*)(uintptr_t)0x40E) << 4;
+    if (ebda) {
+        rsdp = acpi_scan_rsdp(ebda, 1024);
+    }
+    
+    // 2. BIOS read-only area
+    if (!rsdp) {
+        rsdp = acpi_scan_rsdp(0xE0000, 0x20000);
+    }
+    
+    if (!rsdp) return 0;
+    
+    if (rsdp->revision >= 2 && rsdp->xsdt_address) {
+        root_table = acpi_map_table(rsdp->xsdt_address);
+        root_is_xsdt = (root_table != NULL);
+    }
+    
+    if (!root_table) {
+        root_table = acpi_map_table(rsdp->rsdt_address);
+        root_is_xsdt = 0;
+    }
+    
+    return root_table != NULL;
+}
+
+acpi_sdt_header_t* acpi_find_table(const char* signature) {
+    if (!root_table) return NULL;
+    
+    uint32_t entry_size = root_is_xsdt ? 8 : 4;
+    uint32_t entries = (root_table->length - sizeof(acpi_sdt_header_t)) / entry_size;
+    uint8_t* entry_base = (uint8_t*)root_table + sizeof(acpi_sdt_header_t);
+    
+    for (uint32_t i = 0; i < entries; i++) {
+        uint64_t phys;
+        if (root_is_xsdt) {
+            phys = *(uint64_t*)(entry_base + i * 8);
+        } else {
+            phys = *(uint32_t*)(entry_base + i * 4);
+        }
+        
+        acpi_sdt_header_t* table = acpi_map_table(phys);
+        if (table && strncmp(table->signature, signature, 4) == 0) {
+            return table;
+        }
+    }
+    
+    return NULL;
+}
@@ -0,0 +1,132 @@
+#ifndef ACPI_H
+#define ACPI_H
+
+#include <stdint.h>
+
+// Root System Description Pointer
+typedef struct {
+    char signature[8];        // "RSD PTR "
+    uint8_t checksum;
+    char oem_id[6];
+    uint8_t revision;         // 0 = ACPI 1.0, 2+ = has XSDT
+    uint32_t rsdt_address;
+    // ACPI 2.0+
+    uint32_t length;
+    uint64_t xsdt_address;
+    uint8_t extended_checksum;
+    uint8_t reserved[3];
+} __attribute__((packed)) acpi_rsdp_t;
+
+// Common header of every System Description Table
+typedef struct {
+    char signature[4];
+    uint32_t length;
+    uint8_t revision;
+    uint8_t checksum;
+    char oem_id[6];
+    char oem_table_id[8];
+    uint32_t oem_revision;
+    uint32_t creator_id;
+    uint32_t creator_revision;
+} __attribute__((packed)) acpi_sdt_header_t;
+
+// Generic Address Structure
+typedef struct {
+    uint8_t address_space_id;  // 0 = memory, 1 = I/O port
+    uint8_t register_bit_width;
+    uint8_t register_bit_offset;
+    uint8_t reserved;
+    uint64_t address;
+} __attribute__((packed)) acpi_gas_t;
+
+// HPET description table ("HPET")
+typedef struct {
+    acpi_sdt_header_t header;
+    uint32_t event_timer_block_id;
+    acpi_gas_t base_address;
+    uint8_t hpet_number;
+    uint16_t minimum_tick;
+    uint8_t page_protection;
+} __attribute__((packed)) acpi_hpet_t;
+
+// PCI Express memory mapped configuration table ("MCFG")
+typedef struct {
+    acpi_sdt_header_t header;
+    uint64_t reserved;
+    // acpi_mcfg_entry_t allocations follow
+} __attribute__((packed)) acpi_mcfg_t;
+
+// One ECAM window: 1MB of config space per bus from start_bus to end_bus
+typedef struct {
+    uint64_t base_address;
+    uint16_t segment;
+    uint8_t start_bus;
+    uint8_t end_bus;
+    uint32_t reserved;
+} __attribute__((packed)) acpi_mcfg_entry_t;
+
+// Multiple APIC Description Table ("APIC")
+typedef struct {
+    acpi_sdt_header_t header;
+    uint32_t lapic_address;
+    uint32_t flags;            // Bit 0: legacy 8259 pair present
+    // Variable-length interrupt controller entries follow
+} __attribute__((packed)) acpi_madt_t;
+
+#define ACPI_MADT_PCAT_COMPAT       (1 << 0)
+
+// MADT entry types
+#define ACPI_MADT_LAPIC             0
+#define ACPI_MADT_IOAPIC            1
+#define ACPI_MADT_INT_OVERRIDE      2
+#define ACPI_MADT_LAPIC_NMI         4
+#define ACPI_MADT_LAPIC_OVERRIDE    5
+
+typedef struct {
+    uint8_t type;
+    uint8_t length;
+} __attribute__((packed)) acpi_madt_entry_t;
+
+typedef struct {
+    acpi_madt_entry_t header;
+    uint8_t processor_id;
+    uint8_t apic_id;
+    uint32_t flags;            // Bit 0: enabled
+} __attribute__((packed)) acpi_madt_lapic_t;
+
+typedef struct {
+    acpi_madt_entry_t header;
+    uint8_t ioapic_id;
+    uint8_t reserved;
+    uint32_t address;
+    uint32_t gsi_base;
+} __attribute__((packed)) acpi_madt_ioapic_t;
+
+// Interrupt source override: ISA IRQ "source" is wired to GSI "gsi"
+typedef struct {
+    acpi_madt_entry_t header;
+    uint8_t bus;               // Always 0 (ISA)
+    uint8_t source;
+    uint32_t gsi;
+    uint16_t flags;            // MPS INTI polarity/trigger
+} __attribute__((packed)) acpi_madt_override_t;
+
+typedef struct {
+    acpi_madt_entry_t header;
+    uint16_t reserved;
+    uint64_t address;
+} __attribute__((packed)) acpi_madt_lapic_override_t;
+
+// MPS INTI flags
+#define ACPI_MADT_POLARITY_MASK     0x3
+#define ACPI_MADT_POLARITY_LOW      0x3
+#define ACPI_MADT_TRIGGER_MASK      0xC
+#define ACPI_MADT_TRIGGER_LEVEL     0xC
+
+// Locate the RSDP and root table. Returns 1 if ACPI is present.
+int acpi_init(void);
+
+// Find a table by its 4-character signature (NULL if absent)
+acpi_sdt_header_t* acpi_find_table(const char* signature);
+
+#endif
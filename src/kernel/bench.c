@@ -0,0 +1,103 @@
+#include "bench.h"
+#include <stddef.h>
+#include "kernel/tsc.h"
+#include "kernel/irqflags.h"
+#include "lib/printf.h"
+#include "drivers/char/serial.h"
+
+// Bounds of the __benches section (linker.ld)
+extern bench_t __start___benches[];
+extern bench_t __stop___benches[];
+
+static uint64_t samples[BENCH_SAMPLES];
+static uint64_t timer_overhead = ~0ULL;
+
+// rdtsc can execute ahead of (or behind) the code being timed; lfence
+// keeps it in program order
+static inline uint64_t bench_rdtsc(void) {
+    asm volatile("lfence" ::: "memory");
+    uint64_t tsc = rdtsc();
+    asm volatile("lfence" ::: "memory");
+    return tsc;
+}
+
+// Cheapest back-to-back timestamp pair, subtracted from every sample
+static void bench_calibrate(void) {
+    for (int i = 0; i < 64; i++) {
+        uint64_t start = bench_rdtsc();
+        uint64_t end = bench_rdtsc();
+        if (end - start < timer_overhead) timer_overhead = end - start;
+    }
+}
+
+int bench_count(void) {
+    return __stop___benches - __start___benches;
+}
+
+const bench_t* bench_get(int index) {
+    if (index < 0 || index >= bench_count()) return NULL;
+    return &__start___benches[index];
+}
+
+static uint64_t bench_sample(const bench_t* bench) {
+    uint32_t batch = bench->batch ? bench->batch : 1;
+    
+    uint64_t flags = local_irq_save();
+    uint64_t start = bench_rdtsc();
+    for (uint32_t i = 0; i < batch; i++) {
+        bench->fn(bench->arg);
+    }
+    uint64_t end = bench_rdtsc();
+    local_irq_restore(flags);
+    
+    uint64_t cycles = end - start;
+    cycles = cycles > timer_overhead ? cycles - timer_overhead : 0;
+    return cycles / batch;
+}
+
+void bench_run(const bench_t* bench, bench_result_t* result) {
+    if (timer_overhead == ~0ULL) bench_calibrate();
+    
+    if (bench->setup) bench->setup();
+    
+    // Warm caches, TLB and branch predictors
+    for (int i = 0; i < BENCH_WARMUP; i++) {
+        bench_sample(bench);
+    }
+    
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        samples[i] = bench_sample(bench);
+    }
+    
+    if (bench->teardown) bench->teardown();
+    
+    // Insertion sort; the samples are mostly in order already
+    for (int i = 1; i < BENCH_SAMPLES; i++) {
+        uint64_t value = samples[i];
+        int j = i - 1;
+        while (j >= 0 && samples[j] > value) {
+            samples[j + 1] = samples[j];
+            j--;
+        }
+        samples[j + 1] = value;
+    }
+    
+    result->bench = bench;
+    result->samples = BENCH_SAMPLES;
+    result->min = samples[0];
+    result->median = samples[BENCH_SAMPLES / 2];
+    result->p90 = samples[BENCH_SAMPLES * 90 / 100];
+    result->p99 = samples[BENCH_SAMPLES * 99 / 100];
+    result->max = samples[BENCH_SAMPLES - 1];
+}
+
+void bench_report_serial(const bench_result_t* result) {
+    char line[192];
+    snprintf(line, sizeof(line),
+             "BENCH name=%s samples=%u batch=%u min=%llu median=%llu p90=%llu p99=%llu max=%llu\n",
+             result->bench->name, result->samples, result->bench->batch,
+             (unsigned long long)result->min, (unsigned long long)result->median,
+             (unsigned long long)result->p90, (unsigned long long)result->p99,
+             (unsigned long long)result->max);
+    serial_write_blocking(line);
+}
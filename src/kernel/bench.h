@@ -0,0 +1,52 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define BENCH_WARMUP    16      // Untimed batches before sampling
+#define BENCH_SAMPLES   128     // Timed batches per benchmark
+
+// A registered microbenchmark. Each timed sample runs fn(arg) batch times
+// with interrupts off and records the cycles per call, so sub-100-cycle
+// operations aren't swamped by the rdtsc overhead.
+typedef struct bench {
+    const char* name;
+    void (*fn)(uint64_t arg);
+    uint64_t arg;               // e.g. a buffer size
+    uint32_t batch;             // Calls per timed sample
+    void (*setup)(void);        // Optional, runs before warm-up
+    void (*teardown)(void);     // Optional
+} bench_t;
+
+// Benchmarks live next to the code they measure and are collected into
+// the __benches section (linker.ld)
+#define DEFINE_BENCH_FIXTURE(var, bench_name, func, func_arg, calls, setup_fn, teardown_fn) \
+    static bench_t var                                                      \
+    __attribute__((section("__benches"), aligned(8), used)) =               \
+    { bench_name, func, func_arg, calls, setup_fn, teardown_fn }
+
+#define DEFINE_BENCH(var, bench_name, func, func_arg, calls)                \
+    DEFINE_BENCH_FIXTURE(var, bench_name, func, func_arg, calls, NULL, NULL)
+
+typedef struct {
+    const bench_t* bench;
+    uint32_t samples;
+    uint64_t min;               // Cycles per call
+    uint64_t median;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t max;
+} bench_result_t;
+
+int bench_count(void);
+const bench_t* bench_get(int index);
+
+// Warm up, then time BENCH_SAMPLES batches of one benchmark
+void bench_run(const bench_t* bench, bench_result_t* result);
+
+// Queue a machine-readable line on the serial console:
+// "BENCH name=memset/4096 samples=128 batch=8 min=.. median=.. p90=.. p99=.. max=.."
+void bench_report_serial(const bench_result_t* result);
+
+#endif
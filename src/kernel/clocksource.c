@@ -0,0 +1,58 @@
+#include "clocksource.h"
+#include <stddef.h>
+#include "kernel/tsc.h"
+
+static clocksource_t* clocksources[MAX_CLOCKSOURCES];
+static int num_clocksources = 0;
+static clocksource_t* current = NULL;
+
+void clocksource_register(clocksource_t* cs) {
+    if (!cs || num_clocksources >= MAX_CLOCKSOURCES) return;
+    
+    clocksources[num_clocksources++] = cs;
+    
+    if (!current || cs->rating > current->rating) {
+        current = cs;
+    }
+}
+
+clocksource_t* clocksource_current(void) {
+    return current;
+}
+
+int clocksource_count(void) {
+    return num_clocksources;
+}
+
+clocksource_t* clocksource_get(int index) {
+    if (index < 0 || index >= num_clocksources) return NULL;
+    return clocksources[index];
+}
+
+uint64_t clocksource_read_ns(void) {
+    if (!current || current->freq_hz == 0) return 0;
+    
+    uint64_t count = current->read() & current->mask;
+    uint64_t freq = current->freq_hz;
+    
+    // Split to avoid overflowing count * 1e9
+    return (count / freq) * 1000000000ULL +
+           ((count % freq) * 1000000000ULL) / freq;
+}
+
+uint64_t clocksource_cycles_per_read(clocksource_t* cs, uint32_t iterations) {
+    if (!cs || iterations == 0) return 0;
+    
+    // Warm up caches and TLB for the counter registers
+    for (int i = 0; i < 16; i++) {
+        cs->read();
+    }
+    
+    uint64_t start = rdtsc();
+    for (uint32_t i = 0; i < iterations; i++) {
+        cs->read();
+    }
+    uint64_t end = rdtsc();
+    
+    return (end - start) / iterations;
+}
@@ -0,0 +1,33 @@
+#ifndef CLOCKSOURCE_H
+#define CLOCKSOURCE_H
+
+#include <stdint.h>
+
+#define MAX_CLOCKSOURCES 4
+
+// A free-running counter that can be read to tell time
+typedef struct clocksource {
+    const char* name;
+    uint64_t (*read)(void);
+    uint64_t mask;        // Valid counter bits (wraps at mask + 1)
+    uint64_t freq_hz;
+    int rating;           // Higher is better; the best one becomes current
+} clocksource_t;
+
+// Register a clocksource (re-selects the current one)
+void clocksource_register(clocksource_t* cs);
+
+// Highest-rated registered clocksource (NULL before any registration)
+clocksource_t* clocksource_current(void);
+
+// Enumerate registered clocksources
+int clocksource_count(void);
+clocksource_t* clocksource_get(int index);
+
+// Nanoseconds since boot on the current clocksource
+uint64_t clocksource_read_ns(void);
+
+// Average TSC cycles spent in one read() over the given iterations
+uint64_t clocksource_cycles_per_read(clocksource_t* cs, uint32_t iterations);
+
+#endif
@@ -3,6 +3,26 @@
 #include "gui/terminal.h"
 #include "kernel/timer.h"
 #include "mm/pmm.h"
+#include "kernel/clocksource.h"
+#include "kernel/tsc.h"
+#include "kernel/timer_wheel.h"
+#include "kernel/irq.h"
+#include "kernel/lock_bench.h"
+#include "kernel/perf.h"
+#include "kernel/trace.h"
+#include "kernel/debug.h"
+#include "kernel/printk.h"
+#include "kernel/bench.h"
+#include "kernel/input_latency.h"
+#include "kernel/initcall.h"
+#include "drivers/char/serial.h"
+#include "drivers/bus/pci.h"
+#include "drivers/bus/usb.h"
+#include "drivers/bus/xhci.h"
+#include "drivers/input/mouse.h"
+#include "drivers/video/graphics.h"
+#include "lib/printf.h"
+#include "lib/mem_bench.h"
 
 extern char terminal_buffer[];
 extern int term_idx;
@@ -19,6 +39,53 @@ static void cmd_print(const char* text) {
     }
 }
 
+// Newest log records shown by dmesg (the terminal keeps ~30 visible lines)
+#define DMESG_LINES 24
+
+static printk_record_t dmesg_records[DMESG_LINES];
+
+static void cmd_dmesg(int min_level) {
+    char line[PRINTK_LINE_MAX];
+    uint32_t count = printk_snapshot(dmesg_records, DMESG_LINES, min_level);
+    
+    for (uint32_t i = 0; i < count; i++) {
+        printk_format(&dmesg_records[i], line);
+        cmd_print(line);
+    }
+    
+    snprintf(line, sizeof(line), "%llu records logged, %llu overwritten",
+             (unsigned long long)printk_total(), (unsigned long long)printk_overwritten());
+    cmd_print(line);
+    cmd_print("");
+}
+
+// Run every benchmark whose name starts with prefix ("" for all); each
+// result also goes to COM1 as a BENCH line for CI
+static void cmd_bench(const char* prefix) {
+    char buf[96];
+    int ran = 0;
+    size_t prefix_len = strlen(prefix);
+    
+    cmd_print("Benchmark: cycles per call (median / p90 / p99 / min)");
+    for (int i = 0; i < bench_count(); i++) {
+        const bench_t* bench = bench_get(i);
+        if (strncmp(bench->name, prefix, prefix_len) != 0) continue;
+        
+        bench_result_t result;
+        bench_run(bench, &result);
+        bench_report_serial(&result);
+        
+        snprintf(buf, sizeof(buf), "  %s: %llu / %llu / %llu / %llu", bench->name,
+                 (unsigned long long)result.median, (unsigned long long)result.p90,
+                 (unsigned long long)result.p99, (unsigned long long)result.min);
+        cmd_print(buf);
+        ran++;
+    }
+    
+    if (!ran) cmd_print("  No benchmark matches (try 'bench list')");
+    cmd_print("");
+}
+
 void cmd_process(const char* cmd) {
     if (strlen(cmd) == 0) {
         cmd_print("");
@@ -34,6 +101,23 @@ void cmd_process(const char* cmd) {
         cmd_print("  clear     - Clear screen");
         cmd_print("  sysinfo   - System information");
         cmd_print("  time      - Show uptime");
+        cmd_print("  clocks    - Clocksource read cost");
+        cmd_print("  timers    - Timer wheel benchmark + jitter");
+        cmd_print("  irqstat   - Interrupt counts and handler cycles");
+        cmd_print("  lspci     - PCI device table and scan cost");
+        cmd_print("  lsusb     - Enumerated USB devices");
+        cmd_print("  xhci [imod <us>] - xHCI interrupts / set moderation");
+        cmd_print("  mouse     - PS/2 rate, packets, coalescing and resyncs");
+        cmd_print("  locks     - Lock acquire/release cost");
+        cmd_print("  perf start [hz] / stop / top / dump - Sampling profiler");
+        cmd_print("  trace on / off / dump - Frame timeline (Chrome JSON on COM1)");
+        cmd_print("  profile [reset] - Render/ISR zone cycles");
+        cmd_print("  dmesg [debug|info|warn|err] / clear - Kernel log");
+        cmd_print("  bench [name] / list - Microbenchmarks (BENCH lines on COM1)");
+        cmd_print("  memperf   - memcpy/memset GB/s by size and dispatch choice");
+        cmd_print("  frame [reset] / dump - Frame times, checksum / RLE dump on COM1");
+        cmd_print("  latency [reset] - Input-to-photon latency percentiles");
+        cmd_print("  bootchart - Boot stage timings and time to GUI");
         cmd_print("");
     }
     else if (strcmp(cmd, "clear") == 0) {
@@ -56,21 +140,340 @@ void cmd_process(const char* cmd) {
         minutes = minutes % 60;
         
         char buf[32];
-        buf[0] = 'U'; buf[1] = 'p'; buf[2] = 't'; buf[3] = 'i'; buf[4] = 'm'; buf[5] = 'e'; buf[6] = ':'; buf[7] = ' ';
-        int idx = 8;
         if (hours > 0) {
-            if (hours >= 10) buf[idx++] = '0' + (hours / 10);
-            buf[idx++] = '0' + (hours % 10);
-            buf[idx++] = 'h'; buf[idx++] = ' ';
+            snprintf(buf, sizeof(buf), "Uptime: %uh %um %us", hours, minutes, seconds);
+        } else {
+            snprintf(buf, sizeof(buf), "Uptime: %um %us", minutes, seconds);
+        }
+        cmd_print(buf);
+        cmd_print("");
+    }
+    else if (strcmp(cmd, "clocks") == 0) {
+        char buf[96];
+        clocksource_t* current = clocksource_current();
+        
+        snprintf(buf, sizeof(buf), "TSC: %llu kHz (%s)", (unsigned long long)tsc_khz,
+                 tsc_is_stable() ? "invariant" : "not invariant");
+        cmd_print(buf);
+        
+        for (int i = 0; i < clocksource_count(); i++) {
+            clocksource_t* cs = clocksource_get(i);
+            uint64_t cycles = clocksource_cycles_per_read(cs, 1000);
+            snprintf(buf, sizeof(buf), "%c %s: %llu kHz, rating %d, %llu cycles/read",
+                     cs == current ? '*' : ' ', cs->name,
+                     (unsigned long long)(cs->freq_hz / 1000), cs->rating,
+                     (unsigned long long)cycles);
+            cmd_print(buf);
+        }
+        cmd_print("");
+    }
+    else if (strcmp(cmd, "timers") == 0) {
+        char buf[96];
+        uint64_t add_cycles, cancel_cycles;
+        timer_jitter_t jitter;
+        
+        timer_wheel_bench(1000000, &add_cycles, &cancel_cycles);
+        snprintf(buf, sizeof(buf), "1000000 timers: add %llu cycles, cancel %llu cycles",
+                 (unsigned long long)add_cycles, (unsigned long long)cancel_cycles);
+        cmd_print(buf);
+        
+        timer_wheel_measure_jitter(256, &jitter);
+        snprintf(buf, sizeof(buf), "Tick-to-callback (%u timers): min %llu us, avg %llu us, max %llu us",
+                 jitter.samples, (unsigned long long)(jitter.min_ns / 1000),
+                 (unsigned long long)(jitter.avg_ns / 1000), (unsigned long long)(jitter.max_ns / 1000));
+        cmd_print(buf);
+        snprintf(buf, sizeof(buf), "Fired a tick or more late: %u", jitter.late);
+        cmd_print(buf);
+        cmd_print("");
+    }
+    else if (strcmp(cmd, "irqstat") == 0) {
+        char buf[120];
+        cmd_print("vector name chip count avg p50 p99 max (cycles)");
+        
+        for (int v = IRQ_VECTOR_BASE; v < NR_VECTORS; v++) {
+            irq_desc_t* desc = irq_get_desc(v);
+            if (desc->count == 0 && !desc->actions) continue;
+            
+            uint64_t avg = desc->count ? desc->total_cycles / desc->count : 0;
+            snprintf(buf, sizeof(buf), "%d %s %s %llu %llu <%llu <%llu %llu", v,
+                     desc->name ? desc->name : "-",
+                     desc->chip ? desc->chip->name : "-",
+                     (unsigned long long)desc->count, (unsigned long long)avg,
+                     (unsigned long long)irq_hist_percentile(desc, 50),
+                     (unsigned long long)irq_hist_percentile(desc, 99),
+                     (unsigned long long)desc->max_cycles);
+            cmd_print(buf);
+            
+            if (desc->unhandled || desc->spurious) {
+                snprintf(buf, sizeof(buf), "    unhandled %llu, spurious %llu",
+                         (unsigned long long)desc->unhandled, (unsigned long long)desc->spurious);
+                cmd_print(buf);
+            }
+        }
+        cmd_print("");
+    }
+    else if (strcmp(cmd, "lspci") == 0) {
+        char buf[96];
+        for (int i = 0; i < pci_device_count(); i++) {
+            struct pci_device* dev = pci_get_device(i);
+            snprintf(buf, sizeof(buf), "%02x:%02x.%x %04x:%04x %02x%02x%02x %s", dev->bus,
+                     dev->slot, dev->func, dev->vendor_id, dev->device_id, dev->class_code,
+                     dev->subclass, dev->prog_if, pci_class_name(dev->class_code, dev->subclass));
+            cmd_print(buf);
+        }
+        
+        // The old pci_find_device paid the brute-force scan on every call
+        snprintf(buf, sizeof(buf), "Boot enumeration (%s): %llu us", pci_config_method(),
+                 (unsigned long long)(tsc_cycles_to_ns(pci_scan_cycles()) / 1000));
+        cmd_print(buf);
+        snprintf(buf, sizeof(buf), "Brute-force scan per lookup (port I/O): %llu us",
+                 (unsigned long long)(tsc_cycles_to_ns(pci_legacy_scan_cycles()) / 1000));
+        cmd_print(buf);
+        cmd_print("");
+    }
+    else if (strcmp(cmd, "lsusb") == 0) {
+        char buf[96];
+        for (int i = 0; i < usb_device_count(); i++) {
+            usb_device_t* dev = usb_get_device(i);
+            snprintf(buf, sizeof(buf), "%s port %u address %u: %04x:%04x %s speed%s%s",
+                     dev->hcd->name, dev->port + 1, dev->address, dev->desc.vendor_id,
+                     dev->desc.product_id, usb_speed_name(dev->speed),
+                     dev->driver ? ", " : "", dev->driver ? dev->driver : "");
+            cmd_print(buf);
+        }
+        if (usb_device_count() == 0) cmd_print("No USB devices");
+        cmd_print("");
+    }
+    else if (strcmp(cmd, "xhci") == 0 || strncmp(cmd, "xhci imod ", 10) == 0) {
+        char buf[96];
+        if (cmd[4]) {
+            uint32_t us = 0;
+            for (const char* p = cmd + 10; *p >= '0' && *p <= '9'; p++) us = us * 10 + (*p - '0');
+            xhci_set_moderation(us);
+        }
+        
+        for (int i = 0; i < xhci_count(); i++) {
+            xhci_stats_t stats;
+            xhci_get_stats(i, &stats);
+            snprintf(buf, sizeof(buf), "xhci%d: %u ports, %u devices, %s vector %u", i,
+                     stats.ports, stats.slots, stats.irq_mode, stats.vector);
+            cmd_print(buf);
+            snprintf(buf, sizeof(buf), "  %llu interrupts, %llu events",
+                     (unsigned long long)stats.irqs, (unsigned long long)stats.events);
+            cmd_print(buf);
+        }
+        if (xhci_count() == 0) cmd_print("No xHCI controller");
+        snprintf(buf, sizeof(buf), "Interrupt moderation: %u us", (unsigned int)xhci_moderation());
+        cmd_print(buf);
+        cmd_print("");
+    }
+    else if (strcmp(cmd, "mouse") == 0) {
+        char buf[96];
+        mouse_stats_t stats;
+        mouse_get_stats(&stats);
+        
+        snprintf(buf, sizeof(buf), "PS/2: %u samples/s, %u-byte packets%s", (unsigned int)stats.rate,
+                 (unsigned int)stats.packet_size, stats.packet_size == 4 ? " (wheel)" : "");
+        cmd_print(buf);
+        snprintf(buf, sizeof(buf), "Packets %llu, pointer updates %llu, resyncs %llu",
+                 (unsigned long long)stats.packets, (unsigned long long)stats.reports,
+                 (unsigned long long)stats.resyncs);
+        cmd_print(buf);
+        cmd_print("");
+    }
+    else if (strcmp(cmd, "locks") == 0) {
+        char buf[96];
+        lock_bench_result_t results[LOCK_BENCH_MAX];
+        int count = lock_bench_run(100000, results);
+        
+        snprintf(buf, sizeof(buf), "Lock cost on %d CPU(s), cycles per acquire+release:", lock_bench_cpus());
+        cmd_print(buf);
+        for (int i = 0; i < count; i++) {
+            snprintf(buf, sizeof(buf), "  %s: %llu", results[i].name, (unsigned long long)results[i].cycles);
+            cmd_print(buf);
+        }
+        cmd_print("");
+    }
+    else if (strcmp(cmd, "perf start") == 0 || strncmp(cmd, "perf start ", 11) == 0) {
+        char buf[96];
+        uint32_t hz = 0;
+        for (const char* p = cmd + 10; *p; p++) {
+            if (*p >= '0' && *p <= '9') hz = hz * 10 + (*p - '0');
         }
-        if (minutes >= 10) buf[idx++] = '0' + (minutes / 10);
-        buf[idx++] = '0' + (minutes % 10);
-        buf[idx++] = 'm'; buf[idx++] = ' ';
-        if (seconds >= 10) buf[idx++] = '0' + (seconds / 10);
-        buf[idx++] = '0' + (seconds % 10);
-        buf[idx++] = 's';
-        buf[idx] = '\0';
+        
+        hz = perf_start(hz, 1);
+        snprintf(buf, sizeof(buf), "Sampling at %u Hz with call chains", (unsigned int)hz);
+        cmd_print(buf);
+        cmd_print("");
+    }
+    else if (strcmp(cmd, "perf stop") == 0) {
+        char buf[96];
+        perf_stop();
+        snprintf(buf, sizeof(buf), "Stopped: %llu samples, %llu dropped",
+                 (unsigned long long)perf_sample_count(), (unsigned long long)perf_dropped_count());
+        cmd_print(buf);
+        cmd_print("");
+    }
+    else if (strcmp(cmd, "perf") == 0 || strcmp(cmd, "perf top") == 0) {
+        char buf[96];
+        perf_top_entry_t top[PERF_MAX_TOP];
+        uint64_t total = perf_sample_count();
+        int count = perf_top(top, PERF_MAX_TOP);
+        
+        snprintf(buf, sizeof(buf), "%llu samples%s", (unsigned long long)total, perf_running() ? " (running)" : "");
         cmd_print(buf);
+        for (int i = 0; i < count && i < 15; i++) {
+            uint32_t pct10 = total ? (uint32_t)(((uint64_t)top[i].samples * 1000) / total) : 0;
+            snprintf(buf, sizeof(buf), "  %u.%u%%  %s", pct10 / 10, pct10 % 10,
+                     top[i].name ? top[i].name : "[unknown]");
+            cmd_print(buf);
+        }
+        cmd_print("");
+    }
+    else if (strcmp(cmd, "perf dump") == 0) {
+        char buf[96];
+        if (!serial_available()) {
+            cmd_print("No serial port");
+        } else {
+            snprintf(buf, sizeof(buf), "Wrote %u folded stacks to COM1", perf_dump_serial());
+            cmd_print(buf);
+        }
+        cmd_print("");
+    }
+    else if (strcmp(cmd, "trace") == 0) {
+        char buf[96];
+        snprintf(buf, sizeof(buf), "Tracing %s: %d tracepoints, %d patch sites, %llu records",
+                 trace_enabled() ? "on" : "off", tracepoint_count(), jump_label_count(),
+                 (unsigned long long)trace_record_count());
+        cmd_print(buf);
+        cmd_print("");
+    }
+    else if (strcmp(cmd, "trace on") == 0) {
+        trace_clear();
+        trace_enable(1);
+        cmd_print("Tracing on");
+        cmd_print("");
+    }
+    else if (strcmp(cmd, "trace off") == 0) {
+        trace_enable(0);
+        cmd_print("Tracing off");
+        cmd_print("");
+    }
+    else if (strcmp(cmd, "trace dump") == 0) {
+        char buf[96];
+        if (!serial_available()) {
+            cmd_print("No serial port");
+        } else {
+            snprintf(buf, sizeof(buf), "Wrote %u trace events to COM1", trace_dump_chrome());
+            cmd_print(buf);
+        }
+        cmd_print("");
+    }
+    else if (strcmp(cmd, "profile") == 0) {
+        debug_show_profiles(cmd_print);
+        cmd_print("");
+    }
+    else if (strcmp(cmd, "profile reset") == 0) {
+        debug_reset_profiles();
+        cmd_print("Profile zones cleared");
+        cmd_print("");
+    }
+    else if (strcmp(cmd, "dmesg") == 0) {
+        cmd_dmesg(LOG_DEBUG);
+    }
+    else if (strcmp(cmd, "dmesg clear") == 0) {
+        printk_clear();
+        cmd_print("Kernel log cleared");
+        cmd_print("");
+    }
+    else if (strncmp(cmd, "dmesg ", 6) == 0) {
+        int level = printk_parse_level(cmd + 6);
+        if (level < 0) {
+            cmd_print("Usage: dmesg [debug|info|warn|err|fatal] / clear");
+            cmd_print("");
+        } else {
+            cmd_dmesg(level);
+        }
+    }
+    else if (strcmp(cmd, "bench") == 0) {
+        cmd_bench("");
+    }
+    else if (strcmp(cmd, "bench list") == 0) {
+        char buf[96];
+        snprintf(buf, sizeof(buf), "%d benchmarks:", bench_count());
+        cmd_print(buf);
+        for (int i = 0; i < bench_count(); i++) {
+            snprintf(buf, sizeof(buf), "  %s (batch %u)", bench_get(i)->name, bench_get(i)->batch);
+            cmd_print(buf);
+        }
+        cmd_print("");
+    }
+    else if (strncmp(cmd, "bench ", 6) == 0) {
+        cmd_bench(cmd + 6);
+    }
+    else if (strcmp(cmd, "memperf") == 0) {
+        mem_bench_table(cmd_print);
+        cmd_print("");
+    }
+    else if (strcmp(cmd, "frame") == 0) {
+        char buf[96];
+        frame_stats_t stats;
+        graphics_frame_stats(&stats);
+        
+        snprintf(buf, sizeof(buf), "%dx%d %s, %u frames", screen_w, screen_h,
+                 graphics_is_headless() ? "headless" : "framebuffer", stats.frames);
+        cmd_print(buf);
+        snprintf(buf, sizeof(buf), "Frame time us (min/median/p99/max): %llu / %llu / %llu / %llu",
+                 (unsigned long long)(tsc_cycles_to_ns(stats.min) / 1000),
+                 (unsigned long long)(tsc_cycles_to_ns(stats.median) / 1000),
+                 (unsigned long long)(tsc_cycles_to_ns(stats.p99) / 1000),
+                 (unsigned long long)(tsc_cycles_to_ns(stats.max) / 1000));
+        cmd_print(buf);
+        if (graphics_is_headless()) {
+            char sum[17];
+            graphics_format_checksum(graphics_checksum(), sum);
+            snprintf(buf, sizeof(buf), "Checksum: %s", sum);
+            cmd_print(buf);
+        }
+        cmd_print("");
+    }
+    else if (strcmp(cmd, "frame reset") == 0) {
+        graphics_frame_stats_reset();
+        cmd_print("Frame statistics reset");
+        cmd_print("");
+    }
+    else if (strcmp(cmd, "frame dump") == 0) {
+        graphics_dump_serial();
+        cmd_print("Frame written to COM1");
+        cmd_print("");
+    }
+    else if (strcmp(cmd, "latency") == 0) {
+        char buf[96];
+        cmd_print("Input-to-photon latency us (p50/p95/p99/max, avg):");
+        for (int i = 0; i < INPUT_LATENCY_CLASSES; i++) {
+            input_latency_stats_t stats;
+            input_latency_stats(i, &stats);
+            
+            if (stats.events == 0) {
+                snprintf(buf, sizeof(buf), "  %-8s no events", input_latency_name(i));
+            } else {
+                snprintf(buf, sizeof(buf), "  %-8s %u / %u / %u / %u, %u (%llu events, %llu dropped)",
+                         input_latency_name(i), (unsigned int)stats.p50_us,
+                         (unsigned int)stats.p95_us, (unsigned int)stats.p99_us,
+                         (unsigned int)stats.max_us, (unsigned int)stats.avg_us,
+                         (unsigned long long)stats.events, (unsigned long long)stats.dropped);
+            }
+            cmd_print(buf);
+        }
+        cmd_print("");
+    }
+    else if (strcmp(cmd, "latency reset") == 0) {
+        input_latency_reset();
+        cmd_print("Latency histograms reset");
+        cmd_print("");
+    }
+    else if (strcmp(cmd, "bootchart") == 0) {
+        initcall_bootchart(cmd_print);
         cmd_print("");
     }
     else {
@@ -78,10 +481,6 @@ void cmd_process(const char* cmd) {
         cmd_print("");
     }
     
-    // Reset input
-    terminal_buffer[0] = '\0';
-    term_idx = 0;
-    
-    // Reset history position
+    // Reset history position (the keyboard clears the input line on submit)
     terminal_reset_history_pos();
 }
@@ -0,0 +1,61 @@
+#include "cmdline.h"
+#include <stdint.h>
+#include "lib/string.h"
+
+#define MULTIBOOT_INFO_CMDLINE 0x4
+
+static char cmdline[CMDLINE_MAX];
+
+void cmdline_init(multiboot_info_t* mbi) {
+    cmdline[0] = '\0';
+    if (!(mbi->flags & MULTIBOOT_INFO_CMDLINE) || !mbi->cmdline) return;
+    
+    const char* src = (const char*)(uintptr_t)mbi->cmdline;
+    int i = 0;
+    while (src[i] && i < CMDLINE_MAX - 1) {
+        cmdline[i] = src[i];
+        i++;
+    }
+    cmdline[i] = '\0';
+}
+
+const char* cmdline_get(void) {
+    return cmdline;
+}
+
+// Find the word "name" or "name=..."; returns the character after the name
+static const char* cmdline_find(const char* name) {
+    int len = strlen(name);
+    const char* p = cmdline;
+    
+    while (*p) {
+        while (*p == ' ') p++;
+        const char* word = p;
+        while (*p && *p != ' ') p++;
+        
+        if (p - word >= len && strncmp(word, name, len) == 0 &&
+            (word[len] == ' ' || word[len] == '=' || word[len] == '\0')) {
+            return word + len;
+        }
+    }
+    
+    return NULL;
+}
+
+int cmdline_has(const char* name) {
+    return cmdline_find(name) != NULL;
+}
+
+int cmdline_value(const char* name, char* out, int size) {
+    const char* p = cmdline_find(name);
+    if (!p || *p != '=' || size <= 0) return 0;
+    
+    p++;
+    int i = 0;
+    while (p[i] && p[i] != ' ' && i < size - 1) {
+        out[i] = p[i];
+        i++;
+    }
+    out[i] = '\0';
+    return 1;
+}
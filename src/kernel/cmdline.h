@@ -0,0 +1,22 @@
+#ifndef CMDLINE_H
+#define CMDLINE_H
+
+#include "include/multiboot.h"
+
+#define CMDLINE_MAX 256
+
+// Copy the bootloader's command line (multiboot flags bit 2). Call early,
+// before the info structure can be overwritten.
+void cmdline_init(multiboot_info_t* mbi);
+
+// Whole command line ("" if none was passed)
+const char* cmdline_get(void);
+
+// Nonzero if a word equals name, or starts with "name="
+int cmdline_has(const char* name);
+
+// Value of "name=value" copied into out (at most size bytes with the
+// terminator). Returns 1 if found.
+int cmdline_value(const char* name, char* out, int size);
+
+#endif
@@ -6,11 +6,7 @@ cpu_info_t cpu_info;
 
 // Execute CPUID instruction
 static inline void cpuid(uint32_t code, uint32_t* eax, uint32_t* ebx, uint32_t* ecx, uint32_t* edx) {
-    asm volatile(
-        "cpuid"
-        : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx)
-        : "a"(code)
-    );
+    cpuid_count(code, 0, eax, ebx, ecx, edx);
 }
 
 // Check if CPUID is supported
@@ -139,8 +135,24 @@ void cpuid_init() {
     // Get features
     cpuid_get_features(&cpu_info.features_edx, &cpu_info.features_ecx);
     
-    // Try to get core count (simplified)
     uint32_t eax, ebx, ecx, edx;
+    
+    // Structured extended features (AVX2, ERMS, FSRM)
+    cpuid(0, &eax, &ebx, &ecx, &edx);
+    if (eax >= 7) {
+        cpuid_count(7, 0, &eax, &ebx, &ecx, &edx);
+        cpu_info.features7_ebx = ebx;
+        cpu_info.features7_edx = edx;
+    }
+    
+    // Power management flags (invariant TSC)
+    cpuid(0x80000000, &eax, &ebx, &ecx, &edx);
+    if (eax >= 0x80000007) {
+        cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+        cpu_info.power_edx = edx;
+    }
+    
+    // Try to get core count (simplified)
     cpuid(1, &eax, &ebx, &ecx, &edx);
     cpu_info.logical_cores = (ebx >> 16) & 0xFF;
     
@@ -182,5 +194,9 @@ void cpuid_print_features(uint32_t edx, uint32_t ecx) {
     if (ecx & CPUID_FEAT_ECX_SSE42)  printf("SSE4.2 ");
     if (ecx & CPUID_FEAT_ECX_AVX)    printf("AVX ");
     
+    if (cpu_info.features7_ebx & CPUID_FEAT7_EBX_AVX2)  printf("AVX2 ");
+    if (cpu_info.features7_ebx & CPUID_FEAT7_EBX_ERMS)  printf("ERMS ");
+    if (cpu_info.features7_edx & CPUID_FEAT7_EDX_FSRM)  printf("FSRM ");
+    
     printf("\n");
 }
@@ -36,8 +36,28 @@
 #define CPUID_FEAT_ECX_SSSE3   (1 << 9)   // SSSE3 instructions
 #define CPUID_FEAT_ECX_SSE41   (1 << 19)  // SSE4.1 instructions
 #define CPUID_FEAT_ECX_SSE42   (1 << 20)  // SSE4.2 instructions
+#define CPUID_FEAT_ECX_XSAVE   (1 << 26)  // XSAVE/XRSTOR and XCR0
 #define CPUID_FEAT_ECX_AVX     (1 << 28)  // AVX instructions
 
+// Structured extended features (EBX / EDX from CPUID 0x7, sub-leaf 0)
+#define CPUID_FEAT7_EBX_AVX2   (1 << 5)   // AVX2 instructions
+#define CPUID_FEAT7_EBX_ERMS   (1 << 9)   // Enhanced REP MOVSB/STOSB
+#define CPUID_FEAT7_EDX_FSRM   (1 << 4)   // Fast short REP MOVSB
+
+// XSAVE features (EAX from CPUID 0xD, sub-leaf 1)
+#define CPUID_XSAVE_XSAVEOPT   (1 << 0)   // XSAVEOPT skips unmodified state
+
+// Advanced power management flags (EDX from CPUID 0x80000007)
+#define CPUID_FEAT_PM_INVARIANT_TSC (1 << 8)  // TSC runs at a constant rate
+
+// Execute CPUID with a sub-leaf in ECX (leaves 4, 7, 0xB, 0xD, ...)
+static inline void cpuid_count(uint32_t leaf, uint32_t subleaf,
+                               uint32_t* eax, uint32_t* ebx, uint32_t* ecx, uint32_t* edx) {
+    asm volatile("cpuid"
+                 : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx)
+                 : "a"(leaf), "c"(subleaf));
+}
+
 // CPU information structure
 typedef struct {
     char vendor[13];          // 12 chars + null
@@ -48,6 +68,9 @@ typedef struct {
     uint32_t type;
     uint32_t features_edx;    // Feature flags from EDX
     uint32_t features_ecx;    // Feature flags from ECX
+    uint32_t features7_ebx;   // Extended feature flags (0x7 EBX)
+    uint32_t features7_edx;   // Extended feature flags (0x7 EDX)
+    uint32_t power_edx;       // Power management flags (0x80000007 EDX)
     uint32_t logical_cores;
     uint32_t physical_cores;
 } cpu_info_t;
@@ -3,61 +3,37 @@
 #include "drivers/video/vga.h"
 #include "lib/string.h"
 #include "kernel/timer.h"
+#include "kernel/tsc.h"
+#include "kernel/percpu.h"
+#include "kernel/irqflags.h"
+#include "kernel/printk.h"
 #include <stdarg.h>
 
-static log_buffer_t kernel_log;
+static printk_record_t dump_records[PRINTK_RECORDS];
 
 void debug_init() {
-    memset(kernel_log.buffer, 0, LOG_BUFFER_SIZE);
-    kernel_log.write_pos = 0;
-    kernel_log.read_pos = 0;
-    
-    debug_log("[DEBUG] Debug system initialized");
+    debug_log("Debug system initialized");
 }
 
 void debug_log(const char* message) {
-    // Write to ring buffer
-    int len = strlen(message);
-    for (int i = 0; i < len && i < LOG_BUFFER_SIZE - 1; i++) {
-        kernel_log.buffer[kernel_log.write_pos] = message[i];
-        kernel_log.write_pos = (kernel_log.write_pos + 1) % LOG_BUFFER_SIZE;
-        
-        // Overwrite oldest if full
-        if (kernel_log.write_pos == kernel_log.read_pos) {
-            kernel_log.read_pos = (kernel_log.read_pos + 1) % LOG_BUFFER_SIZE;
-        }
-    }
-    
-    // Newline
-    kernel_log.buffer[kernel_log.write_pos] = '\n';
-    kernel_log.write_pos = (kernel_log.write_pos + 1) % LOG_BUFFER_SIZE;
-    
-    // Also print to VGA
-    vga_print(message);
-    vga_print("\n");
+    printk(LOG_INFO, "debug", "%s", message);
 }
 
 void debug_logf(const char* fmt, ...) {
-    char buffer[512];
-    
     va_list args;
     va_start(args, fmt);
-    // Use sprintf from printf.h
-    vsprintf(buffer, fmt, args);
+    vprintk(LOG_INFO, "debug", fmt, args);
     va_end(args);
-    
-    debug_log(buffer);
 }
 
 void debug_dump_log() {
     printf("\n=== KERNEL LOG DUMP ===\n");
     
-    int pos = kernel_log.read_pos;
-    while (pos != kernel_log.write_pos) {
-        if (kernel_log.buffer[pos] != 0) {
-            printf("%c", kernel_log.buffer[pos]);
-        }
-        pos = (pos + 1) % LOG_BUFFER_SIZE;
+    char line[PRINTK_LINE_MAX];
+    uint32_t count = printk_snapshot(dump_records, PRINTK_RECORDS, LOG_DEBUG);
+    for (uint32_t i = 0; i < count; i++) {
+        printk_format(&dump_records[i], line);
+        printf("%s\n", line);
     }
     
     printf("\n=== END LOG ===\n");
@@ -86,61 +62,124 @@ int debug_validate_string(const char* str) {
     return 0;  // No null terminator found
 }
 
-// Simple profiling
-static struct {
-    const char* name;
-    uint32_t start_tick;
-    uint32_t total_ticks;
-    uint32_t call_count;
-} profiles[32];
-
-static int profile_count = 0;
-
-void debug_profile_start(const char* name) {
-    // Find or create profile entry
-    int idx = -1;
-    for (int i = 0; i < profile_count; i++) {
-        if (strcmp(profiles[i].name, name) == 0) {
-            idx = i;
-            break;
-        }
+// --- PROFILE ZONES ---
+
+typedef struct {
+    profile_zone_t* zone;
+    uint64_t start;
+    uint64_t child_cycles;
+} profile_frame_t;
+
+typedef struct {
+    profile_frame_t frames[PROFILE_MAX_DEPTH];
+    volatile uint32_t depth;
+} profile_stack_t;
+
+static DEFINE_PER_CPU(profile_stack_t, profile_stacks);
+
+// Bounds of the __profile_zones section (linker.ld)
+extern profile_zone_t __start___profile_zones[];
+extern profile_zone_t __stop___profile_zones[];
+
+static int profile_hist_bucket(uint64_t cycles) {
+    int bucket = 0;
+    while (cycles && bucket < PROFILE_HIST_BUCKETS - 1) {
+        cycles >>= 1;
+        bucket++;
     }
+    return bucket;
+}
+
+void profile_zone_enter(profile_zone_t* zone) {
+    profile_stack_t* stack = &this_cpu(profile_stacks);
+    uint32_t depth = stack->depth;
+    
+    // Too deep: still count the depth so exits stay balanced
+    stack->depth = depth + 1;
+    if (depth >= PROFILE_MAX_DEPTH) return;
+    
+    profile_frame_t* frame = &stack->frames[depth];
+    frame->zone = zone;
+    frame->child_cycles = 0;
+    frame->start = rdtsc();
+}
+
+void profile_zone_exit(profile_zone_t* zone) {
+    uint64_t end = rdtsc();
+    profile_stack_t* stack = &this_cpu(profile_stacks);
+    uint32_t depth = stack->depth;
+    if (depth == 0) return;
+    
+    depth--;
+    stack->depth = depth;
+    if (depth >= PROFILE_MAX_DEPTH) return;
+    
+    profile_frame_t* frame = &stack->frames[depth];
+    if (frame->zone != zone) return;   // Unbalanced enter/exit
     
-    if (idx == -1 && profile_count < 32) {
-        idx = profile_count++;
-        profiles[idx].name = name;
-        profiles[idx].total_ticks = 0;
-        profiles[idx].call_count = 0;
+    uint64_t cycles = end - frame->start;
+    
+    zone->calls++;
+    zone->total_cycles += cycles;
+    zone->self_cycles += cycles > frame->child_cycles ? cycles - frame->child_cycles : 0;
+    if (cycles < zone->min_cycles) zone->min_cycles = cycles;
+    if (cycles > zone->max_cycles) zone->max_cycles = cycles;
+    zone->hist[profile_hist_bucket(cycles)]++;
+    
+    if (depth > 0) {
+        stack->frames[depth - 1].child_cycles += cycles;
     }
+}
+
+// Upper bound of the histogram bucket holding the given percentile
+static uint64_t profile_percentile(profile_zone_t* zone, int percent) {
+    if (zone->calls == 0) return 0;
     
-    if (idx != -1) {
-        profiles[idx].start_tick = timer_get_ticks();
+    uint64_t target = (zone->calls * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (int b = 0; b < PROFILE_HIST_BUCKETS; b++) {
+        seen += zone->hist[b];
+        if (seen >= target) return 1ULL << b;
     }
+    return 1ULL << (PROFILE_HIST_BUCKETS - 1);
 }
 
-void debug_profile_end(const char* name) {
-    uint32_t end_tick = timer_get_ticks();
+// Profile table for the "profile" command, one line per zone
+void debug_show_profiles(void (*print)(const char* line)) {
+    char line[160];
     
-    for (int i = 0; i < profile_count; i++) {
-        if (strcmp(profiles[i].name, name) == 0) {
-            profiles[i].total_ticks += (end_tick - profiles[i].start_tick);
-            profiles[i].call_count++;
-            return;
+    print("Profile zones (cycles):");
+    for (profile_zone_t* zone = __start___profile_zones; zone < __stop___profile_zones; zone++) {
+        if (zone->calls == 0) {
+            snprintf(line, sizeof(line), "  %s: no calls", zone->name);
+            print(line);
+            continue;
         }
+        snprintf(line, sizeof(line), "  %s: %llu calls, min %llu, avg %llu, max %llu, p99 <%llu, self avg %llu",
+                 zone->name,
+                 (unsigned long long)zone->calls,
+                 (unsigned long long)zone->min_cycles,
+                 (unsigned long long)(zone->total_cycles / zone->calls),
+                 (unsigned long long)zone->max_cycles,
+                 (unsigned long long)profile_percentile(zone, 99),
+                 (unsigned long long)(zone->self_cycles / zone->calls));
+        print(line);
     }
 }
 
-// Command to show profiles
-void debug_show_profiles() {
-    printf("\n=== PERFORMANCE PROFILES ===\n");
-    for (int i = 0; i < profile_count; i++) {
-        uint32_t avg = profiles[i].call_count > 0 ? 
-                       profiles[i].total_ticks / profiles[i].call_count : 0;
-        printf("%s: %u calls, %u total ticks, %u avg\n",
-               profiles[i].name,
-               profiles[i].call_count,
-               profiles[i].total_ticks,
-               avg);
+void debug_reset_profiles() {
+    uint64_t flags = local_irq_save();
+    
+    for (profile_zone_t* zone = __start___profile_zones; zone < __stop___profile_zones; zone++) {
+        zone->calls = 0;
+        zone->total_cycles = 0;
+        zone->self_cycles = 0;
+        zone->min_cycles = ~0ULL;
+        zone->max_cycles = 0;
+        for (int b = 0; b < PROFILE_HIST_BUCKETS; b++) {
+            zone->hist[b] = 0;
+        }
     }
-    printf("=== END PROFILES ===\n");
+    
+    local_irq_restore(flags);
 }
@@ -3,23 +3,14 @@
 
 #include <stdint.h>
 
-// Kernel log buffer (ring buffer)
-#define LOG_BUFFER_SIZE 4096
-
-typedef struct {
-    char buffer[LOG_BUFFER_SIZE];
-    int write_pos;
-    int read_pos;
-} log_buffer_t;
-
 // Initialize debug system
 void debug_init();
 
-// Kernel logging (goes to ring buffer + VGA)
+// Kernel logging (info-level printk records under the "debug" subsystem)
 void debug_log(const char* message);
 void debug_logf(const char* fmt, ...);
 
-// Dump log buffer
+// Print every buffered printk record
 void debug_dump_log();
 
 // Breakpoint (INT 3)
@@ -40,8 +31,34 @@ void debug_dump_log();
 int debug_validate_pointer(void* ptr);
 int debug_validate_string(const char* str);
 
-// Performance profiling
-void debug_profile_start(const char* name);
-void debug_profile_end(const char* name);
+// Performance profiling zones
+// A zone is a static struct collected into the __profile_zones section,
+// so entering/exiting costs two rdtsc's and a per-CPU stack push/pop.
+// Zones nest: each reports inclusive cycles and self cycles (minus the
+// time spent in zones or interrupts nested inside it).
+#define PROFILE_HIST_BUCKETS 32
+#define PROFILE_MAX_DEPTH    16
+
+typedef struct profile_zone {
+    const char* name;
+    uint64_t calls;
+    uint64_t total_cycles;      // Inclusive
+    uint64_t self_cycles;       // Exclusive of nested zones
+    uint64_t min_cycles;
+    uint64_t max_cycles;
+    uint32_t hist[PROFILE_HIST_BUCKETS];  // log2 buckets of inclusive cycles
+} profile_zone_t;
+
+#define DEFINE_PROFILE_ZONE(var, zone_name)                                 \
+    static profile_zone_t var                                               \
+    __attribute__((section("__profile_zones"), aligned(8), used)) =         \
+    { .name = zone_name, .min_cycles = ~0ULL }
+
+void profile_zone_enter(profile_zone_t* zone);
+void profile_zone_exit(profile_zone_t* zone);
+
+// Every zone's calls and min/avg/max/p99 cycles, one line per zone
+void debug_show_profiles(void (*print)(const char* line));
+void debug_reset_profiles();
 
 #endif
@@ -0,0 +1,190 @@
+#include "fpu.h"
+#include "kernel/cpuid.h"
+#include "kernel/irqflags.h"
+#include "kernel/panic.h"
+#include "kernel/percpu.h"
+
+// XSAVE wants 64-byte alignment (FXSAVE only 16)
+typedef struct {
+    uint8_t bytes[FPU_STATE_MAX];
+} __attribute__((aligned(64))) fpu_area_t;
+
+// Level n holds the registers of the section at depth n + 1 while a
+// deeper one runs; the outermost section never needs a level of its own
+typedef struct {
+    fpu_area_t level[FPU_MAX_DEPTH - 1];
+} fpu_stack_t;
+
+static DEFINE_PER_CPU(fpu_stack_t, fpu_saved);
+static DEFINE_PER_CPU(int, fpu_depth);
+
+static fpu_save_t save_method = FPU_SAVE_NONE;
+static uint64_t xfeatures = 0;
+static uint32_t state_size = 0;
+static uint64_t nested_saves = 0;
+
+static inline uint64_t read_cr0(void) {
+    uint64_t value;
+    asm volatile("mov %%cr0, %0" : "=r"(value));
+    return value;
+}
+
+static inline void write_cr0(uint64_t value) {
+    asm volatile("mov %0, %%cr0" : : "r"(value) : "memory");
+}
+
+static inline uint64_t read_cr4(void) {
+    uint64_t value;
+    asm volatile("mov %%cr4, %0" : "=r"(value));
+    return value;
+}
+
+static inline void write_cr4(uint64_t value) {
+    asm volatile("mov %0, %%cr4" : : "r"(value) : "memory");
+}
+
+static inline void xsetbv(uint32_t index, uint64_t value) {
+    asm volatile("xsetbv" : : "c"(index), "a"((uint32_t)value), "d"((uint32_t)(value >> 32)));
+}
+
+// Reset the registers to the state a fresh section expects
+static inline void fpu_reset(void) {
+    uint32_t mxcsr = MXCSR_DEFAULT;
+    asm volatile("fninit; ldmxcsr %0" : : "m"(mxcsr));
+}
+
+static void fpu_save(fpu_area_t* area) {
+    uint32_t lo = (uint32_t)xfeatures;
+    uint32_t hi = (uint32_t)(xfeatures >> 32);
+    
+    switch (save_method) {
+    case FPU_SAVE_XSAVEOPT:
+        asm volatile("xsaveopt64 (%0)" : : "r"(area), "a"(lo), "d"(hi) : "memory");
+        break;
+    case FPU_SAVE_XSAVE:
+        asm volatile("xsave64 (%0)" : : "r"(area), "a"(lo), "d"(hi) : "memory");
+        break;
+    default:
+        asm volatile("fxsave64 (%0)" : : "r"(area) : "memory");
+        break;
+    }
+}
+
+static void fpu_restore(fpu_area_t* area) {
+    uint32_t lo = (uint32_t)xfeatures;
+    uint32_t hi = (uint32_t)(xfeatures >> 32);
+    
+    if (save_method == FPU_SAVE_FXSAVE) {
+        asm volatile("fxrstor64 (%0)" : : "r"(area) : "memory");
+    } else {
+        asm volatile("xrstor64 (%0)" : : "r"(area), "a"(lo), "d"(hi) : "memory");
+    }
+}
+
+void fpu_init(void) {
+    uint32_t eax, ebx, ecx, edx;
+    
+    cpuid_count(1, 0, &eax, &ebx, &ecx, &edx);
+    if (!(edx & CPUID_FEAT_FXSR) || !(edx & CPUID_FEAT_SSE2)) return;
+    uint32_t features_ecx = ecx;
+    
+    // boot.asm only turns on paging; x87 errors are reported natively and
+    // nothing traps on first use
+    uint64_t cr0 = read_cr0();
+    cr0 &= ~(uint64_t)(CR0_EM | CR0_TS);
+    cr0 |= CR0_MP | CR0_NE;
+    write_cr0(cr0);
+    
+    uint64_t cr4 = read_cr4() | CR4_OSFXSR | CR4_OSXMMEXCPT;
+    save_method = FPU_SAVE_FXSAVE;
+    state_size = 512;
+    
+    if (features_ecx & CPUID_FEAT_ECX_XSAVE) {
+        write_cr4(cr4 | CR4_OSXSAVE);
+        
+        uint64_t xcr0 = XFEATURE_X87 | XFEATURE_SSE;
+        if (features_ecx & CPUID_FEAT_ECX_AVX) xcr0 |= XFEATURE_AVX;
+        xsetbv(0, xcr0);
+        
+        // EBX: save area size for the components now enabled in XCR0
+        cpuid_count(0xD, 0, &eax, &ebx, &ecx, &edx);
+        if (ebx <= FPU_STATE_MAX) {
+            xfeatures = xcr0;
+            state_size = ebx;
+            save_method = FPU_SAVE_XSAVE;
+            
+            cpuid_count(0xD, 1, &eax, &ebx, &ecx, &edx);
+            if (eax & CPUID_XSAVE_XSAVEOPT) save_method = FPU_SAVE_XSAVEOPT;
+        } else {
+            xsetbv(0, XFEATURE_X87 | XFEATURE_SSE);
+        }
+    } else {
+        write_cr4(cr4);
+    }
+    
+    fpu_reset();
+}
+
+int fpu_available(void) {
+    return save_method != FPU_SAVE_NONE;
+}
+
+int fpu_has_avx(void) {
+    return (xfeatures & XFEATURE_AVX) != 0;
+}
+
+fpu_save_t fpu_save_method(void) {
+    return save_method;
+}
+
+const char* fpu_save_name(void) {
+    switch (save_method) {
+    case FPU_SAVE_XSAVEOPT: return "xsaveopt";
+    case FPU_SAVE_XSAVE:    return "xsave";
+    case FPU_SAVE_FXSAVE:   return "fxsave";
+    default:                return "none";
+    }
+}
+
+uint32_t fpu_state_size(void) {
+    return state_size;
+}
+
+int may_use_simd(void) {
+    return save_method != FPU_SAVE_NONE && this_cpu(fpu_depth) < FPU_MAX_DEPTH;
+}
+
+void kernel_fpu_begin(void) {
+    uint64_t flags = local_irq_save();
+    int depth = this_cpu(fpu_depth);
+    
+    if (save_method == FPU_SAVE_NONE || depth >= FPU_MAX_DEPTH) {
+        kernel_panic("kernel_fpu_begin: SIMD not usable here", depth);
+    }
+    
+    // Only a section we interrupted has registers worth keeping
+    if (depth > 0) {
+        fpu_save(&this_cpu(fpu_saved).level[depth - 1]);
+        fpu_reset();
+        nested_saves++;
+    }
+    this_cpu(fpu_depth) = depth + 1;
+    
+    local_irq_restore(flags);
+}
+
+void kernel_fpu_end(void) {
+    uint64_t flags = local_irq_save();
+    int depth = this_cpu(fpu_depth) - 1;
+    
+    if (depth > 0) {
+        fpu_restore(&this_cpu(fpu_saved).level[depth - 1]);
+    }
+    this_cpu(fpu_depth) = depth;
+    
+    local_irq_restore(flags);
+}
+
+uint64_t fpu_nested_saves(void) {
+    return nested_saves;
+}
@@ -0,0 +1,69 @@
+#ifndef FPU_H
+#define FPU_H
+
+#include <stdint.h>
+
+// The kernel is built with -mno-sse, so the compiler never touches vector
+// registers behind our back. Files named *_simd.c are built with SSE2 (and
+// may use target attributes for more); their functions must only run
+// between kernel_fpu_begin() and kernel_fpu_end(), including struct copies
+// the compiler may vectorize.
+//
+// There are no threads to switch, so nothing is saved when a section starts
+// on an idle FPU. State is only saved when a section begins on top of
+// another one (an interrupt handler using SIMD while the code it
+// interrupted is inside a section) and restored when the inner one ends.
+
+#define FPU_MAX_DEPTH  3        // Nesting levels (task + IRQ + one more)
+#define FPU_STATE_MAX  4096     // Largest XSAVE area we accept
+
+// CR0 / CR4 bits
+#define CR0_MP          (1 << 1)    // Monitor coprocessor (WAIT honours TS)
+#define CR0_EM          (1 << 2)    // Emulate x87 (must be clear for SSE)
+#define CR0_TS          (1 << 3)    // Task switched (#NM on first FPU use)
+#define CR0_NE          (1 << 5)    // Native x87 error reporting
+#define CR4_OSFXSR      (1 << 9)    // FXSAVE/FXRSTOR and SSE enabled
+#define CR4_OSXMMEXCPT  (1 << 10)   // Unmasked SSE exceptions raise #XM
+#define CR4_OSXSAVE     (1 << 18)   // XSAVE and XGETBV/XSETBV enabled
+
+// XCR0 state components
+#define XFEATURE_X87    (1 << 0)
+#define XFEATURE_SSE    (1 << 1)
+#define XFEATURE_AVX    (1 << 2)
+
+#define MXCSR_DEFAULT   0x1F80      // All exceptions masked, round to nearest
+
+typedef enum {
+    FPU_SAVE_NONE,          // No SSE2: sections are not available
+    FPU_SAVE_FXSAVE,
+    FPU_SAVE_XSAVE,
+    FPU_SAVE_XSAVEOPT,
+} fpu_save_t;
+
+// Enable x87/SSE (and AVX through XCR0 when present) and pick the best
+// save instruction. Run once on each CPU before any section.
+void fpu_init(void);
+
+// Nonzero once SSE2 sections work
+int fpu_available(void);
+
+// Nonzero if AVX state is enabled in XCR0 (AVX code may run in sections)
+int fpu_has_avx(void);
+
+fpu_save_t fpu_save_method(void);
+const char* fpu_save_name(void);
+
+// Bytes saved per nesting level
+uint32_t fpu_state_size(void);
+
+// Nonzero if a section may start here. Callers with a scalar fallback
+// should check this instead of relying on kernel_fpu_begin().
+int may_use_simd(void);
+
+void kernel_fpu_begin(void);
+void kernel_fpu_end(void);
+
+// Sections that had to save an interrupted section's registers
+uint64_t fpu_nested_saves(void);
+
+#endif
@@ -0,0 +1,24 @@
+#include "kernel/fpu.h"
+#include "kernel/bench.h"
+
+// Cost of entering and leaving a section: the plain case is what every
+// vector kernel pays, the nested one is what an interrupt handler pays
+// when it lands inside another section
+static void bench_fpu_section(uint64_t arg) {
+    (void)arg;
+    if (!fpu_available()) return;
+    kernel_fpu_begin();
+    kernel_fpu_end();
+}
+
+static void bench_fpu_nested(uint64_t arg) {
+    (void)arg;
+    if (!fpu_available()) return;
+    kernel_fpu_begin();
+    kernel_fpu_begin();
+    kernel_fpu_end();
+    kernel_fpu_end();
+}
+
+DEFINE_BENCH(bench_fpu_begin_end, "fpu/begin_end", bench_fpu_section, 0, 64);
+DEFINE_BENCH(bench_fpu_nested_save, "fpu/nested", bench_fpu_nested, 0, 16);
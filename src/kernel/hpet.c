@@ -0,0 +1,209 @@
+#include "hpet.h"
+#include <stddef.h>
+#include "kernel/acpi.h"
+#include "kernel/clocksource.h"
+#include "kernel/irq.h"
+#include "kernel/ioapic.h"
+#include "kernel/lapic.h"
+#include "mm/vmm.h"
+
+#define FEMTOSECONDS_PER_SECOND 1000000000000000ULL
+#define NS_PER_SECOND           1000000000ULL
+
+// The spec caps the counter period at 100 ns
+#define HPET_MAX_PERIOD_FS      100000000ULL
+
+static volatile uint8_t* hpet_base = NULL;
+static uint64_t hpet_period_fs = 0;
+static uint64_t hpet_freq = 0;
+static uint64_t hpet_mask = 0;
+static uint16_t hpet_min_ticks = 1;
+
+static uint8_t event_irq = 0xFF;
+static void (*event_handler)(void) = NULL;
+
+static inline uint64_t hpet_read(uint32_t reg) {
+    return *(volatile uint64_t*)(hpet_base + reg);
+}
+
+static inline void hpet_write(uint32_t reg, uint64_t value) {
+    *(volatile uint64_t*)(hpet_base + reg) = value;
+}
+
+static uint64_t hpet_clocksource_read(void) {
+    return hpet_read(HPET_REG_COUNTER);
+}
+
+static clocksource_t hpet_clocksource = {
+    .name = "hpet",
+    .read = hpet_clocksource_read,
+    .rating = 250,
+};
+
+// Pick the event timer's IOAPIC input from the routing capability mask,
+// preferring pins above the ISA range, then ones the PIT doesn't use (0, 2)
+static uint8_t hpet_pick_route(uint32_t route_cap) {
+    for (int line = 16; line < 32; line++) {
+        if (route_cap & (1u << line)) return line;
+    }
+    for (int line = 3; line < 16; line++) {
+        if (route_cap & (1u << line)) return line;
+    }
+    for (int line = 0; line < 3; line++) {
+        if (route_cap & (1u << line)) return line;
+    }
+    return 0xFF;
+}
+
+int hpet_init(void) {
+    acpi_hpet_t* table = (acpi_hpet_t*)acpi_find_table("HPET");
+    if (!table) return 0;
+    
+    // Only memory-mapped register blocks exist in practice
+    if (table->base_address.address_space_id != 0) return 0;
+    
+    hpet_base = (volatile uint8_t*)vmm_map_mmio(table->base_address.address, 1024);
+    if (!hpet_base) return 0;
+    
+    uint64_t caps = hpet_read(HPET_REG_CAPABILITIES);
+    hpet_period_fs = caps >> 32;
+    if (hpet_period_fs == 0 || hpet_period_fs > HPET_MAX_PERIOD_FS) {
+        hpet_base = NULL;
+        return 0;
+    }
+    
+    hpet_freq = FEMTOSECONDS_PER_SECOND / hpet_period_fs;
+    hpet_mask = (caps & HPET_CAP_COUNT_SIZE) ? ~0ULL : 0xFFFFFFFFULL;
+    if (table->minimum_tick) hpet_min_ticks = table->minimum_tick;
+    
+    // Halt and reset the main counter, leave legacy replacement off
+    // so the PIT keeps driving IRQ0
+    uint64_t config = hpet_read(HPET_REG_CONFIG);
+    config &= ~(uint64_t)(HPET_CFG_ENABLE | HPET_CFG_LEGACY);
+    hpet_write(HPET_REG_CONFIG, config);
+    hpet_write(HPET_REG_COUNTER, 0);
+    
+    // Comparator 0: one-shot, edge triggered, interrupt disabled until armed
+    uint64_t timer = hpet_read(HPET_REG_TIMER_CONFIG(0));
+    event_irq = hpet_pick_route((uint32_t)(timer >> 32));
+    timer &= ~(uint64_t)(HPET_TN_INT_ENABLE | HPET_TN_PERIODIC |
+                         HPET_TN_LEVEL | HPET_TN_ROUTE_MASK);
+    if (event_irq != 0xFF) {
+        timer |= (uint64_t)event_irq << HPET_TN_ROUTE_SHIFT;
+    }
+    if (hpet_mask != ~0ULL) {
+        timer |= HPET_TN_32BIT_MODE;
+    }
+    hpet_write(HPET_REG_TIMER_CONFIG(0), timer);
+    
+    hpet_write(HPET_REG_CONFIG, config | HPET_CFG_ENABLE);
+    
+    hpet_clocksource.mask = hpet_mask;
+    hpet_clocksource.freq_hz = hpet_freq;
+    clocksource_register(&hpet_clocksource);
+    
+    return 1;
+}
+
+int hpet_available(void) {
+    return hpet_base != NULL;
+}
+
+uint64_t hpet_read_counter(void) {
+    if (!hpet_base) return 0;
+    return hpet_read(HPET_REG_COUNTER) & hpet_mask;
+}
+
+uint64_t hpet_counter_mask(void) {
+    return hpet_mask;
+}
+
+uint64_t hpet_frequency(void) {
+    return hpet_freq;
+}
+
+uint64_t hpet_ns_to_ticks(uint64_t ns) {
+    return (ns / NS_PER_SECOND) * hpet_freq +
+           ((ns % NS_PER_SECOND) * hpet_freq) / NS_PER_SECOND;
+}
+
+uint64_t hpet_ticks_to_ns(uint64_t ticks) {
+    if (hpet_freq == 0) return 0;
+    return (ticks / hpet_freq) * NS_PER_SECOND +
+           ((ticks % hpet_freq) * NS_PER_SECOND) / hpet_freq;
+}
+
+void hpet_event_set_handler(void (*handler)(void)) {
+    event_handler = handler;
+}
+
+// Returns 0 once armed, -1 if there is no event timer or the deadline
+// had already passed by the time the comparator was written
+int hpet_event_arm_ns(uint64_t ns) {
+    if (!hpet_base || event_irq == 0xFF) return -1;
+    
+    uint64_t ticks = hpet_ns_to_ticks(ns);
+    if (ticks < hpet_min_ticks) ticks = hpet_min_ticks;
+    
+    uint64_t target = (hpet_read_counter() + ticks) & hpet_mask;
+    hpet_write(HPET_REG_TIMER_COMPARATOR(0), target);
+    
+    uint64_t timer = hpet_read(HPET_REG_TIMER_CONFIG(0));
+    hpet_write(HPET_REG_TIMER_CONFIG(0), timer | HPET_TN_INT_ENABLE);
+    
+    // The comparator matches on equality; a counter that already ran
+    // past the target will not fire until it wraps
+    uint64_t passed = (hpet_read_counter() - target) & hpet_mask;
+    if (passed < (hpet_mask >> 1)) {
+        hpet_event_cancel();
+        return -1;
+    }
+    
+    return 0;
+}
+
+void hpet_event_cancel(void) {
+    if (!hpet_base) return;
+    
+    uint64_t timer = hpet_read(HPET_REG_TIMER_CONFIG(0));
+    hpet_write(HPET_REG_TIMER_CONFIG(0), timer & ~(uint64_t)HPET_TN_INT_ENABLE);
+}
+
+uint8_t hpet_event_irq(void) {
+    return event_irq;
+}
+
+void hpet_event_interrupt(void) {
+    if (!hpet_base) return;
+    
+    // One-shot: disarm, then acknowledge (status is only latched for
+    // level-triggered timers, writing 1 is harmless otherwise)
+    hpet_event_cancel();
+    hpet_write(HPET_REG_INT_STATUS, 1);
+    
+    if (event_handler) {
+        event_handler();
+    }
+}
+
+static int hpet_irq_handler(void* ctx) {
+    (void)ctx;
+    hpet_event_interrupt();
+    return IRQ_HANDLED;
+}
+
+int hpet_event_request_irq(void) {
+    if (!hpet_base || event_irq == 0xFF || !ioapic_available()) return -1;
+    
+    int vector = irq_alloc_vector();
+    if (vector < 0) return -1;
+    
+    if (ioapic_route(event_irq, vector, IOAPIC_EDGE_HIGH, lapic_id()) < 0) {
+        irq_free_vector(vector);
+        return -1;
+    }
+    
+    irq_set_name(vector, "hpet");
+    request_irq(vector, hpet_irq_handler, NULL);
+    return vector;
+}
@@ -0,0 +1,66 @@
+#ifndef HPET_H
+#define HPET_H
+
+#include <stdint.h>
+
+// HPET register offsets
+#define HPET_REG_CAPABILITIES   0x000
+#define HPET_REG_CONFIG         0x010
+#define HPET_REG_INT_STATUS     0x020
+#define HPET_REG_COUNTER        0x0F0
+#define HPET_REG_TIMER_CONFIG(n)     (0x100 + 0x20 * (n))
+#define HPET_REG_TIMER_COMPARATOR(n) (0x108 + 0x20 * (n))
+
+// General capabilities
+#define HPET_CAP_COUNT_SIZE     (1 << 13)   // 64-bit main counter
+#define HPET_CAP_LEGACY_ROUTE   (1 << 15)
+
+// General configuration
+#define HPET_CFG_ENABLE         (1 << 0)
+#define HPET_CFG_LEGACY         (1 << 1)
+
+// Timer N configuration
+#define HPET_TN_LEVEL           (1 << 1)
+#define HPET_TN_INT_ENABLE      (1 << 2)
+#define HPET_TN_PERIODIC        (1 << 3)
+#define HPET_TN_PERIODIC_CAP    (1 << 4)
+#define HPET_TN_64BIT_CAP       (1 << 5)
+#define HPET_TN_VAL_SET         (1 << 6)
+#define HPET_TN_32BIT_MODE      (1 << 8)
+#define HPET_TN_ROUTE_SHIFT     9
+#define HPET_TN_ROUTE_MASK      (0x1F << HPET_TN_ROUTE_SHIFT)
+
+// Find the HPET through ACPI, map it and start the main counter.
+// Returns 1 on success.
+int hpet_init(void);
+
+int hpet_available(void);
+
+// Main counter (monotonic; only the low 32 bits count on 32-bit HPETs)
+uint64_t hpet_read_counter(void);
+uint64_t hpet_counter_mask(void);
+
+// Counter frequency in Hz
+uint64_t hpet_frequency(void);
+
+// Convert between nanoseconds and counter ticks
+uint64_t hpet_ns_to_ticks(uint64_t ns);
+uint64_t hpet_ticks_to_ns(uint64_t ticks);
+
+// One-shot event timer (comparator 0)
+// The handler runs in interrupt context when the deadline passes.
+void hpet_event_set_handler(void (*handler)(void));
+int hpet_event_arm_ns(uint64_t ns);
+void hpet_event_cancel(void);
+
+// Interrupt line the event timer is routed to
+uint8_t hpet_event_irq(void);
+
+// Called from the IRQ path for the event timer's line
+void hpet_event_interrupt(void);
+
+// Route the event timer's pin through the IOAPIC to a fresh vector and
+// install the handler. Returns the vector, or -1 without an IOAPIC route.
+int hpet_event_request_irq(void);
+
+#endif
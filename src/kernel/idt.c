@@ -1,5 +1,8 @@
 #include "idt.h"
 #include "lib/io.h"
+#include "kernel/irq.h"
+#include "kernel/pic.h"
+#include "kernel/softirq.h"
 
 // 64-bit IDT entries (16 bytes each)
 struct idt_entry_64 {
@@ -34,6 +37,9 @@ extern void irq4(void);  extern void irq5(void);  extern void irq6(void);  exter
 extern void irq8(void);  extern void irq9(void);  extern void irq10(void); extern void irq11(void);
 extern void irq12(void); extern void irq13(void); extern void irq14(void); extern void irq15(void);
 
+// Stubs for vectors 48-255, indexed from IRQ_DYNAMIC_BASE
+extern uint64_t vector_stub_table[];
+
 static void idt_set_gate(uint8_t num, uint64_t base, uint16_t selector, uint8_t flags) {
     idt_entries[num].base_low = base & 0xFFFF;
     idt_entries[num].base_mid = (base >> 16) & 0xFFFF;
@@ -54,11 +60,7 @@ void init_idt(void) {
     }
     
     // Remap PIC
-    outb(0x20, 0x11); outb(0xA0, 0x11);
-    outb(0x21, 0x20); outb(0xA1, 0x28);
-    outb(0x21, 0x04); outb(0xA1, 0x02);
-    outb(0x21, 0x01); outb(0xA1, 0x01);
-    outb(0x21, 0x0);  outb(0xA1, 0x0);
+    pic_remap(IRQ_TO_VECTOR(0), IRQ_TO_VECTOR(8));
     
     // Set ISRs
     idt_set_gate(0, (uint64_t)isr0, 0x08, 0x8E);   idt_set_gate(1, (uint64_t)isr1, 0x08, 0x8E);
@@ -88,8 +90,13 @@ void init_idt(void) {
     idt_set_gate(44, (uint64_t)irq12, 0x08, 0x8E); idt_set_gate(45, (uint64_t)irq13, 0x08, 0x8E);
     idt_set_gate(46, (uint64_t)irq14, 0x08, 0x8E); idt_set_gate(47, (uint64_t)irq15, 0x08, 0x8E);
     
+    // IOAPIC/MSI/LAPIC vectors
+    for (int v = IRQ_DYNAMIC_BASE; v < 256; v++) {
+        idt_set_gate(v, vector_stub_table[v - IRQ_DYNAMIC_BASE], 0x08, 0x8E);
+    }
+    
+    // Interrupts stay off until the "sti" initcall, once routing is done
     asm volatile("lidt %0" : : "m"(idt_ptr));
-    asm volatile("sti");
 }
 
 // ISR handler - called from assembly
@@ -100,7 +107,9 @@ void isr_handler(void* stack_ptr) {
 
 // IRQ handler - called from assembly
 void irq_handler(void* stack_ptr) {
-    // For now, just send EOI
-    (void)stack_ptr;
-    outb(0x20, 0x20);  // Send EOI to master PIC
+    // Registered handlers + EOI to whichever controller owns the vector
+    irq_dispatch((interrupt_frame_t*)stack_ptr);
+    
+    // Bottom halves run after the EOI so further IRQs can come in
+    do_softirq();
 }
\ No newline at end of file
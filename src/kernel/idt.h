@@ -3,6 +3,15 @@
 
 #include <stdint.h>
 
+// Stack layout built by isr_common_stub / irq_common_stub
+typedef struct {
+    uint64_t gs, fs, es, ds;
+    uint64_t r15, r14, r13, r12, r11, r10, r9, r8;
+    uint64_t rbp, rdi, rsi, rdx, rcx, rbx, rax;
+    uint64_t int_no, err_code;
+    uint64_t rip, cs, rflags, rsp, ss;   // Pushed by the CPU
+} interrupt_frame_t;
+
 // Initialize the IDT
 void init_idt(void);
 
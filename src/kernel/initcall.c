@@ -0,0 +1,170 @@
+#include "initcall.h"
+#include "kernel/tsc.h"
+#include "kernel/printk.h"
+#include "kernel/workqueue.h"
+#include "lib/printf.h"
+#include <stddef.h>
+
+#define BOOTCHART_COLUMNS 32
+
+// Bounds of the __initcalls section (linker.ld)
+extern initcall_t __start___initcalls[];
+extern initcall_t __stop___initcalls[];
+
+// Calls in the order they ran, for the bootchart
+static initcall_t* run_order[INITCALL_MAX];
+static int run_count = 0;
+
+static uint64_t boot_tsc = 0;       // initcall_run_boot entry
+static uint64_t gui_tsc = 0;
+static uint64_t deferred_tsc = 0;   // Last deferred call finished
+
+static work_t deferred_work;
+
+static initcall_t* initcall_find(const char* name, int len) {
+    for (initcall_t* call = __start___initcalls; call < __stop___initcalls; call++) {
+        int i = 0;
+        while (i < len && call->name[i] == name[i]) i++;
+        if (i == len && call->name[len] == '\0') return call;
+    }
+    return NULL;
+}
+
+// 1 when every dependency has run, 0 while one is still waiting, -1 when
+// one does not exist or was skipped
+static int initcall_ready(const initcall_t* call) {
+    const char* dep = call->deps;
+    int ready = 1;
+    
+    while (*dep) {
+        if (*dep == ' ') {
+            dep++;
+            continue;
+        }
+        
+        int len = 0;
+        while (dep[len] && dep[len] != ' ') len++;
+        
+        initcall_t* other = initcall_find(dep, len);
+        if (!other || other->state == INITCALL_SKIPPED) {
+            pr_err("initcall", "%s: missing dependency %.*s", call->name, len, dep);
+            return -1;
+        }
+        if (other->state != INITCALL_DONE) ready = 0;
+        dep += len;
+    }
+    return ready;
+}
+
+static void initcall_run(initcall_t* call) {
+    call->start_tsc = rdtsc();
+    call->result = call->fn();
+    call->end_tsc = rdtsc();
+    call->state = INITCALL_DONE;
+    
+    if (run_count < INITCALL_MAX) run_order[run_count++] = call;
+    if (call->result != 0) pr_warn("initcall", "%s failed (%d)", call->name, call->result);
+}
+
+// Keep sweeping the calls of one class until a pass runs nothing new
+static void initcall_run_class(uint32_t deferred) {
+    int progress;
+    
+    do {
+        progress = 0;
+        for (initcall_t* call = __start___initcalls; call < __stop___initcalls; call++) {
+            if (call->state != INITCALL_WAITING) continue;
+            if ((call->flags & INITCALL_DEFERRED) != deferred) continue;
+            
+            int ready = initcall_ready(call);
+            if (ready < 0) {
+                call->state = INITCALL_SKIPPED;
+                progress = 1;
+            } else if (ready) {
+                initcall_run(call);
+                progress = 1;
+            }
+        }
+    } while (progress);
+    
+    // Whatever is left waits on a cycle, or (at boot) on a deferred call
+    for (initcall_t* call = __start___initcalls; call < __stop___initcalls; call++) {
+        if (call->state != INITCALL_WAITING) continue;
+        if ((call->flags & INITCALL_DEFERRED) != deferred) continue;
+        
+        pr_err("initcall", "%s: dependencies can't be met (%s)", call->name, call->deps);
+        call->state = INITCALL_SKIPPED;
+    }
+}
+
+void initcall_run_boot(void) {
+    boot_tsc = rdtsc();
+    initcall_run_class(0);
+}
+
+static uint32_t boot_us(uint64_t tsc) {
+    return tsc > boot_tsc ? (uint32_t)(tsc_cycles_to_ns(tsc - boot_tsc) / 1000) : 0;
+}
+
+static void initcall_deferred_work(work_t* work) {
+    (void)work;
+    initcall_run_class(INITCALL_DEFERRED);
+    deferred_tsc = rdtsc();
+    pr_info("boot", "deferred initcalls done %u us after kmain", boot_us(deferred_tsc));
+}
+
+void initcall_gui_ready(uint64_t first_frame_tsc) {
+    gui_tsc = first_frame_tsc;
+    pr_info("boot", "%d initcalls, GUI up %u us after kmain", run_count, boot_us(gui_tsc));
+    
+    init_work(&deferred_work, initcall_deferred_work);
+    schedule_work(&deferred_work);
+}
+
+void initcall_bootchart(void (*print)(const char* line)) {
+    char line[128];
+    uint64_t end = deferred_tsc > gui_tsc ? deferred_tsc : gui_tsc;
+    uint32_t span = boot_us(end);
+    if (span == 0) span = 1;
+    
+    snprintf(line, sizeof(line), "  %-12s %8s %8s", "stage", "start us", "time us");
+    print(line);
+    for (int i = 0; i < run_count; i++) {
+        const initcall_t* call = run_order[i];
+        uint32_t start = boot_us(call->start_tsc);
+        uint32_t stop = boot_us(call->end_tsc);
+        
+        // Gantt bar over the whole boot, at least one column wide
+        char bar[BOOTCHART_COLUMNS + 1];
+        int from = (int)((uint64_t)start * BOOTCHART_COLUMNS / span);
+        int to = (int)((uint64_t)stop * BOOTCHART_COLUMNS / span);
+        if (from >= BOOTCHART_COLUMNS) from = BOOTCHART_COLUMNS - 1;
+        if (to <= from) to = from + 1;
+        if (to > BOOTCHART_COLUMNS) to = BOOTCHART_COLUMNS;
+        for (int c = 0; c < to; c++) bar[c] = c < from ? ' ' : '#';
+        bar[to] = '\0';
+        
+        snprintf(line, sizeof(line), "  %-12s %8u %8u %s%s%s", call->name, start, stop - start, bar,
+                 (call->flags & INITCALL_DEFERRED) ? " deferred" : "",
+                 call->result != 0 ? " failed" : "");
+        print(line);
+    }
+    
+    for (initcall_t* call = __start___initcalls; call < __stop___initcalls; call++) {
+        if (call->state != INITCALL_SKIPPED) continue;
+        snprintf(line, sizeof(line), "  %-12s skipped (needs %s)", call->name, call->deps);
+        print(line);
+    }
+    
+    if (gui_tsc) {
+        snprintf(line, sizeof(line), "Time to GUI: %u us (firmware and loader before kmain: %u us)",
+                 boot_us(gui_tsc), (uint32_t)(tsc_cycles_to_ns(boot_tsc) / 1000));
+        print(line);
+    }
+    if (deferred_tsc) {
+        snprintf(line, sizeof(line), "Deferred initcalls done at %u us", boot_us(deferred_tsc));
+        print(line);
+    } else if (gui_tsc) {
+        print("Deferred initcalls still running");
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef INITCALL_H
+#define INITCALL_H
+
+#include <stdint.h>
+
+#define INITCALL_MAX        48      // Bootchart slots
+#define INITCALL_DEFERRED   (1 << 0)    // Run from the system workqueue after the GUI is up
+
+// Lifecycle of one initcall
+#define INITCALL_WAITING    0
+#define INITCALL_DONE       1
+#define INITCALL_SKIPPED    2       // A dependency is missing or never ran
+
+// A boot stage. deps names the stages that must have run first, separated
+// by spaces ("" for none); the order of definition does not matter.
+typedef struct initcall {
+    const char* name;
+    int (*fn)(void);            // Nonzero: the stage failed (dependents still run)
+    const char* deps;
+    uint32_t flags;
+
+    // Filled in as the stage runs
+    uint8_t state;
+    int result;
+    uint64_t start_tsc;
+    uint64_t end_tsc;
+} initcall_t;
+
+// Initcalls are collected into the __initcalls section (linker.ld)
+#define DEFINE_INITCALL(var, call_name, func, dep_names, call_flags)       \
+    static initcall_t var                                                   \
+    __attribute__((section("__initcalls"), aligned(8), used)) =             \
+    { call_name, func, dep_names, call_flags, INITCALL_WAITING, 0, 0, 0 }
+
+// Run every boot-time initcall, each after the ones it depends on. Stages
+// whose dependencies can never be met are skipped with an error.
+void initcall_run_boot(void);
+
+// The first frame has been presented (at first_frame_tsc): record
+// time-to-GUI and queue the deferred initcalls on the system workqueue
+void initcall_gui_ready(uint64_t first_frame_tsc);
+
+// Stage timings for the "bootchart" command, one line per call
+void initcall_bootchart(void (*print)(const char* line));
+
+#endif
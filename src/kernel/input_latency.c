@@ -0,0 +1,139 @@
+#include "input_latency.h"
+#include "kernel/spinlock.h"
+#include "kernel/tsc.h"
+#include <stddef.h>
+
+typedef struct {
+    // Applied, but no frame has sampled them yet
+    uint64_t pending[INPUT_LATENCY_PENDING];
+    uint32_t pending_count;
+    
+    // Sampled by the frame being rendered
+    uint64_t inflight[INPUT_LATENCY_PENDING];
+    uint32_t inflight_count;
+    
+    uint32_t hist[INPUT_LATENCY_BUCKETS];
+    uint64_t events;
+    uint64_t dropped;
+    uint64_t total_us;
+    uint32_t min_us;
+    uint32_t max_us;
+} input_latency_class_t;
+
+static input_latency_class_t classes[INPUT_LATENCY_CLASSES];
+static spinlock_t latency_lock = SPINLOCK_INIT;
+
+void input_latency_event(int cls, uint64_t isr_tsc) {
+    if (cls < 0 || cls >= INPUT_LATENCY_CLASSES) return;
+    
+    uint64_t flags = spin_lock_irqsave(&latency_lock);
+    input_latency_class_t* c = &classes[cls];
+    if (c->pending_count < INPUT_LATENCY_PENDING) {
+        c->pending[c->pending_count++] = isr_tsc;
+    } else {
+        c->dropped++;
+    }
+    spin_unlock_irqrestore(&latency_lock, flags);
+}
+
+void input_latency_frame_begin(void) {
+    uint64_t flags = spin_lock_irqsave(&latency_lock);
+    for (int i = 0; i < INPUT_LATENCY_CLASSES; i++) {
+        input_latency_class_t* c = &classes[i];
+        
+        // A frame that never got flushed hands its events to this one
+        for (uint32_t j = 0; j < c->pending_count; j++) {
+            if (c->inflight_count < INPUT_LATENCY_PENDING) {
+                c->inflight[c->inflight_count++] = c->pending[j];
+            } else {
+                c->dropped++;
+            }
+        }
+        c->pending_count = 0;
+    }
+    spin_unlock_irqrestore(&latency_lock, flags);
+}
+
+static void input_latency_record(input_latency_class_t* c, uint64_t cycles) {
+    uint64_t us = tsc_cycles_to_ns(cycles) / 1000;
+    if (us > UINT32_MAX) us = UINT32_MAX;
+    
+    uint64_t bucket = us / INPUT_LATENCY_BUCKET_US;
+    c->hist[bucket < INPUT_LATENCY_BUCKETS ? bucket : INPUT_LATENCY_BUCKETS - 1]++;
+    
+    if (c->events == 0 || us < c->min_us) c->min_us = (uint32_t)us;
+    if (us > c->max_us) c->max_us = (uint32_t)us;
+    c->total_us += us;
+    c->events++;
+}
+
+void input_latency_frame_flushed(void) {
+    uint64_t now = rdtsc();
+    
+    uint64_t flags = spin_lock_irqsave(&latency_lock);
+    for (int i = 0; i < INPUT_LATENCY_CLASSES; i++) {
+        input_latency_class_t* c = &classes[i];
+        for (uint32_t j = 0; j < c->inflight_count; j++) {
+            input_latency_record(c, now > c->inflight[j] ? now - c->inflight[j] : 0);
+        }
+        c->inflight_count = 0;
+    }
+    spin_unlock_irqrestore(&latency_lock, flags);
+}
+
+// Upper bound of the bucket holding the percentile; the last bucket is
+// open-ended, so report the maximum for it
+static uint32_t input_latency_percentile(const input_latency_class_t* c, int percent) {
+    uint64_t target = (c->events * percent + 99) / 100;
+    uint64_t seen = 0;
+    
+    for (int b = 0; b < INPUT_LATENCY_BUCKETS - 1; b++) {
+        seen += c->hist[b];
+        if (seen >= target) {
+            uint32_t bound = (b + 1) * INPUT_LATENCY_BUCKET_US;
+            return bound < c->max_us ? bound : c->max_us;
+        }
+    }
+    return c->max_us;
+}
+
+void input_latency_stats(int cls, input_latency_stats_t* out) {
+    out->events = 0;
+    if (cls < 0 || cls >= INPUT_LATENCY_CLASSES) return;
+    
+    uint64_t flags = spin_lock_irqsave(&latency_lock);
+    const input_latency_class_t* c = &classes[cls];
+    out->events = c->events;
+    out->dropped = c->dropped;
+    out->min_us = c->min_us;
+    out->max_us = c->max_us;
+    out->avg_us = c->events ? (uint32_t)(c->total_us / c->events) : 0;
+    out->p50_us = c->events ? input_latency_percentile(c, 50) : 0;
+    out->p95_us = c->events ? input_latency_percentile(c, 95) : 0;
+    out->p99_us = c->events ? input_latency_percentile(c, 99) : 0;
+    spin_unlock_irqrestore(&latency_lock, flags);
+}
+
+void input_latency_reset(void) {
+    uint64_t flags = spin_lock_irqsave(&latency_lock);
+    for (int i = 0; i < INPUT_LATENCY_CLASSES; i++) {
+        input_latency_class_t* c = &classes[i];
+        c->pending_count = 0;
+        c->inflight_count = 0;
+        for (int b = 0; b < INPUT_LATENCY_BUCKETS; b++) c->hist[b] = 0;
+        c->events = 0;
+        c->dropped = 0;
+        c->total_us = 0;
+        c->min_us = 0;
+        c->max_us = 0;
+    }
+    spin_unlock_irqrestore(&latency_lock, flags);
+}
+
+const char* input_latency_name(int cls) {
+    switch (cls) {
+    case INPUT_LATENCY_KEY:     return "key";
+    case INPUT_LATENCY_POINTER: return "pointer";
+    default:                    return "unknown";
+    }
+}
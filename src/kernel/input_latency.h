@@ -0,0 +1,46 @@
+#ifndef INPUT_LATENCY_H
+#define INPUT_LATENCY_H
+
+#include <stdint.h>
+
+// Input-to-photon latency: each event carries the TSC of the interrupt
+// that delivered it, the frame loop marks which events a frame picks up,
+// and swap_buffers records how long they took to reach the screen.
+
+enum {
+    INPUT_LATENCY_KEY,
+    INPUT_LATENCY_POINTER,
+    INPUT_LATENCY_CLASSES
+};
+
+#define INPUT_LATENCY_BUCKETS   256     // Histogram: 100 us buckets up to 25.6 ms
+#define INPUT_LATENCY_BUCKET_US 100
+#define INPUT_LATENCY_PENDING   32      // Events per class waiting for a frame
+
+typedef struct {
+    uint64_t events;            // Latencies recorded
+    uint64_t dropped;           // Events that found the pending list full
+    uint32_t min_us;
+    uint32_t avg_us;
+    uint32_t p50_us;            // Percentiles are bucket upper bounds
+    uint32_t p95_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+} input_latency_stats_t;
+
+// An event of class cls changed what the GUI shows; isr_tsc is when its
+// first byte arrived. Called from the input bottom halves.
+void input_latency_event(int cls, uint64_t isr_tsc);
+
+// The frame loop sampled input: everything applied so far is in this frame
+void input_latency_frame_begin(void);
+
+// A frame reached the framebuffer (called by swap_buffers)
+void input_latency_frame_flushed(void);
+
+void input_latency_stats(int cls, input_latency_stats_t* out);
+void input_latency_reset(void);
+
+const char* input_latency_name(int cls);
+
+#endif
@@ -0,0 +1,209 @@
+#include "ioapic.h"
+#include <stddef.h>
+#include "kernel/acpi.h"
+#include "kernel/lapic.h"
+#include "kernel/irqflags.h"
+#include "mm/vmm.h"
+
+#define IOAPIC_NO_GSI 0xFFFFFFFF
+
+typedef struct {
+    volatile uint32_t* base;   // IOREGSEL at +0x00, IOWIN at +0x10
+    uint8_t id;
+    uint32_t gsi_base;
+    uint32_t num_pins;
+} ioapic_t;
+
+static ioapic_t ioapics[MAX_IOAPICS];
+static int num_ioapics = 0;
+
+// ISA IRQ -> GSI and INTI flags from the MADT overrides
+static uint32_t isa_gsi[16];
+static uint16_t isa_flags[16];
+
+// Which GSI feeds each vector, for mask/unmask/affinity
+static uint32_t vector_gsi[NR_VECTORS];
+
+static uint32_t ioapic_read(ioapic_t* io, uint8_t reg) {
+    io->base[0] = reg;
+    return io->base[4];
+}
+
+static void ioapic_write(ioapic_t* io, uint8_t reg, uint32_t value) {
+    io->base[0] = reg;
+    io->base[4] = value;
+}
+
+static ioapic_t* ioapic_for_gsi(uint32_t gsi) {
+    for (int i = 0; i < num_ioapics; i++) {
+        if (gsi >= ioapics[i].gsi_base && gsi < ioapics[i].gsi_base + ioapics[i].num_pins) {
+            return &ioapics[i];
+        }
+    }
+    return NULL;
+}
+
+static uint64_t ioapic_read_rte(uint32_t gsi) {
+    ioapic_t* io = ioapic_for_gsi(gsi);
+    uint32_t pin = gsi - io->gsi_base;
+    return ioapic_read(io, IOAPIC_REG_REDTBL(pin)) |
+           ((uint64_t)ioapic_read(io, IOAPIC_REG_REDTBL(pin) + 1) << 32);
+}
+
+static void ioapic_write_rte(uint32_t gsi, uint64_t rte) {
+    ioapic_t* io = ioapic_for_gsi(gsi);
+    uint32_t pin = gsi - io->gsi_base;
+    
+    // Keep the entry masked while the halves disagree
+    ioapic_write(io, IOAPIC_REG_REDTBL(pin), IOAPIC_RTE_MASKED);
+    ioapic_write(io, IOAPIC_REG_REDTBL(pin) + 1, (uint32_t)(rte >> 32));
+    ioapic_write(io, IOAPIC_REG_REDTBL(pin), (uint32_t)rte);
+}
+
+static void ioapic_eoi(uint8_t vector) {
+    (void)vector;
+    lapic_eoi();
+}
+
+static void ioapic_mask(uint8_t vector) {
+    uint32_t gsi = vector_gsi[vector];
+    if (gsi == IOAPIC_NO_GSI) return;
+    ioapic_write_rte(gsi, ioapic_read_rte(gsi) | IOAPIC_RTE_MASKED);
+}
+
+static void ioapic_unmask(uint8_t vector) {
+    uint32_t gsi = vector_gsi[vector];
+    if (gsi == IOAPIC_NO_GSI) return;
+    ioapic_write_rte(gsi, ioapic_read_rte(gsi) & ~(uint64_t)IOAPIC_RTE_MASKED);
+}
+
+irq_chip_t ioapic_chip = {
+    .name = "IO-APIC",
+    .eoi = ioapic_eoi,
+    .mask = ioapic_mask,
+    .unmask = ioapic_unmask,
+    .is_spurious = NULL,
+};
+
+static void ioapic_add(acpi_madt_ioapic_t* entry) {
+    if (num_ioapics >= MAX_IOAPICS) return;
+    
+    ioapic_t* io = &ioapics[num_ioapics];
+    io->base = (volatile uint32_t*)vmm_map_mmio(entry->address, 4096);
+    if (!io->base) return;
+    io->id = entry->ioapic_id;
+    io->gsi_base = entry->gsi_base;
+    io->num_pins = ((ioapic_read(io, IOAPIC_REG_VERSION) >> 16) & 0xFF) + 1;
+    num_ioapics++;
+    
+    for (uint32_t pin = 0; pin < io->num_pins; pin++) {
+        ioapic_write(io, IOAPIC_REG_REDTBL(pin), IOAPIC_RTE_MASKED);
+        ioapic_write(io, IOAPIC_REG_REDTBL(pin) + 1, 0);
+    }
+}
+
+int ioapic_init(void) {
+    acpi_madt_t* madt = (acpi_madt_t*)acpi_find_table("APIC");
+    if (!madt) return 0;
+    
+    for (int v = 0; v < NR_VECTORS; v++) {
+        vector_gsi[v] = IOAPIC_NO_GSI;
+    }
+    
+    // Identity unless overridden
+    for (int irq = 0; irq < 16; irq++) {
+        isa_gsi[irq] = irq;
+        isa_flags[irq] = 0;
+    }
+    
+    uint8_t* ptr = (uint8_t*)madt + sizeof(acpi_madt_t);
+    uint8_t* end = (uint8_t*)madt + madt->header.length;
+    
+    while (ptr + sizeof(acpi_madt_entry_t) <= end) {
+        acpi_madt_entry_t* entry = (acpi_madt_entry_t*)ptr;
+        if (entry->length < sizeof(acpi_madt_entry_t)) break;
+        
+        if (entry->type == ACPI_MADT_IOAPIC) {
+            ioapic_add((acpi_madt_ioapic_t*)entry);
+        }
+        else if (entry->type == ACPI_MADT_INT_OVERRIDE) {
+            acpi_madt_override_t* iso = (acpi_madt_override_t*)entry;
+            if (iso->bus == 0 && iso->source < 16) {
+                isa_gsi[iso->source] = iso->gsi;
+                isa_flags[iso->source] = iso->flags;
+            }
+        }
+        
+        ptr += entry->length;
+    }
+    
+    return num_ioapics;
+}
+
+int ioapic_available(void) {
+    return num_ioapics > 0;
+}
+
+uint32_t ioapic_isa_to_gsi(uint8_t isa_irq) {
+    if (isa_irq >= 16) return isa_irq;
+    return isa_gsi[isa_irq];
+}
+
+int ioapic_route(uint32_t gsi, uint8_t vector, uint32_t mode, uint8_t dest_apic) {
+    if (!ioapic_for_gsi(gsi)) return -1;
+    
+    uint64_t flags = local_irq_save();
+    
+    // A pin can only deliver one vector; take it over only if its
+    // current vector has nobody listening
+    for (int v = 0; v < NR_VECTORS; v++) {
+        if (v == vector || vector_gsi[v] != gsi) continue;
+        if (irq_get_desc(v)->actions) {
+            local_irq_restore(flags);
+            return -1;
+        }
+        vector_gsi[v] = IOAPIC_NO_GSI;
+    }
+    
+    uint64_t rte = vector | (mode & (IOAPIC_RTE_LEVEL | IOAPIC_RTE_ACTIVE_LOW)) |
+                   ((uint64_t)dest_apic << IOAPIC_RTE_DEST_SHIFT);
+    if (!irq_get_desc(vector)->actions) {
+        rte |= IOAPIC_RTE_MASKED;
+    }
+    
+    vector_gsi[vector] = gsi;
+    ioapic_write_rte(gsi, rte);
+    irq_set_chip(vector, &ioapic_chip);
+    
+    local_irq_restore(flags);
+    return 0;
+}
+
+int ioapic_set_affinity(uint8_t vector, uint8_t dest_apic) {
+    uint32_t gsi = vector_gsi[vector];
+    if (gsi == IOAPIC_NO_GSI) return -1;
+    
+    uint64_t rte = ioapic_read_rte(gsi) & ~(0xFFULL << IOAPIC_RTE_DEST_SHIFT);
+    ioapic_write_rte(gsi, rte | ((uint64_t)dest_apic << IOAPIC_RTE_DEST_SHIFT));
+    return 0;
+}
+
+void ioapic_route_legacy(void) {
+    uint8_t dest = lapic_id();
+    
+    for (int irq = 0; irq < 16; irq++) {
+        // IRQ2 is the PIC cascade and never fires on its own
+        if (irq == 2) continue;
+        
+        // ISA defaults to active-high edge; overrides may say otherwise
+        uint32_t mode = IOAPIC_EDGE_HIGH;
+        if ((isa_flags[irq] & ACPI_MADT_POLARITY_MASK) == ACPI_MADT_POLARITY_LOW) {
+            mode |= IOAPIC_RTE_ACTIVE_LOW;
+        }
+        if ((isa_flags[irq] & ACPI_MADT_TRIGGER_MASK) == ACPI_MADT_TRIGGER_LEVEL) {
+            mode |= IOAPIC_RTE_LEVEL;
+        }
+        
+        ioapic_route(isa_gsi[irq], IRQ_TO_VECTOR(irq), mode, dest);
+    }
+}
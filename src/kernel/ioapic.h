@@ -0,0 +1,45 @@
+#ifndef IOAPIC_H
+#define IOAPIC_H
+
+#include <stdint.h>
+#include "kernel/irq.h"
+
+#define MAX_IOAPICS             4
+
+// Indirect register indices (IOREGSEL)
+#define IOAPIC_REG_ID           0x00
+#define IOAPIC_REG_VERSION      0x01
+#define IOAPIC_REG_REDTBL(n)    (0x10 + 2 * (n))
+
+// Redirection table entry bits
+#define IOAPIC_RTE_ACTIVE_LOW   (1 << 13)
+#define IOAPIC_RTE_LEVEL        (1 << 15)
+#define IOAPIC_RTE_MASKED       (1 << 16)
+#define IOAPIC_RTE_DEST_SHIFT   56
+
+// Trigger/polarity for ioapic_route
+#define IOAPIC_EDGE_HIGH        0
+#define IOAPIC_LEVEL_LOW        (IOAPIC_RTE_LEVEL | IOAPIC_RTE_ACTIVE_LOW)
+
+// Parse the MADT and mask every input. Returns the number of IOAPICs found.
+int ioapic_init(void);
+int ioapic_available(void);
+
+// GSI an ISA IRQ is wired to, after MADT interrupt source overrides
+uint32_t ioapic_isa_to_gsi(uint8_t isa_irq);
+
+// Point a GSI at a vector on the given LAPIC. The entry stays masked until
+// request_irq unmasks it. Returns -1 if the GSI doesn't exist or already
+// serves another vector that has handlers.
+int ioapic_route(uint32_t gsi, uint8_t vector, uint32_t mode, uint8_t dest_apic);
+
+// Steer an already routed vector to another CPU
+int ioapic_set_affinity(uint8_t vector, uint8_t dest_apic);
+
+// Move ISA IRQs 0-15 from the PIC onto the IOAPIC, keeping their vectors
+// (IRQ_TO_VECTOR) so existing handlers keep working
+void ioapic_route_legacy(void);
+
+extern irq_chip_t ioapic_chip;
+
+#endif
@@ -0,0 +1,202 @@
+#include "irq.h"
+#include "kernel/pic.h"
+#include "kernel/tsc.h"
+#include "kernel/irqflags.h"
+#include "kernel/trace.h"
+#include <stddef.h>
+
+static irq_desc_t irq_desc[NR_VECTORS];
+static irq_action_t action_pool[MAX_IRQ_ACTIONS];
+static interrupt_frame_t* current_regs = NULL;
+static uint8_t vector_allocated[NR_VECTORS];
+
+DEFINE_TRACEPOINT(irq);
+
+static int irq_hist_bucket(uint64_t cycles) {
+    int bucket = 0;
+    while (cycles && bucket < IRQ_HIST_BUCKETS - 1) {
+        cycles >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void irq_init(void) {
+    for (int v = 0; v < NR_VECTORS; v++) {
+        irq_desc[v].name = NULL;
+        irq_desc[v].chip = NULL;
+        irq_desc[v].actions = NULL;
+        vector_allocated[v] = 0;
+    }
+    
+    for (int i = 0; i < MAX_IRQ_ACTIONS; i++) {
+        action_pool[i].handler = NULL;
+    }
+    
+    for (int irq = 0; irq < 16; irq++) {
+        irq_desc[IRQ_TO_VECTOR(irq)].chip = &pic_chip;
+    }
+    
+    irq_reset_stats();
+}
+
+int irq_alloc_vector(void) {
+    uint64_t flags = local_irq_save();
+    
+    for (int v = IRQ_DYNAMIC_BASE; v <= IRQ_DYNAMIC_END; v++) {
+        if (!vector_allocated[v] && !irq_desc[v].actions) {
+            vector_allocated[v] = 1;
+            local_irq_restore(flags);
+            return v;
+        }
+    }
+    
+    local_irq_restore(flags);
+    return -1;
+}
+
+void irq_free_vector(uint8_t vector) {
+    vector_allocated[vector] = 0;
+    irq_desc[vector].chip = NULL;
+    irq_desc[vector].name = NULL;
+}
+
+int request_irq(uint8_t vector, irq_handler_t handler, void* ctx) {
+    if (!handler || vector < IRQ_VECTOR_BASE) return -1;
+    
+    uint64_t flags = local_irq_save();
+    
+    irq_action_t* action = NULL;
+    for (int i = 0; i < MAX_IRQ_ACTIONS; i++) {
+        if (!action_pool[i].handler) {
+            action = &action_pool[i];
+            break;
+        }
+    }
+    
+    if (!action) {
+        local_irq_restore(flags);
+        return -1;
+    }
+    
+    action->handler = handler;
+    action->ctx = ctx;
+    action->next = NULL;
+    
+    // Append so handlers run in registration order
+    irq_desc_t* desc = &irq_desc[vector];
+    irq_action_t** tail = &desc->actions;
+    while (*tail) tail = &(*tail)->next;
+    *tail = action;
+    
+    if (desc->chip && desc->chip->unmask) {
+        desc->chip->unmask(vector);
+    }
+    
+    local_irq_restore(flags);
+    return 0;
+}
+
+void free_irq(uint8_t vector, irq_handler_t handler, void* ctx) {
+    uint64_t flags = local_irq_save();
+    
+    irq_desc_t* desc = &irq_desc[vector];
+    for (irq_action_t** link = &desc->actions; *link; link = &(*link)->next) {
+        irq_action_t* action = *link;
+        if (action->handler == handler && action->ctx == ctx) {
+            *link = action->next;
+            action->handler = NULL;
+            break;
+        }
+    }
+    
+    if (!desc->actions && desc->chip && desc->chip->mask) {
+        desc->chip->mask(vector);
+    }
+    
+    local_irq_restore(flags);
+}
+
+void irq_set_name(uint8_t vector, const char* name) {
+    irq_desc[vector].name = name;
+}
+
+void irq_set_chip(uint8_t vector, irq_chip_t* chip) {
+    irq_desc[vector].chip = chip;
+}
+
+irq_desc_t* irq_get_desc(uint8_t vector) {
+    return &irq_desc[vector];
+}
+
+interrupt_frame_t* irq_get_regs(void) {
+    return current_regs;
+}
+
+void irq_dispatch(interrupt_frame_t* frame) {
+    uint8_t vector = (uint8_t)frame->int_no;
+    irq_desc_t* desc = &irq_desc[vector];
+    irq_chip_t* chip = desc->chip;
+    
+    if (chip && chip->is_spurious && chip->is_spurious(vector)) {
+        desc->spurious++;
+        return;
+    }
+    
+    interrupt_frame_t* old_regs = current_regs;
+    current_regs = frame;
+    
+    trace_begin(irq, vector);
+    uint64_t start = rdtsc();
+    
+    int handled = IRQ_NONE;
+    for (irq_action_t* action = desc->actions; action; action = action->next) {
+        handled |= action->handler(action->ctx);
+    }
+    
+    uint64_t cycles = rdtsc() - start;
+    trace_end(irq, vector);
+    
+    current_regs = old_regs;
+    
+    desc->count++;
+    if (!handled) desc->unhandled++;
+    desc->total_cycles += cycles;
+    if (cycles > desc->max_cycles) desc->max_cycles = cycles;
+    desc->hist[irq_hist_bucket(cycles)]++;
+    
+    if (chip && chip->eoi) {
+        chip->eoi(vector);
+    }
+}
+
+uint64_t irq_hist_percentile(irq_desc_t* desc, int percent) {
+    uint64_t total = 0;
+    for (int b = 0; b < IRQ_HIST_BUCKETS; b++) total += desc->hist[b];
+    if (total == 0) return 0;
+    
+    uint64_t target = (total * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (int b = 0; b < IRQ_HIST_BUCKETS; b++) {
+        seen += desc->hist[b];
+        if (seen >= target) return 1ULL << b;
+    }
+    return 1ULL << (IRQ_HIST_BUCKETS - 1);
+}
+
+void irq_reset_stats(void) {
+    uint64_t flags = local_irq_save();
+    
+    for (int v = 0; v < NR_VECTORS; v++) {
+        irq_desc[v].count = 0;
+        irq_desc[v].unhandled = 0;
+        irq_desc[v].spurious = 0;
+        irq_desc[v].total_cycles = 0;
+        irq_desc[v].max_cycles = 0;
+        for (int b = 0; b < IRQ_HIST_BUCKETS; b++) {
+            irq_desc[v].hist[b] = 0;
+        }
+    }
+    
+    local_irq_restore(flags);
+}
@@ -0,0 +1,90 @@
+#ifndef IRQ_H
+#define IRQ_H
+
+#include <stdint.h>
+#include "kernel/idt.h"
+
+// Legacy PIC lines are remapped to vectors 32-47
+#define IRQ_VECTOR_BASE     32
+#define IRQ_TO_VECTOR(irq)  (IRQ_VECTOR_BASE + (irq))
+#define NR_VECTORS          256
+
+// Vectors handed out to IOAPIC pins and MSIs (0xF0 and up are reserved
+// for LAPIC-local interrupts)
+#define IRQ_DYNAMIC_BASE    48
+#define IRQ_DYNAMIC_END     0xEF
+
+// Handler return values (shared lines call every handler)
+#define IRQ_NONE            0
+#define IRQ_HANDLED         1
+
+// Handler duration histogram: bucket n counts durations in [2^(n-1), 2^n) cycles
+#define IRQ_HIST_BUCKETS    24
+
+#define MAX_IRQ_ACTIONS     32
+
+typedef int (*irq_handler_t)(void* ctx);
+
+// Interrupt controller operations for a vector
+typedef struct irq_chip {
+    const char* name;
+    void (*eoi)(uint8_t vector);
+    void (*mask)(uint8_t vector);
+    void (*unmask)(uint8_t vector);
+    int (*is_spurious)(uint8_t vector);   // Optional
+} irq_chip_t;
+
+// One registered handler; shared vectors chain several
+typedef struct irq_action {
+    irq_handler_t handler;
+    void* ctx;
+    struct irq_action* next;
+} irq_action_t;
+
+// Per-vector state and statistics
+typedef struct {
+    const char* name;
+    irq_chip_t* chip;
+    irq_action_t* actions;
+    uint64_t count;
+    uint64_t unhandled;       // No handler claimed it
+    uint64_t spurious;        // Dropped without EOI by the chip
+    uint64_t total_cycles;
+    uint64_t max_cycles;
+    uint32_t hist[IRQ_HIST_BUCKETS];
+} irq_desc_t;
+
+// Set up descriptors; legacy vectors default to the PIC
+void irq_init(void);
+
+// Reserve an unused dynamic vector. Returns -1 when none are left.
+int irq_alloc_vector(void);
+void irq_free_vector(uint8_t vector);
+
+// Attach a handler to a vector. Returns 0 on success, -1 if full.
+int request_irq(uint8_t vector, irq_handler_t handler, void* ctx);
+
+// Detach a handler previously attached with the same ctx
+void free_irq(uint8_t vector, irq_handler_t handler, void* ctx);
+
+// Label a vector for irqstat
+void irq_set_name(uint8_t vector, const char* name);
+
+// Change which controller acknowledges a vector
+void irq_set_chip(uint8_t vector, irq_chip_t* chip);
+
+irq_desc_t* irq_get_desc(uint8_t vector);
+
+// Register frame of the interrupt being handled (NULL outside IRQs)
+interrupt_frame_t* irq_get_regs(void);
+
+// Run handlers for the vector in frame, then EOI. Called from irq_handler.
+void irq_dispatch(interrupt_frame_t* frame);
+
+// Upper bound (cycles) of the histogram bucket holding the given percentile
+uint64_t irq_hist_percentile(irq_desc_t* desc, int percent);
+
+// Clear counters and histograms
+void irq_reset_stats(void);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef IRQFLAGS_H
+#define IRQFLAGS_H
+
+#include <stdint.h>
+
+#define RFLAGS_IF 0x200
+
+// Save RFLAGS and disable interrupts
+static inline uint64_t local_irq_save(void) {
+    uint64_t flags;
+    asm volatile("pushfq; pop %0; cli" : "=r"(flags) : : "memory");
+    return flags;
+}
+
+// Re-enable interrupts only if they were enabled when saved
+static inline void local_irq_restore(uint64_t flags) {
+    if (flags & RFLAGS_IF) asm volatile("sti" : : : "memory");
+}
+
+static inline void local_irq_enable(void) {
+    asm volatile("sti" : : : "memory");
+}
+
+static inline void local_irq_disable(void) {
+    asm volatile("cli" : : : "memory");
+}
+
+static inline int irqs_disabled(void) {
+    uint64_t flags;
+    asm volatile("pushfq; pop %0" : "=r"(flags));
+    return !(flags & RFLAGS_IF);
+}
+
+#endif
@@ -0,0 +1,56 @@
+#include "jump_label.h"
+#include "kernel/irqflags.h"
+
+// Bounds of the __jump_table section (linker.ld)
+extern jump_entry_t __start___jump_table[];
+extern jump_entry_t __stop___jump_table[];
+
+static const uint8_t nop5[5] = { 0x0F, 0x1F, 0x44, 0x00, 0x00 };
+
+static void jump_label_patch(jump_entry_t* entry, int enable) {
+    volatile uint8_t* code = (volatile uint8_t*)(uintptr_t)entry->code;
+    
+    if (enable) {
+        int32_t rel = (int32_t)(entry->target - (entry->code + 5));
+        code[0] = 0xE9;     // jmp rel32
+        code[1] = rel & 0xFF;
+        code[2] = (rel >> 8) & 0xFF;
+        code[3] = (rel >> 16) & 0xFF;
+        code[4] = (rel >> 24) & 0xFF;
+    } else {
+        for (int i = 0; i < 5; i++) {
+            code[i] = nop5[i];
+        }
+    }
+}
+
+static void static_key_update(static_key_t* key, int enable) {
+    if (key->enabled == enable) return;
+    
+    uint64_t flags = local_irq_save();
+    
+    for (jump_entry_t* entry = __start___jump_table; entry < __stop___jump_table; entry++) {
+        if (entry->key == key) {
+            jump_label_patch(entry, enable);
+        }
+    }
+    key->enabled = enable;
+    
+    // A serializing instruction so the patched bytes are what gets fetched
+    uint32_t eax = 0, ebx, ecx = 0, edx;
+    asm volatile("cpuid" : "+a"(eax), "=b"(ebx), "+c"(ecx), "=d"(edx) : : "memory");
+    
+    local_irq_restore(flags);
+}
+
+void static_key_enable(static_key_t* key) {
+    static_key_update(key, 1);
+}
+
+void static_key_disable(static_key_t* key) {
+    static_key_update(key, 0);
+}
+
+int jump_label_count(void) {
+    return __stop___jump_table - __start___jump_table;
+}
@@ -0,0 +1,52 @@
+#ifndef JUMP_LABEL_H
+#define JUMP_LABEL_H
+
+#include <stdint.h>
+
+// Static keys: a branch that costs one 5-byte NOP while the key is off.
+// Turning the key on patches every site into a jmp to the "taken" path.
+typedef struct {
+    volatile int enabled;
+} static_key_t;
+
+#define STATIC_KEY_INIT_FALSE { 0 }
+
+// One patch site, emitted into the __jump_table section
+typedef struct {
+    uint64_t code;              // Address of the NOP
+    uint64_t target;            // Where the jmp goes when enabled
+    static_key_t* key;
+} jump_entry_t;
+
+// True when the key is enabled. `key` must name a global static_key_t
+// (or an object that starts with one): the large code model rules out
+// passing its address as an asm immediate, so the symbol is emitted by name.
+#define static_branch_unlikely(key) ({                                  \
+    __label__ l_yes, l_done;                                            \
+    int __taken = 0;                                                    \
+    asm goto("1: .byte 0x0f, 0x1f, 0x44, 0x00, 0x00\n\t"                \
+             ".pushsection __jump_table, \"aw\"\n\t"                    \
+             ".balign 8\n\t"                                            \
+             ".quad 1b, %l[l_yes], " #key "\n\t"                        \
+             ".popsection"                                              \
+             : : : : l_yes);                                            \
+    goto l_done;                                                        \
+l_yes:                                                                  \
+    __taken = 1;                                                        \
+l_done:                                                                 \
+    __taken;                                                            \
+})
+
+// Patch all sites of a key. Only the BSP runs, so rewriting with
+// interrupts off is enough; SMP will need a breakpoint-based text poke.
+void static_key_enable(static_key_t* key);
+void static_key_disable(static_key_t* key);
+
+static inline int static_key_enabled(static_key_t* key) {
+    return key->enabled;
+}
+
+// Number of patch sites linked into the kernel
+int jump_label_count(void);
+
+#endif
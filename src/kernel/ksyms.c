@@ -0,0 +1,26 @@
+#include "ksyms.h"
+#include <stddef.h>
+
+int ksym_index(uint64_t addr) {
+    if (ksyms_count == 0 || addr < ksyms_table[0].addr) return -1;
+    
+    // Last symbol whose start is <= addr
+    uint32_t lo = 0, hi = ksyms_count;
+    while (hi - lo > 1) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (ksyms_table[mid].addr <= addr) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+const char* ksym_lookup(uint64_t addr, uint64_t* offset) {
+    int index = ksym_index(addr);
+    if (index < 0) return NULL;
+    
+    if (offset) *offset = addr - ksyms_table[index].addr;
+    return ksyms_table[index].name;
+}
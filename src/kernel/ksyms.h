@@ -0,0 +1,23 @@
+#ifndef KSYMS_H
+#define KSYMS_H
+
+#include <stdint.h>
+
+// Kernel symbol, as embedded at link time by scripts/gen_ksyms.sh
+typedef struct {
+    uint64_t addr;
+    const char* name;
+} ksym_t;
+
+// Sorted by address
+extern const ksym_t ksyms_table[];
+extern const uint32_t ksyms_count;
+
+// Name of the function containing addr (NULL if outside the table).
+// If offset is non-NULL it receives addr minus the symbol start.
+const char* ksym_lookup(uint64_t addr, uint64_t* offset);
+
+// Index of that symbol in ksyms_table, or -1
+int ksym_index(uint64_t addr);
+
+#endif
@@ -0,0 +1,128 @@
+#include "lapic.h"
+#include <stddef.h>
+#include "kernel/cpuid.h"
+#include "kernel/msr.h"
+#include "kernel/clocksource.h"
+#include "mm/vmm.h"
+
+#define APIC_BASE_ENABLE    (1 << 11)
+#define APIC_BASE_ADDR_MASK 0xFFFFFF000ULL
+
+// Calibration window for the local timer
+#define LAPIC_CALIBRATE_NS 10000000ULL
+
+static volatile uint8_t* lapic_base = NULL;
+static uint64_t lapic_timer_hz = 0;
+
+uint32_t lapic_read(uint32_t reg) {
+    return *(volatile uint32_t*)(lapic_base + reg);
+}
+
+void lapic_write(uint32_t reg, uint32_t value) {
+    *(volatile uint32_t*)(lapic_base + reg) = value;
+}
+
+int lapic_available(void) {
+    return lapic_base != NULL;
+}
+
+uint8_t lapic_id(void) {
+    if (!lapic_base) return 0;
+    return lapic_read(LAPIC_REG_ID) >> 24;
+}
+
+void lapic_eoi(void) {
+    lapic_write(LAPIC_REG_EOI, 0);
+}
+
+static void lapic_chip_eoi(uint8_t vector) {
+    (void)vector;
+    lapic_eoi();
+}
+
+static int lapic_is_spurious(uint8_t vector) {
+    return vector == LAPIC_SPURIOUS_VECTOR;
+}
+
+irq_chip_t lapic_chip = {
+    .name = "LAPIC",
+    .eoi = lapic_chip_eoi,
+    .mask = NULL,
+    .unmask = NULL,
+    .is_spurious = lapic_is_spurious,
+};
+
+int lapic_init(void) {
+    if (!(cpu_info.features_edx & CPUID_FEAT_APIC)) return 0;
+    
+    uint64_t base = rdmsr(MSR_IA32_APIC_BASE);
+    wrmsr(MSR_IA32_APIC_BASE, base | APIC_BASE_ENABLE);
+    
+    lapic_base = (volatile uint8_t*)vmm_map_mmio(base & APIC_BASE_ADDR_MASK, 4096);
+    if (!lapic_base) return 0;
+    
+    // Accept every priority, software-enable with our spurious vector
+    lapic_write(LAPIC_REG_TPR, 0);
+    lapic_write(LAPIC_REG_SVR, LAPIC_SVR_ENABLE | LAPIC_SPURIOUS_VECTOR);
+    
+    // LINT0 carries the 8259 in virtual-wire mode; the IOAPIC replaces it
+    lapic_write(LAPIC_REG_LVT_LINT0, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_REG_LVT_ERROR, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_LVT_MASKED);
+    
+    // Clear errors latched before we took over (write, then read)
+    lapic_write(LAPIC_REG_ESR, 0);
+    lapic_read(LAPIC_REG_ESR);
+    lapic_eoi();
+    
+    irq_set_chip(LAPIC_SPURIOUS_VECTOR, &lapic_chip);
+    irq_set_name(LAPIC_SPURIOUS_VECTOR, "spurious");
+    
+    return 1;
+}
+
+// Count timer ticks (after the divide-by-16) across a fixed clocksource window
+static void lapic_timer_calibrate(void) {
+    lapic_write(LAPIC_REG_TIMER_DIV, LAPIC_TIMER_DIV_16);
+    lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_REG_TIMER_INIT, 0xFFFFFFFF);
+    
+    uint64_t start = clocksource_read_ns();
+    while (clocksource_read_ns() - start < LAPIC_CALIBRATE_NS) {
+        asm volatile("pause");
+    }
+    
+    uint32_t elapsed = 0xFFFFFFFF - lapic_read(LAPIC_REG_TIMER_CURRENT);
+    lapic_write(LAPIC_REG_TIMER_INIT, 0);
+    
+    lapic_timer_hz = (uint64_t)elapsed * (1000000000ULL / LAPIC_CALIBRATE_NS);
+}
+
+int lapic_timer_start(uint32_t hz) {
+    if (!lapic_base || hz == 0) return -1;
+    
+    if (lapic_timer_hz == 0) {
+        lapic_timer_calibrate();
+        if (lapic_timer_hz == 0) return -1;
+    }
+    
+    uint64_t count = lapic_timer_hz / hz;
+    if (count == 0) count = 1;
+    if (count > 0xFFFFFFFF) count = 0xFFFFFFFF;
+    
+    lapic_write(LAPIC_REG_TIMER_DIV, LAPIC_TIMER_DIV_16);
+    lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_TIMER_PERIODIC | LAPIC_TIMER_VECTOR);
+    lapic_write(LAPIC_REG_TIMER_INIT, (uint32_t)count);
+    return 0;
+}
+
+void lapic_timer_stop(void) {
+    if (!lapic_base) return;
+    
+    lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_REG_TIMER_INIT, 0);
+}
+
+uint64_t lapic_timer_frequency(void) {
+    return lapic_timer_hz;
+}
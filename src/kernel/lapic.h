@@ -0,0 +1,60 @@
+#ifndef LAPIC_H
+#define LAPIC_H
+
+#include <stdint.h>
+#include "kernel/irq.h"
+
+// Local APIC register offsets
+#define LAPIC_REG_ID            0x020
+#define LAPIC_REG_VERSION       0x030
+#define LAPIC_REG_TPR           0x080
+#define LAPIC_REG_EOI           0x0B0
+#define LAPIC_REG_SVR           0x0F0
+#define LAPIC_REG_ESR           0x280
+#define LAPIC_REG_LVT_TIMER     0x320
+#define LAPIC_REG_LVT_LINT0     0x350
+#define LAPIC_REG_LVT_LINT1     0x360
+#define LAPIC_REG_LVT_ERROR     0x370
+#define LAPIC_REG_TIMER_INIT    0x380
+#define LAPIC_REG_TIMER_CURRENT 0x390
+#define LAPIC_REG_TIMER_DIV     0x3E0
+
+#define LAPIC_SVR_ENABLE        (1 << 8)
+#define LAPIC_LVT_MASKED        (1 << 16)
+#define LAPIC_TIMER_PERIODIC    (1 << 17)
+#define LAPIC_TIMER_DIV_16      0x3
+
+// Local timer vector (0xF0 and up are kept out of irq_alloc_vector)
+#define LAPIC_TIMER_VECTOR      0xF0
+
+// Vector delivered when an interrupt is withdrawn before acceptance (no EOI)
+#define LAPIC_SPURIOUS_VECTOR   0xFF
+
+// MSI messages are writes into this window, aimed at one LAPIC
+#define LAPIC_MSI_ADDRESS       0xFEE00000
+
+// Enable this CPU's local APIC. Returns 1 on success, 0 without an APIC.
+int lapic_init(void);
+int lapic_available(void);
+
+uint32_t lapic_read(uint32_t reg);
+void lapic_write(uint32_t reg, uint32_t value);
+
+// APIC ID of the running CPU (the destination for steering interrupts)
+uint8_t lapic_id(void);
+
+void lapic_eoi(void);
+
+// Periodic local timer interrupts on LAPIC_TIMER_VECTOR at roughly hz.
+// Calibrated against the current clocksource on first use.
+// Returns 0 on success, -1 without a LAPIC.
+int lapic_timer_start(uint32_t hz);
+void lapic_timer_stop(void);
+
+// Calibrated timer input frequency (0 until lapic_timer_start has run)
+uint64_t lapic_timer_frequency(void);
+
+// Chip for vectors delivered straight to the LAPIC (MSI, local timer)
+extern irq_chip_t lapic_chip;
+
+#endif
@@ -0,0 +1,120 @@
+#include "lock_bench.h"
+#include "kernel/spinlock.h"
+#include "kernel/seqlock.h"
+#include "kernel/rcu.h"
+#include "kernel/percpu.h"
+#include "kernel/tsc.h"
+
+static spinlock_t bench_spin = SPINLOCK_INIT;
+static mcs_lock_t bench_mcs = MCS_LOCK_INIT;
+static rwlock_t bench_rw = RWLOCK_INIT;
+static seqlock_t bench_seq = SEQLOCK_INIT;
+static volatile uint64_t bench_data = 0;
+
+enum {
+    BENCH_IRQ_SAVE,
+    BENCH_TICKET,
+    BENCH_TICKET_IRQSAVE,
+    BENCH_MCS,
+    BENCH_READ_LOCK,
+    BENCH_WRITE_LOCK,
+    BENCH_SEQ_READ,
+    BENCH_SEQ_WRITE,
+    BENCH_RCU_READ,
+    BENCH_COUNT
+};
+
+static const char* bench_names[BENCH_COUNT] = {
+    "irq save/restore",
+    "ticket spinlock",
+    "ticket irqsave",
+    "MCS lock",
+    "rwlock read",
+    "rwlock write",
+    "seqlock read",
+    "seqlock write",
+    "RCU read",
+};
+
+static void bench_op(int which) {
+    switch (which) {
+        case BENCH_IRQ_SAVE: {
+            uint64_t flags = local_irq_save();
+            bench_data++;
+            local_irq_restore(flags);
+            break;
+        }
+        case BENCH_TICKET:
+            spin_lock(&bench_spin);
+            bench_data++;
+            spin_unlock(&bench_spin);
+            break;
+        case BENCH_TICKET_IRQSAVE: {
+            uint64_t flags = spin_lock_irqsave(&bench_spin);
+            bench_data++;
+            spin_unlock_irqrestore(&bench_spin, flags);
+            break;
+        }
+        case BENCH_MCS: {
+            mcs_node_t node;
+            mcs_lock(&bench_mcs, &node);
+            bench_data++;
+            mcs_unlock(&bench_mcs, &node);
+            break;
+        }
+        case BENCH_READ_LOCK:
+            read_lock(&bench_rw);
+            (void)bench_data;
+            read_unlock(&bench_rw);
+            break;
+        case BENCH_WRITE_LOCK:
+            write_lock(&bench_rw);
+            bench_data++;
+            write_unlock(&bench_rw);
+            break;
+        case BENCH_SEQ_READ: {
+            uint32_t seq;
+            do {
+                seq = read_seqbegin(&bench_seq);
+                (void)bench_data;
+            } while (read_seqretry(&bench_seq, seq));
+            break;
+        }
+        case BENCH_SEQ_WRITE:
+            write_seqlock(&bench_seq);
+            bench_data++;
+            write_sequnlock(&bench_seq);
+            break;
+        case BENCH_RCU_READ:
+            rcu_read_lock();
+            (void)bench_data;
+            rcu_read_unlock();
+            break;
+    }
+}
+
+int lock_bench_run(uint32_t iterations, lock_bench_result_t* results) {
+    if (iterations == 0) return 0;
+    
+    for (int which = 0; which < BENCH_COUNT; which++) {
+        // Warm up the lock's cache line
+        for (int i = 0; i < 16; i++) {
+            bench_op(which);
+        }
+        
+        uint64_t start = rdtsc();
+        for (uint32_t i = 0; i < iterations; i++) {
+            bench_op(which);
+        }
+        uint64_t end = rdtsc();
+        
+        results[which].name = bench_names[which];
+        results[which].cycles = (end - start) / iterations;
+    }
+    
+    return BENCH_COUNT;
+}
+
+int lock_bench_cpus(void) {
+    return NR_CPUS;
+}
@@ -0,0 +1,21 @@
+#ifndef LOCK_BENCH_H
+#define LOCK_BENCH_H
+
+#include <stdint.h>
+
+#define LOCK_BENCH_MAX 10
+
+typedef struct {
+    const char* name;
+    uint64_t cycles;          // Average TSC cycles per acquire + release
+} lock_bench_result_t;
+
+// Time every locking primitive over the given iterations.
+// Returns the number of results written (at most LOCK_BENCH_MAX).
+int lock_bench_run(uint32_t iterations, lock_bench_result_t* results);
+
+// CPUs taking part in the measurement. With only the BSP running this is
+// the uncontended cost; handoff cost needs more than one CPU hammering.
+int lock_bench_cpus(void);
+
+#endif
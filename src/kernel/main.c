@@ -10,6 +10,7 @@
 #include "drivers/bus/usb.h"
 #include "drivers/input/mouse.h"
 #include "drivers/input/keyboard.h"
+#include "drivers/char/serial.h"
 // Memory management
 #include "mm/pmm.h"
 #include "mm/vmm.h"
@@ -17,58 +18,132 @@
 // Library
 #include "lib/io.h"
 #include "lib/string.h"
+#include "lib/mem.h"
 // Kernel
 #include "kernel/gdt.h"
 #include "kernel/idt.h"
 #include "kernel/timer.h"
-#include "kernel/sysinfo.h"
 #include "kernel/cmd.h"
+#include "kernel/acpi.h"
+#include "kernel/hpet.h"
+#include "kernel/tsc.h"
+#include "kernel/timer_wheel.h"
+#include "kernel/irq.h"
+#include "kernel/softirq.h"
+#include "kernel/workqueue.h"
+#include "kernel/rcu.h"
+#include "kernel/trace.h"
+#include "kernel/debug.h"
+#include "kernel/printk.h"
+#include "kernel/irqflags.h"
+#include "kernel/pic.h"
+#include "kernel/lapic.h"
+#include "kernel/ioapic.h"
+#include "kernel/cmdline.h"
+#include "kernel/perftest.h"
+#include "kernel/fpu.h"
+#include "kernel/cpuid.h"
+#include "kernel/input_latency.h"
+#include "kernel/initcall.h"
 // GUI
 #include "gui/terminal.h"
 #include "gui/window_manager.h"
 #include "gui/desktop.h"
 #include "gui/taskbar.h"
 #include "gui/cursor.h"
+#include "gui/compositor.h"
 
-extern char terminal_buffer[];
-extern int term_idx;
 extern int mouse_x, mouse_y;
-extern void init_mouse();
 
-// --- MAIN KERNEL ---
-void kmain(void* multiboot_info_addr) {
-    multiboot_info_t* mbi = (multiboot_info_t*)multiboot_info_addr;
+// Frame timeline (trace on / trace dump); the render stages are traced
+// in gui/compositor.c
+DEFINE_TRACEPOINT(frame);
+
+// Whole-frame zone (profile command)
+DEFINE_PROFILE_ZONE(zone_frame, "frame");
+
+// "headless" or "headless=WxH" on the command line renders into memory
+// instead of the multiboot framebuffer (frame checksums and timings for
+// the perf harness at any resolution up to 4K)
+static void graphics_setup(multiboot_info_t* mbi) {
+    char mode[16];
+    int width = HEADLESS_DEFAULT_WIDTH;
+    int height = HEADLESS_DEFAULT_HEIGHT;
     
-    // EMERGENCY FALLBACK: Use VGA text mode to show we're alive
-    // This always works, even if graphics fail
-    vga_clear();
-    vga_print("CimpleOS Booting...\n");
-    vga_print("Initializing GDT...\n");
+    if (!cmdline_has("headless")) {
+        graphics_init(mbi);  // Sets up video_memory, screen size, and back_buffer
+        return;
+    }
+    
+    if (cmdline_value("headless", mode, sizeof(mode))) {
+        int i = 0;
+        width = 0;
+        height = 0;
+        while (mode[i] >= '0' && mode[i] <= '9') width = width * 10 + (mode[i++] - '0');
+        if (mode[i] == 'x') i++;
+        while (mode[i] >= '0' && mode[i] <= '9') height = height * 10 + (mode[i++] - '0');
+    }
     
-    // Capture Multiboot Info BEFORE enabling paging!
-    // (mb pointer might become invalid if it's outside identity mapped region)
-    uint32_t mb_flags = mbi->flags;
-    uint64_t mb_fb_addr = mbi->framebuffer_addr;
-    uint32_t mb_fb_width = mbi->framebuffer_width;
-    uint32_t mb_fb_height = mbi->framebuffer_height;
-
-    // 1. Setup GDT
+    if (graphics_init_headless(width, height) != 0) {
+        pr_err("graphics", "no room for a %dx%d headless surface, using the framebuffer", width, height);
+        graphics_init(mbi);
+    }
+}
+
+// --- BOOT STAGES ---
+// Each stage names the ones it needs; initcall_run_boot works out the
+// order. Deferred stages run from the frame loop once the GUI is up.
+static multiboot_info_t* boot_mbi;
+
+static int stage_gdt(void) {
+    vga_print("Initializing GDT...\n");
     gdt_install();
+    return 0;
+}
+DEFINE_INITCALL(initcall_gdt, "gdt", stage_gdt, "", 0);
 
-    // 2. Setup Memory Management
-    // We need to initialize PMM first to know what's free.
-    pmm_init(mbi);
-    
-    // FIXED VMM: Now uses pre-allocated page tables and maps high memory!
-    // This identity maps the first 256MB + framebuffer region
-    // No dynamic allocation after paging is enabled = no crashes!
+// CR0/CR4 and XCR0 for kernel SIMD sections (boot.asm leaves SSE off),
+// then pick memcpy/memset variants for this CPU
+static int stage_cpu(void) {
+    cpuid_init();
+    fpu_init();
+    mem_dispatch_init();
+    string_dispatch_init();
+    return 0;
+}
+DEFINE_INITCALL(initcall_cpu, "cpu", stage_cpu, "gdt", 0);
+
+// mem_upper counts the KB of contiguous memory above 1MB
+static int stage_pmm(void) {
+    uint64_t mem_size = 0;
+    if (boot_mbi->flags & MULTIBOOT_INFO_MEMORY) {
+        mem_size = ((uint64_t)boot_mbi->mem_upper + 1024) * 1024;
+    }
+    pmm_init(mem_size);
+    return mem_size ? 0 : -1;
+}
+DEFINE_INITCALL(initcall_pmm, "pmm", stage_pmm, "", 0);
+
+// Identity maps the first 256MB + framebuffer region from pre-allocated
+// page tables
+static int stage_vmm(void) {
     vga_print("Enabling paging...\n");
     vmm_init();
     vga_print("Paging enabled!\n");
+    return 0;
+}
+DEFINE_INITCALL(initcall_vmm, "vmm", stage_vmm, "pmm", 0);
 
-    // 3. Setup Graphics
+static int stage_heap(void) {
+    heap_init();
+    return 0;
+}
+DEFINE_INITCALL(initcall_heap, "heap", stage_heap, "vmm", 0);
+
+// The back buffer comes from the heap
+static int stage_graphics(void) {
     vga_print("Initializing Graphics...\n");
-    graphics_init(mb);  // THIS WAS MISSING! Sets up video_memory, screen size, and back_buffer
+    graphics_setup(boot_mbi);
     
     clear_screen(0x000000); // Black background
     
@@ -76,48 +151,139 @@ void kmain(void* multiboot_info_addr) {
     draw_string(10, 10, 0x00FF00, "CimpleOS v0.4 - Protected Mode + Paging Enabled!");
     draw_string(10, 30, 0xFFFFFF, "Memory Management: PMM + VMM Active");
     draw_string(10, 50, 0xFFFFFF, "Graphics: Initialized");
+    return 0;
+}
+DEFINE_INITCALL(initcall_graphics, "graphics", stage_graphics, "heap cpu", 0);
 
-    // 4. Initialize Interrupts
+static int stage_irq(void) {
     vga_print("Initializing Interrupts...\n");
+    irq_init();
+    softirq_init();
+    rcu_init();
     init_idt();
-    init_mouse();
-    
-    // 5. Initialize Timer (100 Hz)
-    timer_init(100);
+    return 0;
+}
+DEFINE_INITCALL(initcall_irq, "irq", stage_irq, "gdt heap", 0);
+
+static int stage_keyboard(void) {
+    keyboard_init();
+    return 0;
+}
+DEFINE_INITCALL(initcall_keyboard, "keyboard", stage_keyboard, "irq", 0);
+
+// After the TSC so the PS/2 timeouts are calibrated
+static int stage_mouse(void) {
+    return init_mouse();
+}
+DEFINE_INITCALL(initcall_mouse, "mouse", stage_mouse, "irq tsc", 0);
+
+// Serial console for headless logs and profiler dumps (IRQ4 drives TX/RX)
+static int stage_serial(void) {
+    if (serial_init()) {
+        pr_info("serial", "COM1 at %u baud", SERIAL_BAUD);
+    }
+    pr_info("boot", "command line: %s", cmdline_get());
+    pr_info("fpu", "%s, %u byte state%s", fpu_save_name(), fpu_state_size(),
+            fpu_has_avx() ? ", AVX" : "");
+    pr_info("mem", "memcpy %s, from %u bytes %s; strings %s", mem_dispatch_copy(MEM_REP_THRESHOLD)->name,
+            MEM_NT_THRESHOLD, mem_dispatch_copy(MEM_NT_THRESHOLD)->name, string_dispatch_name());
+    return 0;
+}
+DEFINE_INITCALL(initcall_serial, "serial", stage_serial, "irq cpu", 0);
+
+// PIT at TIMER_HZ and the timer wheel it drives
+static int stage_timer(void) {
+    timer_init(TIMER_HZ);
+    timer_wheel_init();
+    return 0;
+}
+DEFINE_INITCALL(initcall_timer, "timer", stage_timer, "irq", 0);
+
+static int stage_acpi(void) {
+    if (!acpi_init() || !hpet_init()) return 0;
     
-    // 6. Initialize Heap
-    heap_init();
+    vga_print("HPET enabled\n");
+    pr_info("hpet", "%u Hz main counter", (unsigned int)hpet_frequency());
+    return 0;
+}
+DEFINE_INITCALL(initcall_acpi, "acpi", stage_acpi, "heap timer", 0);
+
+// Calibrated against the HPET when there is one
+static int stage_tsc(void) {
+    tsc_init();
+    pr_info("tsc", "%u kHz%s", (unsigned int)tsc_khz, tsc_is_stable() ? ", invariant" : "");
+    return 0;
+}
+DEFINE_INITCALL(initcall_tsc, "tsc", stage_tsc, "acpi cpu", 0);
+
+// PCI: enumerate once (ECAM from the MCFG when present); drivers then
+// look their devices up in the table
+static int stage_pci(void) {
+    pci_init();
+    pr_info("pci", "%d functions via %s in %llu us", pci_device_count(), pci_config_method(),
+            (unsigned long long)(tsc_cycles_to_ns(pci_scan_cycles()) / 1000));
+    return 0;
+}
+DEFINE_INITCALL(initcall_pci, "pci", stage_pci, "acpi tsc", 0);
+
+// Hand the ISA lines to the IOAPIC, then mask the PIC (once the legacy
+// handlers are in)
+static int stage_irq_routing(void) {
+    if (!ioapic_init() || !lapic_init()) {
+        pr_warn("irq", "No IOAPIC, staying on the 8259 PIC");
+        return 0;
+    }
     
-    // 7. Initialize System Info
-    sysinfo_init();
+    uint64_t flags = local_irq_save();
+    ioapic_route_legacy();
+    pic_disable();
+    local_irq_restore(flags);
     
-    asm volatile("sti"); 
+    hpet_event_request_irq();
+    vga_print("IOAPIC enabled\n");
+    pr_info("irq", "ISA interrupts routed through the IOAPIC");
+    return 0;
+}
+DEFINE_INITCALL(initcall_irq_routing, "irq_routing", stage_irq_routing, "acpi tsc keyboard mouse serial timer", 0);
+
+// Interrupts go on once, with every boot-time handler installed
+static int stage_sti(void) {
+    local_irq_enable();
     vga_print("Interrupts Enabled!\n");
-    
-    // asm volatile("sti"); // Interrupts enabled later after full hardware setup
-    // vga_print("Interrupts Enabled!\n");
-    
-    // 7. Initialize USB (if available)
-    vga_print("Checking for USB...\n");
-    usb_init();
-    
+    return 0;
+}
+DEFINE_INITCALL(initcall_sti, "sti", stage_sti, "irq_routing", 0);
+
+static int stage_gui(void) {
     vga_print("System ready! Starting GUI...\n");
-    
-    // Initialize hardware
-    gdt_install();
-    init_idt();  // Now 64-bit compatible
-    timer_init(100);
     desktop_init();
     taskbar_init();
     cursor_init();
-    
-    // Enable interrupts after all critical hardware is set up
-    asm volatile("sti");
-    vga_print("Interrupts Enabled!\n");
-
-    // Initialize GUI subsystems
     terminal_init();
     wm_init();
+    return 0;
+}
+DEFINE_INITCALL(initcall_gui, "gui", stage_gui, "graphics", 0);
+
+// Controller resets and port debounce take tens of milliseconds; the
+// desktop doesn't wait for them
+static int stage_usb(void) {
+    usb_init();
+    return 0;
+}
+DEFINE_INITCALL(initcall_usb, "usb", stage_usb, "pci sti", INITCALL_DEFERRED);
+
+// --- MAIN KERNEL ---
+void kmain(void* multiboot_info_addr) {
+    boot_mbi = (multiboot_info_t*)multiboot_info_addr;
+    
+    // EMERGENCY FALLBACK: Use VGA text mode to show we're alive
+    // This always works, even if graphics fail
+    vga_clear();
+    vga_print("CimpleOS Booting...\n");
+    cmdline_init(boot_mbi);
+    
+    initcall_run_boot();
     
     // Create terminal window
     window_t* term_win = wm_create_window(50, 80, 700, 480, "Terminal");
@@ -149,90 +315,77 @@ void kmain(void* multiboot_info_addr) {
         }
     }
     
+    // Scripted benchmark boot (make perf-test): runs the workloads, then
+    // exits QEMU
+    if (perftest_requested()) {
+        perftest_run();
+    }
+    
     // Mouse state for click detection
     int last_mouse_btn = 0;  // Moved outside loop for clarity
-
+    
+    // Latency figures start with the interactive desktop, not at boot
+    input_latency_reset();
+    
+    uint32_t frame_no = 0;
     while (1) {
+        trace_begin(frame, frame_no);
+        profile_zone_enter(&zone_frame);
+        
+        // Act as the worker for deferred work queued by interrupt handlers
+        workqueue_run(&system_wq);
+        
+        // Input applied so far is what this frame shows
+        input_latency_frame_begin();
+        
         // Handle mouse interactions
+        int mx, my;
+        mouse_get_position(&mx, &my);
+        
         int mouse_btn = mouse_button_left();
         
         // Mouse button pressed
         if (mouse_btn && !last_mouse_btn) {
             // Check taskbar first
-            if (mouse_y >= screen_h - 30) {
-                taskbar_handle_click(mouse_x, mouse_y);
+            if (my >= screen_h - 30) {
+                taskbar_handle_click(mx, my);
             } else {
-                wm_handle_mouse_down(mouse_x, mouse_y);
+                wm_handle_mouse_down(mx, my);
             }
         }
         
         // Mouse button released
         if (!mouse_btn && last_mouse_btn) {
-            wm_handle_mouse_up(mouse_x, mouse_y);
+            wm_handle_mouse_up(mx, my);
         }
         
         // Mouse dragging
         if (mouse_btn) {
-            wm_handle_mouse_move(mouse_x, mouse_y);
+            wm_handle_mouse_move(mx, my);
         }
         
         last_mouse_btn = mouse_btn;
         
+        // Wheel steps collected since the last frame
+        int wheel = mouse_wheel_take();
+        if (wheel) {
+            wm_handle_mouse_wheel(mx, my, wheel);
+        }
+        
         // Update cursor position
-        cursor_set_position(mouse_x, mouse_y);
+        cursor_set_position(mx, my);
         
         // === RENDER EVERYTHING ===
+        compositor_render_frame();
         
-        // 1. Desktop background
-        desktop_render_background();
-        desktop_render_topbar();
-        
-        // 2. FEATURE 1: Render ALL terminal windows (not just first one!)
-        window_manager_t* wm_state = wm_get_state();
-        for (int i = 0; i < MAX_WINDOWS; i++) {
-            window_t* win = &wm_state->windows[i];
-            
-            // Skip invalid or minimized windows
-            if (win->id == -1) continue;
-            if (!(win->flags & WIN_FLAG_VISIBLE)) continue;
-            if (win->flags & WIN_FLAG_MINIMIZED) continue;
-            
-            // Check if this window has a terminal instance
-            terminal_instance_t* term = (terminal_instance_t*)win->user_data;
-            if (!term) continue;  // Not a terminal window
-            
-            // Render this terminal's content
-            int win_content_x = win->x;
-            int win_content_y = win->y + TITLEBAR_HEIGHT;
-            int win_content_h = win->height;
-            
-            // Terminal output area
-            terminal_instance_render(term, win_content_x + 10, win_content_y + 10);
-            
-            // Input line at bottom of window (only for focused terminal)
-            if (win->id == wm_state->focused_window_id) {
-                int input_y = win_content_y + win_content_h - 25;
-                draw_string(win_content_x + 10, input_y, 0x00FF00, "$ ");
-                draw_string(win_content_x + 30, input_y, 0xFFFFFF, terminal_buffer);
-                
-                // Cursor blink
-                extern volatile int irq_count;
-                if ((irq_count / 25) % 2 == 0) {
-                    draw_rect(win_content_x + 30 + (term_idx * 8), input_y, 8, 12, 0xFFFFFF);
-                }
-            }
+        // Frame 0 is on screen: time-to-GUI ends here, and USB and the
+        // other deferred stages start from the next iteration's workqueue run
+        if (frame_no == 0) {
+            initcall_gui_ready(graphics_first_present());
         }
         
-        // Render window frames (title bars, buttons, borders)
-        wm_render_all();
-        
-        // 3. Taskbar (always on top)
-        taskbar_render();
-        
-        // 4. Cursor (absolutely last - on top of everything)
-        cursor_render();
-        
-        // Swap buffers to display
-        swap_buffers();
+        profile_zone_exit(&zone_frame);
+        trace_end(frame, frame_no);
+        frame_no++;
     }
 }
\ No newline at end of file
@@ -52,12 +52,12 @@ void kernel_panic(const char* message, uint32_t error_code) {
     
     // Error message
     char buf[256];
-    sprintf(buf, "Fatal Error: %s", message);
+    snprintf(buf, sizeof(buf), "Fatal Error: %s", message);
     draw_string(10, 30, 0xFFFF00, buf);
     
     // Error code if present
     if (error_code != 0) {
-        sprintf(buf, "Error Code: 0x%X", error_code);
+        snprintf(buf, sizeof(buf), "Error Code: 0x%X", error_code);
         draw_string(10, 50, 0xFFAAAA, buf);
     }
     
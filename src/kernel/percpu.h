@@ -0,0 +1,19 @@
+#ifndef PERCPU_H
+#define PERCPU_H
+
+#include <stdint.h>
+
+// Only the BSP runs kernel code for now; per-CPU data is laid out as
+// arrays so bringing up APs only has to change smp_processor_id()
+#define NR_CPUS 1
+
+#define DEFINE_PER_CPU(type, name) type name[NR_CPUS]
+#define DECLARE_PER_CPU(type, name) extern type name[NR_CPUS]
+#define per_cpu(name, cpu) (name[(cpu)])
+#define this_cpu(name) (name[smp_processor_id()])
+
+static inline int smp_processor_id(void) {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,217 @@
+#include "perf.h"
+#include <stddef.h>
+#include "kernel/irq.h"
+#include "kernel/lapic.h"
+#include "kernel/ksyms.h"
+#include "kernel/percpu.h"
+#include "kernel/irqflags.h"
+#include "kernel/timer.h"
+#include "drivers/char/serial.h"
+#include "lib/printf.h"
+
+// Sampling runs from an ordinary interrupt, so code that runs with
+// interrupts disabled is attributed to wherever they get re-enabled.
+
+typedef struct {
+    perf_sample_t samples[PERF_MAX_SAMPLES];
+    volatile uint32_t count;
+    volatile uint64_t dropped;
+} perf_buffer_t;
+
+static DEFINE_PER_CPU(perf_buffer_t, perf_buffers);
+
+static volatile int perf_active = 0;
+static volatile int perf_pit_mode = 0;
+static int perf_callchain = 0;
+static int perf_irq_registered = 0;
+
+// Bounds for validating frame pointers and return addresses
+extern char _text_start[], _text_end[];
+extern char stack_bottom[], stack_top[];
+
+static int perf_is_text(uint64_t addr) {
+    return addr >= (uint64_t)(uintptr_t)_text_start && addr < (uint64_t)(uintptr_t)_text_end;
+}
+
+static int perf_is_stack(uint64_t addr) {
+    return addr >= (uint64_t)(uintptr_t)stack_bottom &&
+           addr + 16 <= (uint64_t)(uintptr_t)stack_top && (addr & 7) == 0;
+}
+
+static void perf_record(interrupt_frame_t* regs) {
+    if (!regs) return;
+    
+    perf_buffer_t* buf = &this_cpu(perf_buffers);
+    if (buf->count >= PERF_MAX_SAMPLES) {
+        buf->dropped++;
+        return;
+    }
+    
+    perf_sample_t* sample = &buf->samples[buf->count];
+    sample->rip = regs->rip;
+    sample->depth = 0;
+    
+    if (perf_callchain) {
+        // [rbp] holds the caller's rbp, [rbp + 8] the return address
+        uint64_t fp = regs->rbp;
+        while (sample->depth < PERF_MAX_STACK && perf_is_stack(fp)) {
+            uint64_t* frame = (uint64_t*)(uintptr_t)fp;
+            if (!perf_is_text(frame[1])) break;
+            
+            sample->callchain[sample->depth++] = frame[1];
+            
+            // Stacks grow down, so callers' frames must be higher
+            if (frame[0] <= fp) break;
+            fp = frame[0];
+        }
+    }
+    
+    buf->count++;
+}
+
+static int perf_lapic_handler(void* ctx) {
+    (void)ctx;
+    perf_record(irq_get_regs());
+    return IRQ_HANDLED;
+}
+
+void perf_timer_tick(void) {
+    if (perf_pit_mode) {
+        perf_record(irq_get_regs());
+    }
+}
+
+uint32_t perf_start(uint32_t hz, int callchain) {
+    perf_stop();
+    
+    for (int cpu = 0; cpu < NR_CPUS; cpu++) {
+        per_cpu(perf_buffers, cpu).count = 0;
+        per_cpu(perf_buffers, cpu).dropped = 0;
+    }
+    perf_callchain = callchain;
+    
+    if (hz == 0) hz = PERF_DEFAULT_HZ;
+    
+    if (lapic_available()) {
+        if (!perf_irq_registered) {
+            irq_set_chip(LAPIC_TIMER_VECTOR, &lapic_chip);
+            irq_set_name(LAPIC_TIMER_VECTOR, "perf");
+            request_irq(LAPIC_TIMER_VECTOR, perf_lapic_handler, NULL);
+            perf_irq_registered = 1;
+        }
+        if (lapic_timer_start(hz) == 0) {
+            perf_active = 1;
+            return hz;
+        }
+    }
+    
+    // No LAPIC timer: piggyback on the PIT tick
+    perf_pit_mode = 1;
+    perf_active = 1;
+    return TIMER_HZ;
+}
+
+void perf_stop(void) {
+    if (!perf_active) return;
+    
+    if (perf_pit_mode) {
+        perf_pit_mode = 0;
+    } else {
+        lapic_timer_stop();
+    }
+    perf_active = 0;
+}
+
+int perf_running(void) {
+    return perf_active;
+}
+
+uint64_t perf_sample_count(void) {
+    uint64_t total = 0;
+    for (int cpu = 0; cpu < NR_CPUS; cpu++) {
+        total += per_cpu(perf_buffers, cpu).count;
+    }
+    return total;
+}
+
+uint64_t perf_dropped_count(void) {
+    uint64_t total = 0;
+    for (int cpu = 0; cpu < NR_CPUS; cpu++) {
+        total += per_cpu(perf_buffers, cpu).dropped;
+    }
+    return total;
+}
+
+int perf_top(perf_top_entry_t* entries, int max) {
+    int used = 0;
+    
+    for (int cpu = 0; cpu < NR_CPUS; cpu++) {
+        perf_buffer_t* buf = &per_cpu(perf_buffers, cpu);
+        for (uint32_t i = 0; i < buf->count; i++) {
+            const char* name = ksym_lookup(buf->samples[i].rip, NULL);
+            
+            int slot = -1;
+            for (int e = 0; e < used; e++) {
+                if (entries[e].name == name) {
+                    slot = e;
+                    break;
+                }
+            }
+            if (slot < 0) {
+                if (used >= max) continue;
+                slot = used++;
+                entries[slot].name = name;
+                entries[slot].samples = 0;
+            }
+            entries[slot].samples++;
+        }
+    }
+    
+    // Insertion sort, busiest first (at most PERF_MAX_TOP entries)
+    for (int i = 1; i < used; i++) {
+        perf_top_entry_t entry = entries[i];
+        int j = i - 1;
+        while (j >= 0 && entries[j].samples < entry.samples) {
+            entries[j + 1] = entries[j];
+            j--;
+        }
+        entries[j + 1] = entry;
+    }
+    
+    return used;
+}
+
+static void perf_write_frame(uint64_t addr) {
+    const char* name = ksym_lookup(addr, NULL);
+    if (name) {
+        serial_write_blocking(name);
+        return;
+    }
+    
+    // Unknown address: raw hex so it can be resolved with addr2line
+    char hex[19];
+    snprintf(hex, sizeof(hex), "0x%016llx", (unsigned long long)addr);
+    serial_write_blocking(hex);
+}
+
+uint32_t perf_dump_serial(void) {
+    uint32_t written = 0;
+    
+    for (int cpu = 0; cpu < NR_CPUS; cpu++) {
+        perf_buffer_t* buf = &per_cpu(perf_buffers, cpu);
+        for (uint32_t i = 0; i < buf->count; i++) {
+            perf_sample_t* sample = &buf->samples[i];
+            
+            // Folded stacks list the outermost caller first
+            for (int d = sample->depth - 1; d >= 0; d--) {
+                perf_write_frame(sample->callchain[d]);
+                serial_write_blocking(";");
+            }
+            perf_write_frame(sample->rip);
+            serial_write_blocking(" 1\n");
+            written++;
+        }
+    }
+    
+    return written;
+}
@@ -0,0 +1,46 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include <stdint.h>
+
+#define PERF_MAX_SAMPLES    1024    // Per CPU
+#define PERF_MAX_STACK      6       // Return addresses kept per sample
+#define PERF_DEFAULT_HZ     997     // Prime, so sampling doesn't lock step with 100 Hz work
+#define PERF_MAX_TOP        64      // Distinct functions tracked by perf_top
+
+// One sample: where the interrupted code was, plus its callers if
+// call chains are on (walked through saved frame pointers)
+typedef struct {
+    uint64_t rip;
+    uint64_t callchain[PERF_MAX_STACK];
+    uint32_t depth;
+} perf_sample_t;
+
+typedef struct {
+    const char* name;       // NULL for addresses outside the symbol table
+    uint32_t samples;
+} perf_top_entry_t;
+
+// Start sampling at hz (LAPIC timer), or on every PIT tick when there is
+// no LAPIC. Clears previous samples. Returns the effective rate.
+uint32_t perf_start(uint32_t hz, int callchain);
+void perf_stop(void);
+int perf_running(void);
+
+// Samples held / lost to full buffers, across CPUs
+uint64_t perf_sample_count(void);
+uint64_t perf_dropped_count(void);
+
+// Fill entries with the functions holding the most samples, busiest first.
+// Returns the number of entries written.
+int perf_top(perf_top_entry_t* entries, int max);
+
+// Write every sample to the serial port as folded stacks
+// ("outer;inner;leaf 1"), ready for flamegraph.pl on the host.
+// Returns the number of samples written.
+uint32_t perf_dump_serial(void);
+
+// PIT fallback hook, called from the timer interrupt
+void perf_timer_tick(void);
+
+#endif
@@ -0,0 +1,243 @@
+#include "perftest.h"
+#include <stddef.h>
+#include "kernel/bench.h"
+#include "kernel/cmdline.h"
+#include "kernel/input_latency.h"
+#include "kernel/irqflags.h"
+#include "kernel/softirq.h"
+#include "kernel/printk.h"
+#include "mm/pmm.h"
+#include "mm/heap.h"
+#include "lib/io.h"
+#include "lib/printf.h"
+#include "drivers/char/serial.h"
+#include "drivers/input/keyboard.h"
+#include "drivers/input/mouse.h"
+#include "drivers/video/graphics.h"
+#include "gui/compositor.h"
+#include "gui/cursor.h"
+#include "gui/taskbar.h"
+#include "gui/terminal.h"
+#include "gui/window_manager.h"
+
+// Workloads allocate from the bump heap; each one rewinds it afterwards
+static void* workload_heap_mark = NULL;
+
+static void workload_heap_save(void) {
+    workload_heap_mark = heap_mark();
+}
+
+static void workload_heap_restore(void) {
+    heap_release(workload_heap_mark);
+}
+
+// Open a terminal window the way the taskbar launcher does, draw it once
+// and close it again
+static void workload_window_churn(uint64_t arg) {
+    (void)arg;
+    window_t* win = wm_create_window(120, 100, 500, 300, "perftest");
+    if (!win) return;
+    
+    win->user_data = terminal_create_instance();
+    taskbar_add_button(win->id, "perftest");
+    compositor_render_frame();
+    wm_destroy_window(win->id);
+}
+
+// Print a burst of lines into the focused terminal, then draw the frame
+static terminal_instance_t* flood_term = NULL;
+
+static void workload_flood_setup(void) {
+    workload_heap_save();
+    
+    window_t* win = wm_get_window(wm_get_state()->focused_window_id);
+    flood_term = win ? (terminal_instance_t*)win->user_data : NULL;
+    if (!flood_term) flood_term = terminal_create_instance();
+}
+
+static void workload_terminal_flood(uint64_t lines) {
+    char line[64];
+    for (uint64_t i = 0; i < lines; i++) {
+        snprintf(line, sizeof(line), "perftest: terminal flood line %llu", (unsigned long long)i);
+        terminal_instance_print(flood_term, line);
+    }
+    compositor_render_frame();
+}
+
+// Replay a title-bar drag: one mouse move and one frame per call
+static int drag_window = -1;
+static int drag_step = 0;
+
+static void workload_drag_setup(void) {
+    window_t* win = wm_create_window(200, 150, 400, 250, "drag");
+    if (!win) return;
+    
+    drag_window = win->id;
+    drag_step = 0;
+    wm_handle_mouse_down(win->x + 40, win->y + TITLEBAR_HEIGHT / 2);
+}
+
+static void workload_drag_teardown(void) {
+    if (drag_window == -1) return;
+    
+    int mx, my;
+    cursor_get_position(&mx, &my);
+    wm_handle_mouse_up(mx, my);
+    wm_destroy_window(drag_window);
+    drag_window = -1;
+}
+
+static void workload_mouse_drag(uint64_t arg) {
+    (void)arg;
+    
+    // Zig-zag across the screen so every frame damages a new area
+    int phase = drag_step++ % 128;
+    int x = 60 + (phase < 64 ? phase : 127 - phase) * (screen_w - 520) / 64;
+    int y = 60 + (drag_step % 32) * 8;
+    
+    wm_handle_mouse_move(x, y);
+    cursor_set_position(x, y);
+    compositor_render_frame();
+}
+
+// A burst of frame and heap allocations of mixed sizes
+static void workload_alloc_stress(uint64_t count) {
+    void* frames[64];
+    if (count > 64) count = 64;
+    
+    for (uint64_t i = 0; i < count; i++) {
+        frames[i] = pmm_alloc_frame();
+    }
+    for (uint64_t i = 0; i < count; i++) {
+        if (frames[i]) pmm_free_frame(frames[i]);
+    }
+    
+    void* mark = heap_mark();
+    for (uint64_t i = 0; i < count; i++) {
+        void* ptr = malloc(16 + (i * 97) % 2048);
+        if (ptr) free(ptr);
+    }
+    heap_release(mark);
+}
+
+static void workload_frame(uint64_t arg) {
+    (void)arg;
+    compositor_render_frame();
+}
+
+// One keystroke and one pointer nudge per frame, taken through the same
+// bottom halves and frame sampling as real input
+static int nudge = 1;
+
+static void workload_input_latency(uint64_t arg) {
+    (void)arg;
+    
+    // Shift press and release: a key event that leaves no text behind
+    keyboard_inject_scancode(0x2A);
+    keyboard_inject_scancode(0xAA);
+    mouse_report(nudge, 0, 0);
+    nudge = -nudge;
+    
+    uint64_t flags = local_irq_save();
+    do_softirq();
+    local_irq_restore(flags);
+    
+    input_latency_frame_begin();
+    compositor_render_frame();
+}
+
+static const bench_t workloads[] = {
+    { "workload/window_churn", workload_window_churn, 0, 1, workload_heap_save, workload_heap_restore },
+    { "workload/terminal_flood", workload_terminal_flood, 32, 1, workload_flood_setup, workload_heap_restore },
+    { "workload/mouse_drag", workload_mouse_drag, 0, 1, workload_drag_setup, workload_drag_teardown },
+    { "workload/alloc_stress", workload_alloc_stress, 64, 1, NULL, NULL },
+    { "workload/frame", workload_frame, 0, 1, NULL, NULL },
+    { "workload/input_latency", workload_input_latency, 0, 1, NULL, NULL },
+};
+
+// Headless runs: present one more frame after the workload and report its
+// checksum plus the frame-to-frame times seen while the workload ran
+static void perftest_report_frames(const char* name) {
+    char line[160];
+    frame_stats_t stats;
+    
+    if (!graphics_is_headless()) return;
+    
+    compositor_render_frame();
+    graphics_frame_stats(&stats);
+    char sum[17];
+    graphics_format_checksum(graphics_checksum(), sum);
+    
+    snprintf(line, sizeof(line), "CHECKSUM name=%s value=%s\n", name, sum);
+    serial_write_blocking(line);
+    snprintf(line, sizeof(line), "FRAMETIME name=%s frames=%u median=%llu p99=%llu max=%llu\n", name,
+             stats.frames, (unsigned long long)stats.median, (unsigned long long)stats.p99,
+             (unsigned long long)stats.max);
+    serial_write_blocking(line);
+}
+
+// Latency of the events the workloads injected, in microseconds
+static void perftest_report_latency(void) {
+    char line[160];
+    
+    for (int i = 0; i < INPUT_LATENCY_CLASSES; i++) {
+        input_latency_stats_t stats;
+        input_latency_stats(i, &stats);
+        
+        snprintf(line, sizeof(line), "LATENCY name=%s events=%llu p50=%u p95=%u p99=%u max=%u\n",
+                 input_latency_name(i), (unsigned long long)stats.events, (unsigned int)stats.p50_us,
+                 (unsigned int)stats.p95_us, (unsigned int)stats.p99_us,
+                 (unsigned int)stats.max_us);
+        serial_write_blocking(line);
+    }
+}
+
+int perftest_requested(void) {
+    return cmdline_has("perftest");
+}
+
+void perftest_exit(uint8_t code) {
+    outb(ISA_DEBUG_EXIT_PORT, code);
+    
+    // Still here: not QEMU, or no exit device attached
+    while (1) {
+        asm volatile("cli; hlt");
+    }
+}
+
+void perftest_run(void) {
+    bench_result_t result;
+    char line[64];
+    
+    pr_info("perftest", "running %u workloads and %d benchmarks",
+            (unsigned int)(sizeof(workloads) / sizeof(workloads[0])), bench_count());
+    
+    // Without a serial port nobody can read the results
+    if (!serial_available()) perftest_exit(PERFTEST_EXIT_FAILURE);
+    
+    serial_write_blocking("PERFTEST BEGIN\n");
+    if (graphics_is_headless()) {
+        snprintf(line, sizeof(line), "HEADLESS width=%d height=%d\n", screen_w, screen_h);
+        serial_write_blocking(line);
+    }
+    
+    // Only the input workload's own events count
+    input_latency_reset();
+    
+    for (uint32_t i = 0; i < sizeof(workloads) / sizeof(workloads[0]); i++) {
+        graphics_frame_stats_reset();
+        bench_run(&workloads[i], &result);
+        bench_report_serial(&result);
+        perftest_report_frames(workloads[i].name);
+    }
+    perftest_report_latency();
+    
+    for (int i = 0; i < bench_count(); i++) {
+        bench_run(bench_get(i), &result);
+        bench_report_serial(&result);
+    }
+    
+    serial_write_blocking("PERFTEST END\n");
+    serial_flush();
+    perftest_exit(PERFTEST_EXIT_SUCCESS);
+}
@@ -0,0 +1,24 @@
+#ifndef PERFTEST_H
+#define PERFTEST_H
+
+#include <stdint.h>
+
+// QEMU's isa-debug-exit device (make perf-test attaches it at 0xF4).
+// Writing v makes QEMU exit with status (v << 1) | 1.
+#define ISA_DEBUG_EXIT_PORT     0xF4
+#define PERFTEST_EXIT_SUCCESS   0x10    // QEMU exits 33
+#define PERFTEST_EXIT_FAILURE   0x11    // QEMU exits 35
+
+// Nonzero when booted with "perftest" on the kernel command line
+int perftest_requested(void);
+
+// Run the scripted workloads (window churn, terminal flood, mouse drag
+// replay, allocator stress, plain frames) and then every registered
+// microbenchmark, reporting each as a BENCH line on COM1. Exits QEMU when
+// done and never returns.
+void perftest_run(void);
+
+// Leave QEMU through isa-debug-exit (halts on real hardware)
+void perftest_exit(uint8_t code);
+
+#endif
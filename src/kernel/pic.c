@@ -0,0 +1,79 @@
+#include "pic.h"
+#include "include/common.h"
+#include "lib/io.h"
+
+#define PIC_READ_ISR 0x0B
+
+static uint8_t pic_offset = IRQ_VECTOR_BASE;
+
+static uint16_t pic_read_isr(void) {
+    outb(PIC_MASTER_CMD, PIC_READ_ISR);
+    outb(PIC_SLAVE_CMD, PIC_READ_ISR);
+    return ((uint16_t)inb(PIC_SLAVE_CMD) << 8) | inb(PIC_MASTER_CMD);
+}
+
+static void pic_eoi(uint8_t vector) {
+    // Lines 8-15 are cascaded through the master's line 2
+    if (vector - pic_offset >= 8) {
+        outb(PIC_SLAVE_CMD, PIC_EOI);
+    }
+    outb(PIC_MASTER_CMD, PIC_EOI);
+}
+
+static void pic_mask(uint8_t vector) {
+    uint8_t line = vector - pic_offset;
+    uint16_t port = line < 8 ? PIC_MASTER_DATA : PIC_SLAVE_DATA;
+    outb(port, inb(port) | (1 << (line & 7)));
+}
+
+static void pic_unmask(uint8_t vector) {
+    uint8_t line = vector - pic_offset;
+    uint16_t port = line < 8 ? PIC_MASTER_DATA : PIC_SLAVE_DATA;
+    outb(port, inb(port) & ~(1 << (line & 7)));
+    
+    // Slave lines also need the cascade line open
+    if (line >= 8) {
+        outb(PIC_MASTER_DATA, inb(PIC_MASTER_DATA) & ~(1 << 2));
+    }
+}
+
+// IRQ7/IRQ15 fire spuriously when a request goes away before the CPU
+// acknowledges it; the in-service bit tells the difference. A spurious
+// IRQ15 still needs an EOI to the master for the cascade.
+static int pic_is_spurious(uint8_t vector) {
+    uint8_t line = vector - pic_offset;
+    if (line != 7 && line != 15) return 0;
+    
+    if (pic_read_isr() & (1 << line)) return 0;
+    
+    if (line == 15) {
+        outb(PIC_MASTER_CMD, PIC_EOI);
+    }
+    return 1;
+}
+
+irq_chip_t pic_chip = {
+    .name = "PIC",
+    .eoi = pic_eoi,
+    .mask = pic_mask,
+    .unmask = pic_unmask,
+    .is_spurious = pic_is_spurious,
+};
+
+void pic_remap(uint8_t master_offset, uint8_t slave_offset) {
+    pic_offset = master_offset;
+    
+    outb(PIC_MASTER_CMD, 0x11); outb(PIC_SLAVE_CMD, 0x11);     // ICW1: init + ICW4
+    outb(PIC_MASTER_DATA, master_offset);                     // ICW2: vector offsets
+    outb(PIC_SLAVE_DATA, slave_offset);
+    outb(PIC_MASTER_DATA, 0x04); outb(PIC_SLAVE_DATA, 0x02);   // ICW3: cascade on line 2
+    outb(PIC_MASTER_DATA, 0x01); outb(PIC_SLAVE_DATA, 0x01);   // ICW4: 8086 mode
+    // Everything masked but the cascade; request_irq unmasks each line
+    // as its handler goes in
+    outb(PIC_MASTER_DATA, 0xFF & ~(1 << 2)); outb(PIC_SLAVE_DATA, 0xFF);
+}
+
+void pic_disable(void) {
+    outb(PIC_MASTER_DATA, 0xFF);
+    outb(PIC_SLAVE_DATA, 0xFF);
+}
@@ -0,0 +1,17 @@
+#ifndef PIC_H
+#define PIC_H
+
+#include <stdint.h>
+#include "kernel/irq.h"
+
+// 8259A master/slave pair
+extern irq_chip_t pic_chip;
+
+// Reinitialize both PICs with the given vector offsets, every line masked
+// except the cascade (request_irq unmasks the rest)
+void pic_remap(uint8_t master_offset, uint8_t slave_offset);
+
+// Mask every line (once another interrupt controller takes over)
+void pic_disable(void);
+
+#endif
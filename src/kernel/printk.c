@@ -0,0 +1,163 @@
+#include "printk.h"
+#include <stddef.h>
+#include "kernel/percpu.h"
+#include "kernel/tsc.h"
+#include "lib/string.h"
+#include "drivers/char/serial.h"
+
+typedef struct {
+    printk_record_t records[PRINTK_RECORDS];
+    volatile uint64_t head;     // Total records ever reserved
+    uint64_t cleared;           // Records before this were dropped by dmesg clear
+} printk_buffer_t;
+
+static DEFINE_PER_CPU(printk_buffer_t, printk_buffers);
+static int console_level = LOG_INFO;
+
+static const char level_chars[] = "DIWEF";
+
+void vprintk(int level, const char* subsys, const char* fmt, va_list args) {
+    char text[PRINTK_MSG_MAX];
+    vsnprintf(text, sizeof(text), fmt, args);
+    
+    int cpu = smp_processor_id();
+    printk_buffer_t* buf = &per_cpu(printk_buffers, cpu);
+    
+    // Reserve a slot with an atomic add so an interrupt on this CPU can
+    // log into the next slot while we fill ours
+    uint64_t slot = __atomic_fetch_add(&buf->head, 1, __ATOMIC_RELAXED);
+    printk_record_t* rec = &buf->records[slot & (PRINTK_RECORDS - 1)];
+    
+    // Unpublish first so readers never see a half-written record
+    __atomic_store_n(&rec->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    
+    uint16_t len = 0;
+    while (text[len] && len < PRINTK_MSG_MAX - 1) {
+        rec->text[len] = text[len];
+        len++;
+    }
+    rec->text[len] = '\0';
+    rec->len = len;
+    rec->tsc = rdtsc();
+    rec->subsys = subsys ? subsys : "kernel";
+    rec->level = (uint8_t)level;
+    rec->cpu = (uint8_t)cpu;
+    
+    __atomic_store_n(&rec->seq, slot + 1, __ATOMIC_RELEASE);
+    
+    if (level >= console_level) {
+        char line[PRINTK_LINE_MAX];
+        printk_format(rec, line);
+        serial_write(line);
+        serial_write("\n");
+    }
+}
+
+void printk(int level, const char* subsys, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    vprintk(level, subsys, fmt, args);
+    va_end(args);
+}
+
+void printk_set_console_level(int level) {
+    console_level = level;
+}
+
+int printk_console_level(void) {
+    return console_level;
+}
+
+// Copy a slot if it still holds the record for seq; the seq re-check
+// catches a producer that lapped us mid-copy
+static int printk_read_slot(printk_buffer_t* buf, uint64_t seq, printk_record_t* out) {
+    printk_record_t* rec = &buf->records[seq & (PRINTK_RECORDS - 1)];
+    
+    if (__atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE) != seq + 1) return 0;
+    memcpy(out, (const void*)rec, sizeof(*out));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&rec->seq, __ATOMIC_RELAXED) != seq + 1) return 0;
+    
+    return 1;
+}
+
+uint32_t printk_snapshot(printk_record_t* out, uint32_t max, int min_level) {
+    uint32_t count = 0;
+    printk_record_t rec;
+    
+    if (max == 0) return 0;
+    
+    // Keep out[] sorted oldest first; once full, only newer records get in
+    for (int cpu = 0; cpu < NR_CPUS; cpu++) {
+        printk_buffer_t* buf = &per_cpu(printk_buffers, cpu);
+        uint64_t head = __atomic_load_n(&buf->head, __ATOMIC_ACQUIRE);
+        uint64_t first = head > PRINTK_RECORDS ? head - PRINTK_RECORDS : 0;
+        if (first < buf->cleared) first = buf->cleared;
+        uint32_t taken = 0;
+        
+        for (uint64_t seq = head; seq > first && taken < max; seq--) {
+            if (!printk_read_slot(buf, seq - 1, &rec)) continue;
+            if (rec.level < min_level) continue;
+            taken++;
+            
+            if (count == max) {
+                if (rec.tsc <= out[0].tsc) continue;
+                for (uint32_t i = 1; i < max; i++) {
+                    out[i - 1] = out[i];
+                }
+                count--;
+            }
+            
+            uint32_t pos = count;
+            while (pos > 0 && out[pos - 1].tsc > rec.tsc) {
+                out[pos] = out[pos - 1];
+                pos--;
+            }
+            out[pos] = rec;
+            count++;
+        }
+    }
+    
+    return count;
+}
+
+void printk_format(const printk_record_t* rec, char* out) {
+    uint64_t us = tsc_cycles_to_ns(rec->tsc) / 1000;
+    
+    snprintf(out, PRINTK_LINE_MAX, "[%5llu.%06llu] %c %s: %s", us / 1000000, us % 1000000,
+             rec->level < 5 ? level_chars[rec->level] : '?', rec->subsys, rec->text);
+}
+
+uint64_t printk_total(void) {
+    uint64_t total = 0;
+    for (int cpu = 0; cpu < NR_CPUS; cpu++) {
+        total += per_cpu(printk_buffers, cpu).head;
+    }
+    return total;
+}
+
+uint64_t printk_overwritten(void) {
+    uint64_t lost = 0;
+    for (int cpu = 0; cpu < NR_CPUS; cpu++) {
+        uint64_t head = per_cpu(printk_buffers, cpu).head;
+        if (head > PRINTK_RECORDS) lost += head - PRINTK_RECORDS;
+    }
+    return lost;
+}
+
+void printk_clear(void) {
+    for (int cpu = 0; cpu < NR_CPUS; cpu++) {
+        printk_buffer_t* buf = &per_cpu(printk_buffers, cpu);
+        buf->cleared = buf->head;
+    }
+}
+
+int printk_parse_level(const char* name) {
+    if (strcmp(name, "debug") == 0) return LOG_DEBUG;
+    if (strcmp(name, "info") == 0) return LOG_INFO;
+    if (strcmp(name, "warn") == 0) return LOG_WARN;
+    if (strcmp(name, "err") == 0 || strcmp(name, "error") == 0) return LOG_ERROR;
+    if (strcmp(name, "fatal") == 0) return LOG_FATAL;
+    return -1;
+}
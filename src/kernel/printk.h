@@ -0,0 +1,57 @@
+#ifndef PRINTK_H
+#define PRINTK_H
+
+#include <stdint.h>
+#include <stdarg.h>
+#include "lib/printf.h"
+
+#define PRINTK_RECORDS      256     // Records per CPU, power of two
+#define PRINTK_MSG_MAX      96      // Message bytes kept per record
+#define PRINTK_LINE_MAX     (PRINTK_MSG_MAX + 48)   // Formatted record
+
+// One log record. seq is the record's slot number + 1 once it is
+// published, 0 while a producer is still filling it in.
+typedef struct {
+    volatile uint64_t seq;
+    uint64_t tsc;
+    const char* subsys;
+    uint8_t level;              // enum log_level
+    uint8_t cpu;
+    uint16_t len;
+    char text[PRINTK_MSG_MAX];
+} printk_record_t;
+
+// Append a record to this CPU's ring. Lock-free and safe from IRQ
+// context; once full the oldest records are overwritten. Records at or
+// above the console level are also queued to the serial console, which
+// never blocks.
+void printk(int level, const char* subsys, const char* fmt, ...);
+void vprintk(int level, const char* subsys, const char* fmt, va_list args);
+
+#define pr_debug(subsys, ...)   printk(LOG_DEBUG, subsys, __VA_ARGS__)
+#define pr_info(subsys, ...)    printk(LOG_INFO, subsys, __VA_ARGS__)
+#define pr_warn(subsys, ...)    printk(LOG_WARN, subsys, __VA_ARGS__)
+#define pr_err(subsys, ...)     printk(LOG_ERROR, subsys, __VA_ARGS__)
+
+// Minimum level mirrored to the console (default LOG_INFO)
+void printk_set_console_level(int level);
+int printk_console_level(void);
+
+// Copy out the newest (up to max) records at or above min_level, oldest
+// first, merged across CPUs by timestamp. Records overwritten while being
+// copied are skipped. Returns the number copied.
+uint32_t printk_snapshot(printk_record_t* out, uint32_t max, int min_level);
+
+// "[    1.234567] W subsys: text"
+void printk_format(const printk_record_t* rec, char* out);
+
+// Records ever logged / lost to ring wrap-around
+uint64_t printk_total(void);
+uint64_t printk_overwritten(void);
+
+void printk_clear(void);
+
+// Parse "debug", "info", "warn", "err"/"error" or "fatal"; -1 if unknown
+int printk_parse_level(const char* name);
+
+#endif
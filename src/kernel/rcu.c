@@ -0,0 +1,132 @@
+#include "rcu.h"
+#include <stddef.h>
+#include "kernel/softirq.h"
+
+DEFINE_PER_CPU(volatile int, rcu_nesting);
+
+// Grace periods are numbered; gp_current == gp_completed means idle
+static volatile uint64_t gp_completed = 0;
+static volatile uint64_t gp_current = 0;
+static int gp_next_requested = 0;
+static spinlock_t rcu_lock = SPINLOCK_INIT;
+
+// Last grace period each CPU passed a quiescent state in
+static DEFINE_PER_CPU(volatile uint64_t, rcu_qs_gp);
+
+// Callbacks waiting for their grace period, oldest first
+static DEFINE_PER_CPU(rcu_head_t*, rcu_cb_head);
+static DEFINE_PER_CPU(rcu_head_t**, rcu_cb_tail);
+
+// Called with rcu_lock held
+static void rcu_try_complete(void) {
+    if (gp_current == gp_completed) return;
+    
+    for (int cpu = 0; cpu < NR_CPUS; cpu++) {
+        if (per_cpu(rcu_qs_gp, cpu) != gp_current) return;
+    }
+    
+    gp_completed = gp_current;
+    
+    if (gp_next_requested) {
+        gp_next_requested = 0;
+        gp_current++;
+    }
+}
+
+// Grace period a new updater has to wait for. A period already running
+// may have seen quiescent states from before the update, so the caller
+// needs the one after it.
+static uint64_t rcu_request_gp(void) {
+    uint64_t flags = spin_lock_irqsave(&rcu_lock);
+    
+    uint64_t target;
+    if (gp_current == gp_completed) {
+        target = ++gp_current;
+    } else {
+        gp_next_requested = 1;
+        target = gp_current + 1;
+    }
+    
+    spin_unlock_irqrestore(&rcu_lock, flags);
+    return target;
+}
+
+void rcu_note_quiescent(void) {
+    int cpu = smp_processor_id();
+    if (per_cpu(rcu_nesting, cpu) != 0) return;
+    if (gp_current == gp_completed || per_cpu(rcu_qs_gp, cpu) == gp_current) return;
+    
+    uint64_t flags = spin_lock_irqsave(&rcu_lock);
+    per_cpu(rcu_qs_gp, cpu) = gp_current;
+    rcu_try_complete();
+    spin_unlock_irqrestore(&rcu_lock, flags);
+}
+
+void synchronize_rcu(void) {
+    uint64_t target = rcu_request_gp();
+    
+    while ((int64_t)(gp_completed - target) < 0) {
+        rcu_note_quiescent();
+        cpu_relax();
+    }
+}
+
+void call_rcu(rcu_head_t* head, void (*func)(rcu_head_t*)) {
+    head->func = func;
+    head->next = NULL;
+    head->gp = rcu_request_gp();
+    
+    uint64_t flags = local_irq_save();
+    int cpu = smp_processor_id();
+    *per_cpu(rcu_cb_tail, cpu) = head;
+    per_cpu(rcu_cb_tail, cpu) = &head->next;
+    local_irq_restore(flags);
+}
+
+static void rcu_process_callbacks(void) {
+    int cpu = smp_processor_id();
+    
+    while (1) {
+        uint64_t flags = local_irq_save();
+        rcu_head_t* head = per_cpu(rcu_cb_head, cpu);
+        if (!head || (int64_t)(gp_completed - head->gp) < 0) {
+            local_irq_restore(flags);
+            break;
+        }
+        
+        per_cpu(rcu_cb_head, cpu) = head->next;
+        if (!head->next) per_cpu(rcu_cb_tail, cpu) = &per_cpu(rcu_cb_head, cpu);
+        local_irq_restore(flags);
+        
+        head->func(head);
+    }
+}
+
+void rcu_barrier(void) {
+    while (this_cpu(rcu_cb_head)) {
+        rcu_note_quiescent();
+        rcu_process_callbacks();
+        cpu_relax();
+    }
+}
+
+void rcu_check_callbacks(void) {
+    // The tick interrupted whatever ran; if that wasn't a reader, this CPU
+    // is quiescent
+    rcu_note_quiescent();
+    
+    rcu_head_t* head = this_cpu(rcu_cb_head);
+    if (head && (int64_t)(gp_completed - head->gp) >= 0) {
+        raise_softirq(RCU_SOFTIRQ);
+    }
+}
+
+void rcu_init(void) {
+    for (int cpu = 0; cpu < NR_CPUS; cpu++) {
+        per_cpu(rcu_nesting, cpu) = 0;
+        per_cpu(rcu_qs_gp, cpu) = 0;
+        per_cpu(rcu_cb_head, cpu) = NULL;
+        per_cpu(rcu_cb_tail, cpu) = &per_cpu(rcu_cb_head, cpu);
+    }
+    open_softirq(RCU_SOFTIRQ, rcu_process_callbacks);
+}
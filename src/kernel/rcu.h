@@ -0,0 +1,53 @@
+#ifndef RCU_H
+#define RCU_H
+
+#include <stdint.h>
+#include "kernel/percpu.h"
+#include "kernel/spinlock.h"
+
+// Read-copy-update for read-mostly data such as the window list.
+// Readers only bump a per-CPU nesting count; any moment a CPU has no
+// reader active is a quiescent state. Updaters publish a new copy with
+// rcu_assign_pointer and free the old one after a grace period.
+
+DECLARE_PER_CPU(volatile int, rcu_nesting);
+
+static inline void rcu_read_lock(void) {
+    this_cpu(rcu_nesting)++;
+    barrier();
+}
+
+static inline void rcu_read_unlock(void) {
+    barrier();
+    this_cpu(rcu_nesting)--;
+}
+
+#define rcu_dereference(p)          __atomic_load_n(&(p), __ATOMIC_CONSUME)
+#define rcu_assign_pointer(p, v)    __atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+
+typedef struct rcu_head {
+    struct rcu_head* next;
+    void (*func)(struct rcu_head* head);
+    uint64_t gp;                // Grace period that must complete first
+} rcu_head_t;
+
+void rcu_init(void);
+
+// Wait until every reader that might see the old data has finished.
+// Process context only, never inside a read-side section.
+void synchronize_rcu(void);
+
+// Run func(head) after a grace period, from RCU_SOFTIRQ
+void call_rcu(rcu_head_t* head, void (*func)(rcu_head_t*));
+
+// Wait until every callback queued on this CPU so far has run. Same
+// rules as synchronize_rcu.
+void rcu_barrier(void);
+
+// Report a quiescent state if this CPU is outside any read section
+void rcu_note_quiescent(void);
+
+// Timer tick hook: note quiescent states and kick ready callbacks
+void rcu_check_callbacks(void);
+
+#endif
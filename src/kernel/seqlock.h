@@ -0,0 +1,45 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdint.h>
+#include "kernel/spinlock.h"
+
+// Sequence lock for small, hot snapshots (e.g. the mouse position).
+// Writers serialize on the spinlock and bump the sequence to odd while
+// updating; readers never block, they retry if the sequence moved.
+// A reader must not run on a CPU that is in the middle of a write (i.e.
+// from an interrupt that preempted the writer) or it will spin forever.
+typedef struct {
+    volatile uint32_t sequence;
+    spinlock_t lock;
+} seqlock_t;
+
+#define SEQLOCK_INIT { 0, SPINLOCK_INIT }
+
+static inline void write_seqlock(seqlock_t* sl) {
+    spin_lock(&sl->lock);
+    sl->sequence++;
+    barrier();
+}
+
+static inline void write_sequnlock(seqlock_t* sl) {
+    barrier();
+    sl->sequence++;
+    spin_unlock(&sl->lock);
+}
+
+static inline uint32_t read_seqbegin(seqlock_t* sl) {
+    uint32_t seq;
+    while ((seq = __atomic_load_n(&sl->sequence, __ATOMIC_ACQUIRE)) & 1) {
+        cpu_relax();
+    }
+    return seq;
+}
+
+// Nonzero if a writer ran since read_seqbegin returned start
+static inline int read_seqretry(seqlock_t* sl, uint32_t start) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return sl->sequence != start;
+}
+
+#endif
@@ -0,0 +1,107 @@
+#include "softirq.h"
+#include "kernel/irqflags.h"
+#include "kernel/percpu.h"
+#include <stddef.h>
+
+// Stop after this many passes so a softirq that keeps re-raising itself
+// can't starve the interrupted code; leftovers run on the next IRQ exit
+#define MAX_SOFTIRQ_RESTART 10
+
+static softirq_action_t softirq_vec[NR_SOFTIRQS];
+static DEFINE_PER_CPU(volatile uint32_t, softirq_pending);
+static DEFINE_PER_CPU(volatile int, softirq_running);
+
+// Per-CPU tasklet list, appended at the tail so tasklets run in FIFO order
+static DEFINE_PER_CPU(tasklet_t*, tasklet_head);
+static DEFINE_PER_CPU(tasklet_t**, tasklet_tail);
+
+void open_softirq(int nr, softirq_action_t action) {
+    if (nr < 0 || nr >= NR_SOFTIRQS) return;
+    softirq_vec[nr] = action;
+}
+
+void raise_softirq(int nr) {
+    if (nr < 0 || nr >= NR_SOFTIRQS) return;
+    this_cpu(softirq_pending) |= (1u << nr);
+}
+
+int in_softirq(void) {
+    return this_cpu(softirq_running);
+}
+
+// Entered with interrupts disabled (IRQ exit path), returns the same way
+void do_softirq(void) {
+    int cpu = smp_processor_id();
+    if (per_cpu(softirq_running, cpu) || per_cpu(softirq_pending, cpu) == 0) return;
+    
+    per_cpu(softirq_running, cpu) = 1;
+    
+    for (int restart = 0; restart < MAX_SOFTIRQ_RESTART && per_cpu(softirq_pending, cpu); restart++) {
+        uint32_t pending = per_cpu(softirq_pending, cpu);
+        per_cpu(softirq_pending, cpu) = 0;
+        
+        local_irq_enable();
+        for (int nr = 0; nr < NR_SOFTIRQS; nr++) {
+            if ((pending & (1u << nr)) && softirq_vec[nr]) {
+                softirq_vec[nr]();
+            }
+        }
+        local_irq_disable();
+    }
+    
+    per_cpu(softirq_running, cpu) = 0;
+}
+
+// --- TASKLETS ---
+
+static void tasklet_action(void) {
+    int cpu = smp_processor_id();
+    
+    // Detach the whole list so tasklets rescheduled while running go to the next pass
+    uint64_t flags = local_irq_save();
+    tasklet_t* list = per_cpu(tasklet_head, cpu);
+    per_cpu(tasklet_head, cpu) = NULL;
+    per_cpu(tasklet_tail, cpu) = &per_cpu(tasklet_head, cpu);
+    local_irq_restore(flags);
+    
+    while (list) {
+        tasklet_t* t = list;
+        list = t->next;
+        
+        t->next = NULL;
+        t->scheduled = 0;
+        t->runs++;
+        t->func(t->data);
+    }
+}
+
+void softirq_init(void) {
+    for (int cpu = 0; cpu < NR_CPUS; cpu++) {
+        per_cpu(tasklet_head, cpu) = NULL;
+        per_cpu(tasklet_tail, cpu) = &per_cpu(tasklet_head, cpu);
+    }
+    open_softirq(TASKLET_SOFTIRQ, tasklet_action);
+}
+
+void tasklet_init(tasklet_t* t, void (*func)(uint64_t), uint64_t data) {
+    t->next = NULL;
+    t->scheduled = 0;
+    t->func = func;
+    t->data = data;
+    t->runs = 0;
+}
+
+void tasklet_schedule(tasklet_t* t) {
+    uint64_t flags = local_irq_save();
+    
+    if (!t->scheduled) {
+        int cpu = smp_processor_id();
+        t->scheduled = 1;
+        t->next = NULL;
+        *per_cpu(tasklet_tail, cpu) = t;
+        per_cpu(tasklet_tail, cpu) = &t->next;
+        raise_softirq(TASKLET_SOFTIRQ);
+    }
+    
+    local_irq_restore(flags);
+}
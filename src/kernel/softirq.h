@@ -0,0 +1,45 @@
+#ifndef SOFTIRQ_H
+#define SOFTIRQ_H
+
+#include <stdint.h>
+
+// Softirq vectors, run in priority order (lowest number first)
+enum {
+    TIMER_SOFTIRQ,
+    TASKLET_SOFTIRQ,
+    RCU_SOFTIRQ,
+    NR_SOFTIRQS
+};
+
+typedef void (*softirq_action_t)(void);
+
+// Install the action for a softirq vector
+void open_softirq(int nr, softirq_action_t action);
+
+// Mark a softirq pending on this CPU (call with interrupts disabled, e.g. from an IRQ)
+void raise_softirq(int nr);
+
+// Run this CPU's pending softirqs with interrupts enabled.
+// Called on IRQ exit; does nothing if softirqs are already running.
+void do_softirq(void);
+
+// Nonzero while softirq actions are executing on this CPU
+int in_softirq(void);
+
+// Per-driver bottom half run from TASKLET_SOFTIRQ.
+// A tasklet is queued at most once and never runs concurrently with itself.
+typedef struct tasklet {
+    struct tasklet* next;
+    volatile int scheduled;
+    void (*func)(uint64_t data);
+    uint64_t data;
+    uint32_t runs;
+} tasklet_t;
+
+void softirq_init(void);
+void tasklet_init(tasklet_t* t, void (*func)(uint64_t), uint64_t data);
+
+// Queue the tasklet on this CPU; safe from hard IRQ context
+void tasklet_schedule(tasklet_t* t);
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef SPINLOCK_H
+#define SPINLOCK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "kernel/irqflags.h"
+
+// Compiler-only barrier; x86 keeps loads and stores in order otherwise
+#define barrier() asm volatile("" : : : "memory")
+
+static inline void cpu_relax(void) {
+    asm volatile("pause" : : : "memory");
+}
+
+// --- TICKET SPINLOCK ---
+// FIFO-fair: each locker takes a ticket and waits for "owner" to reach it.
+// Nests with interrupts only through the _irqsave variants.
+typedef struct {
+    volatile uint16_t owner;
+    volatile uint16_t next;
+} spinlock_t;
+
+#define SPINLOCK_INIT { 0, 0 }
+
+static inline void spin_lock_init(spinlock_t* lock) {
+    lock->owner = 0;
+    lock->next = 0;
+}
+
+static inline void spin_lock(spinlock_t* lock) {
+    uint16_t ticket = __atomic_fetch_add(&lock->next, 1, __ATOMIC_RELAXED);
+    while (__atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE) != ticket) {
+        cpu_relax();
+    }
+}
+
+static inline int spin_trylock(spinlock_t* lock) {
+    uint16_t owner = __atomic_load_n(&lock->owner, __ATOMIC_RELAXED);
+    uint16_t expected = owner;
+    return __atomic_compare_exchange_n(&lock->next, &expected, (uint16_t)(owner + 1), 0,
+                                       __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+static inline void spin_unlock(spinlock_t* lock) {
+    __atomic_store_n(&lock->owner, (uint16_t)(lock->owner + 1), __ATOMIC_RELEASE);
+}
+
+static inline int spin_is_locked(spinlock_t* lock) {
+    return lock->owner != lock->next;
+}
+
+// For data also touched from interrupt handlers
+static inline uint64_t spin_lock_irqsave(spinlock_t* lock) {
+    uint64_t flags = local_irq_save();
+    spin_lock(lock);
+    return flags;
+}
+
+static inline void spin_unlock_irqrestore(spinlock_t* lock, uint64_t flags) {
+    spin_unlock(lock);
+    local_irq_restore(flags);
+}
+
+// --- MCS QUEUED SPINLOCK ---
+// Each waiter spins on its own node, so handoff touches one remote cache
+// line instead of every waiter hammering the lock word.
+typedef struct mcs_node {
+    struct mcs_node* volatile next;
+    volatile int locked;
+} mcs_node_t;
+
+typedef struct {
+    mcs_node_t* volatile tail;
+} mcs_lock_t;
+
+#define MCS_LOCK_INIT { NULL }
+
+static inline void mcs_lock(mcs_lock_t* lock, mcs_node_t* node) {
+    node->next = NULL;
+    node->locked = 1;
+    
+    mcs_node_t* prev = __atomic_exchange_n(&lock->tail, node, __ATOMIC_ACQ_REL);
+    if (!prev) return;
+    
+    __atomic_store_n(&prev->next, node, __ATOMIC_RELEASE);
+    while (__atomic_load_n(&node->locked, __ATOMIC_ACQUIRE)) {
+        cpu_relax();
+    }
+}
+
+static inline void mcs_unlock(mcs_lock_t* lock, mcs_node_t* node) {
+    mcs_node_t* next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE);
+    
+    if (!next) {
+        // No known successor: release unless someone is mid-enqueue
+        mcs_node_t* expected = node;
+        if (__atomic_compare_exchange_n(&lock->tail, &expected, NULL, 0,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            return;
+        }
+        while (!(next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE))) {
+            cpu_relax();
+        }
+    }
+    
+    __atomic_store_n(&next->locked, 0, __ATOMIC_RELEASE);
+}
+
+// --- READER-WRITER SPINLOCK ---
+// count > 0: that many readers; -1: one writer. Readers can starve a
+// writer, so keep read sections short.
+typedef struct {
+    volatile int32_t count;
+} rwlock_t;
+
+#define RWLOCK_INIT { 0 }
+
+static inline void read_lock(rwlock_t* lock) {
+    while (1) {
+        int32_t count = __atomic_load_n(&lock->count, __ATOMIC_RELAXED);
+        if (count >= 0 &&
+            __atomic_compare_exchange_n(&lock->count, &count, count + 1, 0,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            return;
+        }
+        cpu_relax();
+    }
+}
+
+static inline void read_unlock(rwlock_t* lock) {
+    __atomic_fetch_sub(&lock->count, 1, __ATOMIC_RELEASE);
+}
+
+static inline void write_lock(rwlock_t* lock) {
+    while (1) {
+        int32_t expected = 0;
+        if (__atomic_compare_exchange_n(&lock->count, &expected, -1, 0,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            return;
+        }
+        cpu_relax();
+    }
+}
+
+static inline void write_unlock(rwlock_t* lock) {
+    __atomic_store_n(&lock->count, 0, __ATOMIC_RELEASE);
+}
+
+#endif
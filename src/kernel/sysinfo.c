@@ -39,49 +39,13 @@ void sysinfo_print() {
     
     printf("\n");
     
-    // PCI Devices (optimized to scan only first 8 buses)
+    // PCI Devices (from the table built at boot)
     printf("PCI Devices:\n");
     
-    // Scan PCI bus (limit to 8 buses for performance)
-    for (uint16_t bus = 0; bus < 8; bus++) {
-        int empty_slots = 0;
-        
-        for (uint8_t slot = 0; slot < 32; slot++) {
-            uint32_t vendor = pci_read_config(bus, slot, 0, 0);
-            
-            if ((vendor & 0xFFFF) == 0xFFFF) {
-                empty_slots++;
-                // If we hit 8 empty slots in a row, skip rest of bus
-                if (empty_slots > 8) break;
-                continue;
-            }
-            
-            empty_slots = 0;  // Reset counter
-            
-            uint16_t vendor_id = vendor & 0xFFFF;
-            uint16_t device_id = (vendor >> 16) & 0xFFFF;
-            
-            uint32_t class_info = pci_read_config(bus, slot, 0, 0x08);
-            uint8_t class_code = (class_info >> 24) & 0xFF;
-            uint8_t subclass = (class_info >> 16) & 0xFF;
-            
-            // Determine device type name
-            const char* type_name = "Unknown";
-            if (class_code == 0x00) type_name = "Legacy Device";
-            else if (class_code == 0x01) type_name = "Mass Storage";
-            else if (class_code == 0x02) type_name = "Network Controller";
-            else if (class_code == 0x03) type_name = "Display Controller";
-            else if (class_code == 0x04) type_name = "Multimedia";
-            else if (class_code == 0x05) type_name = "Memory Controller";
-            else if (class_code == 0x06) type_name = "Bridge Device";
-            else if (class_code == 0x0C) {
-                if (subclass == 0x03) type_name = "USB Controller";
-                else type_name = "Serial Bus";
-            }
-            
-            printf("  %02x:%02x.0 %s [%04x:%04x]\n",
-                   bus, slot, type_name, vendor_id, device_id);
-        }
+    for (int i = 0; i < pci_device_count(); i++) {
+        struct pci_device* dev = pci_get_device(i);
+        printf("  %02x:%02x.%x %s [%04x:%04x]\n", dev->bus, dev->slot, dev->func,
+               pci_class_name(dev->class_code, dev->subclass), dev->vendor_id, dev->device_id);
     }
     
     printf("\n=== END SYSTEM INFORMATION ===\n");
@@ -1,16 +1,50 @@
 #include "timer.h"
+#include <stddef.h>
 #include "lib/io.h"
+#include "kernel/clocksource.h"
+#include "kernel/timer_wheel.h"
+#include "kernel/irq.h"
+#include "kernel/rcu.h"
+#include "kernel/perf.h"
+#include "kernel/debug.h"
 
 volatile uint32_t timer_ticks = 0;
+static uint32_t pit_divisor = 0;
 
-void timer_handler() {
+DEFINE_PROFILE_ZONE(zone_timer_irq, "timer_irq");
+
+int timer_handler(void* ctx) {
+    (void)ctx;
+    profile_zone_enter(&zone_timer_irq);
     timer_ticks++;
-    outb(0x20, 0x20); // Send EOI
+    timer_wheel_tick();
+    rcu_check_callbacks();
+    perf_timer_tick();
+    profile_zone_exit(&zone_timer_irq);
+    return IRQ_HANDLED;
+}
+
+// PIT as a clocksource: whole ticks plus the latched channel 0 countdown.
+// Slow (three port accesses) and only as monotonic as the tick count.
+static uint64_t pit_clocksource_read(void) {
+    outb(0x43, 0x00);   // Latch channel 0
+    uint8_t lo = inb(0x40);
+    uint8_t hi = inb(0x40);
+    uint16_t count = ((uint16_t)hi << 8) | lo;
+    
+    return (uint64_t)timer_ticks * pit_divisor + (pit_divisor - count);
 }
 
+static clocksource_t pit_clocksource = {
+    .name = "pit",
+    .read = pit_clocksource_read,
+    .mask = ~0ULL,
+    .freq_hz = PIT_FREQUENCY,
+    .rating = 50,
+};
+
 void timer_init(uint32_t frequency) {
-    // PIT frequency is 1193180 Hz
-    uint32_t divisor = 1193180 / frequency;
+    uint32_t divisor = PIT_FREQUENCY / frequency;
     
     // Send command byte
     outb(0x43, 0x36);
@@ -18,6 +52,13 @@ void timer_init(uint32_t frequency) {
     // Send frequency divisor
     outb(0x40, (uint8_t)(divisor & 0xFF));
     outb(0x40, (uint8_t)((divisor >> 8) & 0xFF));
+    
+    if (pit_divisor == 0) {
+        clocksource_register(&pit_clocksource);
+        irq_set_name(IRQ_TO_VECTOR(0), "timer");
+        request_irq(IRQ_TO_VECTOR(0), timer_handler, NULL);
+    }
+    pit_divisor = divisor;
 }
 
 uint32_t timer_get_ticks() {
@@ -25,6 +66,5 @@ uint32_t timer_get_ticks() {
 }
 
 void timer_wait(uint32_t ticks) {
-    uint32_t start = timer_ticks;
-    while (timer_ticks < start + ticks);
+    sleep_ns((uint64_t)ticks * (1000000000ULL / TIMER_HZ));
 }
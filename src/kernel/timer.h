@@ -3,6 +3,12 @@
 
 #include <stdint.h>
 
+// Tick rate programmed into the PIT
+#define TIMER_HZ 100
+
+// PIT input clock in Hz (also used to calibrate the TSC)
+#define PIT_FREQUENCY 1193182
+
 // Timer state
 extern volatile uint32_t timer_ticks;
 
@@ -12,7 +18,10 @@ void timer_init(uint32_t frequency);
 // Get current tick count
 uint32_t timer_get_ticks();
 
-// Sleep for specified ticks
+// PIT interrupt handler (IRQ0)
+int timer_handler(void* ctx);
+
+// Sleep for specified ticks (halts until the timer wheel wakes us)
 void timer_wait(uint32_t ticks);
 
 #endif
@@ -0,0 +1,297 @@
+#include "timer_wheel.h"
+#include "kernel/timer.h"
+#include "kernel/tsc.h"
+#include "kernel/softirq.h"
+#include "kernel/irqflags.h"
+#include <stddef.h>
+
+#define NS_PER_TICK     (1000000000ULL / TIMER_HZ)
+#define TW_MAX_DELTA    0xFFFFFFFFULL
+
+static ktimer_t* root[TW_ROOT_SIZE];
+static ktimer_t* levels[TW_LEVELS][TW_LEVEL_SIZE];
+
+// Timers being run by the softirq (detached from their slot)
+static ktimer_t* expired_list = NULL;
+
+static volatile uint64_t jiffies64 = 0;   // Ticks seen by the interrupt
+static uint64_t wheel_clock = 0;          // Next tick the softirq will process
+static volatile uint64_t tick_tsc = 0;    // TSC at the most recent tick
+
+static void tw_list_add(ktimer_t** head, ktimer_t* timer) {
+    timer->next = *head;
+    if (timer->next) timer->next->pprev = &timer->next;
+    *head = timer;
+    timer->pprev = head;
+}
+
+static void tw_list_del(ktimer_t* timer) {
+    *timer->pprev = timer->next;
+    if (timer->next) timer->next->pprev = timer->pprev;
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+// Put a timer in the slot for its expiry relative to wheel_clock.
+// Interrupts must be disabled.
+static void tw_enqueue(ktimer_t* timer) {
+    uint64_t expires = timer->expires;
+    int64_t delta = (int64_t)(expires - wheel_clock);
+    ktimer_t** head;
+    
+    if (delta < 0) {
+        // Already due: run on the next processed tick
+        head = &root[wheel_clock & (TW_ROOT_SIZE - 1)];
+    } else if (delta < TW_ROOT_SIZE) {
+        head = &root[expires & (TW_ROOT_SIZE - 1)];
+    } else {
+        // Beyond the wheel's range: park in the last slot of the top level,
+        // it re-cascades until it comes into range
+        if ((uint64_t)delta > TW_MAX_DELTA) {
+            delta = TW_MAX_DELTA;
+            expires = wheel_clock + TW_MAX_DELTA;
+        }
+        
+        int level = 0;
+        while (level < TW_LEVELS - 1 &&
+               delta >= (1LL << (TW_ROOT_BITS + (level + 1) * TW_LEVEL_BITS))) {
+            level++;
+        }
+        
+        int shift = TW_ROOT_BITS + level * TW_LEVEL_BITS;
+        head = &levels[level][(expires >> shift) & (TW_LEVEL_SIZE - 1)];
+    }
+    
+    tw_list_add(head, timer);
+}
+
+// Move every timer in one upper-level slot down to where it now belongs
+static int tw_cascade(int level, int index) {
+    ktimer_t* list = levels[level][index];
+    levels[level][index] = NULL;
+    
+    while (list) {
+        ktimer_t* timer = list;
+        list = timer->next;
+        timer->next = NULL;
+        timer->pprev = NULL;
+        tw_enqueue(timer);
+    }
+    
+    return index;
+}
+
+static void timer_softirq(void) {
+    uint64_t flags = local_irq_save();
+    
+    while ((int64_t)(jiffies64 - wheel_clock) >= 0) {
+        int index = wheel_clock & (TW_ROOT_SIZE - 1);
+        
+        // Root wrapped: pull the next slot of each level down, stopping at
+        // the first level that didn't wrap too
+        if (index == 0) {
+            for (int level = 0; level < TW_LEVELS; level++) {
+                int shift = TW_ROOT_BITS + level * TW_LEVEL_BITS;
+                if (tw_cascade(level, (wheel_clock >> shift) & (TW_LEVEL_SIZE - 1)) != 0) {
+                    break;
+                }
+            }
+        }
+        
+        wheel_clock++;
+        
+        expired_list = root[index];
+        root[index] = NULL;
+        if (expired_list) expired_list->pprev = &expired_list;
+        
+        while (expired_list) {
+            ktimer_t* timer = expired_list;
+            tw_list_del(timer);
+            
+            local_irq_enable();
+            timer->function(timer);
+            local_irq_disable();
+        }
+    }
+    
+    local_irq_restore(flags);
+}
+
+void timer_wheel_init(void) {
+    for (int i = 0; i < TW_ROOT_SIZE; i++) root[i] = NULL;
+    for (int l = 0; l < TW_LEVELS; l++) {
+        for (int i = 0; i < TW_LEVEL_SIZE; i++) levels[l][i] = NULL;
+    }
+    
+    jiffies64 = timer_ticks;
+    wheel_clock = jiffies64;
+    open_softirq(TIMER_SOFTIRQ, timer_softirq);
+}
+
+void timer_wheel_tick(void) {
+    jiffies64++;
+    tick_tsc = rdtsc();
+    raise_softirq(TIMER_SOFTIRQ);
+}
+
+void ktimer_init(ktimer_t* timer, void (*function)(ktimer_t*), void* data) {
+    timer->next = NULL;
+    timer->pprev = NULL;
+    timer->expires = 0;
+    timer->function = function;
+    timer->data = data;
+}
+
+void ktimer_add(ktimer_t* timer, uint64_t expires) {
+    uint64_t flags = local_irq_save();
+    
+    if (timer->pprev) tw_list_del(timer);
+    timer->expires = expires;
+    tw_enqueue(timer);
+    
+    local_irq_restore(flags);
+}
+
+int ktimer_cancel(ktimer_t* timer) {
+    int pending = 0;
+    uint64_t flags = local_irq_save();
+    
+    if (timer->pprev) {
+        tw_list_del(timer);
+        pending = 1;
+    }
+    
+    local_irq_restore(flags);
+    return pending;
+}
+
+int ktimer_pending(ktimer_t* timer) {
+    return timer->pprev != NULL;
+}
+
+uint64_t timer_wheel_now(void) {
+    return jiffies64;
+}
+
+uint64_t timer_ns_to_ticks(uint64_t ns) {
+    return (ns + NS_PER_TICK - 1) / NS_PER_TICK;
+}
+
+static void sleep_wakeup(ktimer_t* timer) {
+    *(volatile int*)timer->data = 1;
+}
+
+void sleep_ns(uint64_t ns) {
+    // Can't wait for a tick with interrupts off, and shorter waits
+    // would overshoot by up to a whole tick
+    if (irqs_disabled() || ns < NS_PER_TICK) {
+        ndelay(ns);
+        return;
+    }
+    
+    volatile int done = 0;
+    ktimer_t timer;
+    ktimer_init(&timer, sleep_wakeup, (void*)&done);
+    
+    // +1: the current tick is already partly over
+    ktimer_add(&timer, timer_wheel_now() + timer_ns_to_ticks(ns) + 1);
+    
+    // sti;hlt is atomic, so a wakeup between the check and the halt
+    // can't be lost
+    for (;;) {
+        local_irq_disable();
+        if (done) break;
+        asm volatile("sti; hlt" : : : "memory");
+    }
+    local_irq_enable();
+}
+
+// --- Benchmarks ---
+
+#define TW_BENCH_BATCH 1024
+
+static ktimer_t bench_timers[TW_BENCH_BATCH];
+static uint64_t bench_expires[TW_BENCH_BATCH];
+
+static void bench_noop(ktimer_t* timer) {
+    (void)timer;
+}
+
+void timer_wheel_bench(uint32_t count, uint64_t* add_cycles, uint64_t* cancel_cycles) {
+    uint64_t add_total = 0;
+    uint64_t cancel_total = 0;
+    uint32_t seed = 12345;
+    
+    for (int i = 0; i < TW_BENCH_BATCH; i++) {
+        ktimer_init(&bench_timers[i], bench_noop, NULL);
+    }
+    
+    for (uint32_t done = 0; done < count; ) {
+        uint32_t batch = count - done;
+        if (batch > TW_BENCH_BATCH) batch = TW_BENCH_BATCH;
+        
+        // Spread expiries over the root and the first two levels
+        uint64_t now = timer_wheel_now();
+        for (uint32_t i = 0; i < batch; i++) {
+            seed = seed * 1103515245 + 12345;
+            bench_expires[i] = now + 1 + (seed >> 8) % 100000;
+        }
+        
+        uint64_t start = rdtsc();
+        for (uint32_t i = 0; i < batch; i++) {
+            ktimer_add(&bench_timers[i], bench_expires[i]);
+        }
+        uint64_t mid = rdtsc();
+        for (uint32_t i = 0; i < batch; i++) {
+            ktimer_cancel(&bench_timers[i]);
+        }
+        uint64_t end = rdtsc();
+        
+        add_total += mid - start;
+        cancel_total += end - mid;
+        done += batch;
+    }
+    
+    *add_cycles = count ? add_total / count : 0;
+    *cancel_cycles = count ? cancel_total / count : 0;
+}
+
+static volatile uint32_t jitter_fired;
+static uint64_t jitter_min, jitter_max, jitter_sum;
+static uint32_t jitter_late;
+
+static void jitter_callback(ktimer_t* timer) {
+    uint64_t latency = rdtsc() - tick_tsc;
+    
+    if (timer_wheel_now() > timer->expires) jitter_late++;
+    if (latency < jitter_min) jitter_min = latency;
+    if (latency > jitter_max) jitter_max = latency;
+    jitter_sum += latency;
+    jitter_fired++;
+}
+
+void timer_wheel_measure_jitter(uint32_t samples, timer_jitter_t* out) {
+    if (samples > TW_BENCH_BATCH) samples = TW_BENCH_BATCH;
+    
+    jitter_fired = 0;
+    jitter_min = ~0ULL;
+    jitter_max = 0;
+    jitter_sum = 0;
+    jitter_late = 0;
+    
+    uint64_t now = timer_wheel_now();
+    for (uint32_t i = 0; i < samples; i++) {
+        ktimer_init(&bench_timers[i], jitter_callback, NULL);
+        ktimer_add(&bench_timers[i], now + 2 + (i % 8));
+    }
+    
+    while (jitter_fired < samples) {
+        sleep_ns(NS_PER_TICK);
+    }
+    
+    out->samples = samples;
+    out->late = jitter_late;
+    out->min_ns = samples ? tsc_cycles_to_ns(jitter_min) : 0;
+    out->max_ns = tsc_cycles_to_ns(jitter_max);
+    out->avg_ns = samples ? tsc_cycles_to_ns(jitter_sum / samples) : 0;
+}
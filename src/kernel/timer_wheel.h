@@ -0,0 +1,66 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+
+// Hierarchical timing wheel driven by the PIT tick (timer_ticks).
+// Level 0 has one slot per tick; each higher level covers 64x the range
+// of the one below and cascades down when level 0 wraps.
+#define TW_ROOT_BITS    8
+#define TW_LEVEL_BITS   6
+#define TW_ROOT_SIZE    (1 << TW_ROOT_BITS)
+#define TW_LEVEL_SIZE   (1 << TW_LEVEL_BITS)
+#define TW_LEVELS       4       // Levels above the root
+
+typedef struct ktimer {
+    struct ktimer* next;
+    struct ktimer** pprev;      // NULL when not queued
+    uint64_t expires;           // Absolute tick
+    void (*function)(struct ktimer* timer);
+    void* data;
+} ktimer_t;
+
+// Tick-to-callback latency measured by timer_wheel_measure_jitter
+typedef struct {
+    uint32_t samples;
+    uint32_t late;              // Fired one or more ticks after expiry
+    uint64_t min_ns;
+    uint64_t avg_ns;
+    uint64_t max_ns;
+} timer_jitter_t;
+
+// Set up the wheel and its softirq
+void timer_wheel_init(void);
+
+// Called from the PIT interrupt on every tick
+void timer_wheel_tick(void);
+
+// Prepare a timer; function runs in softirq context with interrupts enabled
+void ktimer_init(ktimer_t* timer, void (*function)(ktimer_t*), void* data);
+
+// Queue (or re-queue) a timer for an absolute tick. O(1).
+void ktimer_add(ktimer_t* timer, uint64_t expires);
+
+// Remove a queued timer. O(1). Returns 1 if it was pending.
+int ktimer_cancel(ktimer_t* timer);
+
+int ktimer_pending(ktimer_t* timer);
+
+// Current wheel time in ticks
+uint64_t timer_wheel_now(void);
+
+// Convert nanoseconds to ticks, rounding up
+uint64_t timer_ns_to_ticks(uint64_t ns);
+
+// Halt until at least ns nanoseconds have passed.
+// Falls back to a TSC spin when called with interrupts disabled.
+void sleep_ns(uint64_t ns);
+
+// Average cycles per ktimer_add/ktimer_cancel over count arm+cancel pairs
+void timer_wheel_bench(uint32_t count, uint64_t* add_cycles, uint64_t* cancel_cycles);
+
+// Arm samples timers a few ticks out and measure how long after their tick
+// each callback ran. Sleeps while waiting, so call from process context.
+void timer_wheel_measure_jitter(uint32_t samples, timer_jitter_t* out);
+
+#endif
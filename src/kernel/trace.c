@@ -0,0 +1,112 @@
+#include "trace.h"
+#include <stddef.h>
+#include "kernel/percpu.h"
+#include "kernel/tsc.h"
+#include "lib/printf.h"
+#include "drivers/char/serial.h"
+
+typedef struct {
+    trace_record_t records[TRACE_BUFFER_SIZE];
+    volatile uint64_t head;     // Total records ever reserved
+} trace_buffer_t;
+
+static DEFINE_PER_CPU(trace_buffer_t, trace_buffers);
+static int tracing_on = 0;
+
+// Bounds of the __tracepoints section (linker.ld)
+extern tracepoint_t __start___tracepoints[];
+extern tracepoint_t __stop___tracepoints[];
+
+void trace_emit(const tracepoint_t* tp, uint8_t phase, uint32_t arg) {
+    int cpu = smp_processor_id();
+    trace_buffer_t* buf = &per_cpu(trace_buffers, cpu);
+    
+    // Reserving with an atomic add lets an interrupt on this CPU trace
+    // into the next slot while we fill ours
+    uint64_t slot = __atomic_fetch_add(&buf->head, 1, __ATOMIC_RELAXED);
+    trace_record_t* rec = &buf->records[slot & (TRACE_BUFFER_SIZE - 1)];
+    
+    rec->tsc = rdtsc();
+    rec->tp = tp;
+    rec->arg = arg;
+    rec->phase = phase;
+    rec->cpu = cpu;
+}
+
+void trace_enable(int enable) {
+    for (tracepoint_t* tp = __start___tracepoints; tp < __stop___tracepoints; tp++) {
+        if (enable) {
+            static_key_enable(&tp->key);
+        } else {
+            static_key_disable(&tp->key);
+        }
+    }
+    tracing_on = enable;
+}
+
+int trace_enabled(void) {
+    return tracing_on;
+}
+
+void trace_clear(void) {
+    for (int cpu = 0; cpu < NR_CPUS; cpu++) {
+        per_cpu(trace_buffers, cpu).head = 0;
+    }
+}
+
+static uint64_t trace_first_slot(trace_buffer_t* buf) {
+    return buf->head > TRACE_BUFFER_SIZE ? buf->head - TRACE_BUFFER_SIZE : 0;
+}
+
+uint64_t trace_record_count(void) {
+    uint64_t total = 0;
+    for (int cpu = 0; cpu < NR_CPUS; cpu++) {
+        trace_buffer_t* buf = &per_cpu(trace_buffers, cpu);
+        total += buf->head - trace_first_slot(buf);
+    }
+    return total;
+}
+
+int tracepoint_count(void) {
+    return __stop___tracepoints - __start___tracepoints;
+}
+
+uint32_t trace_dump_chrome(void) {
+    int was_on = tracing_on;
+    if (was_on) trace_enable(0);
+    
+    // Timestamps are relative to the oldest record still buffered
+    uint64_t base = ~0ULL;
+    for (int cpu = 0; cpu < NR_CPUS; cpu++) {
+        trace_buffer_t* buf = &per_cpu(trace_buffers, cpu);
+        if (buf->head == 0) continue;
+        trace_record_t* oldest = &buf->records[trace_first_slot(buf) & (TRACE_BUFFER_SIZE - 1)];
+        if (oldest->tsc < base) base = oldest->tsc;
+    }
+    
+    char line[192];
+    uint32_t written = 0;
+    serial_write_blocking("{\"traceEvents\":[\n");
+    
+    for (int cpu = 0; cpu < NR_CPUS; cpu++) {
+        trace_buffer_t* buf = &per_cpu(trace_buffers, cpu);
+        for (uint64_t slot = trace_first_slot(buf); slot < buf->head; slot++) {
+            trace_record_t* rec = &buf->records[slot & (TRACE_BUFFER_SIZE - 1)];
+            uint64_t ns = tsc_cycles_to_ns(rec->tsc - base);
+            
+            snprintf(line, sizeof(line),
+                     "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu.%03llu,\"pid\":0,\"tid\":%u%s,\"args\":{\"arg\":%u}}\n",
+                     written ? "," : "", rec->tp->name, rec->phase,
+                     (unsigned long long)(ns / 1000), (unsigned long long)(ns % 1000),
+                     (unsigned int)rec->cpu, rec->phase == TRACE_INSTANT ? ",\"s\":\"t\"" : "",
+                     (unsigned int)rec->arg);
+            serial_write_blocking(line);
+            written++;
+        }
+    }
+    
+    serial_write_blocking("]}\n");
+    
+    if (was_on) trace_enable(1);
+    return written;
+}
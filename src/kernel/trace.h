@@ -0,0 +1,66 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include "kernel/jump_label.h"
+
+#define TRACE_BUFFER_SIZE   2048    // Records per CPU, power of two
+
+// Chrome trace-event phases
+#define TRACE_BEGIN         'B'
+#define TRACE_END           'E'
+#define TRACE_INSTANT       'i'
+
+// A static tracepoint. The key must stay the first member: trace sites
+// reference the tracepoint symbol itself as the static key.
+typedef struct tracepoint {
+    static_key_t key;
+    const char* name;
+} tracepoint_t;
+
+typedef struct {
+    uint64_t tsc;
+    const tracepoint_t* tp;
+    uint32_t arg;
+    uint8_t phase;
+    uint8_t cpu;
+} trace_record_t;
+
+#define DEFINE_TRACEPOINT(tpname)                                           \
+    tracepoint_t __tracepoint_##tpname                                      \
+    __attribute__((section("__tracepoints"), aligned(8), used)) =           \
+    { STATIC_KEY_INIT_FALSE, #tpname }
+
+#define DECLARE_TRACEPOINT(tpname) extern tracepoint_t __tracepoint_##tpname
+
+// Trace sites: a single NOP until tracing is switched on
+#define trace_event(tpname, phase, arg) do {                                \
+    if (static_branch_unlikely(__tracepoint_##tpname)) {                    \
+        trace_emit(&__tracepoint_##tpname, (phase), (arg));                 \
+    }                                                                       \
+} while (0)
+
+#define trace_begin(tpname, arg)    trace_event(tpname, TRACE_BEGIN, arg)
+#define trace_end(tpname, arg)      trace_event(tpname, TRACE_END, arg)
+#define trace_instant(tpname, arg)  trace_event(tpname, TRACE_INSTANT, arg)
+
+// Append a record to this CPU's ring (lock-free, IRQ-safe, overwrites
+// the oldest records once full)
+void trace_emit(const tracepoint_t* tp, uint8_t phase, uint32_t arg);
+
+// Switch every tracepoint on or off
+void trace_enable(int enable);
+int trace_enabled(void);
+
+// Drop all buffered records
+void trace_clear(void);
+
+// Records currently buffered across CPUs
+uint64_t trace_record_count(void);
+int tracepoint_count(void);
+
+// Stream the buffers to serial as Chrome trace-event JSON. Tracing is
+// paused while dumping. Returns the number of events written.
+uint32_t trace_dump_chrome(void);
+
+#endif
@@ -0,0 +1,99 @@
+#include "tsc.h"
+#include "kernel/cpuid.h"
+#include "kernel/hpet.h"
+#include "kernel/clocksource.h"
+#include "kernel/timer.h"
+#include "lib/io.h"
+
+#define CALIBRATE_MS        10
+
+uint64_t tsc_khz = 0;
+
+static uint64_t tsc_clocksource_read(void) {
+    return rdtsc();
+}
+
+static clocksource_t tsc_clocksource = {
+    .name = "tsc",
+    .read = tsc_clocksource_read,
+    .mask = ~0ULL,
+};
+
+// Count TSC cycles across CALIBRATE_MS of HPET time
+static uint64_t tsc_calibrate_hpet(void) {
+    uint64_t mask = hpet_counter_mask();
+    uint64_t ticks = hpet_ns_to_ticks(CALIBRATE_MS * 1000000ULL);
+    
+    uint64_t hpet_start = hpet_read_counter();
+    uint64_t tsc_start = rdtsc();
+    while (((hpet_read_counter() - hpet_start) & mask) < ticks);
+    uint64_t tsc_end = rdtsc();
+    
+    return (tsc_end - tsc_start) / CALIBRATE_MS;
+}
+
+// Count TSC cycles while PIT channel 2 counts down CALIBRATE_MS in mode 0.
+// Channel 2 is gated through port 0x61 and doesn't disturb the IRQ0 tick.
+static uint64_t tsc_calibrate_pit(void) {
+    uint16_t latch = PIT_FREQUENCY / (1000 / CALIBRATE_MS);
+    
+    // Gate high, speaker off
+    outb(0x61, (inb(0x61) & ~0x02) | 0x01);
+    
+    // Channel 2, lobyte/hibyte, mode 0 (interrupt on terminal count)
+    outb(0x43, 0xB0);
+    outb(0x42, latch & 0xFF);
+    outb(0x42, latch >> 8);
+    
+    uint64_t tsc_start = rdtsc();
+    while (!(inb(0x61) & 0x20));   // OUT2 goes high at terminal count
+    uint64_t tsc_end = rdtsc();
+    
+    return (tsc_end - tsc_start) / CALIBRATE_MS;
+}
+
+void tsc_init(void) {
+    if (!(cpu_info.features_edx & CPUID_FEAT_TSC)) return;
+    
+    if (hpet_available()) {
+        tsc_khz = tsc_calibrate_hpet();
+    } else {
+        tsc_khz = tsc_calibrate_pit();
+    }
+    
+    if (tsc_khz == 0) return;
+    
+    // An invariant TSC is the cheapest good clock; otherwise prefer the HPET
+    tsc_clocksource.freq_hz = tsc_khz * 1000;
+    tsc_clocksource.rating = tsc_is_stable() ? 300 : 100;
+    clocksource_register(&tsc_clocksource);
+}
+
+uint64_t tsc_cycles_to_ns(uint64_t cycles) {
+    if (tsc_khz == 0) return 0;
+    return (cycles / tsc_khz) * 1000000ULL + ((cycles % tsc_khz) * 1000000ULL) / tsc_khz;
+}
+
+int tsc_is_stable(void) {
+    return (cpu_info.power_edx & CPUID_FEAT_PM_INVARIANT_TSC) != 0;
+}
+
+void ndelay(uint64_t ns) {
+    if (tsc_khz == 0) {
+        // Each write to the POST port takes about a microsecond
+        for (uint64_t us = 0; us <= ns / 1000; us++) {
+            outb(0x80, 0);
+        }
+        return;
+    }
+    
+    uint64_t cycles = ns * tsc_khz / 1000000;
+    uint64_t start = rdtsc();
+    while (rdtsc() - start < cycles) {
+        asm volatile("pause");
+    }
+}
+
+void udelay(uint64_t us) {
+    ndelay(us * 1000);
+}
@@ -0,0 +1,30 @@
+#ifndef TSC_H
+#define TSC_H
+
+#include <stdint.h>
+
+// TSC frequency in kHz (0 until tsc_init has run)
+extern uint64_t tsc_khz;
+
+// Read the Time Stamp Counter
+static inline uint64_t rdtsc(void) {
+    uint32_t lo, hi;
+    asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+// Calibrate the TSC against the HPET (or the PIT if there is no HPET)
+// and register it as a clocksource
+void tsc_init(void);
+
+// Convert a cycle count to nanoseconds
+uint64_t tsc_cycles_to_ns(uint64_t cycles);
+
+// Nonzero if the TSC rate is invariant across P/C-states
+int tsc_is_stable(void);
+
+// Busy-wait for short hardware delays (rough port-I/O timing until calibrated)
+void ndelay(uint64_t ns);
+void udelay(uint64_t us);
+
+#endif
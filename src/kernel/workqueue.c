@@ -0,0 +1,80 @@
+#include "workqueue.h"
+#include <stddef.h>
+#include "kernel/irqflags.h"
+#include "kernel/clocksource.h"
+
+// There is no scheduler yet, so a queue's "worker" is whoever calls
+// workqueue_run: kmain's loop drains system_wq between frames.
+
+workqueue_t system_wq = { "events", NULL, &system_wq.head, 0, 0, 0 };
+
+void init_work(work_t* work, void (*func)(work_t*)) {
+    work->next = NULL;
+    work->func = func;
+    work->pending = 0;
+    work->queued_ns = 0;
+}
+
+void workqueue_init(workqueue_t* wq, const char* name) {
+    wq->name = name;
+    wq->head = NULL;
+    wq->tail = &wq->head;
+    wq->queued = 0;
+    wq->completed = 0;
+    wq->max_latency_ns = 0;
+}
+
+int queue_work(workqueue_t* wq, work_t* work) {
+    uint64_t flags = local_irq_save();
+    
+    if (work->pending) {
+        local_irq_restore(flags);
+        return 0;
+    }
+    
+    work->pending = 1;
+    work->next = NULL;
+    work->queued_ns = clocksource_read_ns();
+    *wq->tail = work;
+    wq->tail = &work->next;
+    wq->queued++;
+    
+    local_irq_restore(flags);
+    return 1;
+}
+
+int schedule_work(work_t* work) {
+    return queue_work(&system_wq, work);
+}
+
+int workqueue_run(workqueue_t* wq) {
+    int ran = 0;
+    
+    while (1) {
+        uint64_t flags = local_irq_save();
+        work_t* work = wq->head;
+        if (!work) {
+            local_irq_restore(flags);
+            break;
+        }
+        
+        wq->head = work->next;
+        if (!wq->head) wq->tail = &wq->head;
+        
+        uint64_t latency = clocksource_read_ns() - work->queued_ns;
+        if (latency > wq->max_latency_ns) {
+            wq->max_latency_ns = latency;
+        }
+        
+        // Clear pending before running so the work can requeue itself
+        work->next = NULL;
+        work->pending = 0;
+        local_irq_restore(flags);
+        
+        work->func(work);
+        wq->completed++;
+        ran++;
+    }
+    
+    return ran;
+}
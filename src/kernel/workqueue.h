@@ -0,0 +1,42 @@
+#ifndef WORKQUEUE_H
+#define WORKQUEUE_H
+
+#include <stdint.h>
+
+// Deferred work that runs in process context with interrupts enabled,
+// so it may block (sleep_ns, polling hardware, long terminal output).
+typedef struct work_struct {
+    struct work_struct* next;
+    void (*func)(struct work_struct* work);
+    volatile int pending;
+    uint64_t queued_ns;        // When it was last queued
+} work_t;
+
+typedef struct workqueue {
+    const char* name;
+    work_t* head;
+    work_t** tail;
+    uint32_t queued;
+    uint32_t completed;
+    uint64_t max_latency_ns;   // Longest wait between queueing and running
+} workqueue_t;
+
+// Default queue serviced by the kernel's idle loop
+extern workqueue_t system_wq;
+
+void init_work(work_t* work, void (*func)(work_t*));
+void workqueue_init(workqueue_t* wq, const char* name);
+
+// Queue work; returns 0 if it was already pending. Safe from IRQ context.
+int queue_work(workqueue_t* wq, work_t* work);
+int schedule_work(work_t* work);
+
+static inline int work_pending(work_t* work) {
+    return work->pending;
+}
+
+// Worker body: run everything queued on wq. Must be called from process
+// context (never from an IRQ or softirq). Returns the number of items run.
+int workqueue_run(workqueue_t* wq);
+
+#endif
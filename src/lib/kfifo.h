@@ -0,0 +1,46 @@
+#ifndef KFIFO_H
+#define KFIFO_H
+
+#include <stdint.h>
+
+// Single-producer/single-consumer byte ring, e.g. an ISR filling it and a
+// bottom half draining it. Size must be a power of two.
+#define KFIFO_SIZE 256
+
+typedef struct {
+    uint8_t data[KFIFO_SIZE];
+    volatile uint32_t head;     // Next write (producer)
+    volatile uint32_t tail;     // Next read (consumer)
+    uint32_t dropped;           // Bytes lost to a full ring
+} kfifo_t;
+
+static inline void kfifo_init(kfifo_t* fifo) {
+    fifo->head = 0;
+    fifo->tail = 0;
+    fifo->dropped = 0;
+}
+
+static inline int kfifo_put(kfifo_t* fifo, uint8_t byte) {
+    if (fifo->head - fifo->tail >= KFIFO_SIZE) {
+        fifo->dropped++;
+        return 0;
+    }
+    fifo->data[fifo->head & (KFIFO_SIZE - 1)] = byte;
+    asm volatile("" : : : "memory");   // Publish data before the index
+    fifo->head++;
+    return 1;
+}
+
+static inline int kfifo_get(kfifo_t* fifo, uint8_t* byte) {
+    if (fifo->tail == fifo->head) return 0;
+    *byte = fifo->data[fifo->tail & (KFIFO_SIZE - 1)];
+    asm volatile("" : : : "memory");
+    fifo->tail++;
+    return 1;
+}
+
+static inline uint32_t kfifo_len(kfifo_t* fifo) {
+    return fifo->head - fifo->tail;
+}
+
+#endif
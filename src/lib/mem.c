@@ -0,0 +1,245 @@
+#include "mem.h"
+#include "lib/string.h"
+#include "kernel/cpuid.h"
+#include "kernel/fpu.h"
+
+// Below this the aligned head and the FPU section cost more than the
+// cache pollution they avoid
+#define MEM_STREAM_MIN 256
+
+// Unaligned 64-bit access that may alias anything
+typedef uint64_t __attribute__((may_alias, aligned(1))) mem_word_t;
+
+enum { MEM_IMPL_UNROLLED, MEM_IMPL_ERMS, MEM_IMPL_SSE2_NT, MEM_IMPL_AVX2_NT };
+
+static mem_impl_t mem_impls[] = {
+    { "unrolled", memcpy_unrolled, memset_unrolled, 1 },
+    { "erms", memcpy_erms, memset_erms, 0 },
+    { "sse2_nt", memcpy_sse2_nt, memset_sse2_nt, 0 },
+    { "avx2_nt", memcpy_avx2_nt, memset_avx2_nt, 0 },
+};
+
+// Dispatch state: the portable loops until mem_dispatch_init runs
+static const mem_impl_t* mem_rep = &mem_impls[MEM_IMPL_UNROLLED];
+static const mem_impl_t* mem_large = &mem_impls[MEM_IMPL_UNROLLED];
+static size_t copy_rep_threshold = SIZE_MAX;
+static size_t set_rep_threshold = SIZE_MAX;
+static size_t nt_threshold = SIZE_MAX;
+
+// Each block is loaded completely before it is stored, so copying forward
+// is also safe when dest overlaps the tail of src (memmove relies on this)
+void* memcpy_unrolled(void* dest, const void* src, size_t n) {
+    unsigned char* d = (unsigned char*)dest;
+    const unsigned char* s = (const unsigned char*)src;
+    
+    while (n >= 64) {
+        const mem_word_t* sw = (const mem_word_t*)s;
+        mem_word_t* dw = (mem_word_t*)d;
+        uint64_t w0 = sw[0], w1 = sw[1], w2 = sw[2], w3 = sw[3];
+        uint64_t w4 = sw[4], w5 = sw[5], w6 = sw[6], w7 = sw[7];
+        dw[0] = w0; dw[1] = w1; dw[2] = w2; dw[3] = w3;
+        dw[4] = w4; dw[5] = w5; dw[6] = w6; dw[7] = w7;
+        d += 64;
+        s += 64;
+        n -= 64;
+    }
+    while (n >= 8) {
+        *(mem_word_t*)d = *(const mem_word_t*)s;
+        d += 8;
+        s += 8;
+        n -= 8;
+    }
+    while (n--) *d++ = *s++;
+    return dest;
+}
+
+void* memset_unrolled(void* dest, int val, size_t n) {
+    unsigned char* d = (unsigned char*)dest;
+    uint64_t pattern = 0x0101010101010101ULL * (unsigned char)val;
+    
+    while (n >= 64) {
+        mem_word_t* dw = (mem_word_t*)d;
+        dw[0] = pattern; dw[1] = pattern; dw[2] = pattern; dw[3] = pattern;
+        dw[4] = pattern; dw[5] = pattern; dw[6] = pattern; dw[7] = pattern;
+        d += 64;
+        n -= 64;
+    }
+    while (n >= 8) {
+        *(mem_word_t*)d = pattern;
+        d += 8;
+        n -= 8;
+    }
+    while (n--) *d++ = (unsigned char)val;
+    return dest;
+}
+
+// Mirror image of memcpy_unrolled for dest above an overlapping src
+static void* memcpy_backward(void* dest, const void* src, size_t n) {
+    unsigned char* d = (unsigned char*)dest + n;
+    const unsigned char* s = (const unsigned char*)src + n;
+    
+    while (n >= 64) {
+        d -= 64;
+        s -= 64;
+        n -= 64;
+        const mem_word_t* sw = (const mem_word_t*)s;
+        mem_word_t* dw = (mem_word_t*)d;
+        uint64_t w0 = sw[0], w1 = sw[1], w2 = sw[2], w3 = sw[3];
+        uint64_t w4 = sw[4], w5 = sw[5], w6 = sw[6], w7 = sw[7];
+        dw[7] = w7; dw[6] = w6; dw[5] = w5; dw[4] = w4;
+        dw[3] = w3; dw[2] = w2; dw[1] = w1; dw[0] = w0;
+    }
+    while (n >= 8) {
+        d -= 8;
+        s -= 8;
+        n -= 8;
+        *(mem_word_t*)d = *(const mem_word_t*)s;
+    }
+    while (n--) *--d = *--s;
+    return dest;
+}
+
+// Fast strings: microcode moves whole cache lines once the count is large
+// enough (ERMS), and short counts are cheap too with FSRM
+void* memcpy_erms(void* dest, const void* src, size_t n) {
+    void* d = dest;
+    asm volatile("rep movsb" : "+D"(d), "+S"(src), "+c"(n) : : "memory");
+    return dest;
+}
+
+void* memset_erms(void* dest, int val, size_t n) {
+    void* d = dest;
+    asm volatile("rep stosb" : "+D"(d), "+c"(n) : "a"(val) : "memory");
+    return dest;
+}
+
+// Copy up to a cache-line boundary in dest, stream whole lines with
+// non-temporal stores, then finish the tail
+static void* mem_stream_copy(void* dest, const void* src, size_t n,
+                             void (*stream)(void*, const void*, size_t)) {
+    if (n < MEM_STREAM_MIN || !may_use_simd()) return memcpy_unrolled(dest, src, n);
+    
+    unsigned char* d = (unsigned char*)dest;
+    const unsigned char* s = (const unsigned char*)src;
+    size_t head = (0 - (uintptr_t)d) & 63;
+    memcpy_unrolled(d, s, head);
+    d += head;
+    s += head;
+    n -= head;
+    
+    kernel_fpu_begin();
+    stream(d, s, n / 64);
+    kernel_fpu_end();
+    
+    memcpy_unrolled(d + (n & ~(size_t)63), s + (n & ~(size_t)63), n & 63);
+    return dest;
+}
+
+static void* mem_stream_set(void* dest, int val, size_t n,
+                            void (*stream)(void*, int, size_t)) {
+    if (n < MEM_STREAM_MIN || !may_use_simd()) return memset_unrolled(dest, val, n);
+    
+    unsigned char* d = (unsigned char*)dest;
+    size_t head = (0 - (uintptr_t)d) & 63;
+    memset_unrolled(d, val, head);
+    d += head;
+    n -= head;
+    
+    kernel_fpu_begin();
+    stream(d, val, n / 64);
+    kernel_fpu_end();
+    
+    memset_unrolled(d + (n & ~(size_t)63), val, n & 63);
+    return dest;
+}
+
+void* memcpy_sse2_nt(void* dest, const void* src, size_t n) {
+    return mem_stream_copy(dest, src, n, mem_stream_copy_sse2);
+}
+
+void* memset_sse2_nt(void* dest, int val, size_t n) {
+    return mem_stream_set(dest, val, n, mem_stream_set_sse2);
+}
+
+void* memcpy_avx2_nt(void* dest, const void* src, size_t n) {
+    return mem_stream_copy(dest, src, n, mem_stream_copy_avx2);
+}
+
+void* memset_avx2_nt(void* dest, int val, size_t n) {
+    return mem_stream_set(dest, val, n, mem_stream_set_avx2);
+}
+
+void mem_dispatch_init(void) {
+    int erms = (cpu_info.features7_ebx & CPUID_FEAT7_EBX_ERMS) != 0;
+    int fsrm = (cpu_info.features7_edx & CPUID_FEAT7_EDX_FSRM) != 0;
+    
+    mem_impls[MEM_IMPL_ERMS].supported = erms;
+    mem_impls[MEM_IMPL_SSE2_NT].supported = fpu_available();
+    mem_impls[MEM_IMPL_AVX2_NT].supported =
+        fpu_has_avx() && (cpu_info.features7_ebx & CPUID_FEAT7_EBX_AVX2);
+    
+    if (erms) {
+        mem_rep = &mem_impls[MEM_IMPL_ERMS];
+        copy_rep_threshold = fsrm ? 0 : MEM_REP_THRESHOLD;
+        set_rep_threshold = MEM_REP_THRESHOLD;
+    }
+    
+    mem_large = mem_rep;
+    if (mem_impls[MEM_IMPL_AVX2_NT].supported) {
+        mem_large = &mem_impls[MEM_IMPL_AVX2_NT];
+    } else if (mem_impls[MEM_IMPL_SSE2_NT].supported) {
+        mem_large = &mem_impls[MEM_IMPL_SSE2_NT];
+    }
+    nt_threshold = mem_large == mem_rep ? SIZE_MAX : MEM_NT_THRESHOLD;
+    
+    // Without ERMS the middle range is the unrolled loop as well
+    if (!erms) {
+        copy_rep_threshold = nt_threshold;
+        set_rep_threshold = nt_threshold;
+    }
+}
+
+int mem_impl_count(void) {
+    return sizeof(mem_impls) / sizeof(mem_impls[0]);
+}
+
+const mem_impl_t* mem_impl_get(int index) {
+    if (index < 0 || index >= mem_impl_count()) return NULL;
+    return &mem_impls[index];
+}
+
+const mem_impl_t* mem_dispatch_copy(size_t n) {
+    if (n >= nt_threshold) return mem_large;
+    if (n >= copy_rep_threshold) return mem_rep;
+    return &mem_impls[MEM_IMPL_UNROLLED];
+}
+
+const mem_impl_t* mem_dispatch_set(size_t n) {
+    if (n >= nt_threshold) return mem_large;
+    if (n >= set_rep_threshold) return mem_rep;
+    return &mem_impls[MEM_IMPL_UNROLLED];
+}
+
+void* memcpy(void* dest, const void* src, size_t n) {
+    if (n < copy_rep_threshold) return memcpy_unrolled(dest, src, n);
+    if (n < nt_threshold) return mem_rep->copy(dest, src, n);
+    return mem_large->copy(dest, src, n);
+}
+
+void* memset(void* dest, int val, size_t count) {
+    if (count < set_rep_threshold) return memset_unrolled(dest, val, count);
+    if (count < nt_threshold) return mem_rep->set(dest, val, count);
+    return mem_large->set(dest, val, count);
+}
+
+void* memmove(void* dest, const void* src, size_t n) {
+    uintptr_t d = (uintptr_t)dest;
+    uintptr_t s = (uintptr_t)src;
+    
+    // No overlap: any memcpy variant will do
+    if (d + n <= s || s + n <= d) return memcpy(dest, src, n);
+    
+    if (d < s) return memcpy_unrolled(dest, src, n);
+    if (d > s) return memcpy_backward(dest, src, n);
+    return dest;
+}
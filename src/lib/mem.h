@@ -0,0 +1,56 @@
+#ifndef MEM_H
+#define MEM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// memcpy/memset pick an implementation by size. Until mem_dispatch_init()
+// runs everything goes through the portable unrolled loops; afterwards:
+//   n >= mem_nt_threshold   non-temporal SIMD (bypasses the cache)
+//   n >= mem_rep_threshold  rep movsb/stosb on ERMS CPUs
+//   otherwise               unrolled 64-bit loops
+// memmove uses the unrolled loops in whichever direction is safe.
+
+#define MEM_REP_THRESHOLD   128         // rep startup beats loops from here (ERMS)
+#define MEM_NT_THRESHOLD    0x100000    // Larger copies would evict the L2
+
+typedef struct {
+    const char* name;
+    void* (*copy)(void* dest, const void* src, size_t n);
+    void* (*set)(void* dest, int val, size_t n);
+    int supported;          // Set by mem_dispatch_init
+} mem_impl_t;
+
+// Select implementations from cpu_info (after cpuid_init and fpu_init)
+void mem_dispatch_init(void);
+
+// Every implementation, supported or not (tests and benchmarks)
+int mem_impl_count(void);
+const mem_impl_t* mem_impl_get(int index);
+
+// Implementation memcpy (or memset) uses for a size
+const mem_impl_t* mem_dispatch_copy(size_t n);
+const mem_impl_t* mem_dispatch_set(size_t n);
+
+// Portable variants
+void* memcpy_unrolled(void* dest, const void* src, size_t n);
+void* memset_unrolled(void* dest, int val, size_t n);
+void* memcpy_erms(void* dest, const void* src, size_t n);
+void* memset_erms(void* dest, int val, size_t n);
+
+// Non-temporal SIMD variants. They enter a kernel FPU section themselves
+// and fall back to the unrolled loops where SIMD can't be used.
+void* memcpy_sse2_nt(void* dest, const void* src, size_t n);
+void* memset_sse2_nt(void* dest, int val, size_t n);
+void* memcpy_avx2_nt(void* dest, const void* src, size_t n);
+void* memset_avx2_nt(void* dest, int val, size_t n);
+
+// Streaming loops behind them (lib/mem_simd.c): whole 64-byte blocks to a
+// 64-byte aligned dest, ending with sfence. Only call between
+// kernel_fpu_begin() and kernel_fpu_end().
+void mem_stream_copy_sse2(void* dest, const void* src, size_t blocks);
+void mem_stream_set_sse2(void* dest, int val, size_t blocks);
+void mem_stream_copy_avx2(void* dest, const void* src, size_t blocks);
+void mem_stream_set_avx2(void* dest, int val, size_t blocks);
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef MEM_BENCH_H
+#define MEM_BENCH_H
+
+// memcpy/memset throughput from 16B to 8MiB with the implementation the
+// dispatcher picks for each size, one line per size
+void mem_bench_table(void (*print)(const char* line));
+
+#endif
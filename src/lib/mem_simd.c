@@ -0,0 +1,69 @@
+#include "mem.h"
+
+// Built with SSE2 (see SIMD_CFLAGS in the Makefile); the AVX2 loops opt in
+// per function. Everything here runs inside kernel_fpu_begin/end.
+
+typedef long long v2di __attribute__((vector_size(16)));
+typedef long long v2di_u __attribute__((vector_size(16), aligned(1), may_alias));
+typedef long long v4di __attribute__((vector_size(32)));
+typedef long long v4di_u __attribute__((vector_size(32), aligned(1), may_alias));
+
+void mem_stream_copy_sse2(void* dest, const void* src, size_t blocks) {
+    v2di* d = (v2di*)dest;
+    const v2di_u* s = (const v2di_u*)src;
+    
+    while (blocks--) {
+        v2di a = s[0], b = s[1], c = s[2], e = s[3];
+        __builtin_ia32_movntdq(&d[0], a);
+        __builtin_ia32_movntdq(&d[1], b);
+        __builtin_ia32_movntdq(&d[2], c);
+        __builtin_ia32_movntdq(&d[3], e);
+        d += 4;
+        s += 4;
+    }
+    __builtin_ia32_sfence();
+}
+
+void mem_stream_set_sse2(void* dest, int val, size_t blocks) {
+    v2di* d = (v2di*)dest;
+    long long pattern = 0x0101010101010101LL * (unsigned char)val;
+    v2di v = { pattern, pattern };
+    
+    while (blocks--) {
+        __builtin_ia32_movntdq(&d[0], v);
+        __builtin_ia32_movntdq(&d[1], v);
+        __builtin_ia32_movntdq(&d[2], v);
+        __builtin_ia32_movntdq(&d[3], v);
+        d += 4;
+    }
+    __builtin_ia32_sfence();
+}
+
+__attribute__((target("avx2")))
+void mem_stream_copy_avx2(void* dest, const void* src, size_t blocks) {
+    v4di* d = (v4di*)dest;
+    const v4di_u* s = (const v4di_u*)src;
+    
+    while (blocks--) {
+        v4di a = s[0], b = s[1];
+        __builtin_ia32_movntdq256(&d[0], a);
+        __builtin_ia32_movntdq256(&d[1], b);
+        d += 2;
+        s += 2;
+    }
+    __builtin_ia32_sfence();
+}
+
+__attribute__((target("avx2")))
+void mem_stream_set_avx2(void* dest, int val, size_t blocks) {
+    v4di* d = (v4di*)dest;
+    long long pattern = 0x0101010101010101LL * (unsigned char)val;
+    v4di v = { pattern, pattern, pattern, pattern };
+    
+    while (blocks--) {
+        __builtin_ia32_movntdq256(&d[0], v);
+        __builtin_ia32_movntdq256(&d[1], v);
+        d += 2;
+    }
+    __builtin_ia32_sfence();
+}
@@ -1,128 +1,322 @@
 #include "printf.h"
-#include "vga.h"
+#include "drivers/video/vga.h"
+#include "drivers/char/serial.h"
 #include "string.h"
 #include <stdarg.h>
 #include <stdint.h>
 
-// Helper to print a number
-static void print_num(char* buf, int* pos, unsigned int num, int base, int uppercase) {
-    char digits_lower[] = "0123456789abcdef";
-    char digits_upper[] = "0123456789ABCDEF";
-    char* digits = uppercase ? digits_upper : digits_lower;
-    
-    char temp[32];
-    int i = 0;
+// Conversion flags
+#define FMT_LEFT    (1 << 0)    // '-'
+#define FMT_ZERO    (1 << 1)    // '0'
+#define FMT_PLUS    (1 << 2)    // '+'
+#define FMT_SPACE   (1 << 3)    // ' '
+#define FMT_ALT     (1 << 4)    // '#'
+#define FMT_UPPER   (1 << 5)    // %X
+#define FMT_SIGNED  (1 << 6)    // %d / %i
+#define FMT_PTR     (1 << 7)    // %p: 0x even for NULL
+
+// Largest number: 64 bits in octal (22 digits)
+#define FMT_NUM_MAX 24
+
+// "00" "01" ... "99": two decimal digits per division
+static const char digit_pairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// Output cursor: writes past the end are counted but dropped, so the
+// return value is the length the whole string would have had
+typedef struct {
+    char* buf;
+    size_t size;
+    size_t pos;
+} fmt_out_t;
+
+static inline void out_char(fmt_out_t* out, char c) {
+    if (out->pos < out->size) out->buf[out->pos] = c;
+    out->pos++;
+}
+
+static void out_repeat(fmt_out_t* out, char c, int count) {
+    while (count-- > 0) out_char(out, c);
+}
+
+static void out_mem(fmt_out_t* out, const char* str, size_t len) {
+    if (out->pos < out->size) {
+        size_t room = out->size - out->pos;
+        memcpy(out->buf + out->pos, str, len < room ? len : room);
+    }
+    out->pos += len;
+}
+
+char* fmt_u64_dec(char* end, uint64_t value) {
+    char* p = end;
     
-    if (num == 0) {
-        temp[i++] = '0';
+    while (value >= 100) {
+        uint32_t pair = (uint32_t)(value % 100) * 2;
+        value /= 100;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    }
+    if (value >= 10) {
+        *--p = digit_pairs[value * 2 + 1];
+        *--p = digit_pairs[value * 2];
     } else {
-        while (num > 0) {
-            temp[i++] = digits[num % base];
-            num /= base;
-        }
+        *--p = '0' + (char)value;
     }
+    return p;
+}
+
+static char* fmt_u64_base(char* end, uint64_t value, int shift, int upper) {
+    const char* digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    uint64_t mask = (1u << shift) - 1;
+    char* p = end;
+    
+    do {
+        *--p = digits[value & mask];
+        value >>= shift;
+    } while (value);
+    return p;
+}
+
+// One integer conversion with its sign, prefix, precision and padding
+static void out_number(fmt_out_t* out, uint64_t value, int negative, int base,
+                       int flags, int width, int precision) {
+    char num[FMT_NUM_MAX];
+    char* end = num + sizeof(num);
+    char* digits;
+    
+    if (base == 10) digits = fmt_u64_dec(end, value);
+    else digits = fmt_u64_base(end, value, base == 16 ? 4 : 3, flags & FMT_UPPER);
+    
+    int len = end - digits;
+    
+    // "%.0d" of zero prints nothing
+    if (precision == 0 && value == 0) len = 0;
+    
+    const char* prefix = "";
+    if (flags & FMT_SIGNED) {
+        if (negative) prefix = "-";
+        else if (flags & FMT_PLUS) prefix = "+";
+        else if (flags & FMT_SPACE) prefix = " ";
+    } else if (flags & FMT_PTR) {
+        prefix = "0x";
+    } else if ((flags & FMT_ALT) && base == 16) {
+        if (value != 0) prefix = (flags & FMT_UPPER) ? "0X" : "0x";
+    } else if ((flags & FMT_ALT) && base == 8) {
+        // '#' only guarantees a leading zero, so "%#.0o" of zero is "0"
+        if (len == 0 || (value != 0 && precision <= len)) prefix = "0";
+    }
+    int prefix_len = strlen(prefix);
+    
+    // Zero padding is precision in disguise (and ignored when one is given)
+    if (precision < 0 && (flags & FMT_ZERO) && !(flags & FMT_LEFT)) {
+        precision = width - prefix_len;
+    }
+    int zeros = precision > len ? precision - len : 0;
+    int pad = width - prefix_len - zeros - len;
+    
+    if (!(flags & FMT_LEFT)) out_repeat(out, ' ', pad);
+    out_mem(out, prefix, prefix_len);
+    out_repeat(out, '0', zeros);
+    out_mem(out, digits, len);
+    if (flags & FMT_LEFT) out_repeat(out, ' ', pad);
+}
+
+static void out_string(fmt_out_t* out, const char* str, int flags, int width, int precision) {
+    if (!str) str = "(null)";
     
-    // Reverse
-    while (i > 0) {
-        buf[(*pos)++] = temp[--i];
+    size_t len = precision >= 0 ? strnlen(str, precision) : strlen(str);
+    int pad = width - (int)len;
+    
+    if (!(flags & FMT_LEFT)) out_repeat(out, ' ', pad);
+    out_mem(out, str, len);
+    if (flags & FMT_LEFT) out_repeat(out, ' ', pad);
+}
+
+// Length modifiers
+enum { LEN_INT, LEN_CHAR, LEN_SHORT, LEN_LONG, LEN_LLONG, LEN_SIZE };
+
+static uint64_t arg_unsigned(va_list* args, int length) {
+    switch (length) {
+    case LEN_CHAR:  return (unsigned char)va_arg(*args, unsigned int);
+    case LEN_SHORT: return (unsigned short)va_arg(*args, unsigned int);
+    case LEN_LONG:  return va_arg(*args, unsigned long);
+    case LEN_LLONG: return va_arg(*args, unsigned long long);
+    case LEN_SIZE:  return va_arg(*args, size_t);
+    default:        return va_arg(*args, unsigned int);
     }
 }
 
-// Core formatting function
-static void do_printf(char* output, const char* fmt, va_list args) {
-    int pos = 0;
+static int64_t arg_signed(va_list* args, int length) {
+    switch (length) {
+    case LEN_CHAR:  return (signed char)va_arg(*args, int);
+    case LEN_SHORT: return (short)va_arg(*args, int);
+    case LEN_LONG:  return va_arg(*args, long);
+    case LEN_LLONG: return va_arg(*args, long long);
+    case LEN_SIZE:  return (int64_t)va_arg(*args, size_t);
+    default:        return va_arg(*args, int);
+    }
+}
+
+// Core formatting function: C99 conversions d i u x X o p s c %, flags
+// "-0+ #", width and precision (numbers or *), and hh h l ll z t j.
+// Always NUL-terminates when size > 0.
+int vsnprintf(char* buf, size_t size, const char* fmt, va_list args) {
+    fmt_out_t out = { buf, size ? size - 1 : 0, 0 };
+    va_list ap;
+    va_copy(ap, args);
     
     while (*fmt) {
-        if (*fmt == '%') {
-            fmt++;
-            switch (*fmt) {
-                case 'd':
-                case 'i': {
-                    int num = va_arg(args, int);
-                    if (num < 0) {
-                        output[pos++] = '-';
-                        num = -num;
-                    }
-                    print_num(output, &pos, num, 10, 0);
-                    break;
-                }
-                case 'u': {
-                    unsigned int num = va_arg(args, unsigned int);
-                    print_num(output, &pos, num, 10, 0);
-                    break;
-                }
-                case 'x': {
-                    unsigned int num = va_arg(args, unsigned int);
-                    print_num(output, &pos, num, 16, 0);
-                    break;
-                }
-                case 'X': {
-                    unsigned int num = va_arg(args, unsigned int);
-                    print_num(output, &pos, num, 16, 1);
-                    break;
-                }
-                case 'p': {
-                    output[pos++] = '0';
-                    output[pos++] = 'x';
-                    void* ptr = va_arg(args, void*);
-                    print_num(output, &pos, (unsigned int)ptr, 16, 0);
-                    break;
-                }
-                case 's': {
-                    char* str = va_arg(args, char*);
-                    if (!str) str = "(null)";
-                    while (*str) {
-                        output[pos++] = *str++;
-                    }
-                    break;
-                }
-                case 'c': {
-                    char c = (char)va_arg(args, int);
-                    output[pos++] = c;
-                    break;
-                }
-                case '%': {
-                    output[pos++] = '%';
-                    break;
-                }
-                default:
-                    output[pos++] = '%';
-                    output[pos++] = *fmt;
-                    break;
+        // Copy literal runs in one go
+        const char* run = fmt;
+        while (*fmt && *fmt != '%') fmt++;
+        if (fmt != run) out_mem(&out, run, fmt - run);
+        if (!*fmt) break;
+        fmt++;
+        
+        int flags = 0;
+        for (;; fmt++) {
+            if (*fmt == '-') flags |= FMT_LEFT;
+            else if (*fmt == '0') flags |= FMT_ZERO;
+            else if (*fmt == '+') flags |= FMT_PLUS;
+            else if (*fmt == ' ') flags |= FMT_SPACE;
+            else if (*fmt == '#') flags |= FMT_ALT;
+            else break;
+        }
+        
+        int width = 0;
+        if (*fmt == '*') {
+            width = va_arg(ap, int);
+            if (width < 0) {
+                flags |= FMT_LEFT;
+                width = -width;
             }
+            fmt++;
         } else {
-            output[pos++] = *fmt;
+            while (*fmt >= '0' && *fmt <= '9') width = width * 10 + (*fmt++ - '0');
+        }
+        
+        int precision = -1;
+        if (*fmt == '.') {
+            fmt++;
+            precision = 0;
+            if (*fmt == '*') {
+                precision = va_arg(ap, int);
+                if (precision < 0) precision = -1;
+                fmt++;
+            } else {
+                while (*fmt >= '0' && *fmt <= '9') precision = precision * 10 + (*fmt++ - '0');
+            }
+        }
+        
+        int length = LEN_INT;
+        if (*fmt == 'h') {
+            length = LEN_SHORT;
+            if (*++fmt == 'h') {
+                length = LEN_CHAR;
+                fmt++;
+            }
+        } else if (*fmt == 'l') {
+            length = LEN_LONG;
+            if (*++fmt == 'l') {
+                length = LEN_LLONG;
+                fmt++;
+            }
+        } else if (*fmt == 'z' || *fmt == 't' || *fmt == 'j') {
+            length = *fmt == 'j' ? LEN_LLONG : LEN_SIZE;
+            fmt++;
+        }
+        
+        switch (*fmt) {
+            case 'd':
+            case 'i': {
+                int64_t num = arg_signed(&ap, length);
+                uint64_t magnitude = num < 0 ? 0 - (uint64_t)num : (uint64_t)num;
+                out_number(&out, magnitude, num < 0, 10, flags | FMT_SIGNED, width, precision);
+                break;
+            }
+            case 'u':
+                out_number(&out, arg_unsigned(&ap, length), 0, 10, flags, width, precision);
+                break;
+            case 'x':
+                out_number(&out, arg_unsigned(&ap, length), 0, 16, flags, width, precision);
+                break;
+            case 'X':
+                out_number(&out, arg_unsigned(&ap, length), 0, 16, flags | FMT_UPPER, width, precision);
+                break;
+            case 'o':
+                out_number(&out, arg_unsigned(&ap, length), 0, 8, flags, width, precision);
+                break;
+            case 'p': {
+                // Full 64-bit address, always with the 0x prefix
+                uintptr_t ptr = (uintptr_t)va_arg(ap, void*);
+                out_number(&out, ptr, 0, 16, (flags | FMT_PTR) & ~FMT_ZERO, width, precision);
+                break;
+            }
+            case 's':
+                out_string(&out, va_arg(ap, const char*), flags, width, precision);
+                break;
+            case 'c': {
+                char c = (char)va_arg(ap, int);
+                if (!(flags & FMT_LEFT)) out_repeat(&out, ' ', width - 1);
+                out_char(&out, c);
+                if (flags & FMT_LEFT) out_repeat(&out, ' ', width - 1);
+                break;
+            }
+            case '%':
+                out_char(&out, '%');
+                break;
+            case '\0':
+                fmt--;
+                break;
+            default:
+                out_char(&out, '%');
+                out_char(&out, *fmt);
+                break;
         }
         fmt++;
     }
     
-    output[pos] = '\0';
+    va_end(ap);
+    if (size) buf[out.pos < out.size ? out.pos : out.size] = '\0';
+    return (int)out.pos;
+}
+
+int snprintf(char* buf, size_t size, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(buf, size, fmt, args);
+    va_end(args);
+    return len;
 }
 
 void printf(const char* fmt, ...) {
     char buffer[512];  // Reduced from 1024 - saves stack space
     va_list args;
     va_start(args, fmt);
-    do_printf(buffer, fmt, args);
+    vsnprintf(buffer, sizeof(buffer), fmt, args);
     va_end(args);
     
     vga_print(buffer);
+    serial_write(buffer);   // Queued; the UART drains it from its IRQ
 }
 
-void sprintf(char* buf, const char* fmt, ...) {
+// Unbounded: callers size buf for the output. New code should use snprintf.
+int sprintf(char* buf, const char* fmt, ...) {
     va_list args;
     va_start(args, fmt);
-    do_printf(buf, fmt, args);
+    int len = vsnprintf(buf, SIZE_MAX, fmt, args);
     va_end(args);
+    return len;
 }
 
-void vsprintf(char* buf, const char* fmt, va_list args) {
-    do_printf(buf, fmt, args);
+int vsprintf(char* buf, const char* fmt, va_list args) {
+    return vsnprintf(buf, SIZE_MAX, fmt, args);
 }
 
 // Logging with levels
 void log_printf(enum log_level level, const char* fmt, ...) {
-    char buffer[1024];
     char final[1200];
     
     const char* level_str[] = {
@@ -133,15 +327,15 @@ void log_printf(enum log_level level, const char* fmt, ...) {
         "[FATAL] "
     };
     
+    // Level prefix + message
+    size_t len = strlen(level_str[level]);
+    memcpy(final, level_str[level], len);
+    
     va_list args;
     va_start(args, fmt);
-    do_printf(buffer, fmt, args);
+    vsnprintf(final + len, sizeof(final) - len, fmt, args);
     va_end(args);
     
-    // Combine level + message
-    strcpy(final, level_str[level]);
-    int len = strlen(final);
-    strcpy(final + len, buffer);
-    
     vga_print(final);
+    serial_write(final);
 }
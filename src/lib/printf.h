@@ -2,11 +2,26 @@
 #define PRINTF_H
 
 #include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
 
 // Formatted printing to screen
 void printf(const char* fmt, ...);
-void sprintf(char* buf, const char* fmt, ...);
-void vsprintf(char* buf, const char* fmt, va_list args);  // Added for debug.c
+
+// C99 formatting: d i u x X o p s c %, flags "-0+ #", width/precision
+// (numbers or *), and hh h l ll z t j for 64-bit values. Writes at most
+// size bytes including the NUL and returns the length the full output
+// would have had.
+int vsnprintf(char* buf, size_t size, const char* fmt, va_list args);
+int snprintf(char* buf, size_t size, const char* fmt, ...);
+
+// Unbounded versions of the above (buf must be big enough)
+int sprintf(char* buf, const char* fmt, ...);
+int vsprintf(char* buf, const char* fmt, va_list args);
+
+// Write value in decimal, two digits per division, ending just before
+// end (no NUL). Returns the first digit; needs up to 20 bytes.
+char* fmt_u64_dec(char* end, uint64_t value);
 
 // Logging levels
 enum log_level {
@@ -1,44 +1,259 @@
 #include "string.h"
 
-size_t strlen(const char* str) {
-    size_t len = 0;
-    while (str[len]) len++;
-    return len;
+#include "kernel/cpuid.h"
+#include "kernel/fpu.h"
+
+// Reads never cross into a page the string doesn't reach: aligned words
+// stay inside one page, and unaligned ones are only used when the page
+// offset leaves room for the whole load
+#define STR_PAGE_SIZE 4096
+#define STR_LOAD_FITS(p, size) \
+    ((((uintptr_t)(p)) & (STR_PAGE_SIZE - 1)) <= STR_PAGE_SIZE - (size))
+
+#define STR_ONES  0x0101010101010101ULL
+#define STR_HIGHS 0x8080808080808080ULL
+
+typedef uint64_t __attribute__((may_alias, aligned(1))) str_word_t;
+
+// Nonzero if any byte of w is zero; the lowest set bit marks the first one
+static inline uint64_t has_zero(uint64_t w) {
+    return (w - STR_ONES) & ~w & STR_HIGHS;
 }
 
-int strcmp(const char* s1, const char* s2) {
-    while (*s1 && (*s1 == *s2)) {
-        s1++;
-        s2++;
+size_t strlen_word(const char* str) {
+    uintptr_t addr = (uintptr_t)str;
+    const str_word_t* p = (const str_word_t*)(addr & ~(uintptr_t)7);
+    
+    // Bytes before str become 0xFF so they can't look like the terminator
+    uint64_t w = *p | ((1ULL << ((addr & 7) * 8)) - 1);
+    while (!has_zero(w)) w = *++p;
+    
+    return (const char*)p + (__builtin_ctzll(has_zero(w)) >> 3) - str;
+}
+
+size_t strnlen_word(const char* str, size_t max) {
+    if (max == 0) return 0;
+    
+    uintptr_t addr = (uintptr_t)str;
+    const str_word_t* p = (const str_word_t*)(addr & ~(uintptr_t)7);
+    
+    uint64_t w = *p | ((1ULL << ((addr & 7) * 8)) - 1);
+    while (!has_zero(w)) {
+        if ((size_t)((const char*)(p + 1) - str) >= max) return max;
+        w = *++p;
     }
-    return *(unsigned char*)s1 - *(unsigned char*)s2;
+    
+    size_t len = (const char*)p + (__builtin_ctzll(has_zero(w)) >> 3) - str;
+    return len < max ? len : max;
 }
 
-int strncmp(const char* s1, const char* s2, size_t n) {
-    while (n && *s1 && (*s1 == *s2)) {
-        s1++;
-        s2++;
+// Whole words while s1 is aligned and both match without a terminator;
+// bytes otherwise, which also pins down the difference inside a word
+int strcmp_word(const char* s1, const char* s2) {
+    const unsigned char* a = (const unsigned char*)s1;
+    const unsigned char* b = (const unsigned char*)s2;
+    
+    while (1) {
+        if (((uintptr_t)a & 7) == 0 && STR_LOAD_FITS(b, 8)) {
+            uint64_t wa = *(const str_word_t*)a;
+            if (wa == *(const str_word_t*)b && !has_zero(wa)) {
+                a += 8;
+                b += 8;
+                continue;
+            }
+        }
+        if (*a != *b || !*a) return *a - *b;
+        a++;
+        b++;
+    }
+}
+
+int strncmp_word(const char* s1, const char* s2, size_t n) {
+    const unsigned char* a = (const unsigned char*)s1;
+    const unsigned char* b = (const unsigned char*)s2;
+    
+    while (n) {
+        if (n >= 8 && ((uintptr_t)a & 7) == 0 && STR_LOAD_FITS(b, 8)) {
+            uint64_t wa = *(const str_word_t*)a;
+            if (wa == *(const str_word_t*)b && !has_zero(wa)) {
+                a += 8;
+                b += 8;
+                n -= 8;
+                continue;
+            }
+        }
+        if (*a != *b || !*a) return *a - *b;
+        a++;
+        b++;
         n--;
     }
-    if (n == 0) return 0;
-    return *(unsigned char*)s1 - *(unsigned char*)s2;
+    return 0;
 }
 
-char* strcpy(char* dest, const char* src) {
-    char* ret = dest;
-    while ((*dest++ = *src++));
-    return ret;
+// SSE4.2 variants. pcmpistri only needs xmm0, which is saved and restored
+// around each use; that is much cheaper than a kernel_fpu_begin() section
+// for strings that are usually a few dozen bytes, and safe inside one.
+//
+// imm 0x08: unsigned bytes, equal each. Against an all-zero xmm0 (an empty
+// string) ECX is the index of the first NUL in the block, and ZF is set
+// if there is one.
+// imm 0x18: the same, negated: ECX is the first byte that differs or where
+// only one string has ended, with CF set if there is one.
+
+size_t strlen_sse42(const char* str) {
+    const char* p = str;
+    uint64_t index;
+    uint8_t save[16];
+    
+    while ((uintptr_t)p & 15) {
+        if (!*p) return p - str;
+        p++;
+    }
+    
+    asm volatile("movdqu %%xmm0, %[save]\n\t"
+                 "pxor %%xmm0, %%xmm0\n"
+                 "1:\n\t"
+                 "pcmpistri $0x08, (%[p]), %%xmm0\n\t"
+                 "lea 16(%[p]), %[p]\n\t"
+                 "jnz 1b\n\t"
+                 "movdqu %[save], %%xmm0"
+                 : [p] "+r"(p), "=c"(index), [save] "+m"(save)
+                 :
+                 : "cc", "memory");
+    
+    return p - 16 + (uint32_t)index - str;
 }
 
-char* strncpy(char* dest, const char* src, size_t n) {
-    char* ret = dest;
-    while (n && (*dest++ = *src++)) {
-        n--;
+size_t strnlen_sse42(const char* str, size_t max) {
+    const char* p = str;
+    const char* end = str + max;
+    uint64_t index;
+    uint8_t save[16];
+    
+    while ((uintptr_t)p & 15) {
+        if (p == end || !*p) return p - str;
+        p++;
     }
-    while (n--) {
-        *dest++ = '\0';
+    
+    asm volatile("movdqu %%xmm0, %[save]\n\t"
+                 "pxor %%xmm0, %%xmm0\n"
+                 "1:\n\t"
+                 "cmp %[end], %[p]\n\t"
+                 "jae 2f\n\t"
+                 "pcmpistri $0x08, (%[p]), %%xmm0\n\t"
+                 "jz 3f\n\t"
+                 "add $16, %[p]\n\t"
+                 "jmp 1b\n"
+                 "3:\n\t"
+                 "add %%rcx, %[p]\n"
+                 "2:\n\t"
+                 "movdqu %[save], %%xmm0"
+                 : [p] "+r"(p), "=&c"(index), [save] "+m"(save)
+                 : [end] "r"(end)
+                 : "cc", "memory");
+    
+    size_t len = p - str;
+    return len < max ? len : max;
+}
+
+int strcmp_sse42(const char* s1, const char* s2) {
+    const unsigned char* a = (const unsigned char*)s1;
+    const unsigned char* b = (const unsigned char*)s2;
+    uint8_t save[16];
+    
+    while (1) {
+        if (((uintptr_t)a & 15) == 0 && STR_LOAD_FITS(b, 16)) {
+            uint32_t index;
+            uint8_t differs, ended;
+            
+            asm volatile("movdqu %%xmm0, %[save]\n\t"
+                         "movdqa (%[a]), %%xmm0\n\t"
+                         "pcmpistri $0x18, (%[b]), %%xmm0\n\t"
+                         "movdqu %[save], %%xmm0"
+                         : "=c"(index), "=@ccc"(differs), "=@ccz"(ended), [save] "+m"(save)
+                         : [a] "r"(a), [b] "r"(b)
+                         : "memory");
+            
+            if (differs) return a[index] - b[index];
+            if (ended) return 0;
+            a += 16;
+            b += 16;
+            continue;
+        }
+        if (*a != *b || !*a) return *a - *b;
+        a++;
+        b++;
     }
-    return ret;
+}
+
+// Most strings (terminal lines, commands, titles) end before the SSE4.2
+// loop has paid for its alignment prologue and register save, so the
+// first bytes are scanned a word at a time
+#define STR_SSE42_MIN 64
+
+static size_t strlen_hybrid(const char* str) {
+    size_t len = strnlen_word(str, STR_SSE42_MIN);
+    if (len < STR_SSE42_MIN) return len;
+    return STR_SSE42_MIN + strlen_sse42(str + STR_SSE42_MIN);
+}
+
+static size_t strnlen_hybrid(const char* str, size_t max) {
+    if (max <= STR_SSE42_MIN) return strnlen_word(str, max);
+    
+    size_t len = strnlen_word(str, STR_SSE42_MIN);
+    if (len < STR_SSE42_MIN) return len;
+    return STR_SSE42_MIN + strnlen_sse42(str + STR_SSE42_MIN, max - STR_SSE42_MIN);
+}
+
+// Dispatch: the word versions until string_dispatch_init runs
+static size_t (*strlen_impl)(const char*) = strlen_word;
+static size_t (*strnlen_impl)(const char*, size_t) = strnlen_word;
+static int (*strcmp_impl)(const char*, const char*) = strcmp_word;
+static int sse42_selected = 0;
+
+int string_sse42_supported(void) {
+    return fpu_available() && (cpu_info.features_ecx & CPUID_FEAT_ECX_SSE42);
+}
+
+void string_dispatch_init(void) {
+    if (!string_sse42_supported()) return;
+    
+    strlen_impl = strlen_hybrid;
+    strnlen_impl = strnlen_hybrid;
+    strcmp_impl = strcmp_sse42;
+    sse42_selected = 1;
+}
+
+const char* string_dispatch_name(void) {
+    return sse42_selected ? "sse4.2" : "word";
+}
+
+size_t strlen(const char* str) {
+    return strlen_impl(str);
+}
+
+size_t strnlen(const char* str, size_t max) {
+    return strnlen_impl(str, max);
+}
+
+int strcmp(const char* s1, const char* s2) {
+    return strcmp_impl(s1, s2);
+}
+
+int strncmp(const char* s1, const char* s2, size_t n) {
+    return strncmp_word(s1, s2, n);
+}
+
+char* strcpy(char* dest, const char* src) {
+    memcpy(dest, src, strlen(src) + 1);
+    return dest;
+}
+
+char* strncpy(char* dest, const char* src, size_t n) {
+    size_t len = strnlen(src, n);
+    memcpy(dest, src, len);
+    memset(dest + len, 0, n - len);
+    return dest;
 }
 
 void itoa(int value, char* str, int base) {
@@ -46,21 +261,21 @@ void itoa(int value, char* str, int base) {
     char* ptr1 = str;
     char tmp_char;
     int tmp_value;
-
+    
     if (base < 2 || base > 36) {
         *str = '\0';
         return;
     }
-
+    
     do {
         tmp_value = value;
         value /= base;
         *ptr++ = "zyxwvutsrqponmlkjihgfedcba9876543210123456789abcdefghijklmnopqrstuvwxyz"[35 + (tmp_value - value * base)];
     } while (value);
-
+    
     if (tmp_value < 0) *ptr++ = '-';
     *ptr-- = '\0';
-
+    
     // Reverse
     while (ptr1 < ptr) {
         tmp_char = *ptr;
@@ -68,16 +283,3 @@ void itoa(int value, char* str, int base) {
         *ptr1++ = tmp_char;
     }
 }
-
-void* memset(void* dest, int val, size_t count) {
-    unsigned char* d = (unsigned char*)dest;
-    while (count--) *d++ = (unsigned char)val;
-    return dest;
-}
-
-void* memcpy(void* dest, const void* src, size_t n) {
-    unsigned char* d = (unsigned char*)dest;
-    const unsigned char* s = (const unsigned char*)src;
-    while (n--) *d++ = *s++;
-    return dest;
-}
@@ -6,6 +6,7 @@
 
 // String length
 size_t strlen(const char* str);
+size_t strnlen(const char* str, size_t max);
 
 // String compare
 int strcmp(const char* s1, const char* s2);
@@ -18,8 +19,24 @@ char* strncpy(char* dest, const char* src, size_t n);
 // Integer to ASCII
 void itoa(int value, char* str, int base);
 
-// Memory operations
+// Memory operations (lib/mem.c; implementation chosen by CPU features)
 void* memset(void* dest, int val, size_t count);
 void* memcpy(void* dest, const void* src, size_t n);
+void* memmove(void* dest, const void* src, size_t n);
+
+// strlen/strnlen/strcmp use SSE4.2 when the CPU has it (after fpu_init
+// and cpuid_init), word-at-a-time loops before that and otherwise
+void string_dispatch_init(void);
+int string_sse42_supported(void);
+const char* string_dispatch_name(void);
+
+// Individual variants (tests and benchmarks)
+size_t strlen_word(const char* str);
+size_t strnlen_word(const char* str, size_t max);
+int strcmp_word(const char* s1, const char* s2);
+int strncmp_word(const char* s1, const char* s2, size_t n);
+size_t strlen_sse42(const char* str);
+size_t strnlen_sse42(const char* str, size_t max);
+int strcmp_sse42(const char* s1, const char* s2);
 
 #endif
@@ -0,0 +1,105 @@
+#include "lib/string.h"
+#include "lib/printf.h"
+#include "kernel/bench.h"
+
+// memcpy/memset from one cache line up to half a typical L1. The buffers
+// are page aligned so misalignment doesn't skew the results.
+#define STRING_BENCH_MAX 16384
+
+static uint8_t bench_src[STRING_BENCH_MAX] __attribute__((aligned(4096)));
+static uint8_t bench_dst[STRING_BENCH_MAX] __attribute__((aligned(4096)));
+
+static void bench_memcpy(uint64_t size) {
+    memcpy(bench_dst, bench_src, size);
+}
+
+static void bench_memset(uint64_t size) {
+    memset(bench_dst, (int)size, size);
+}
+
+// Overlapping move up by one cache line (the backward path)
+static void bench_memmove(uint64_t size) {
+    memmove(bench_dst + 64, bench_dst, size);
+}
+
+DEFINE_BENCH(bench_memcpy_64, "memcpy/64", bench_memcpy, 64, 64);
+DEFINE_BENCH(bench_memcpy_512, "memcpy/512", bench_memcpy, 512, 16);
+DEFINE_BENCH(bench_memcpy_4096, "memcpy/4096", bench_memcpy, 4096, 4);
+DEFINE_BENCH(bench_memcpy_16384, "memcpy/16384", bench_memcpy, 16384, 1);
+
+DEFINE_BENCH(bench_memset_64, "memset/64", bench_memset, 64, 64);
+DEFINE_BENCH(bench_memset_512, "memset/512", bench_memset, 512, 16);
+DEFINE_BENCH(bench_memset_4096, "memset/4096", bench_memset, 4096, 4);
+DEFINE_BENCH(bench_memset_16384, "memset/16384", bench_memset, 16384, 1);
+
+DEFINE_BENCH(bench_memmove_512, "memmove/512", bench_memmove, 512, 16);
+DEFINE_BENCH(bench_memmove_4096, "memmove/4096", bench_memmove, 4096, 4);
+
+// String scans over a terminal-line sized and a long string, per variant
+static char bench_str_a[1024];
+static char bench_str_b[1024];
+
+static void bench_str_setup(void) {
+    for (int i = 0; i < 1023; i++) {
+        bench_str_a[i] = bench_str_b[i] = 'a' + i % 26;
+    }
+}
+
+static void bench_strlen(uint64_t len) {
+    bench_str_a[len] = '\0';
+    strlen(bench_str_a);
+    bench_str_a[len] = 'x';
+}
+
+static void bench_strlen_word(uint64_t len) {
+    bench_str_a[len] = '\0';
+    strlen_word(bench_str_a);
+    bench_str_a[len] = 'x';
+}
+
+static void bench_strlen_sse42(uint64_t len) {
+    if (!string_sse42_supported()) return;
+    bench_str_a[len] = '\0';
+    strlen_sse42(bench_str_a);
+    bench_str_a[len] = 'x';
+}
+
+static void bench_strcmp_word(uint64_t len) {
+    bench_str_a[len] = bench_str_b[len] = '\0';
+    strcmp_word(bench_str_a, bench_str_b);
+    bench_str_a[len] = bench_str_b[len] = 'x';
+}
+
+static void bench_strcmp_sse42(uint64_t len) {
+    if (!string_sse42_supported()) return;
+    bench_str_a[len] = bench_str_b[len] = '\0';
+    strcmp_sse42(bench_str_a, bench_str_b);
+    bench_str_a[len] = bench_str_b[len] = 'x';
+}
+
+DEFINE_BENCH_FIXTURE(bench_strlen_40, "strlen/40", bench_strlen, 40, 64, bench_str_setup, NULL);
+DEFINE_BENCH_FIXTURE(bench_strlen_1000, "strlen/1000", bench_strlen, 1000, 16, bench_str_setup, NULL);
+DEFINE_BENCH_FIXTURE(bench_strlen_word_40, "strlen/word/40", bench_strlen_word, 40, 64, bench_str_setup, NULL);
+DEFINE_BENCH_FIXTURE(bench_strlen_word_1000, "strlen/word/1000", bench_strlen_word, 1000, 16, bench_str_setup, NULL);
+DEFINE_BENCH_FIXTURE(bench_strlen_sse42_40, "strlen/sse4.2/40", bench_strlen_sse42, 40, 64, bench_str_setup, NULL);
+DEFINE_BENCH_FIXTURE(bench_strlen_sse42_1000, "strlen/sse4.2/1000", bench_strlen_sse42, 1000, 16, bench_str_setup, NULL);
+DEFINE_BENCH_FIXTURE(bench_strcmp_word_40, "strcmp/word/40", bench_strcmp_word, 40, 64, bench_str_setup, NULL);
+DEFINE_BENCH_FIXTURE(bench_strcmp_word_1000, "strcmp/word/1000", bench_strcmp_word, 1000, 16, bench_str_setup, NULL);
+DEFINE_BENCH_FIXTURE(bench_strcmp_sse42_40, "strcmp/sse4.2/40", bench_strcmp_sse42, 40, 64, bench_str_setup, NULL);
+DEFINE_BENCH_FIXTURE(bench_strcmp_sse42_1000, "strcmp/sse4.2/1000", bench_strcmp_sse42, 1000, 16, bench_str_setup, NULL);
+
+// One irqstat-style line: the cost stats commands pay per row
+static void bench_snprintf_stats(uint64_t seed) {
+    static char line[128];
+    uint64_t count = seed * 0x9E3779B97F4A7C15ULL;
+    snprintf(line, sizeof(line), "%d %s %s %llu %llu <%llu <%llu %llu", 33, "timer", "ioapic",
+             count, count >> 20, count >> 24, count >> 12, count >> 8);
+}
+
+static void bench_snprintf_hex(uint64_t seed) {
+    static char line[32];
+    snprintf(line, sizeof(line), "%016llx", seed * 0x9E3779B97F4A7C15ULL);
+}
+
+DEFINE_BENCH(bench_snprintf_stats_line, "snprintf/stats", bench_snprintf_stats, 12345, 16);
+DEFINE_BENCH(bench_snprintf_hex64, "snprintf/hex64", bench_snprintf_hex, 12345, 64);
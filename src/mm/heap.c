@@ -1,5 +1,6 @@
 #include "heap.h"
 #include "mm/pmm.h"
+#include "mm/vmm.h"
 
 #define HEAP_START 0x1000000
 #define HEAP_SIZE 0x1000000
@@ -9,6 +10,8 @@ static uintptr_t heap_end = HEAP_START + HEAP_SIZE;
 static uintptr_t current_break = HEAP_START;
 
 void heap_init(void) {
+    // boot.asm only identity maps the first 2MB
+    vmm_identity_map(heap_start, heap_end - heap_start, VMM_PRESENT | VMM_WRITE);
     current_break = heap_start;
 }
 
@@ -30,3 +33,14 @@ void free(void* ptr) {
     // Simple heap - no real free for now
     (void)ptr;
 }
+
+void* heap_mark(void) {
+    return (void*)current_break;
+}
+
+void heap_release(void* mark) {
+    uintptr_t addr = (uintptr_t)mark;
+    if (addr >= heap_start && addr <= current_break) {
+        current_break = addr;
+    }
+}
@@ -12,4 +12,10 @@ void* malloc(size_t size);
 // Free memory
 void free(void* ptr);
 
+// free() doesn't reclaim yet, so code that allocates in a loop (the
+// malloc benchmarks) saves the break and rolls back to it afterwards.
+// Only safe when nothing else allocated in between.
+void* heap_mark(void);
+void heap_release(void* mark);
+
 #endif
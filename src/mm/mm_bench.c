@@ -0,0 +1,36 @@
+#include "mm/pmm.h"
+#include "mm/heap.h"
+#include "kernel/bench.h"
+
+// Allocations are timed as alloc+free pairs so the allocators return to
+// the same state every call instead of draining. The heap's free() is a
+// no-op, so the malloc runs also rewind the break when they finish.
+
+static void bench_pmm_frame(uint64_t arg) {
+    (void)arg;
+    void* frame = pmm_alloc_frame();
+    if (frame) pmm_free_frame(frame);
+}
+
+static void* bench_heap_mark = NULL;
+
+static void bench_heap_save(void) {
+    bench_heap_mark = heap_mark();
+}
+
+static void bench_heap_restore(void) {
+    heap_release(bench_heap_mark);
+}
+
+static void bench_malloc(uint64_t size) {
+    void* ptr = malloc(size);
+    if (ptr) free(ptr);
+}
+
+DEFINE_BENCH(bench_pmm, "pmm_alloc_frame+free", bench_pmm_frame, 0, 16);
+DEFINE_BENCH_FIXTURE(bench_malloc_32, "malloc+free/32", bench_malloc, 32, 16,
+                     bench_heap_save, bench_heap_restore);
+DEFINE_BENCH_FIXTURE(bench_malloc_256, "malloc+free/256", bench_malloc, 256, 16,
+                     bench_heap_save, bench_heap_restore);
+DEFINE_BENCH_FIXTURE(bench_malloc_4096, "malloc+free/4096", bench_malloc, 4096, 16,
+                     bench_heap_save, bench_heap_restore);
@@ -1,5 +1,6 @@
 #include "pmm.h"
 #include "lib/string.h"
+#include "kernel/spinlock.h"
 
 #define PAGE_SIZE 4096
 #define BITMAP_SIZE 32768
@@ -7,6 +8,7 @@
 static uint32_t bitmap[BITMAP_SIZE];
 static uint64_t total_memory;  // 64-bit
 static uint64_t used_frames;   // 64-bit
+static spinlock_t pmm_lock = SPINLOCK_INIT;
 
 static void mmap_set(int bit) {
     bitmap[bit / 32] |= (1 << (bit % 32));
@@ -42,11 +44,17 @@ void pmm_init(uint64_t mem_size) {
 }
 
 void* pmm_alloc_frame(void) {
+    uint64_t flags = spin_lock_irqsave(&pmm_lock);
+    
     int frame = mmap_first_free();
-    if (frame == -1) return NULL;
+    if (frame == -1) {
+        spin_unlock_irqrestore(&pmm_lock, flags);
+        return NULL;
+    }
     
     mmap_set(frame);
     used_frames++;
+    spin_unlock_irqrestore(&pmm_lock, flags);
     
     uint64_t addr = (uint64_t)frame * PAGE_SIZE;
     return (void*)addr;
@@ -55,8 +63,32 @@ void* pmm_alloc_frame(void) {
 void pmm_free_frame(void* frame) {
     uint64_t addr = (uint64_t)frame;
     int frame_num = addr / PAGE_SIZE;
+    
+    uint64_t flags = spin_lock_irqsave(&pmm_lock);
     mmap_unset(frame_num);
     used_frames--;
+    spin_unlock_irqrestore(&pmm_lock, flags);
+}
+
+int pmm_reserve_range(uint64_t base, uint64_t size) {
+    uint64_t first = base / PAGE_SIZE;
+    uint64_t end = (base + size + PAGE_SIZE - 1) / PAGE_SIZE;
+    
+    if (size == 0 || base + size > total_memory || end > (uint64_t)BITMAP_SIZE * 32) return -1;
+    
+    uint64_t flags = spin_lock_irqsave(&pmm_lock);
+    for (uint64_t frame = first; frame < end; frame++) {
+        if (mmap_test((int)frame)) {
+            spin_unlock_irqrestore(&pmm_lock, flags);
+            return -1;
+        }
+    }
+    for (uint64_t frame = first; frame < end; frame++) {
+        mmap_set((int)frame);
+    }
+    used_frames += end - first;
+    spin_unlock_irqrestore(&pmm_lock, flags);
+    return 0;
 }
 
 uint64_t pmm_get_total_memory(void) {
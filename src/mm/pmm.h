@@ -9,4 +9,9 @@ void pmm_free_frame(void* frame);
 uint64_t pmm_get_total_memory(void);
 uint64_t pmm_get_free_memory(void);
 
+// Take a fixed physical range (whole frames) out of the allocator for a
+// caller that uses it directly. Fails (-1) if the range runs past the end
+// of memory or any frame in it is already in use.
+int pmm_reserve_range(uint64_t base, uint64_t size);
+
 #endif
@@ -1,21 +1,192 @@
 #include "vmm.h"
 #include "mm/pmm.h"
+#include "lib/string.h"
 
-// 64-bit Virtual Memory Manager (stub - boot.asm handles paging)
+// 64-bit Virtual Memory Manager
+// boot.asm builds the initial 4-level tables; this walks and extends them.
+
+#define PAGE_SIZE 4096
+#define LARGE_PAGE_SIZE 0x200000
+#define VMM_ADDR_MASK 0x000FFFFFFFFFF000ULL
+#define VMM_NX        (1ULL << 63)
+#define VMM_PAT_LARGE 0x1000      // PAT bit of a large page (bit 7 in a PTE)
+
+// Flags that must match for an existing large page to serve a request
+#define VMM_ATTR_MASK (VMM_WRITE | VMM_USER | VMM_PWT | VMM_PCD)
+
+// Pre-allocated page tables (pmm frames are not reserved against the kernel
+// image yet, so new tables come from here instead)
+#define VMM_TABLE_POOL 64
+
+static uint64_t table_pool[VMM_TABLE_POOL][512] __attribute__((aligned(4096)));
+static int table_pool_used = 0;
+
+static uint64_t* vmm_get_pml4(void) {
+    uint64_t cr3;
+    asm volatile("mov %%cr3, %0" : "=r"(cr3));
+    return (uint64_t*)(uintptr_t)(cr3 & VMM_ADDR_MASK);
+}
+
+static void vmm_invlpg(uint64_t virt) {
+    asm volatile("invlpg (%0)" : : "r"(virt) : "memory");
+}
+
+// Return the next-level table for an entry, creating it if asked.
+// Returns NULL if the entry is a large page or the pool is exhausted.
+static uint64_t* vmm_next_table(uint64_t* table, int index, int create) {
+    uint64_t entry = table[index];
+    
+    if (entry & VMM_PRESENT) {
+        if (entry & VMM_HUGE) return NULL;
+        return (uint64_t*)(uintptr_t)(entry & VMM_ADDR_MASK);
+    }
+    
+    if (!create || table_pool_used >= VMM_TABLE_POOL) return NULL;
+    
+    uint64_t* next = table_pool[table_pool_used++];
+    memset(next, 0, PAGE_SIZE);
+    table[index] = (uint64_t)(uintptr_t)next | VMM_PRESENT | VMM_WRITE;
+    return next;
+}
+
+// Replace a present large page (2MB in a PD, or 1GB in a PDPT) with a
+// table of the next size down mapping the same memory with the same
+// flags. Returns the new table, or NULL if the pool is exhausted.
+static uint64_t* vmm_split_large(uint64_t* entry, uint64_t size) {
+    if (table_pool_used >= VMM_TABLE_POOL) return NULL;
+    
+    uint64_t* next = table_pool[table_pool_used++];
+    uint64_t base = *entry & VMM_ADDR_MASK & ~(size - 1);
+    uint64_t step = size / 512;
+    uint64_t flags = *entry & (VMM_NX | 0xFFF);
+    
+    // 1GB splits into 2MB pages and keeps the large-page PAT bit; 2MB
+    // splits into 4K pages, whose PAT bit is where VMM_HUGE was
+    if (step == PAGE_SIZE) {
+        flags &= ~(uint64_t)VMM_HUGE;
+        if (*entry & VMM_PAT_LARGE) flags |= VMM_HUGE;
+    } else {
+        flags |= *entry & VMM_PAT_LARGE;
+    }
+    
+    for (int i = 0; i < 512; i++) {
+        next[i] = (base + i * step) | flags;
+    }
+    
+    // Tables point at the split pages with permissive flags; the leaf
+    // entries keep the original ones
+    *entry = (uint64_t)(uintptr_t)next | VMM_PRESENT | VMM_WRITE | (*entry & VMM_USER);
+    for (uint64_t addr = base; addr < base + size; addr += LARGE_PAGE_SIZE) {
+        vmm_invlpg(addr);
+    }
+    return next;
+}
+
+// Does the large page in entry already map virt to phys with these flags?
+static int vmm_large_covers(uint64_t entry, uint64_t size, uint64_t virt, uint64_t phys, uint32_t flags) {
+    uint64_t base = entry & VMM_ADDR_MASK & ~(size - 1);
+    return base + (virt & (size - 1)) == (phys & VMM_ADDR_MASK) &&
+           (entry & VMM_ATTR_MASK) == (flags & VMM_ATTR_MASK);
+}
 
 void vmm_init(void) {
-    // Boot.asm sets up 4-level page tables
-    // This is a stub for future expansion
+    // Boot.asm sets up 4-level page tables; nothing to rebuild yet
+    table_pool_used = 0;
 }
 
-void vmm_map_page(uint64_t virt, uint64_t phys, uint32_t flags) {
-    // Stub - would manipulate page tables
-    (void)virt;
-    (void)phys;
-    (void)flags;
+int vmm_map_page(uint64_t virt, uint64_t phys, uint32_t flags) {
+    uint64_t* pml4 = vmm_get_pml4();
+    
+    uint64_t* pdpt = vmm_next_table(pml4, (virt >> 39) & 0x1FF, 1);
+    if (!pdpt) return -1;
+    
+    // A large page in the way is left alone if it already maps this page
+    // the same way, and split otherwise (e.g. to make one page uncached)
+    uint64_t* pdpte = &pdpt[(virt >> 30) & 0x1FF];
+    uint64_t* pd;
+    if ((*pdpte & VMM_PRESENT) && (*pdpte & VMM_HUGE)) {
+        if (vmm_large_covers(*pdpte, 1ULL << 30, virt, phys, flags)) return 0;
+        pd = vmm_split_large(pdpte, 1ULL << 30);
+    } else {
+        pd = vmm_next_table(pdpt, (virt >> 30) & 0x1FF, 1);
+    }
+    if (!pd) return -1;
+    
+    uint64_t* pde = &pd[(virt >> 21) & 0x1FF];
+    uint64_t* pt;
+    if ((*pde & VMM_PRESENT) && (*pde & VMM_HUGE)) {
+        if (vmm_large_covers(*pde, LARGE_PAGE_SIZE, virt, phys, flags)) return 0;
+        pt = vmm_split_large(pde, LARGE_PAGE_SIZE);
+    } else {
+        pt = vmm_next_table(pd, (virt >> 21) & 0x1FF, 1);
+    }
+    if (!pt) return -1;
+    
+    pt[(virt >> 12) & 0x1FF] = (phys & VMM_ADDR_MASK) | flags | VMM_PRESENT;
+    vmm_invlpg(virt);
+    return 0;
 }
 
 void vmm_unmap_page(uint64_t virt) {
-    // Stub - would clear page table entry
-    (void)virt;
+    uint64_t* pml4 = vmm_get_pml4();
+    
+    uint64_t* pdpt = vmm_next_table(pml4, (virt >> 39) & 0x1FF, 0);
+    if (!pdpt) return;
+    uint64_t* pd = vmm_next_table(pdpt, (virt >> 30) & 0x1FF, 0);
+    if (!pd) return;
+    uint64_t* pt = vmm_next_table(pd, (virt >> 21) & 0x1FF, 0);
+    if (!pt) return;
+    
+    pt[(virt >> 12) & 0x1FF] = 0;
+    vmm_invlpg(virt);
+}
+
+// Map one 2MB page. Fails (returns 0) if the slot already holds a page
+// table of 4K mappings; the caller then maps it page by page.
+static int vmm_map_large(uint64_t virt, uint64_t phys, uint32_t flags) {
+    uint64_t* pml4 = vmm_get_pml4();
+    
+    uint64_t* pdpt = vmm_next_table(pml4, (virt >> 39) & 0x1FF, 1);
+    if (!pdpt) return 0;
+    
+    uint64_t* pdpte = &pdpt[(virt >> 30) & 0x1FF];
+    uint64_t* pd;
+    if ((*pdpte & VMM_PRESENT) && (*pdpte & VMM_HUGE)) {
+        if (vmm_large_covers(*pdpte, 1ULL << 30, virt, phys, flags)) return 1;
+        pd = vmm_split_large(pdpte, 1ULL << 30);
+    } else {
+        pd = vmm_next_table(pdpt, (virt >> 30) & 0x1FF, 1);
+    }
+    if (!pd) return 0;
+    
+    uint64_t* entry = &pd[(virt >> 21) & 0x1FF];
+    if ((*entry & VMM_PRESENT) && !(*entry & VMM_HUGE)) return 0;
+    
+    *entry = (phys & VMM_ADDR_MASK) | flags | VMM_PRESENT | VMM_HUGE;
+    vmm_invlpg(virt);
+    return 1;
+}
+
+int vmm_identity_map(uint64_t phys, uint64_t size, uint32_t flags) {
+    uint64_t addr = phys & ~(uint64_t)(PAGE_SIZE - 1);
+    uint64_t end = (phys + size + PAGE_SIZE - 1) & ~(uint64_t)(PAGE_SIZE - 1);
+    int result = 0;
+    
+    while (addr < end) {
+        // Whole aligned 2MB chunks take one PD entry instead of a page table
+        if ((addr & (LARGE_PAGE_SIZE - 1)) == 0 && end - addr >= LARGE_PAGE_SIZE &&
+            vmm_map_large(addr, addr, flags)) {
+            addr += LARGE_PAGE_SIZE;
+            continue;
+        }
+        
+        if (vmm_map_page(addr, addr, flags) != 0) result = -1;
+        addr += PAGE_SIZE;
+    }
+    return result;
+}
+
+void* vmm_map_mmio(uint64_t phys, uint64_t size) {
+    if (vmm_identity_map(phys, size, VMM_MMIO) != 0) return NULL;
+    return (void*)(uintptr_t)phys;
 }
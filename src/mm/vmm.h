@@ -3,8 +3,29 @@
 
 #include <stdint.h>
 
+// Page table entry flags
+#define VMM_PRESENT   0x001
+#define VMM_WRITE     0x002
+#define VMM_USER      0x004
+#define VMM_PWT       0x008   // Write-through
+#define VMM_PCD       0x010   // Cache disable
+#define VMM_HUGE      0x080   // 2MB / 1GB page
+
+// Flags for device registers (uncached)
+#define VMM_MMIO      (VMM_PRESENT | VMM_WRITE | VMM_PCD | VMM_PWT)
+
 void vmm_init(void);
-void vmm_map_page(uint64_t virt, uint64_t phys, uint32_t flags);  // 64-bit addresses
+// Map one 4K page, splitting a large page that covers it with other
+// flags. Returns -1 if the page-table pool is exhausted.
+int vmm_map_page(uint64_t virt, uint64_t phys, uint32_t flags);  // 64-bit addresses
 void vmm_unmap_page(uint64_t virt);  // 64-bit address
 
+// Identity map a physical range (rounded out to whole pages; aligned 2MB
+// stretches use large pages). Returns -1 if part of it couldn't be mapped.
+int vmm_identity_map(uint64_t phys, uint64_t size, uint32_t flags);
+
+// Identity map device registers uncached and return a pointer to them,
+// or NULL if they couldn't be mapped
+void* vmm_map_mmio(uint64_t phys, uint64_t size);
+
 #endif
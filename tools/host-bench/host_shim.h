@@ -0,0 +1,43 @@
+#ifndef HOST_SHIM_H
+#define HOST_SHIM_H
+
+// Force-included into every file of the host build (see "host-bench" in
+// the Makefile). The kernel defines functions with libc names; renaming
+// them keeps the Linux executable's own stdio and allocator away from
+// the kernel's bump heap, and lets tests compare both.
+#define memset      kmemset
+#define memcpy      kmemcpy
+#define memmove     kmemmove
+#define strlen      kstrlen
+#define strnlen     kstrnlen
+#define strcmp      kstrcmp
+#define strncmp     kstrncmp
+#define strcpy      kstrcpy
+#define strncpy     kstrncpy
+#define malloc      kmalloc
+#define free        kfree
+#define printf      kprintf
+#define sprintf     ksprintf
+#define vsprintf    kvsprintf
+#define snprintf    ksnprintf
+#define vsnprintf   kvsnprintf
+
+#include <stdint.h>
+
+// Fake framebuffer the graphics code renders into
+#define HOST_FB_WIDTH   1024
+#define HOST_FB_HEIGHT  768
+
+extern uint32_t host_framebuffer[];
+
+// Map the kernel heap's fixed range, point graphics_init at the fake
+// framebuffer and run the memcpy/string dispatch against the host CPU.
+// Call before anything touches malloc or the renderer.
+void host_init(void);
+
+// Fake port I/O: the last value written to each port, and a value for
+// inb/inw/inl to return
+extern uint32_t host_port_out[65536];
+extern uint32_t host_port_in[65536];
+
+#endif
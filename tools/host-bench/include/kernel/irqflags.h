@@ -0,0 +1,35 @@
+#ifndef IRQFLAGS_H
+#define IRQFLAGS_H
+
+#include <stdint.h>
+
+// Host stand-in for src/kernel/irqflags.h: cli/sti fault in user mode,
+// and a single-threaded test process has no interrupts to mask
+
+#define RFLAGS_IF 0x200
+
+static uint64_t host_irq_flags __attribute__((unused)) = RFLAGS_IF;
+
+static inline uint64_t local_irq_save(void) {
+    uint64_t flags = host_irq_flags;
+    host_irq_flags = 0;
+    return flags;
+}
+
+static inline void local_irq_restore(uint64_t flags) {
+    host_irq_flags = flags;
+}
+
+static inline void local_irq_enable(void) {
+    host_irq_flags = RFLAGS_IF;
+}
+
+static inline void local_irq_disable(void) {
+    host_irq_flags = 0;
+}
+
+static inline int irqs_disabled(void) {
+    return !(host_irq_flags & RFLAGS_IF);
+}
+
+#endif
@@ -0,0 +1,590 @@
+// Host test and benchmark driver for the freestanding lib/mm/gui code.
+// Randomized tests check the kernel implementations against simple
+// reference models; the benchmarks are the kernel's own bench registry
+// (DEFINE_BENCH), printed as the same BENCH lines the kernel sends to COM1.
+//
+//   build/host/host-bench [--seed N] [--rounds N] [--no-test] [--no-bench] [--filter PREFIX]
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/mman.h>
+#include "lib/string.h"
+#include "lib/mem.h"
+#include "mm/heap.h"
+#include "mm/pmm.h"
+#include "gui/terminal.h"
+#include "gui/window_manager.h"
+#include "drivers/video/graphics.h"
+#include "kernel/bench.h"
+
+extern uint32_t* back_buffer;
+
+// lib/printf.h declares a void printf, which clashes with stdio
+char* fmt_u64_dec(char* end, uint64_t value);
+
+static uint64_t rng_state;
+static int failures = 0;
+
+#define CHECK(cond, ...) do {                                               \
+    if (!(cond)) {                                                          \
+        fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__);                \
+        fprintf(stderr, __VA_ARGS__);                                       \
+        fputc('\n', stderr);                                                \
+        failures++;                                                         \
+        return;                                                             \
+    }                                                                       \
+} while (0)
+
+// xorshift64*
+static uint64_t rng(void) {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+static uint32_t rng_below(uint32_t limit) {
+    return (uint32_t)(rng() % limit);
+}
+
+static void fill_random(uint8_t* buf, size_t len) {
+    for (size_t i = 0; i < len; i++) buf[i] = (uint8_t)rng();
+}
+
+static int sign(int value) {
+    return (value > 0) - (value < 0);
+}
+
+// --- lib/string.c ---
+
+#define STR_BUF 1024
+#define GUARD   64
+
+// Lengths past the streaming cutoff (256) and the 64-byte head/tail
+#define MEM_BUF 65536
+
+typedef void* (*copy_fn_t)(void*, const void*, size_t);
+typedef void* (*set_fn_t)(void*, int, size_t);
+
+static void check_copy_set(const char* name, copy_fn_t copy, set_fn_t set, int rounds) {
+    static uint8_t dst[MEM_BUF + 2 * GUARD], ref[MEM_BUF + 2 * GUARD], src[MEM_BUF];
+    
+    for (int r = 0; r < rounds; r++) {
+        size_t len = rng_below(4) ? rng_below(STR_BUF - 16) : rng_below(MEM_BUF - 64);
+        size_t dst_off = GUARD + rng_below(64);
+        size_t src_off = rng_below(64);
+        
+        fill_random(src, sizeof(src));
+        fill_random(dst, sizeof(dst));
+        for (size_t i = 0; i < sizeof(dst); i++) ref[i] = dst[i];
+        for (size_t i = 0; i < len; i++) ref[dst_off + i] = src[src_off + i];
+        
+        void* ret = copy(dst + dst_off, src + src_off, len);
+        CHECK(ret == dst + dst_off, "%s copy returned %p, want %p", name, ret, (void*)(dst + dst_off));
+        for (size_t i = 0; i < sizeof(dst); i++) {
+            CHECK(dst[i] == ref[i], "%s copy len %zu dst+%zu src+%zu: byte %zu differs",
+                  name, len, dst_off, src_off, i);
+        }
+        
+        int value = (int)rng();
+        for (size_t i = 0; i < len; i++) ref[dst_off + i] = (uint8_t)value;
+        
+        ret = set(dst + dst_off, value, len);
+        CHECK(ret == dst + dst_off, "%s set returned %p, want %p", name, ret, (void*)(dst + dst_off));
+        for (size_t i = 0; i < sizeof(dst); i++) {
+            CHECK(dst[i] == ref[i], "%s set len %zu dst+%zu: byte %zu differs", name, len, dst_off, i);
+        }
+    }
+}
+
+// The dispatched entry points, then every variant this CPU supports
+static void test_memcpy_memset(int rounds) {
+    check_copy_set("memcpy/memset", memcpy, memset, rounds);
+    
+    for (int i = 0; i < mem_impl_count(); i++) {
+        const mem_impl_t* impl = mem_impl_get(i);
+        if (impl->supported) check_copy_set(impl->name, impl->copy, impl->set, rounds);
+    }
+}
+
+static void test_memmove(int rounds) {
+    static uint8_t buf[2 * STR_BUF], ref[2 * STR_BUF];
+    
+    for (int r = 0; r < rounds; r++) {
+        size_t len = rng_below(STR_BUF);
+        size_t src_off = rng_below(STR_BUF);
+        size_t dst_off = rng_below(STR_BUF);
+        
+        fill_random(buf, sizeof(buf));
+        for (size_t i = 0; i < sizeof(buf); i++) ref[i] = buf[i];
+        
+        // Reference: through a temporary, which is what memmove promises
+        uint8_t tmp[STR_BUF];
+        for (size_t i = 0; i < len; i++) tmp[i] = ref[src_off + i];
+        for (size_t i = 0; i < len; i++) ref[dst_off + i] = tmp[i];
+        
+        void* ret = memmove(buf + dst_off, buf + src_off, len);
+        CHECK(ret == buf + dst_off, "memmove returned %p, want %p", ret, (void*)(buf + dst_off));
+        for (size_t i = 0; i < sizeof(buf); i++) {
+            CHECK(buf[i] == ref[i], "memmove len %zu dst+%zu src+%zu: byte %zu differs",
+                  len, dst_off, src_off, i);
+        }
+    }
+}
+
+static int ref_strncmp(const char* a, const char* b, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (a[i] != b[i] || !a[i]) return (unsigned char)a[i] - (unsigned char)b[i];
+    }
+    return 0;
+}
+
+static void random_string(char* buf, size_t max_len) {
+    size_t len = rng_below(max_len);
+    for (size_t i = 0; i < len; i++) buf[i] = 'a' + rng_below(3);   // Small alphabet: long common prefixes
+    buf[len] = '\0';
+}
+
+static void test_strings(int rounds) {
+    static char a[STR_BUF], b[STR_BUF], copy[STR_BUF + GUARD];
+    
+    for (int r = 0; r < rounds; r++) {
+        random_string(a, 200);
+        random_string(b, 200);
+        
+        size_t len = 0;
+        while (a[len]) len++;
+        CHECK(strlen(a) == len, "strlen %zu, want %zu", strlen(a), len);
+        
+        CHECK(sign(strcmp(a, b)) == sign(ref_strncmp(a, b, STR_BUF)), "strcmp(\"%s\", \"%s\")", a, b);
+        
+        size_t n = rng_below(220);
+        CHECK(sign(strncmp(a, b, n)) == sign(ref_strncmp(a, b, n)), "strncmp(\"%s\", \"%s\", %zu)", a, b, n);
+        
+        // strncpy copies at most n and zero-pads the rest
+        for (size_t i = 0; i < sizeof(copy); i++) copy[i] = 'X';
+        strncpy(copy, a, n);
+        for (size_t i = 0; i < n; i++) {
+            char want = i < len ? a[i] : '\0';
+            CHECK(copy[i] == want, "strncpy(\"%s\", %zu): byte %zu", a, n, i);
+        }
+        CHECK(copy[n] == 'X', "strncpy(\"%s\", %zu) wrote past n", a, n);
+        
+        strcpy(copy, a);
+        CHECK(strcmp(copy, a) == 0, "strcpy(\"%s\")", a);
+    }
+}
+
+// Every strlen/strnlen/strcmp/strncmp variant, on strings whose terminator
+// is the last byte before an unmapped page, at every start alignment.
+// A variant that reads past the terminator into the next page faults.
+typedef struct {
+    const char* name;
+    size_t (*len)(const char*);
+    size_t (*nlen)(const char*, size_t);
+    int (*cmp)(const char*, const char*);
+} str_variant_t;
+
+#define EDGE_PAGE 4096
+
+static void check_string_variant(const str_variant_t* v, char* page_end, int rounds) {
+    static char other[EDGE_PAGE];
+    
+    for (int r = 0; r < rounds; r++) {
+        size_t len = rng_below(200);
+        char* s = page_end - len - 1;     // NUL is the page's last byte
+        
+        for (size_t i = 0; i < len; i++) s[i] = 'a' + rng_below(3);
+        s[len] = '\0';
+        
+        CHECK(v->len(s) == len, "%s strlen at page end: %zu, want %zu (align %lu)",
+              v->name, v->len(s), len, (unsigned long)((uintptr_t)s & 15));
+        
+        size_t max = rng_below(220);
+        size_t want = len < max ? len : max;
+        CHECK(v->nlen(s, max) == want, "%s strnlen(%zu) at page end: %zu, want %zu",
+              v->name, max, v->nlen(s, max), want);
+        
+        // Equal, differing at a random byte, and one a prefix of the other,
+        // with the copy at a random alignment of its own
+        char* o = other + rng_below(32);
+        for (size_t i = 0; i <= len; i++) o[i] = s[i];
+        CHECK(v->cmp(s, o) == 0 && v->cmp(o, s) == 0, "%s strcmp equal len %zu", v->name, len);
+        
+        if (len > 0) {
+            size_t at = rng_below(len);
+            o[at] = s[at] + 1;
+            CHECK(sign(v->cmp(s, o)) == -1 && sign(v->cmp(o, s)) == 1,
+                  "%s strcmp differing at %zu of %zu", v->name, at, len);
+            o[at] = s[at];
+            
+            o[len] = 'x';
+            o[len + 1] = '\0';
+            CHECK(sign(v->cmp(s, o)) == -1 && sign(v->cmp(o, s)) == 1,
+                  "%s strcmp prefix len %zu", v->name, len);
+        }
+    }
+}
+
+static void test_string_edges(int rounds) {
+    char* pages = mmap(NULL, 2 * EDGE_PAGE, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    CHECK(pages != MAP_FAILED, "mmap for the page-edge tests");
+    mprotect(pages + EDGE_PAGE, EDGE_PAGE, PROT_NONE);
+    
+    const str_variant_t variants[] = {
+        { "dispatched", strlen, strnlen, strcmp },
+        { "word", strlen_word, strnlen_word, strcmp_word },
+        { "sse4.2", strlen_sse42, strnlen_sse42, strcmp_sse42 },
+    };
+    int count = string_sse42_supported() ? 3 : 2;
+    
+    for (int i = 0; i < count; i++) {
+        check_string_variant(&variants[i], pages + EDGE_PAGE, rounds);
+    }
+    
+    // strncmp and strncpy read up to n bytes or the terminator, no further
+    char* end = pages + EDGE_PAGE;
+    for (int r = 0; r < rounds; r++) {
+        size_t len = rng_below(100);
+        char* s = end - len - 1;
+        for (size_t i = 0; i < len; i++) s[i] = 'a' + rng_below(3);
+        s[len] = '\0';
+        
+        char copy[256];
+        size_t n = rng_below(200);
+        CHECK(strncmp_word(s, s, n + len) == 0, "strncmp_word at page end len %zu", len);
+        strncpy(copy, s, n);
+        for (size_t i = 0; i < n; i++) {
+            CHECK(copy[i] == (i < len ? s[i] : '\0'), "strncpy at page end len %zu n %zu", len, n);
+        }
+    }
+    
+    munmap(pages, 2 * EDGE_PAGE);
+}
+
+// --- lib/printf.c ---
+
+// snprintf is the kernel's (renamed by the shim); __builtin_snprintf still
+// calls the C library, which is the reference
+#define PRINTF_BOTH(...) do {                                               \
+    klen = snprintf(kbuf, size, fmt, __VA_ARGS__);                          \
+    glen = __builtin_snprintf(gbuf, size, fmt, __VA_ARGS__);                \
+} while (0)
+
+// '*' width and precision come before the value
+#define PRINTF_ARG(value) do {                                              \
+    switch (stars) {                                                        \
+    case 0: PRINTF_BOTH(value); break;                                      \
+    case 1: PRINTF_BOTH(width, value); break;                               \
+    case 2: PRINTF_BOTH(precision, value); break;                           \
+    default: PRINTF_BOTH(width, precision, value); break;                   \
+    }                                                                       \
+} while (0)
+
+static uint64_t random_value(void) {
+    switch (rng_below(4)) {
+    case 0: return 0;
+    case 1: return rng_below(1000);
+    case 2: return rng() >> rng_below(64);
+    default: return -(uint64_t)rng_below(1000);
+    }
+}
+
+static void test_printf(int rounds) {
+    static const char* lengths[] = { "", "hh", "h", "l", "ll", "z", "j" };
+    static const char convs[] = "diuxXosc";
+    char fmt[64], kbuf[160], gbuf[160];
+    
+    for (int r = 0; r < rounds; r++) {
+        char conv = convs[rng_below(sizeof(convs) - 1)];
+        int integer = conv != 's' && conv != 'c';
+        int width = (int)rng_below(40) - 8;
+        int precision = (int)rng_below(30) - 4;
+        int stars = 0;
+        
+        // Literal text around a random conversion spec
+        int pos = 0;
+        fmt[pos++] = 'a';
+        fmt[pos++] = '%';
+        for (const char* f = "-0+ #"; *f; f++) {
+            if (!rng_below(3) && (integer || *f == '-')) fmt[pos++] = *f;
+        }
+        if (rng_below(2)) {
+            if (rng_below(2)) {
+                fmt[pos++] = '*';
+                stars |= 1;
+            } else if (width > 0) {
+                pos += sprintf(fmt + pos, "%d", width);
+            }
+        }
+        if (rng_below(2) && conv != 'c') {
+            fmt[pos++] = '.';
+            if (rng_below(2)) {
+                fmt[pos++] = '*';
+                stars |= 2;
+            } else if (precision >= 0) {
+                pos += sprintf(fmt + pos, "%d", precision);
+            }
+        }
+        const char* length = integer ? lengths[rng_below(7)] : "";
+        pos += sprintf(fmt + pos, "%s%cz", length, conv);
+        
+        size_t size = rng_below(8) ? sizeof(kbuf) : rng_below(24);
+        memset(kbuf, 0x55, sizeof(kbuf));
+        memset(gbuf, 0x55, sizeof(gbuf));
+        
+        uint64_t value = random_value();
+        int klen = 0, glen = 0;
+        static const char* strings[] = { "", "x", "hello", "a longer string here" };
+        const char* str = strings[rng_below(4)];
+        int ch = '!' + (int)rng_below(90);
+        if (conv == 's') {
+            PRINTF_ARG(str);
+        } else if (conv == 'c') {
+            PRINTF_ARG(ch);
+        } else if (!strcmp(length, "l")) {
+            PRINTF_ARG((long)value);
+        } else if (!strcmp(length, "ll") || !strcmp(length, "j")) {
+            PRINTF_ARG((long long)value);
+        } else if (!strcmp(length, "z")) {
+            PRINTF_ARG((size_t)value);
+        } else {
+            PRINTF_ARG((int)value);
+        }
+        
+        CHECK(klen == glen, "\"%s\" size %zu returned %d, want %d", fmt, size, klen, glen);
+        for (size_t i = 0; i < sizeof(kbuf); i++) {
+            CHECK(kbuf[i] == gbuf[i], "\"%s\" size %zu gave \"%.*s\", want \"%.*s\"",
+                  fmt, size, (int)size, kbuf, (int)size, gbuf);
+        }
+    }
+    
+    // %p is the full address with 0x (glibc agrees except for NULL)
+    char buf[32];
+    void* ptr = (void*)0xffff800012345678ULL;
+    snprintf(buf, sizeof(buf), "%p", ptr);
+    CHECK(strcmp(buf, "0xffff800012345678") == 0, "%%p gave \"%s\"", buf);
+    snprintf(buf, sizeof(buf), "%p", (void*)0);
+    CHECK(strcmp(buf, "0x0") == 0, "%%p of NULL gave \"%s\"", buf);
+    
+    // Decimal conversion on both sides of every power of ten
+    for (uint64_t value = 1;; value *= 10) {
+        uint64_t edges[] = { value - 1, value, UINT64_MAX };
+        for (int i = 0; i < 3; i++) {
+            char kdec[24], gdec[24];
+            kdec[sizeof(kdec) - 1] = '\0';
+            char* digits = fmt_u64_dec(kdec + sizeof(kdec) - 1, edges[i]);
+            __builtin_snprintf(gdec, sizeof(gdec), "%llu", (unsigned long long)edges[i]);
+            CHECK(strcmp(digits, gdec) == 0, "fmt_u64_dec gave %s, want %s", digits, gdec);
+        }
+        if (value > UINT64_MAX / 10) break;
+    }
+}
+
+// --- mm/heap.c ---
+
+static void test_heap(int rounds) {
+    uint8_t* prev = NULL;
+    size_t prev_len = 0;
+    uint8_t prev_tag = 0;
+    
+    for (int r = 0; r < rounds; r++) {
+        size_t len = 1 + rng_below(4096);
+        uint8_t* ptr = malloc(len);
+        CHECK(ptr != NULL, "malloc(%zu) failed", len);
+        CHECK(((uintptr_t)ptr & 15) == 0, "malloc(%zu) = %p is not 16-byte aligned", len, (void*)ptr);
+        
+        uint8_t tag = (uint8_t)rng();
+        memset(ptr, tag, len);
+        
+        // The previous block must not overlap this one
+        if (prev) {
+            for (size_t i = 0; i < prev_len; i++) {
+                CHECK(prev[i] == prev_tag, "malloc block %p overlaps the previous one", (void*)ptr);
+            }
+            free(prev);
+        }
+        
+        prev = ptr;
+        prev_len = len;
+        prev_tag = tag;
+    }
+}
+
+// --- mm/pmm.c ---
+
+#define PMM_TEST_FRAMES 4096
+
+static void test_pmm(int rounds) {
+    static uint8_t held[PMM_TEST_FRAMES * 4];
+    static uintptr_t frames[PMM_TEST_FRAMES];
+    int count = 0;
+    
+    pmm_init(256ULL * 1024 * 1024);
+    uint64_t total = pmm_get_total_memory();
+    
+    for (size_t i = 0; i < sizeof(held); i++) held[i] = 0;
+    
+    for (int r = 0; r < rounds; r++) {
+        if (count < PMM_TEST_FRAMES && (count == 0 || rng_below(3) != 0)) {
+            // Frame 0 comes back as a NULL pointer; it's still a frame
+            uintptr_t addr = (uintptr_t)pmm_alloc_frame();
+            CHECK((addr & 4095) == 0, "pmm_alloc_frame returned unaligned %#lx", (unsigned long)addr);
+            
+            uintptr_t index = addr / 4096;
+            CHECK(index < sizeof(held), "frame %#lx outside the test range", (unsigned long)addr);
+            CHECK(!held[index], "frame %#lx handed out twice", (unsigned long)addr);
+            held[index] = 1;
+            frames[count++] = addr;
+        } else {
+            int victim = rng_below(count);
+            uintptr_t addr = frames[victim];
+            frames[victim] = frames[--count];
+            held[addr / 4096] = 0;
+            pmm_free_frame((void*)addr);
+        }
+        
+        CHECK(pmm_get_free_memory() == total - (uint64_t)count * 4096,
+              "free memory %llu, want %llu", (unsigned long long)pmm_get_free_memory(),
+              (unsigned long long)(total - (uint64_t)count * 4096));
+    }
+    
+    while (count > 0) pmm_free_frame((void*)frames[--count]);
+}
+
+// --- gui/terminal.c ---
+
+static void test_terminal(int rounds) {
+    static char model[MAX_LINES][MAX_LINE_LENGTH];
+    static char text[400];
+    int model_count = 0;
+    
+    terminal_instance_t* term = terminal_create_instance();
+    CHECK(term != NULL, "terminal_create_instance failed");
+    
+    for (int r = 0; r < rounds; r++) {
+        size_t len = rng_below(3) == 0 ? 0 : rng_below(sizeof(text) - 1);
+        for (size_t i = 0; i < len; i++) text[i] = ' ' + rng_below(95);
+        text[len] = '\0';
+        
+        terminal_instance_print(term, text);
+        
+        // Model: empty text is one empty line, long text wraps
+        if (len == 0) {
+            model[model_count++ % MAX_LINES][0] = '\0';
+        }
+        for (size_t pos = 0; pos < len; pos += MAX_LINE_LENGTH - 1) {
+            char* line = model[model_count++ % MAX_LINES];
+            size_t chunk = len - pos < MAX_LINE_LENGTH - 1 ? len - pos : MAX_LINE_LENGTH - 1;
+            for (size_t i = 0; i < chunk; i++) line[i] = text[pos + i];
+            line[chunk] = '\0';
+        }
+        
+        CHECK(term->line_count == model_count, "line_count %d, want %d", term->line_count, model_count);
+        for (int i = 0; i < MAX_LINES && i < model_count; i++) {
+            CHECK(strcmp(term->lines[i], model[i]) == 0, "line %d is \"%s\", want \"%s\"",
+                  i, term->lines[i], model[i]);
+        }
+    }
+    
+    terminal_destroy_instance(term);
+}
+
+// --- drivers/video/graphics.c ---
+
+static void test_graphics(int rounds) {
+    static uint32_t model[HOST_FB_WIDTH * HOST_FB_HEIGHT];
+    
+    clear_screen(0);
+    for (int i = 0; i < HOST_FB_WIDTH * HOST_FB_HEIGHT; i++) model[i] = 0;
+    
+    for (int r = 0; r < rounds; r++) {
+        // Rectangles partly or wholly off screen exercise the clipping
+        int x = (int)rng_below(HOST_FB_WIDTH + 200) - 100;
+        int y = (int)rng_below(HOST_FB_HEIGHT + 200) - 100;
+        int w = (int)rng_below(300);
+        int h = (int)rng_below(300);
+        uint32_t color = (uint32_t)rng();
+        
+        draw_rect(x, y, w, h, color);
+        for (int py = y; py < y + h; py++) {
+            for (int px = x; px < x + w; px++) {
+                if (px >= 0 && px < HOST_FB_WIDTH && py >= 0 && py < HOST_FB_HEIGHT) {
+                    model[py * HOST_FB_WIDTH + px] = color;
+                }
+            }
+        }
+    }
+    
+    for (int i = 0; i < HOST_FB_WIDTH * HOST_FB_HEIGHT; i++) {
+        CHECK(back_buffer[i] == model[i], "pixel (%d, %d) is %#x, want %#x",
+              i % HOST_FB_WIDTH, i / HOST_FB_WIDTH, back_buffer[i], model[i]);
+    }
+    
+    swap_buffers();
+    for (int i = 0; i < HOST_FB_WIDTH * HOST_FB_HEIGHT; i++) {
+        CHECK(host_framebuffer[i] == model[i], "swap_buffers: pixel %d differs", i);
+    }
+}
+
+static void run_benches(const char* prefix) {
+    size_t prefix_len = prefix ? strlen(prefix) : 0;
+    
+    for (int i = 0; i < bench_count(); i++) {
+        const bench_t* bench = bench_get(i);
+        if (prefix && strncmp(bench->name, prefix, prefix_len) != 0) continue;
+        
+        bench_result_t result;
+        bench_run(bench, &result);
+        bench_report_serial(&result);
+    }
+}
+
+int main(int argc, char** argv) {
+    uint64_t seed = (uint64_t)time(NULL);
+    int rounds = 2000;
+    int run_tests = 1;
+    int benches = 1;
+    const char* filter = NULL;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+            rounds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--no-test") == 0) {
+            run_tests = 0;
+        } else if (strcmp(argv[i], "--no-bench") == 0) {
+            benches = 0;
+        } else {
+            fprintf(stderr, "usage: %s [--seed N] [--rounds N] [--no-test] [--no-bench] [--filter PREFIX]\n", argv[0]);
+            return 2;
+        }
+    }
+    
+    host_init();
+    wm_init();
+    rng_state = seed ? seed : 1;
+    
+    if (run_tests) {
+        fprintf(stdout, "host-bench: seed %llu, %d rounds\n", (unsigned long long)seed, rounds);
+        test_memcpy_memset(rounds);
+        test_memmove(rounds);
+        test_strings(rounds);
+        test_string_edges(rounds);
+        test_printf(rounds * 10);
+        test_heap(rounds);
+        test_pmm(rounds);
+        test_terminal(rounds);
+        test_graphics(rounds / 10);
+        fprintf(stdout, "host-bench: %s\n", failures ? "TESTS FAILED" : "all tests passed");
+    }
+    
+    if (benches && !failures) run_benches(filter);
+    
+    fflush(stdout);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,111 @@
+// Host-side replacements for the kernel pieces the host build leaves out:
+// port I/O, the VGA/serial consoles, the multiboot framebuffer and the
+// fixed heap mapping.
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include "include/multiboot.h"
+#include "drivers/video/graphics.h"
+#include "kernel/cpuid.h"
+#include "kernel/rcu.h"
+#include "lib/mem.h"
+#include "lib/string.h"
+
+// mm/heap.c hands out addresses from this fixed window
+#define HOST_HEAP_START 0x1000000
+#define HOST_HEAP_SIZE  0x1000000
+
+uint32_t host_framebuffer[HOST_FB_WIDTH * HOST_FB_HEIGHT];
+
+uint32_t host_port_out[65536];
+uint32_t host_port_in[65536];
+
+void host_init(void) {
+    void* heap = mmap((void*)HOST_HEAP_START, HOST_HEAP_SIZE, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (heap != (void*)HOST_HEAP_START) {
+        fprintf(stderr, "host-bench: can't map the kernel heap at %#x\n", HOST_HEAP_START);
+        exit(2);
+    }
+    
+    multiboot_info_t mbi = {0};
+    mbi.framebuffer_addr = (uint64_t)(uintptr_t)host_framebuffer;
+    mbi.framebuffer_width = HOST_FB_WIDTH;
+    mbi.framebuffer_height = HOST_FB_HEIGHT;
+    mbi.framebuffer_pitch = HOST_FB_WIDTH * 4;
+    mbi.framebuffer_bpp = 32;
+    graphics_init(&mbi);
+    
+    cpuid_init();
+    mem_dispatch_init();
+    string_dispatch_init();
+}
+
+// lib/io.h
+void outb(uint16_t port, uint8_t val) { host_port_out[port] = val; }
+uint8_t inb(uint16_t port) { return (uint8_t)host_port_in[port]; }
+void outw(uint16_t port, uint16_t val) { host_port_out[port] = val; }
+uint16_t inw(uint16_t port) { return (uint16_t)host_port_in[port]; }
+void outl(uint16_t port, uint32_t val) { host_port_out[port] = val; }
+uint32_t inl(uint16_t port) { return host_port_in[port]; }
+
+// drivers/video/vga.h and drivers/char/serial.h both go to stdout
+void vga_print(const char* str) {
+    fputs(str, stdout);
+}
+
+void serial_write(const char* str) {
+    fputs(str, stdout);
+}
+
+void serial_write_blocking(const char* str) {
+    fputs(str, stdout);
+}
+
+// gui/taskbar.c is not part of the host build
+void taskbar_remove_button(int window_id) {
+    (void)window_id;
+}
+
+// kernel/rcu.c: the host build has a single thread and no readers can be
+// running, so the grace period is already over
+DEFINE_PER_CPU(volatile int, rcu_nesting);
+
+void call_rcu(rcu_head_t* head, void (*func)(rcu_head_t*)) {
+    func(head);
+}
+
+void rcu_barrier(void) {
+}
+
+// kernel/input_latency.c is not part of the host build; no input arrives
+void input_latency_frame_flushed(void) {
+}
+
+// mm/vmm.c: the heap window is mmapped by host_init and the framebuffer is
+// a static array, so there is nothing to map
+int vmm_identity_map(uint64_t phys, uint64_t size, uint32_t flags) {
+    (void)phys;
+    (void)size;
+    (void)flags;
+    return 0;
+}
+
+// kernel/fpu.c: user space owns its vector registers, so sections are free
+int fpu_available(void) {
+    return 1;
+}
+
+int fpu_has_avx(void) {
+    return __builtin_cpu_supports("avx");
+}
+
+int may_use_simd(void) {
+    return 1;
+}
+
+void kernel_fpu_begin(void) {
+}
+
+void kernel_fpu_end(void) {
+}